@@ -32,6 +32,7 @@
 #include "svn_error.h"
 #include "svn_ra.h"
 #include "svn_delta.h"
+#include "svn_diff.h"
 #include "svn_editor.h"
 #include "svn_io.h"
 
@@ -154,6 +155,55 @@ svn_ra__release_operational_lock(svn_ra_session_t *session,
                                  const svn_string_t *mylocktoken,
                                  apr_pool_t *scratch_pool);
 
+/*** Server-side Blame ***/
+
+/** Callback type for svn_ra__get_blame().
+ *
+ * @a line_count lines starting at the 0-based line @a start_line of the
+ * file have last been changed in @a revision, whose revision properties
+ * are @a rev_props.  If the lines had been changed before the start of
+ * the requested range, @a revision is #SVN_INVALID_REVNUM and @a rev_props
+ * is NULL.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+typedef svn_error_t *(*svn_ra__blame_receiver_t)(void *baton,
+                                                 apr_int64_t start_line,
+                                                 apr_int64_t line_count,
+                                                 svn_revnum_t revision,
+                                                 apr_hash_t *rev_props,
+                                                 apr_pool_t *scratch_pool);
+
+/** Let the server annotate the lines of the file @a path, relative to
+ * the URL of @a session, as of revision @a end with the revision in which
+ * they last changed, not looking further back than revision @a start.
+ * Lines are compared according to @a diff_options.
+ *
+ * Call @a receiver with @a receiver_baton for every run of adjacent lines
+ * that share the same revision, in order.  Only the @c svn:author and
+ * @c svn:date revision properties are guaranteed to be provided.
+ *
+ * Merged revisions are not being reported.  @a start must not be larger
+ * than @a end.  Return #SVN_ERR_UNSUPPORTED_FEATURE if the server cannot
+ * do this; the caller should then compute the blame itself from
+ * svn_ra_get_file_revs2().
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_ra__get_blame(svn_ra_session_t *session,
+                  const char *path,
+                  svn_revnum_t start,
+                  svn_revnum_t end,
+                  const svn_diff_file_options_t *diff_options,
+                  svn_ra__blame_receiver_t receiver,
+                  void *receiver_baton,
+                  apr_pool_t *scratch_pool);
+
 /** Register CALLBACKS to be used with the Ev2 shims in RA_SESSION. */
 svn_error_t *
 svn_ra__register_editor_shim_callbacks(svn_ra_session_t *ra_session,
@@ -32,6 +32,7 @@
 #include "svn_types.h"
 #include "svn_repos.h"
 #include "svn_delta.h"
+#include "svn_diff.h"
 #include "svn_editor.h"
 #include "svn_config.h"
 
@@ -371,6 +372,173 @@ svn_repos__get_dump_editor(const svn_delta_editor_t **editor,
                            const char *update_anchor_relpath,
                            apr_pool_t *pool);
 
+/**
+ * Create the changed-paths index for @a repos, replacing any existing one,
+ * and fill it with all revisions.  Once it exists, commits will keep the
+ * index up to date and svn_repos_get_logs5() will use it to find the
+ * revisions that changed a given path without walking its history.
+ *
+ * Use @a cancel_func and @a cancel_baton to check for cancellation.
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_repos__log_index_build(svn_repos_t *repos,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool);
+
+/**
+ * Callback type for svn_repos__get_blame().
+ *
+ * @a line_count lines starting at the 0-based line @a start_line of the
+ * file have last been changed in @a revision.  @a rev_props are the
+ * revision properties of @a revision as returned by
+ * svn_repos_get_file_revs2().  If the lines had been changed before the
+ * start of the requested range, @a revision is #SVN_INVALID_REVNUM and
+ * @a rev_props is NULL.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+typedef svn_error_t *
+(*svn_repos__blame_receiver_t)(void *baton,
+                               apr_int64_t start_line,
+                               apr_int64_t line_count,
+                               svn_revnum_t revision,
+                               apr_hash_t *rev_props,
+                               apr_pool_t *scratch_pool);
+
+/**
+ * The largest file, in bytes, that svn_repos__get_blame() annotates.
+ * Every revision of the file is held in memory twice while diffing it
+ * against its predecessor.
+ *
+ * @since New in 1.12.
+ */
+#define SVN_REPOS__BLAME_MAX_TEXT_SIZE  (16 * 1024 * 1024)
+
+/**
+ * Annotate the lines of the file @a path in @a repos as of revision
+ * @a end with the revision in which they last changed, not looking further
+ * back than revision @a start.  Lines are compared as specified by
+ * @a diff_options.  @a start must not be larger than @a end.
+ *
+ * Call @a receiver with @a receiver_baton for every run of adjacent lines
+ * that share the same revision, in order.  Merged revisions are not taken
+ * into account.
+ *
+ * If any revision of the file within the range is larger than
+ * #SVN_REPOS__BLAME_MAX_TEXT_SIZE, return #SVN_ERR_UNSUPPORTED_FEATURE
+ * before calling @a receiver, so that clients can annotate the file
+ * themselves.
+ *
+ * @a authz_read_func and @a authz_read_baton are being passed on to
+ * svn_repos_get_file_revs2().  If @a authz_read_func is @c NULL, results
+ * are being cached in the repository and later calls will only process
+ * the revisions not covered by the cache.  Check @a cancel_func with
+ * @a cancel_baton for cancellation.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_repos__get_blame(svn_repos_t *repos,
+                     const char *path,
+                     svn_revnum_t start,
+                     svn_revnum_t end,
+                     const svn_diff_file_options_t *diff_options,
+                     svn_repos_authz_func_t authz_read_func,
+                     void *authz_read_baton,
+                     svn_repos__blame_receiver_t receiver,
+                     void *receiver_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool);
+
+/**
+ * Let the reporter @a report_baton, as returned by svn_repos_begin_report3(),
+ * compute the text deltas of added files in up to @a threads worker threads
+ * ahead of the editor drive.  The editor will still be driven from the
+ * thread calling svn_repos_finish_report() and in the same order as before.
+ *
+ * Precomputed deltas that have not been sent yet will use at most
+ * @a memory_limit bytes; 0 selects a default.  The workers open their own
+ * instances of the repository's filesystem, using @a fs_config.
+ *
+ * If @a threads is 0 or APR does not support threads, this is a no-op.
+ * The same is true if the caches have been configured as single-threaded
+ * through svn_cache_config_set() at the time the report gets finished.
+ * Must be called before svn_repos_finish_report().
+ */
+svn_error_t *
+svn_repos__report_set_delta_threads(void *report_baton,
+                                    int threads,
+                                    apr_size_t memory_limit,
+                                    apr_hash_t *fs_config);
+
+/**
+ * Like svn_repos_dump_fs4(), but let up to @a jobs worker threads dump
+ * the revisions ahead of writing them to @a stream.  The output will be
+ * identical to that of svn_repos_dump_fs4() and @a notify_func as well as
+ * @a cancel_func will still be called from the calling thread only.
+ *
+ * The workers open their own instances of @a repos, using @a fs_config.
+ * They call @a filter_func concurrently, so it must be thread-safe.
+ * For @a jobs greater than 1, the caches must not be configured as
+ * single-threaded, see svn_cache_config_t; otherwise, this fails with
+ * #SVN_ERR_REPOS_BAD_ARGS.
+ *
+ * If @a jobs is less than 2 or APR does not support threads, the dump
+ * runs in the calling thread only.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_repos__dump_fs(svn_repos_t *repos,
+                   svn_stream_t *stream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t incremental,
+                   svn_boolean_t use_deltas,
+                   svn_boolean_t include_revprops,
+                   svn_boolean_t include_changes,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_repos_dump_filter_func_t filter_func,
+                   void *filter_baton,
+                   int jobs,
+                   apr_hash_t *fs_config,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool);
+
+/**
+ * Like svn_repos_parse_dumpstream3() with @a deltas_are_text set to
+ * @c FALSE, but parse @a stream in a separate thread and decode text deltas
+ * in up to @a jobs - 2 further threads.  @a parse_fns will be invoked from
+ * the calling thread only, in the same order as before, which makes this
+ * suitable for svn_repos_get_fs_build_parser6() vtables.
+ *
+ * @a stream will be read from the parser thread while @a parse_fns run.
+ * Their pools must therefore not share an allocator that is not thread-safe.
+ * Node records outside of any revision record are rejected.
+ *
+ * If @a jobs is less than 2 or APR does not support threads, this is the
+ * same as svn_repos_parse_dumpstream3().
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      int jobs,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
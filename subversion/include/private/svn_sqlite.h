@@ -29,6 +29,7 @@
 #include "svn_types.h"
 #include "svn_checksum.h"
 #include "svn_error.h"
+#include "svn_io.h"
 
 #include "private/svn_token.h"  /* for svn_token_map_t  */
 
@@ -359,6 +360,26 @@ svn_sqlite__column_bytes(svn_sqlite__stmt_t *stmt, int column);
 void
 svn_sqlite__dbg_enable_errorlog(void);
 
+/* Start collecting execution statistics for the statements of DB: for
+   each statement the number of times it was executed, the number of rows
+   it returned and the total time spent stepping it.  Statements executed
+   with svn_sqlite__exec_statements() are not included.
+
+   Profiling is enabled automatically for every database opened while the
+   SVN_SQLITE_PROFILE environment variable is set.  The statistics are
+   then appended as a table to the file named by that variable when the
+   database is closed, or written to stderr if its value is "-". */
+void
+svn_sqlite__profile_enable(svn_sqlite__db_t *db);
+
+/* Write the statistics collected for DB as a table to STREAM, with one
+   line per executed statement, slowest first.  Do nothing if profiling
+   is not enabled for DB. */
+svn_error_t *
+svn_sqlite__profile_write(svn_stream_t *stream,
+                          svn_sqlite__db_t *db,
+                          apr_pool_t *scratch_pool);
+
 
 /* --------------------------------------------------------------------- */
 
@@ -295,6 +295,142 @@ svn_checksum__wrap_write_stream_fnv1a_32x4(apr_uint32_t *digest,
                                            svn_stream_t *inner_stream,
                                            apr_pool_t *pool);
 
+/**
+ * Opaque context that calculates the MD5 and, optionally, the SHA-1
+ * checksum over the same data.  This is faster than using two separate
+ * #svn_checksum_ctx_t because the data gets read from memory only once.
+ *
+ * @since New in 1.12.
+ */
+typedef struct svn_checksum__md5_sha1_ctx_t svn_checksum__md5_sha1_ctx_t;
+
+/**
+ * Return a new context calculating an MD5 checksum and, if @a with_sha1
+ * is set, a SHA-1 checksum.  Allocate it in @a pool.
+ *
+ * @since New in 1.12.
+ */
+svn_checksum__md5_sha1_ctx_t *
+svn_checksum__md5_sha1_ctx_create(svn_boolean_t with_sha1,
+                                  apr_pool_t *pool);
+
+/**
+ * Reset @a ctx to its initial state, as returned by
+ * svn_checksum__md5_sha1_ctx_create().
+ *
+ * @since New in 1.12.
+ */
+void
+svn_checksum__md5_sha1_ctx_reset(svn_checksum__md5_sha1_ctx_t *ctx);
+
+/**
+ * Feed @a len bytes from @a data into @a ctx.
+ *
+ * @since New in 1.12.
+ */
+void
+svn_checksum__md5_sha1_update(svn_checksum__md5_sha1_ctx_t *ctx,
+                              const void *data,
+                              apr_size_t len);
+
+/**
+ * Return the checksums over all data fed into @a ctx in @a *md5_checksum
+ * and @a *sha1_checksum, allocated in @a result_pool.  Either pointer may
+ * be @c NULL if that checksum is not wanted.  @a *sha1_checksum will be
+ * @c NULL if @a ctx has been created without SHA-1.  @a ctx must be reset
+ * before being used again.
+ *
+ * @since New in 1.12.
+ */
+void
+svn_checksum__md5_sha1_final(svn_checksum_t **md5_checksum,
+                             svn_checksum_t **sha1_checksum,
+                             svn_checksum__md5_sha1_ctx_t *ctx,
+                             apr_pool_t *result_pool);
+
+/**
+ * Return a stream that calculates the MD5 and the SHA-1 checksum over all
+ * data written to the @a inner_stream in a single pass.  When the returned
+ * stream gets closed, write the checksums to @a *md5_checksum and
+ * @a *sha1_checksum, respectively.  Either may be @c NULL.
+ * Allocate the result in @a pool.
+ *
+ * @note The stream returned only supports #svn_stream_write and
+ * #svn_stream_close.
+ *
+ * @since New in 1.12.
+ */
+svn_stream_t *
+svn_checksum__wrap_write_stream_md5_sha1(svn_checksum_t **md5_checksum,
+                                         svn_checksum_t **sha1_checksum,
+                                         svn_stream_t *inner_stream,
+                                         apr_pool_t *pool);
+
+/**
+ * A checksum calculation to be performed by svn_checksum__compute_batch().
+ * The caller fills in the input members; the others are being set by
+ * svn_checksum__compute_batch().
+ *
+ * @since New in 1.12.
+ */
+typedef struct svn_checksum__job_t
+{
+  /** File to read the data from. */
+  const char *abspath;
+
+  /** Offset of the data within the file. */
+  apr_off_t offset;
+
+  /** Number of bytes to process.  A negative value means "up to EOF". */
+  apr_off_t length;
+
+  /** Kind of checksum to calculate. */
+  svn_checksum_kind_t kind;
+
+  /** If set, calculate the MD5 checksum in the same pass as well.
+   * @a kind must then be #svn_checksum_sha1. */
+  svn_boolean_t with_md5;
+
+  /** Caller-provided data, not used by svn_checksum__compute_batch(). */
+  void *baton;
+
+  /** The checksum of kind @a kind over the data read. */
+  svn_checksum_t *checksum;
+
+  /** The MD5 checksum over the data read, if @a with_md5 had been set. */
+  svn_checksum_t *md5_checksum;
+
+  /** Number of bytes actually processed. */
+  apr_off_t size;
+
+  /** Error encountered while reading the data.  If set, the checksums
+   * are undefined.  The caller must clear it. */
+  svn_error_t *err;
+} svn_checksum__job_t;
+
+/**
+ * Perform all calculations given in @a jobs, an array of
+ * #svn_checksum__job_t *, using up to @a max_threads threads to work on
+ * independent jobs concurrently.  If @a max_threads is 0, use a default.
+ * The calling thread will process jobs as well; without thread support
+ * in APR, all jobs get processed sequentially.
+ *
+ * Errors that are specific to a job, e.g. missing files, are reported in
+ * that job's @c err member.  Only errors that prevent the batch as a
+ * whole from being processed are being returned.  Allocate the checksums
+ * in @a result_pool and use @a scratch_pool for temporaries.  Invoke
+ * @a cancel_func with @a cancel_baton between jobs in the calling thread.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_checksum__compute_batch(apr_array_header_t *jobs,
+                            int max_threads,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
 /**
  * Return a 32 bit FNV-1a checksum for the first @a len bytes in @a input.
  *
@@ -607,10 +743,34 @@ svn__decompress_lz4(const void *data, apr_size_t len,
 typedef struct svn_root_pools__t svn_root_pools__t;
 
 /* Create a new root pools container and return it in *POOLS.
+ *
+ * Each thread keeps the pool it released last for its next acquisition.
+ * All other released pools go into a shared list of at most MAX_UNUSED
+ * entries; pools released while that list is full get destroyed.  The
+ * allocator of every pool retains at most MAX_FREE bytes of free memory.
+ * Pass 0 for either limit to use the default.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_root_pools__create2(svn_root_pools__t **pools,
+                        int max_unused,
+                        apr_size_t max_free);
+
+/* Same as svn_root_pools__create2() with default limits.
  */
 svn_error_t *
 svn_root_pools__create(svn_root_pools__t **pools);
 
+/* Destroy POOLS and all unused pools in it, including the one cached by
+ * the calling thread.  All other threads that used POOLS must have
+ * terminated and all acquired pools must have been released before.
+ *
+ * @since New in 1.12.
+ */
+void
+svn_root_pools__destroy(svn_root_pools__t *pools);
+
 /* Return a currently unused pool from POOLS.  If POOLS is empty, create a
  * new root pool and return that.  The pool returned is not thread-safe.
  */
@@ -624,6 +784,88 @@ void
 svn_root_pools__release_pool(apr_pool_t *pool,
                              svn_root_pools__t *pools);
 
+/* Usage statistics of a root pools container.
+ *
+ * @since New in 1.12.
+ */
+typedef struct svn_root_pools__info_t
+{
+  /* Number of pools acquired so far. */
+  apr_uint64_t acquired;
+
+  /* Number of acquisitions served from the calling thread's cache. */
+  apr_uint64_t thread_hits;
+
+  /* Number of root pools created so far. */
+  apr_uint64_t created;
+
+  /* Number of released pools destroyed because of the MAX_UNUSED limit. */
+  apr_uint64_t reclaimed;
+
+  /* Number of pools currently acquired. */
+  apr_size_t in_use;
+
+  /* Number of pools in the shared list of unused pools. */
+  apr_size_t unused;
+
+  /* Number of unused pools cached by individual threads. */
+  apr_size_t thread_cached;
+
+  /* The limits that the container has been created with. */
+  int max_unused;
+  apr_size_t max_free;
+
+  /* Upper limit to the free memory retained by all unused pools. */
+  apr_uint64_t max_retained;
+} svn_root_pools__info_t;
+
+/* Return the current usage statistics of POOLS, allocated in
+ * RESULT_POOL.
+ *
+ * @since New in 1.12.
+ */
+svn_root_pools__info_t *
+svn_root_pools__get_info(svn_root_pools__t *pools,
+                         apr_pool_t *result_pool);
+
+/* Return the statistics in INFO as multi-line text, allocated in
+ * RESULT_POOL, in the same style as svn_cache__format_info().
+ *
+ * @since New in 1.12.
+ */
+svn_string_t *
+svn_root_pools__format_info(const svn_root_pools__info_t *info,
+                            apr_pool_t *result_pool);
+
+/**
+ * Return a pool to be used like a sub-pool of @a parent_pool, typically
+ * as an iteration pool in a hot loop.  Its lifetime ends when it is passed
+ * to svn_pool__destroy_arena() or when @a parent_pool gets cleared or
+ * destroyed, whichever happens first.
+ *
+ * Arenas are sub-pools of @a parent_pool that take their memory from a
+ * per-thread allocator, which caches free blocks and requires no locking.
+ * Creating and clearing one is therefore cheaper than for a standard
+ * sub-pool and it usually comes with memory ready for use.
+ *
+ * The arena must only be used, cleared and destroyed by the thread that
+ * created it and @a parent_pool must be cleared and destroyed by that
+ * thread as well.
+ *
+ * @since New in 1.12.
+ */
+apr_pool_t *
+svn_pool__create_arena(apr_pool_t *parent_pool);
+
+/**
+ * Release @a arena_pool, which has been returned by svn_pool__create_arena(),
+ * similar to svn_pool_destroy().
+ *
+ * @since New in 1.12.
+ */
+void
+svn_pool__destroy_arena(apr_pool_t *arena_pool);
+
 /** @} */
 
 /**
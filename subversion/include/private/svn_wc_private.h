@@ -1024,7 +1024,8 @@ svn_wc__node_get_md5_from_sha1(const svn_checksum_t **md5_checksum,
 /* Like svn_wc_get_pristine_contents2(), but keyed on the CHECKSUM
    rather than on the local absolute path of the working file.
    WRI_ABSPATH is any versioned path of the working copy in whose
-   pristine database we'll be looking for these contents.  */
+   pristine database we'll be looking for these contents.  If they are
+   not there, look in the shared pristine store, if configured.  */
 svn_error_t *
 svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
                                           svn_wc_context_t *wc_ctx,
@@ -1559,6 +1560,63 @@ svn_wc__get_switch_editor(const svn_delta_editor_t **editor,
                           apr_pool_t *result_pool,
                           apr_pool_t *scratch_pool);
 
+/**
+ * Callback for svn_wc__hydrate(): write the text of the file
+ * @a repos_relpath in @a revision of the repository at @a repos_root_url
+ * to @a stream.  Don't close @a stream.
+ *
+ * @since New in 1.12.
+ */
+typedef svn_error_t *(*svn_wc__fetch_text_func_t)(void *baton,
+                                                  svn_stream_t *stream,
+                                                  const char *repos_root_url,
+                                                  const char *repos_relpath,
+                                                  svn_revnum_t revision,
+                                                  apr_pool_t *scratch_pool);
+
+/**
+ * Set @a *local_abspaths to an array of const char * absolute paths of all
+ * files within @a depth of @a local_abspath that were added without their
+ * text, allocated in @a result_pool.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_wc__get_unfetched(apr_array_header_t **local_abspaths,
+                      svn_wc_context_t *wc_ctx,
+                      const char *local_abspath,
+                      svn_depth_t depth,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool);
+
+/**
+ * Fetch the text of all files within @a depth of @a local_abspath that
+ * were added without their text, as done when the @c lazy-fetch option
+ * is set, using @a fetch_text_func with @a fetch_text_baton.  Install
+ * the texts in the pristine store and create the missing working files,
+ * using the last-commit-time for their timestamps if
+ * @a use_commit_times is TRUE.
+ *
+ * Notify #svn_wc_notify_text_fetched for each file using @a notify_func
+ * with @a notify_baton, if not NULL.
+ *
+ * The caller must hold a write lock on @a local_abspath.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_wc__hydrate(svn_wc_context_t *wc_ctx,
+                const char *local_abspath,
+                svn_depth_t depth,
+                svn_boolean_t use_commit_times,
+                svn_wc__fetch_text_func_t fetch_text_func,
+                void *fetch_text_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                svn_wc_notify_func2_t notify_func,
+                void *notify_baton,
+                apr_pool_t *scratch_pool);
+
 
 
 /**
@@ -2110,6 +2168,50 @@ svn_wc__translated_stream(svn_stream_t **stream,
                           apr_pool_t *result_pool,
                           apr_pool_t *scratch_pool);
 
+/**
+ * Name of the journal in the administrative area of a working copy root,
+ * in which a file system watcher records the directories whose entries
+ * changed on disk.  The status walk uses it to skip reading directories
+ * that did not change since the previous walk.
+ *
+ * The first line of the journal is #SVN_WC__WATCH_JOURNAL_HEADER followed
+ * by a space and a session identifier without spaces that is unique to
+ * this run of the watcher.  Each further line is the wcroot-relative path
+ * of a changed directory (the empty line for the root),
+ * #SVN_WC__WATCH_JOURNAL_OVERFLOW if the watcher may have missed changes
+ * or #SVN_WC__WATCH_JOURNAL_COOKIE followed by the name of a cookie file.
+ * Lines are terminated by a single '\n' and only appended.
+ *
+ * The watcher ignores the administrative area, except for the creation of
+ * files named #SVN_WC__WATCH_COOKIE_PREFIX followed by anything in the
+ * administrative area of the root.  Once their entries appear in the
+ * journal, the watcher has journaled all changes that happened before.
+ *
+ * The watcher holds an exclusive lock on the journal while it runs.  A
+ * journal that is not locked is stale and ignored.
+ *
+ * @since New in 1.12.
+ */
+#define SVN_WC__WATCH_JOURNAL "watch-journal"
+
+/** First word and format number of #SVN_WC__WATCH_JOURNAL.
+ * @since New in 1.12. */
+#define SVN_WC__WATCH_JOURNAL_HEADER "SVN-watch-journal 1"
+
+/** Entry in #SVN_WC__WATCH_JOURNAL after which the status walk has to read
+ * every directory again.
+ * @since New in 1.12. */
+#define SVN_WC__WATCH_JOURNAL_OVERFLOW "!"
+
+/** Start of the entries in #SVN_WC__WATCH_JOURNAL that record the
+ * creation of cookie files.  No relpath starts with it.
+ * @since New in 1.12. */
+#define SVN_WC__WATCH_JOURNAL_COOKIE "/"
+
+/** Start of the names of cookie files, see #SVN_WC__WATCH_JOURNAL.
+ * @since New in 1.12. */
+#define SVN_WC__WATCH_COOKIE_PREFIX "watch-cookie"
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -4316,6 +4316,33 @@ svn_client_upgrade(const char *wcroot_dir,
 
 /** @} */
 
+/**
+ * @defgroup Hydrate Fetch the text of files added without it.
+ *
+ * @{
+ */
+
+/** Fetch the text of all files within @a depth of each of the working
+ * copy @a paths that were checked out or updated without their text, as
+ * done when the @c lazy-fetch option in the @c working-copy section of
+ * the configuration is set, and create their working files.  After this
+ * the files are like any other versioned file.
+ *
+ * If @a ctx->notify_func2 is not NULL, call it with @a ctx->notify_baton2
+ * and an #svn_wc_notify_text_fetched notification for each file.
+ *
+ * Use @a scratch_pool for any temporary allocations.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_client_hydrate(const apr_array_header_t *paths,
+                   svn_depth_t depth,
+                   svn_client_ctx_t *ctx,
+                   apr_pool_t *scratch_pool);
+
+/** @} */
+
 /**
  * @defgroup Relocate Switch a working copy to a different repository.
  *
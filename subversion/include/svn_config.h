@@ -112,6 +112,8 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS      "http-max-connections"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS     "http-chunked-requests"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_HTTP_PIPELINED_COMMITS    "http-pipelined-commits"
 
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SERF_LOG_COMPONENTS       "serf-log-components"
@@ -171,6 +173,20 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SQLITE_EXCLUSIVE_CLIENTS  "exclusive-locking-clients"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SQLITE_BUSY_TIMEOUT       "busy-timeout"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_INSTALL_THREADS           "install-threads"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_UPDATE_BATCH_SIZE         "update-batch-size"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_PRISTINE_CHUNKING         "pristine-chunking"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE     "shared-pristine-store"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_COMPARE_BY_CHECKSUM       "compare-by-checksum"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_INCREMENTAL_VACUUM        "incremental-vacuum"
+/** @since New in 1.12. */
+#define SVN_CONFIG_OPTION_LAZY_FETCH                "lazy-fetch"
 /** @} */
 
 /** @name Repository conf directory configuration files strings
@@ -2339,6 +2339,22 @@ svn_fs_dir_optimal_order(apr_array_header_t **ordered_p,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
+/** Hint to @a root's filesystem that the nodes given by the APR array
+ * of #svn_fs_dirent_t * @a entries, as returned e.g. by
+ * #svn_fs_dir_optimal_order, as well as the contents of any directories
+ * among them are about to be read.  The backend may then read them in
+ * a single, efficient pass and keep them in its caches.  Backends not
+ * supporting this will simply do nothing.
+ *
+ * Use @a scratch_pool for temporaries.
+ *
+ * @since New in 1.12.
+ */
+svn_error_t *
+svn_fs_dir_prefetch(svn_fs_root_t *root,
+                    const apr_array_header_t *entries,
+                    apr_pool_t *scratch_pool);
+
 /** Create a new directory named @a path in @a root.  The new directory has
  * no entries, and no properties.  @a root must be the root of a transaction,
  * not a revision.
@@ -71,6 +71,9 @@ extern "C" {
 #define SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE "file-revs-reverse"
 /* maps to SVN_RA_CAPABILITY_LIST */
 #define SVN_RA_SVN_CAP_LIST "list"
+/* server supports the get-blame command; not mapped to any public
+   SVN_RA_CAPABILITY_* */
+#define SVN_RA_SVN_CAP_BLAME "blame"
 
 
 /** ra_svn passes @c svn_dirent_t fields over the wire as a list of
@@ -1303,7 +1303,25 @@ typedef enum svn_wc_notify_action_t
 
   /** Done searching the repository for details about a conflict.
    * @since New in 1.10. */
-  svn_wc_notify_end_search_tree_conflict_details
+  svn_wc_notify_end_search_tree_conflict_details,
+
+  /** Progressing in removing unreferenced pristine texts during cleanup.
+   * The number of texts removed so far and the total number of texts to
+   * remove are in #svn_wc_notify_t.progress and
+   * #svn_wc_notify_t.progress_total.
+   * @since New in 1.12. */
+  svn_wc_notify_cleanup_pristines_progress,
+
+  /** Progressing in releasing the unused space of the working copy
+   * database during cleanup.  The number of database pages released so
+   * far and the total number of pages to release are in
+   * #svn_wc_notify_t.progress and #svn_wc_notify_t.progress_total.
+   * @since New in 1.12. */
+  svn_wc_notify_cleanup_vacuum_progress,
+
+  /** The text of a file that was added without it was fetched.
+   * @since New in 1.12. */
+  svn_wc_notify_text_fetched
 
 } svn_wc_notify_action_t;
 
@@ -1489,6 +1507,15 @@ typedef struct svn_wc_notify_t {
    * @since New in 1.7 */
   svn_linenum_t hunk_fuzz;
 
+  /** When @c action is #svn_wc_notify_cleanup_pristines_progress or
+   * #svn_wc_notify_cleanup_vacuum_progress, the number of items processed
+   * so far and the total number of items to process.
+   * @since New in 1.12. */
+  /* @{ */
+  apr_int64_t progress;
+  apr_int64_t progress_total;
+  /* @} */
+
   /* NOTE: Add new fields at the end to preserve binary compatibility.
      Also, if you add fields here, you have to update svn_wc_create_notify
      and svn_wc_dup_notify. */
@@ -7346,10 +7373,11 @@ svn_wc_get_pristine_copy_path(const char *path,
  * #SVN_ERR_CANCELLED), return that error immediately.
  *
  * If @a notify_func is non-NULL, invoke it with @a notify_baton to report
- * the progress of the operation.
+ * the progress of the operation.  Removing unreferenced pristines reports
+ * #svn_wc_notify_cleanup_pristines_progress and releasing unused space of
+ * the working copy database reports #svn_wc_notify_cleanup_vacuum_progress.
  *
- * @note In 1.9, @a notify_func does not get called at all.  This may change
- * in later releases.
+ * @note In 1.9 - 1.11, @a notify_func does not get called at all.
  *
  * @since New in 1.9.
  */
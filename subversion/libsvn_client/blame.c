@@ -37,6 +37,7 @@
 #include "svn_hash.h"
 #include "svn_sorts.h"
 
+#include "private/svn_ra_private.h"
 #include "private/svn_wc_private.h"
 
 #include "svn_private_config.h"
@@ -58,6 +59,16 @@ struct blame
   const struct rev *rev;    /* the responsible revision */
   apr_off_t start;          /* the starting diff-token (line) */
   struct blame *next;       /* the next chunk */
+
+  /* The chunks of a chain also form a treap ordered by START, such that
+     finding a chunk and shifting all chunks following it take O(log n)
+     instead of O(n).  ADJUST is a shift already applied to this chunk's
+     START but still pending for all chunks in the LEFT and RIGHT
+     sub-trees. */
+  struct blame *left;       /* sub-tree of chunks before this one */
+  struct blame *right;      /* sub-tree of chunks after this one */
+  apr_off_t adjust;         /* shift pending for the sub-trees */
+  apr_uint32_t priority;    /* random heap priority within the treap */
 };
 
 /* A chain of blame chunks */
@@ -65,6 +76,8 @@ struct blame_chain
 {
   struct blame *blame;      /* linked list of blame chunks */
   struct blame *avail;      /* linked list of free blame chunks */
+  struct blame *root;       /* treap of the chunks in BLAME */
+  apr_uint32_t seed;        /* state of the treap priority generator */
   struct apr_pool_t *pool;  /* Allocate members from this pool. */
 };
 
@@ -141,6 +154,16 @@ blame_create(struct blame_chain *chain,
   blame->rev = rev;
   blame->start = start;
   blame->next = NULL;
+
+  /* Xorshift is plenty random for balancing the treap. */
+  chain->seed ^= chain->seed << 13;
+  chain->seed ^= chain->seed >> 17;
+  chain->seed ^= chain->seed << 5;
+
+  blame->left = NULL;
+  blame->right = NULL;
+  blame->adjust = 0;
+  blame->priority = chain->seed;
   return blame;
 }
 
@@ -153,33 +176,160 @@ blame_destroy(struct blame_chain *chain,
   chain->avail = blame;
 }
 
-/* Return the blame chunk that contains token OFF, starting the search at
-   BLAME. */
+/* Apply the shift pending in BLAME to the roots of its sub-trees. */
+static void
+blame_push_down(struct blame *blame)
+{
+  if (blame->adjust == 0)
+    return;
+
+  if (blame->left)
+    {
+      blame->left->start += blame->adjust;
+      blame->left->adjust += blame->adjust;
+    }
+  if (blame->right)
+    {
+      blame->right->start += blame->adjust;
+      blame->right->adjust += blame->adjust;
+    }
+  blame->adjust = 0;
+}
+
+/* Split the treap TREE into *LEFT, containing all chunks that start
+   before token START, and *RIGHT, containing the others. */
+static void
+blame_split(struct blame **left,
+            struct blame **right,
+            struct blame *tree,
+            apr_off_t start)
+{
+  if (!tree)
+    {
+      *left = NULL;
+      *right = NULL;
+    }
+  else
+    {
+      blame_push_down(tree);
+      if (tree->start < start)
+        {
+          blame_split(&tree->right, right, tree->right, start);
+          *left = tree;
+        }
+      else
+        {
+          blame_split(left, &tree->left, tree->left, start);
+          *right = tree;
+        }
+    }
+}
+
+/* Return the treap containing the chunks of LEFT and RIGHT.  All chunks
+   in LEFT must start before those in RIGHT. */
 static struct blame *
-blame_find(struct blame *blame, apr_off_t off)
+blame_merge(struct blame *left,
+            struct blame *right)
 {
-  struct blame *prev = NULL;
-  while (blame)
+  if (!left)
+    return right;
+  if (!right)
+    return left;
+
+  if (left->priority > right->priority)
+    {
+      blame_push_down(left);
+      left->right = blame_merge(left->right, right);
+      return left;
+    }
+  else
     {
-      if (blame->start > off) break;
-      prev = blame;
-      blame = blame->next;
+      blame_push_down(right);
+      right->left = blame_merge(left, right->left);
+      return right;
     }
-  return prev;
 }
 
-/* Shift the start-point of BLAME and all subsequence blame-chunks
-   by ADJUST tokens */
+/* Add the new chunk BLAME to the treap of CHAIN. */
+static void
+blame_tree_insert(struct blame_chain *chain,
+                  struct blame *blame)
+{
+  struct blame *left, *right;
+
+  blame_split(&left, &right, chain->root, blame->start);
+  chain->root = blame_merge(blame_merge(left, blame), right);
+}
+
+/* Remove all chunks that start at or after token START but before
+   token END from the treap of CHAIN.  The chunks remain in the list. */
 static void
-blame_adjust(struct blame *blame, apr_off_t adjust)
+blame_tree_remove(struct blame_chain *chain,
+                  apr_off_t start,
+                  apr_off_t end)
 {
-  while (blame)
+  struct blame *left, *middle, *right;
+
+  blame_split(&left, &middle, chain->root, start);
+  blame_split(&middle, &right, middle, end);
+  chain->root = blame_merge(left, right);
+}
+
+/* Apply all pending shifts in TREE, such that the START values of all
+   its chunks are up to date. */
+static void
+blame_tree_flush(struct blame *tree)
+{
+  if (tree)
     {
-      blame->start += adjust;
-      blame = blame->next;
+      blame_push_down(tree);
+      blame_tree_flush(tree->left);
+      blame_tree_flush(tree->right);
     }
 }
 
+/* Return the blame chunk in CHAIN that contains token OFF.  The START
+   of the chunk returned will be up to date. */
+static struct blame *
+blame_find(struct blame_chain *chain, apr_off_t off)
+{
+  struct blame *tree = chain->root;
+  struct blame *found = NULL;
+
+  while (tree)
+    {
+      blame_push_down(tree);
+      if (tree->start > off)
+        {
+          tree = tree->left;
+        }
+      else
+        {
+          found = tree;
+          tree = tree->right;
+        }
+    }
+
+  return found;
+}
+
+/* Shift the start-point of all blame-chunks in CHAIN that start at or
+   after token START by ADJUST tokens.  The order of chunks must not
+   change by that. */
+static void
+blame_adjust(struct blame_chain *chain, apr_off_t start, apr_off_t adjust)
+{
+  struct blame *left, *right;
+
+  blame_split(&left, &right, chain->root, start);
+  if (right)
+    {
+      right->start += adjust;
+      right->adjust += adjust;
+    }
+  chain->root = blame_merge(left, right);
+}
+
 /* Delete the blame associated with the region from token START to
    START + LENGTH */
 static svn_error_t *
@@ -187,13 +337,16 @@ blame_delete_range(struct blame_chain *chain,
                    apr_off_t start,
                    apr_off_t length)
 {
-  struct blame *first = blame_find(chain->blame, start);
-  struct blame *last = blame_find(chain->blame, start + length);
-  struct blame *tail = last->next;
+  struct blame *first = blame_find(chain, start);
+  struct blame *last = blame_find(chain, start + length);
 
   if (first != last)
     {
+      svn_boolean_t first_deleted = (first->start == start);
       struct blame *walk = first->next;
+
+      /* Drop all chunks that lie entirely within the range. */
+      blame_tree_remove(chain, first->start + 1, last->start);
       while (walk != last)
         {
           struct blame *next = walk->next;
@@ -201,23 +354,24 @@ blame_delete_range(struct blame_chain *chain,
           walk = next;
         }
       first->next = last;
-      last->start = start;
-      if (first->start == start)
+
+      if (first_deleted)
         {
-          *first = *last;
+          /* Let FIRST take over what remains of LAST. */
+          blame_tree_remove(chain, last->start, last->start + 1);
+          first->rev = last->rev;
+          first->next = last->next;
           blame_destroy(chain, last);
-          last = first;
+        }
+      else
+        {
+          /* The remainder of LAST begins where the range ends.
+             It will be moved to START together with all that follows. */
+          last->start = start + length;
         }
     }
 
-  if (tail && tail->start == last->start + length)
-    {
-      *last = *tail;
-      blame_destroy(chain, tail);
-      tail = last->next;
-    }
-
-  blame_adjust(tail, -length);
+  blame_adjust(chain, start + length, -length);
 
   return SVN_NO_ERROR;
 }
@@ -230,16 +384,19 @@ blame_insert_range(struct blame_chain *chain,
                    apr_off_t start,
                    apr_off_t length)
 {
-  struct blame *head = chain->blame;
-  struct blame *point = blame_find(head, start);
+  struct blame *point = blame_find(chain, start);
   struct blame *insert;
 
+  /* Make room for the new chunk by moving everything behind POINT. */
+  blame_adjust(chain, start + 1, length);
+
   if (point->start == start)
     {
-      insert = blame_create(chain, point->rev, point->start + length);
+      insert = blame_create(chain, point->rev, start + length);
       point->rev = rev;
       insert->next = point->next;
       point->next = insert;
+      blame_tree_insert(chain, insert);
     }
   else
     {
@@ -249,8 +406,9 @@ blame_insert_range(struct blame_chain *chain,
       middle->next = insert;
       insert->next = point->next;
       point->next = middle;
+      blame_tree_insert(chain, middle);
+      blame_tree_insert(chain, insert);
     }
-  blame_adjust(insert->next, length);
 
   return SVN_NO_ERROR;
 }
@@ -299,6 +457,7 @@ add_file_blame(const char *last_file,
     {
       SVN_ERR_ASSERT(chain->blame == NULL);
       chain->blame = blame_create(chain, rev, 0);
+      chain->root = chain->blame;
     }
   else
     {
@@ -591,6 +750,98 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
   return SVN_NO_ERROR;
 }
 
+/* The baton used with server_blame_receiver. */
+struct server_blame_baton {
+  struct file_rev_baton *file_rev_baton;
+  struct blame *last;    /* the last chunk added to the chain */
+  apr_hash_t *revs;      /* maps svn_revnum_t to struct rev * */
+};
+
+/* Implements svn_ra__blame_receiver_t, appending a chunk for REVISION
+   to the blame chain of BATON, a struct server_blame_baton. */
+static svn_error_t *
+server_blame_receiver(void *baton,
+                      apr_int64_t start_line,
+                      apr_int64_t line_count,
+                      svn_revnum_t revision,
+                      apr_hash_t *rev_props,
+                      apr_pool_t *scratch_pool)
+{
+  struct server_blame_baton *sbb = baton;
+  struct file_rev_baton *frb = sbb->file_rev_baton;
+  struct rev *rev;
+  struct blame *blame;
+
+  if (frb->ctx->cancel_func)
+    SVN_ERR(frb->ctx->cancel_func(frb->ctx->cancel_baton));
+
+  rev = apr_hash_get(sbb->revs, &revision, sizeof(revision));
+  if (!rev)
+    {
+      rev = apr_pcalloc(frb->mainpool, sizeof(*rev));
+      rev->revision = revision;
+      if (rev_props)
+        rev->rev_props = svn_prop_hash_dup(rev_props, frb->mainpool);
+      apr_hash_set(sbb->revs, &rev->revision, sizeof(rev->revision), rev);
+    }
+
+  blame = blame_create(frb->chain, rev, start_line);
+  if (sbb->last)
+    sbb->last->next = blame;
+  else
+    frb->chain->blame = blame;
+  blame_tree_insert(frb->chain, blame);
+  sbb->last = blame;
+
+  return SVN_NO_ERROR;
+}
+
+/* Let the server behind RA_SESSION compute the blame chain of FRB for
+   the revisions START_REVNUM to END_REVNUM and fetch the text of
+   END_REVNUM.  Return SVN_ERR_UNSUPPORTED_FEATURE if the server can't
+   do that.  Use POOL for temporary allocations. */
+static svn_error_t *
+blame_on_server(struct file_rev_baton *frb,
+                svn_ra_session_t *ra_session,
+                svn_revnum_t start_revnum,
+                svn_revnum_t end_revnum,
+                apr_pool_t *pool)
+{
+  struct server_blame_baton sbb;
+  svn_stream_t *stream;
+  const char *filename;
+
+  sbb.file_rev_baton = frb;
+  sbb.last = NULL;
+  sbb.revs = apr_hash_make(pool);
+
+  SVN_ERR(svn_ra__get_blame(ra_session, "", start_revnum, end_revnum,
+                            frb->diff_options, server_blame_receiver, &sbb,
+                            pool));
+
+  /* An empty file has no chunks.  Still, local modifications need a
+     chain to be applied to. */
+  if (!frb->chain->blame)
+    {
+      struct rev *rev = apr_pcalloc(frb->mainpool, sizeof(*rev));
+
+      rev->revision = SVN_INVALID_REVNUM;
+      frb->chain->blame = blame_create(frb->chain, rev, 0);
+      frb->chain->root = frb->chain->blame;
+    }
+
+  /* The blame receiver will need the lines themselves. */
+  SVN_ERR(svn_stream_open_unique(&stream, &filename, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 frb->mainpool, pool));
+  SVN_ERR(svn_ra_get_file(ra_session, "", end_revnum, stream, NULL, NULL,
+                          pool));
+  SVN_ERR(svn_stream_close(stream));
+  frb->last_filename = filename;
+
+  return SVN_NO_ERROR;
+}
+
 /* Ensure that CHAIN_ORIG and CHAIN_MERGED have the same number of chunks,
    and that for every chunk C, CHAIN_ORIG[C] and CHAIN_MERGED[C] have the
    same starting value.  Both CHAIN_ORIG and CHAIN_MERGED should not be
@@ -779,12 +1030,16 @@ svn_client_blame5(const char *target,
   frb.chain = apr_palloc(pool, sizeof(*frb.chain));
   frb.chain->blame = NULL;
   frb.chain->avail = NULL;
+  frb.chain->root = NULL;
+  frb.chain->seed = 2463534242U;
   frb.chain->pool = pool;
   if (include_merged_revisions)
     {
       frb.merged_chain = apr_palloc(pool, sizeof(*frb.merged_chain));
       frb.merged_chain->blame = NULL;
       frb.merged_chain->avail = NULL;
+      frb.merged_chain->root = NULL;
+      frb.merged_chain->seed = 2463534242U;
       frb.merged_chain->pool = pool;
     }
   frb.backwards = (frb.start_rev > frb.end_rev);
@@ -806,22 +1061,49 @@ svn_client_blame5(const char *target,
       frb.prevfilepool = svn_pool_create(pool);
     }
 
+  /* Servers that can do it themselves send only the final blame chunks,
+     saving us all the intermediate file contents. */
+  if (!include_merged_revisions && !frb.backwards)
+    {
+      svn_error_t *err = blame_on_server(&frb, ra_session, start_revnum,
+                                         end_revnum, pool);
+
+      if (err && (err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE
+                  || err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED))
+        {
+          svn_error_clear(err);
+          frb.chain->blame = NULL;
+          frb.chain->root = NULL;
+          frb.last_filename = NULL;
+        }
+      else
+        SVN_ERR(err);
+    }
+
   /* Collect all blame information.
      We need to ensure that we get one revision before the start_rev,
      if available so that we can know what was actually changed in the start
      revision. */
-  SVN_ERR(svn_ra_get_file_revs2(ra_session, "",
-                                frb.backwards ? start_revnum
-                                              : MAX(0, start_revnum-1),
-                                end_revnum,
-                                include_merged_revisions,
-                                file_rev_handler, &frb, pool));
+  if (!frb.last_filename)
+    SVN_ERR(svn_ra_get_file_revs2(ra_session, "",
+                                  frb.backwards ? start_revnum
+                                                : MAX(0, start_revnum-1),
+                                  end_revnum,
+                                  include_merged_revisions,
+                                  file_rev_handler, &frb, pool));
 
   if (end->kind == svn_opt_revision_working)
     {
       /* If the local file is modified we have to call the handler on the
          working copy file with keywords unexpanded */
       svn_wc_status3_t *status;
+      svn_boolean_t sleep_needed = FALSE;
+
+      /* Fetch the text first if the file was added without it */
+      SVN_ERR(svn_client__hydrate(&sleep_needed, target_abspath_or_url,
+                                  svn_depth_empty, ctx, pool));
+      if (sleep_needed)
+        svn_io_sleep_for_timestamps(target_abspath_or_url, pool);
 
       SVN_ERR(svn_wc_status3(&status, ctx->wc_ctx, target_abspath_or_url, pool,
                              pool));
@@ -891,6 +1173,12 @@ svn_client_blame5(const char *target,
   stream = svn_subst_stream_translated(last_stream,
                                        "\n", TRUE, NULL, FALSE, pool);
 
+  /* From here on, we only walk the chunk lists.  Make their START
+     values final. */
+  blame_tree_flush(frb.chain->root);
+  if (include_merged_revisions)
+    blame_tree_flush(frb.merged_chain->root);
+
   /* Perform optional merged chain normalization. */
   if (include_merged_revisions)
     {
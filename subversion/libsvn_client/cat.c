@@ -216,6 +216,17 @@ svn_client_cat3(apr_hash_t **returned_props,
 
       SVN_ERR(svn_dirent_get_absolute(&local_abspath, path_or_url,
                                       scratch_pool));
+
+      /* Fetch the text first if the file was added without it */
+      {
+        svn_boolean_t sleep_needed = FALSE;
+
+        SVN_ERR(svn_client__hydrate(&sleep_needed, local_abspath,
+                                    svn_depth_empty, ctx, scratch_pool));
+        if (sleep_needed)
+          svn_io_sleep_for_timestamps(local_abspath, scratch_pool);
+      }
+
       SVN_ERR(svn_client__get_normalized_stream(&normal_stream, ctx->wc_ctx,
                                             local_abspath, revision,
                                             expand_keywords, FALSE,
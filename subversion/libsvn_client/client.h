@@ -592,6 +592,28 @@ svn_client__switch_internal(svn_revnum_t *result_rev,
                             svn_client_ctx_t *ctx,
                             apr_pool_t *pool);
 
+/* Fetch the text of all files within DEPTH of the working copy path
+   LOCAL_ABSPATH that were added without it, as done when the lazy-fetch
+   option is set.  A write lock will be acquired and released.
+
+   Set *TIMESTAMP_SLEEP to TRUE if a sleep is required; otherwise do not
+   change *TIMESTAMP_SLEEP.  */
+svn_error_t *
+svn_client__hydrate(svn_boolean_t *timestamp_sleep,
+                    const char *local_abspath,
+                    svn_depth_t depth,
+                    svn_client_ctx_t *ctx,
+                    apr_pool_t *scratch_pool);
+
+/* Like svn_client__hydrate(), but for callers that already hold a write
+   lock on LOCAL_ABSPATH.  */
+svn_error_t *
+svn_client__hydrate_locked(svn_boolean_t *timestamp_sleep,
+                           const char *local_abspath,
+                           svn_depth_t depth,
+                           svn_client_ctx_t *ctx,
+                           apr_pool_t *scratch_pool);
+
 /* ---------------------------------------------------------------- */
 
 
@@ -1461,6 +1461,16 @@ svn_client_export5(svn_revnum_t *result_rev,
 
       SVN_ERR(svn_dirent_get_absolute(&to_path, to_path, pool));
 
+      /* Fetch the text of files that were added without it */
+      {
+        svn_boolean_t sleep_needed = FALSE;
+
+        SVN_ERR(svn_client__hydrate(&sleep_needed, from_path_or_url, depth,
+                                    ctx, pool));
+        if (sleep_needed)
+          svn_io_sleep_for_timestamps(from_path_or_url, pool);
+      }
+
       SVN_ERR(svn_io_check_path(from_path_or_url, &kind, pool));
 
       /* ### [JAF] If something already exists on disk at the destination path,
@@ -0,0 +1,213 @@
+/*
+ * hydrate.c:  fetch the text of files added without it
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include <string.h>
+
+#include "svn_wc.h"
+#include "svn_client.h"
+#include "svn_config.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_path.h"
+#include "svn_pools.h"
+#include "svn_ra.h"
+#include "client.h"
+
+#include "svn_private_config.h"
+#include "private/svn_wc_private.h"
+
+
+/*** Code. ***/
+
+/* Baton for fetch_text() */
+struct fetch_text_baton
+{
+  /* A session to the root of REPOS_ROOT_URL, or NULL if not opened yet */
+  svn_ra_session_t *ra_session;
+  const char *repos_root_url;
+
+  /* The working copy path being hydrated */
+  const char *local_abspath;
+
+  svn_client_ctx_t *ctx;
+
+  /* Pool for the session */
+  apr_pool_t *pool;
+};
+
+/* Implements svn_wc__fetch_text_func_t by reading the text through a
+   session to the repository root, which is reused as long as the files
+   are from the same repository. */
+static svn_error_t *
+fetch_text(void *baton,
+           svn_stream_t *stream,
+           const char *repos_root_url,
+           const char *repos_relpath,
+           svn_revnum_t revision,
+           apr_pool_t *scratch_pool)
+{
+  struct fetch_text_baton *b = baton;
+
+  if (!b->ra_session || strcmp(b->repos_root_url, repos_root_url) != 0)
+    {
+      b->repos_root_url = apr_pstrdup(b->pool, repos_root_url);
+      SVN_ERR(svn_client__open_ra_session_internal(&b->ra_session, NULL,
+                                                   b->repos_root_url,
+                                                   b->local_abspath, NULL,
+                                                   FALSE, TRUE, b->ctx,
+                                                   b->pool, scratch_pool));
+    }
+
+  SVN_ERR(svn_ra_get_file(b->ra_session, repos_relpath, revision,
+                          svn_stream_disown(stream, scratch_pool),
+                          NULL, NULL, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch the unfetched files within DEPTH of LOCAL_ABSPATH, on which the
+   caller holds a write lock.  Set *TIMESTAMP_SLEEP to TRUE. */
+static svn_error_t *
+hydrate_internal(svn_boolean_t *timestamp_sleep,
+                 const char *local_abspath,
+                 svn_depth_t depth,
+                 svn_client_ctx_t *ctx,
+                 apr_pool_t *scratch_pool)
+{
+  struct fetch_text_baton b;
+  svn_boolean_t use_commit_times;
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+
+  /* See if the user wants last-commit timestamps instead of current ones. */
+  SVN_ERR(svn_config_get_bool(cfg, &use_commit_times,
+                              SVN_CONFIG_SECTION_MISCELLANY,
+                              SVN_CONFIG_OPTION_USE_COMMIT_TIMES, FALSE));
+
+  b.ra_session = NULL;
+  b.repos_root_url = NULL;
+  b.local_abspath = local_abspath;
+  b.ctx = ctx;
+  b.pool = scratch_pool;
+
+  /* Any working files are created from here on */
+  *timestamp_sleep = TRUE;
+
+  return svn_error_trace(svn_wc__hydrate(ctx->wc_ctx, local_abspath, depth,
+                                         use_commit_times,
+                                         fetch_text, &b,
+                                         ctx->cancel_func, ctx->cancel_baton,
+                                         ctx->notify_func2,
+                                         ctx->notify_baton2,
+                                         scratch_pool));
+}
+
+svn_error_t *
+svn_client__hydrate(svn_boolean_t *timestamp_sleep,
+                    const char *local_abspath,
+                    svn_depth_t depth,
+                    svn_client_ctx_t *ctx,
+                    apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *unfetched;
+
+  /* Don't lock working copies that have nothing to fetch */
+  SVN_ERR(svn_wc__get_unfetched(&unfetched, ctx->wc_ctx, local_abspath,
+                                depth, scratch_pool, scratch_pool));
+  if (unfetched->nelts == 0)
+    return SVN_NO_ERROR;
+
+  SVN_WC__CALL_WITH_WRITE_LOCK(
+    hydrate_internal(timestamp_sleep, local_abspath, depth, ctx,
+                     scratch_pool),
+    ctx->wc_ctx, local_abspath, FALSE /* lock_anchor */, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_client__hydrate_locked(svn_boolean_t *timestamp_sleep,
+                           const char *local_abspath,
+                           svn_depth_t depth,
+                           svn_client_ctx_t *ctx,
+                           apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *unfetched;
+
+  SVN_ERR(svn_wc__get_unfetched(&unfetched, ctx->wc_ctx, local_abspath,
+                                depth, scratch_pool, scratch_pool));
+  if (unfetched->nelts == 0)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(hydrate_internal(timestamp_sleep, local_abspath,
+                                          depth, ctx, scratch_pool));
+}
+
+svn_error_t *
+svn_client_hydrate(const apr_array_header_t *paths,
+                   svn_depth_t depth,
+                   svn_client_ctx_t *ctx,
+                   apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_boolean_t sleep_needed = FALSE;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      const char *local_abspath;
+
+      svn_pool_clear(iterpool);
+
+      if (svn_path_is_url(path))
+        {
+          err = svn_error_createf(SVN_ERR_ILLEGAL_TARGET, NULL,
+                                  _("'%s' is not a local path"), path);
+          break;
+        }
+
+      err = svn_dirent_get_absolute(&local_abspath, path, iterpool);
+      if (!err)
+        err = svn_client__hydrate(&sleep_needed, local_abspath, depth, ctx,
+                                  iterpool);
+      if (err)
+        break;
+    }
+
+  if (sleep_needed)
+    svn_io_sleep_for_timestamps(NULL, iterpool);
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
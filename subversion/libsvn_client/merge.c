@@ -1807,6 +1807,12 @@ merge_file_opened(void **new_file_baton,
       if (! right_source)
         fb->tree_conflict_action = svn_wc_conflict_action_delete;
 
+      /* A file added without its text would look missing; fetch it now.
+         Even a dry run needs the text to tell about conflicts. */
+      SVN_ERR(svn_client__hydrate_locked(merge_b->use_sleep, local_abspath,
+                                         svn_depth_empty, merge_b->ctx,
+                                         scratch_pool));
+
       {
         svn_wc_notify_state_t obstr_state;
 
@@ -314,6 +314,7 @@ update_internal(svn_revnum_t *result_rev,
   svn_revnum_t revnum;
   svn_boolean_t use_commit_times;
   svn_boolean_t clean_checkout = FALSE;
+  svn_boolean_t lazy_fetch;
   const char *diff3_cmd;
   apr_hash_t *wcroot_iprops;
   svn_opt_revision_t opt_rev;
@@ -453,6 +454,11 @@ update_internal(svn_revnum_t *result_rev,
     ? svn_cstring_split(preserved_exts_str, "\n\r\t\v ", FALSE, scratch_pool)
     : NULL;
 
+  /* See if files should be added without their text. */
+  SVN_ERR(svn_config_get_bool(cfg, &lazy_fetch,
+                              SVN_CONFIG_SECTION_WORKING_COPY,
+                              SVN_CONFIG_OPTION_LAZY_FETCH, FALSE));
+
   /* Let everyone know we're starting a real update (unless we're
      asked not to). */
   if (ctx->notify_func2 && notify_summary)
@@ -539,16 +545,34 @@ update_internal(svn_revnum_t *result_rev,
                                     scratch_pool, scratch_pool));
 
   /* Tell RA to do an update of URL+TARGET to REVISION; if we pass an
-     invalid revnum, that means RA will use the latest revision.  */
-  SVN_ERR(svn_ra_do_update3(ra_session, &reporter, &report_baton,
+     invalid revnum, that means RA will use the latest revision.
+
+     A clean checkout that adds all files without their text doesn't need
+     any text from the server, which a report without text deltas avoids
+     sending.  The update editor handles such a drive just like an update
+     that adds everything.  */
+  if (lazy_fetch && clean_checkout)
+    SVN_ERR(svn_ra_do_diff3(ra_session, &reporter, &report_baton,
                             revnum, target,
                             (!server_supports_depth || depth_is_sticky
                              ? depth
                              : svn_depth_unknown),
-                            FALSE /* send_copyfrom_args */,
                             FALSE /* ignore_ancestry */,
+                            FALSE /* text_deltas */,
+                            svn_path_url_add_component2(anchor_url, target,
+                                                        scratch_pool),
                             update_editor, update_edit_baton,
-                            scratch_pool, scratch_pool));
+                            scratch_pool));
+  else
+    SVN_ERR(svn_ra_do_update3(ra_session, &reporter, &report_baton,
+                              revnum, target,
+                              (!server_supports_depth || depth_is_sticky
+                               ? depth
+                               : svn_depth_unknown),
+                              FALSE /* send_copyfrom_args */,
+                              FALSE /* ignore_ancestry */,
+                              update_editor, update_edit_baton,
+                              scratch_pool, scratch_pool));
 
   /* Past this point, we assume the WC is going to be modified so we will
    * need to sleep for timestamps. */
@@ -1475,6 +1475,18 @@ svn_fs_dir_optimal_order(apr_array_header_t **ordered_p,
                                                          scratch_pool));
 }
 
+svn_error_t *
+svn_fs_dir_prefetch(svn_fs_root_t *root,
+                    const apr_array_header_t *entries,
+                    apr_pool_t *scratch_pool)
+{
+  if (root->vtable->dir_prefetch == NULL)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(root->vtable->dir_prefetch(root, entries,
+                                                    scratch_pool));
+}
+
 svn_error_t *
 svn_fs_make_dir(svn_fs_root_t *root, const char *path, apr_pool_t *pool)
 {
@@ -369,6 +369,9 @@ typedef struct root_vtable_t
                                     apr_hash_t *entries,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
+  svn_error_t *(*dir_prefetch)(svn_fs_root_t *root,
+                               const apr_array_header_t *entries,
+                               apr_pool_t *scratch_pool);
   svn_error_t *(*make_dir)(svn_fs_root_t *root, const char *path,
                            apr_pool_t *pool);
 
@@ -2964,6 +2964,200 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
   return SVN_NO_ERROR;
 }
 
+/* An item to read in svn_fs_fs__prefetch_dir_entries. */
+typedef struct prefetch_item_t
+{
+  /* Logical address of the item. */
+  svn_revnum_t revision;
+  apr_uint64_t item_index;
+
+  /* Physical address of the item: first revision in the rev / pack file
+   * and the absolute offset within that file. */
+  svn_revnum_t base_rev;
+  apr_off_t offset;
+
+  /* The svn_fs_dirent_t * or node_revision_t * to read. */
+  void *data;
+} prefetch_item_t;
+
+/* Comparison function ordering prefetch_item_t by their logical address. */
+static int
+compare_prefetch_revisions(const void *lhs,
+                           const void *rhs)
+{
+  const prefetch_item_t *a = lhs;
+  const prefetch_item_t *b = rhs;
+
+  if (a->revision != b->revision)
+    return a->revision < b->revision ? -1 : 1;
+
+  return 0;
+}
+
+/* Comparison function ordering prefetch_item_t by their physical address. */
+static int
+compare_prefetch_offsets(const void *lhs,
+                         const void *rhs)
+{
+  const prefetch_item_t *a = lhs;
+  const prefetch_item_t *b = rhs;
+
+  if (a->base_rev != b->base_rev)
+    return a->base_rev < b->base_rev ? -1 : 1;
+
+  if (a->offset != b->offset)
+    return a->offset < b->offset ? -1 : 1;
+
+  return 0;
+}
+
+/* Sort the prefetch_item_t elements in ITEMS by the order in which they
+ * are stored in the rev / pack files of FS.  Use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+sort_prefetch_items(svn_fs_t *fs,
+                    apr_array_header_t *items,
+                    apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__revision_file_t *rev_file = NULL;
+  apr_pool_t *file_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  /* Group the items by revision such that we don't need to reopen
+   * rev / pack files and their indexes all the time. */
+  svn_sort__array(items, compare_prefetch_revisions);
+
+  for (i = 0; i < items->nelts; ++i)
+    {
+      prefetch_item_t *item = &APR_ARRAY_IDX(items, i, prefetch_item_t);
+      svn_pool_clear(iterpool);
+
+      item->base_rev = svn_fs_fs__packed_base_rev(fs, item->revision);
+
+      if (svn_fs_fs__use_log_addressing(fs))
+        {
+          /* Log addressing requires the respective index. */
+          if (!rev_file || rev_file->start_revision != item->base_rev)
+            {
+              svn_pool_clear(file_pool);
+              SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs,
+                                                       item->revision,
+                                                       file_pool,
+                                                       iterpool));
+            }
+
+          SVN_ERR(svn_fs_fs__item_offset(&item->offset, fs, rev_file,
+                                         item->revision, NULL,
+                                         item->item_index, iterpool));
+        }
+      else if (svn_fs_fs__is_packed_rev(fs, item->revision))
+        {
+          /* With physical addressing, ITEM_INDEX is the offset within
+           * the revision's part of the pack file. */
+          apr_off_t rev_offset;
+          SVN_ERR(svn_fs_fs__get_packed_offset(&rev_offset, fs,
+                                               item->revision, iterpool));
+          item->offset = rev_offset + (apr_off_t)item->item_index;
+        }
+      else
+        {
+          /* ... and the offset within the rev file if not packed. */
+          item->offset = (apr_off_t)item->item_index;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(file_pool);
+
+  svn_sort__array(items, compare_prefetch_offsets);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__prefetch_dir_entries(svn_fs_t *fs,
+                                const apr_array_header_t *entries,
+                                apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *noderevs, *dirs;
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Without caches, there is no point in reading anything ahead. */
+  if (!ffd->node_revision_cache)
+    return SVN_NO_ERROR;
+
+  /* Collect the committed node-revisions. */
+  noderevs = apr_array_make(scratch_pool, entries->nelts,
+                            sizeof(prefetch_item_t));
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_dirent_t *dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+      const svn_fs_fs__id_part_t *rev_item
+        = svn_fs_fs__id_rev_item(dirent->id);
+      prefetch_item_t *item;
+
+      if (!SVN_IS_VALID_REVNUM(rev_item->revision))
+        continue;
+
+      item = apr_array_push(noderevs);
+      item->revision = rev_item->revision;
+      item->item_index = rev_item->number;
+      item->data = dirent;
+    }
+
+  /* Read them in file order.  Keep the sub-directory node-revisions
+   * around to fetch their contents in the second pass. */
+  SVN_ERR(sort_prefetch_items(fs, noderevs, scratch_pool));
+
+  dirs = apr_array_make(scratch_pool, 16, sizeof(prefetch_item_t));
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < noderevs->nelts; ++i)
+    {
+      prefetch_item_t *item = &APR_ARRAY_IDX(noderevs, i, prefetch_item_t);
+      svn_fs_dirent_t *dirent = item->data;
+      svn_boolean_t is_dir = dirent->kind == svn_node_dir;
+      node_revision_t *noderev;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, dirent->id,
+                                           is_dir ? scratch_pool : iterpool,
+                                           iterpool));
+
+      if (is_dir
+          && noderev->data_rep
+          && !svn_fs_fs__id_txn_used(&noderev->data_rep->txn_id))
+        {
+          prefetch_item_t *dir = apr_array_push(dirs);
+          dir->revision = noderev->data_rep->revision;
+          dir->item_index = noderev->data_rep->item_index;
+          dir->data = noderev;
+        }
+    }
+
+  /* Read the sub-directory contents in file order as well. */
+  if (ffd->dir_cache && dirs->nelts)
+    {
+      SVN_ERR(sort_prefetch_items(fs, dirs, scratch_pool));
+
+      for (i = 0; i < dirs->nelts; ++i)
+        {
+          prefetch_item_t *item = &APR_ARRAY_IDX(dirs, i, prefetch_item_t);
+          apr_array_header_t *dir_entries;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_fs_fs__rep_contents_dir(&dir_entries, fs, item->data,
+                                              iterpool, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
                         svn_fs_t *fs,
@@ -161,6 +161,16 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool);
 
+/* Read the node-revisions of all svn_fs_dirent_t * in ENTRIES as well as
+   the contents of all sub-directories among them from filesystem FS,
+   in the order they are stored in the rev / pack files, and put them
+   into the respective caches.  Uncommitted nodes will be ignored.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__prefetch_dir_entries(svn_fs_t *fs,
+                                const apr_array_header_t *entries,
+                                apr_pool_t *scratch_pool);
+
 /* Set *PROPLIST to be an apr_hash_t containing the property list of
    node-revision NODEREV as seen in filesystem FS.  Use POOL for
    temporary allocations. */
@@ -2464,6 +2464,15 @@ fs_dir_optimal_order(apr_array_header_t **ordered_p,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+fs_dir_prefetch(svn_fs_root_t *root,
+                const apr_array_header_t *entries,
+                apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_fs_fs__prefetch_dir_entries(root->fs, entries,
+                                                         scratch_pool));
+}
+
 /* Raise an error if PATH contains a newline because FSFS cannot handle
  * such paths. See issue #4340. */
 static svn_error_t *
@@ -4542,6 +4551,7 @@ static root_vtable_t root_vtable = {
   fs_props_changed,
   fs_dir_entries,
   fs_dir_optimal_order,
+  fs_dir_prefetch,
   fs_make_dir,
   fs_file_length,
   fs_file_checksum,
@@ -525,37 +525,66 @@ expected_buffered_checksum(svn_fs_x__revision_file_t *file,
   return SVN_NO_ERROR;
 }
 
-/* Verify that the FNV checksum over the next ENTRY->SIZE bytes read from
- * FILE will match ENTRY's expected checksum.
- * Use SCRATCH_POOL for temporary allocations.
+/* Number of large items that compare_p2l_to_rev() collects before
+ * verifying their checksums concurrently. */
+#define CHECKSUM_BATCH_SIZE 64
+
+/* Append a job to JOBS that will calculate the FNV checksum over the
+ * contents of ENTRY in the rev / pack file at PATH.  Allocate the job
+ * and a copy of ENTRY in RESULT_POOL.
+ */
+static void
+queue_checksum(apr_array_header_t *jobs,
+               const char *path,
+               const svn_fs_x__p2l_entry_t *entry,
+               apr_pool_t *result_pool)
+{
+  svn_checksum__job_t *job = apr_pcalloc(result_pool, sizeof(*job));
+  job->abspath = path;
+  job->offset = entry->offset;
+  job->length = entry->size;
+  job->kind = svn_checksum_fnv1a_32x4;
+  job->baton = apr_pmemdup(result_pool, entry, sizeof(*entry));
+
+  APR_ARRAY_PUSH(jobs, svn_checksum__job_t *) = job;
+}
+
+/* Calculate the checksums for all JOBS queued by queue_checksum() and
+ * verify that they match the ones expected by the respective p2l index
+ * entries.  Use the name of FILE in error messages.  If given, invoke
+ * CANCEL_FUNC with CANCEL_BATON at regular intervals.  Use SCRATCH_POOL
+ * for temporary allocations.
  */
 static svn_error_t *
-expected_streamed_checksum(svn_fs_x__revision_file_t *file,
-                           svn_fs_x__p2l_entry_t *entry,
-                           apr_pool_t *scratch_pool)
+verify_checksums(apr_array_header_t *jobs,
+                 svn_fs_x__revision_file_t *file,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
 {
-  unsigned char buffer[STREAM_THRESHOLD];
-  svn_checksum_t *checksum;
-  svn_checksum_ctx_t *context
-    = svn_checksum_ctx_create(svn_checksum_fnv1a_32x4, scratch_pool);
-  apr_off_t size = entry->size;
+  svn_error_t *err;
+  int i;
 
-  while (size > 0)
+  err = svn_checksum__compute_batch(jobs, 0, cancel_func, cancel_baton,
+                                    scratch_pool, scratch_pool);
+
+  /* Report the first problem in file order. */
+  for (i = 0; i < jobs->nelts; ++i)
     {
-      apr_size_t to_read = size > sizeof(buffer)
-                         ? sizeof(buffer)
-                         : (apr_size_t)size;
-      SVN_ERR(svn_fs_x__rev_file_read(file, buffer, to_read));
-      SVN_ERR(svn_checksum_update(context, buffer, to_read));
-      size -= to_read;
+      svn_checksum__job_t *job = APR_ARRAY_IDX(jobs, i,
+                                               svn_checksum__job_t *);
+      if (err)
+        svn_error_clear(job->err);
+      else if (job->err)
+        err = job->err;
+      else
+        err = expected_checksum(file, job->baton,
+                                ntohl(*(const apr_uint32_t *)
+                                      job->checksum->digest),
+                                scratch_pool);
     }
 
-  SVN_ERR(svn_checksum_final(&checksum, context, scratch_pool));
-  SVN_ERR(expected_checksum(file, entry,
-                            ntohl(*(const apr_uint32_t *)checksum->digest),
-                            scratch_pool));
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(err);
 }
 
 /* Verify that for all phys-to-log index entries for revisions START to
@@ -576,10 +605,15 @@ compare_p2l_to_rev(svn_fs_t *fs,
 {
   svn_fs_x__data_t *ffd = fs->fsap_data;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *batch_pool = svn_pool_create(scratch_pool);
   apr_off_t max_offset;
   apr_off_t offset = 0;
   svn_fs_x__revision_file_t *rev_file;
   svn_fs_x__index_info_t l2p_index_info;
+  const char *rev_file_path;
+  apr_array_header_t *jobs = apr_array_make(scratch_pool,
+                                            CHECKSUM_BATCH_SIZE,
+                                            sizeof(svn_checksum__job_t *));
 
   /* open the pack / rev file that is covered by the p2l index */
   SVN_ERR(svn_fs_x__rev_file_init(&rev_file, fs, start, scratch_pool));
@@ -600,6 +634,7 @@ compare_p2l_to_rev(svn_fs_t *fs,
                                            max_offset));
 
   SVN_ERR(svn_fs_x__rev_file_seek(rev_file, NULL, 0));
+  SVN_ERR(svn_fs_x__rev_file_name(&rev_file_path, rev_file, scratch_pool));
 
   /* for all offsets in the file, get the P2L index entries and check
      them against the L2P index */
@@ -654,22 +689,41 @@ compare_p2l_to_rev(svn_fs_t *fs,
             }
           else
             {
+              /* Larger items get checksummed concurrently by a separate
+               * batch. */
               if (entry->size < STREAM_THRESHOLD)
-                SVN_ERR(expected_buffered_checksum(rev_file, entry,
-                                                   iterpool));
+                {
+                  SVN_ERR(expected_buffered_checksum(rev_file, entry,
+                                                     iterpool));
+                }
               else
-                SVN_ERR(expected_streamed_checksum(rev_file, entry,
-                                                   iterpool));
+                {
+                  queue_checksum(jobs, rev_file_path, entry, batch_pool);
+                  SVN_ERR(svn_fs_x__rev_file_seek(rev_file, NULL,
+                                                  offset + entry->size));
+                }
             }
 
           /* advance offset */
           offset += entry->size;
         }
 
+      if (jobs->nelts >= CHECKSUM_BATCH_SIZE)
+        {
+          SVN_ERR(verify_checksums(jobs, rev_file, cancel_func,
+                                   cancel_baton, batch_pool));
+          apr_array_clear(jobs);
+          svn_pool_clear(batch_pool);
+        }
+
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
     }
 
+  SVN_ERR(verify_checksums(jobs, rev_file, cancel_func, cancel_baton,
+                           batch_pool));
+
+  svn_pool_destroy(batch_pool);
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
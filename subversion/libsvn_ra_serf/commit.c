@@ -72,6 +72,11 @@ typedef struct commit_context_t {
   const char *vcc_url;           /* vcc url */
 
   int open_batons;               /* Number of open batons */
+
+  /* Pipelined PUT support; PENDING_PUTS is NULL unless enabled. */
+  svn_ra_serf__connection_t *put_conn; /* connection PUTs are queued on */
+  apr_array_header_t *pending_puts;    /* pending_put_t *, in queue order */
+  apr_size_t pending_put_bytes;        /* svndiff bytes held by them */
 } commit_context_t;
 
 #define USING_HTTPV2_COMMIT_SUPPORT(commit_ctx) ((commit_ctx)->txn_url != NULL)
@@ -176,6 +181,10 @@ typedef struct file_context_t {
   /* Buffer holding the svndiff (can spill to disk). */
   svn_ra_serf__request_body_t *svndiff;
 
+  /* Pool owning SVNDIFF if the PUT gets pipelined.  This is a subpool of
+     the commit context's pool, as the PUT may outlive this baton. */
+  apr_pool_t *put_pool;
+
   /* Did we send the svndiff in apply_textdelta_stream()? */
   svn_boolean_t svndiff_sent;
 
@@ -196,6 +205,31 @@ typedef struct file_context_t {
 
 } file_context_t;
 
+/* A PUT, and the PROPPATCH following it (if any), queued on the commit's
+   PUT connection but not yet known to be completed. */
+typedef struct pending_put_t {
+  /* Pool for everything below; destroyed once the requests are done. */
+  apr_pool_t *pool;
+
+  /* Copy of the file baton, allocated in POOL. */
+  file_context_t *file;
+
+  svn_ra_serf__handler_t *put_handler;
+  svn_ra_serf__handler_t *proppatch_handler; /* May be NULL */
+
+  /* Size of the spooled svndiff. */
+  apr_size_t body_size;
+} pending_put_t;
+
+/* Maximum number of PUT requests we queue on the PUT connection before
+   waiting for responses.  */
+#define MAX_PENDING_PUTS 64
+
+/* Maximum number of spooled svndiff bytes (in memory or in temporary
+   files) held by queued PUT requests.  A single larger file is still
+   sent, but only after all previously queued requests have completed.  */
+#define MAX_PENDING_PUT_BYTES (64 * 1024 * 1024)
+
 
 /* Setup routines and handlers for various requests we'll invoke. */
 
@@ -829,13 +863,14 @@ create_proppatch_body(serf_bucket_t **bkt,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t*
-proppatch_resource(svn_ra_serf__session_t *session,
-                   proppatch_context_t *proppatch,
-                   apr_pool_t *pool)
+/* Create a handler for the PROPPATCH request described by PROPPATCH,
+   allocated in POOL. */
+static svn_ra_serf__handler_t *
+create_proppatch_handler(svn_ra_serf__session_t *session,
+                         proppatch_context_t *proppatch,
+                         apr_pool_t *pool)
 {
   svn_ra_serf__handler_t *handler;
-  svn_error_t *err;
 
   handler = svn_ra_serf__create_handler(session, pool);
 
@@ -852,8 +887,15 @@ proppatch_resource(svn_ra_serf__session_t *session,
   handler->response_handler = svn_ra_serf__handle_multistatus_only;
   handler->response_baton = handler;
 
-  err = svn_ra_serf__context_run_one(handler, pool);
+  return handler;
+}
 
+/* Check the result of the completed PROPPATCH request HANDLER, given
+   the error ERR returned while running it.  */
+static svn_error_t *
+check_proppatch_result(svn_ra_serf__handler_t *handler,
+                       svn_error_t *err)
+{
   if (!err && handler->sline.code != 207)
     err = svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
@@ -873,6 +915,20 @@ proppatch_resource(svn_ra_serf__session_t *session,
   return svn_error_trace(err);
 }
 
+static svn_error_t*
+proppatch_resource(svn_ra_serf__session_t *session,
+                   proppatch_context_t *proppatch,
+                   apr_pool_t *pool)
+{
+  svn_ra_serf__handler_t *handler;
+  svn_error_t *err;
+
+  handler = create_proppatch_handler(session, proppatch, pool);
+  err = svn_ra_serf__context_run_one(handler, pool);
+
+  return svn_error_trace(check_proppatch_result(handler, err));
+}
+
 /* Implements svn_ra_serf__request_body_delegate_t */
 static svn_error_t *
 create_empty_put_body(serf_bucket_t **body_bkt,
@@ -1956,9 +2012,13 @@ apply_textdelta(void *file_baton,
    * in response to a PUT" capability, and only if the editor driver uses the
    * new callback.
    */
+  if (ctx->commit_ctx->pending_puts)
+    ctx->put_pool = svn_pool_create(ctx->commit_ctx->pool);
+
   ctx->svndiff =
     svn_ra_serf__request_body_create(SVN_RA_SERF__REQUEST_BODY_IN_MEM_SIZE,
-                                     ctx->pool);
+                                     ctx->put_pool ? ctx->put_pool
+                                                   : ctx->pool);
   ctx->stream = svn_ra_serf__request_body_get_stream(ctx->svndiff);
 
   negotiate_put_encoding(&svndiff_version, &compression_level,
@@ -2133,6 +2193,308 @@ change_file_prop(void *file_baton,
   return SVN_NO_ERROR;
 }
 
+/* Return the status code we expect in response to the PUT for CTX. */
+static int
+put_expected_status(const file_context_t *ctx)
+{
+  if (ctx->added && ! ctx->copy_path)
+    return 201; /* Created */
+  else
+    return 204; /* Updated */
+}
+
+/* Create a handler for PUTting the svndiff collected for CTX, or an empty
+   file if PUT_EMPTY_FILE is TRUE.  Allocate the handler in POOL. */
+static svn_ra_serf__handler_t *
+create_put_handler(file_context_t *ctx,
+                   svn_boolean_t put_empty_file,
+                   apr_pool_t *pool)
+{
+  svn_ra_serf__handler_t *handler;
+
+  handler = svn_ra_serf__create_handler(ctx->commit_ctx->session, pool);
+
+  handler->method = "PUT";
+  handler->path = ctx->url;
+
+  handler->response_handler = svn_ra_serf__expect_empty_body;
+  handler->response_baton = handler;
+
+  if (put_empty_file)
+    {
+      handler->body_delegate = create_empty_put_body;
+      handler->body_delegate_baton = ctx;
+      handler->body_type = "text/plain";
+    }
+  else
+    {
+      svn_ra_serf__request_body_get_delegate(&handler->body_delegate,
+                                             &handler->body_delegate_baton,
+                                             ctx->svndiff);
+      handler->body_type = SVN_SVNDIFF_MIME_TYPE;
+    }
+
+  handler->header_delegate = setup_put_headers;
+  handler->header_delegate_baton = ctx;
+
+  return handler;
+}
+
+/* Compare the result checksum reported by the WC for CTX with the one
+   reported by the server, if we have both. */
+static svn_error_t *
+verify_result_checksum(file_context_t *ctx,
+                       apr_pool_t *scratch_pool)
+{
+  svn_checksum_t *result_checksum;
+
+  if (!ctx->result_checksum || !ctx->remote_result_checksum)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_checksum_parse_hex(&result_checksum, svn_checksum_md5,
+                                 ctx->result_checksum, scratch_pool));
+
+  if (!svn_checksum_match(result_checksum, ctx->remote_result_checksum))
+    return svn_checksum_mismatch_err(result_checksum,
+                                     ctx->remote_result_checksum,
+                                     scratch_pool,
+                                     _("Checksum mismatch for '%s'"),
+                                     svn_dirent_local_style(ctx->relpath,
+                                                            scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Check the results of all completed requests in CTX->PENDING_PUTS and
+   release their resources.  If one of them failed, return its error but
+   leave the remaining requests in CTX->PENDING_PUTS. */
+static svn_error_t *
+reap_pending_puts(commit_context_t *ctx,
+                  apr_pool_t *scratch_pool)
+{
+  int i, j;
+
+  for (i = 0, j = 0; i < ctx->pending_puts->nelts; i++)
+    {
+      pending_put_t *put = APR_ARRAY_IDX(ctx->pending_puts, i,
+                                         pending_put_t *);
+      svn_error_t *err;
+
+      if (!put->put_handler->done
+          || (put->proppatch_handler && !put->proppatch_handler->done))
+        {
+          APR_ARRAY_IDX(ctx->pending_puts, j++, pending_put_t *) = put;
+          continue;
+        }
+
+      if (put->put_handler->sline.code != put_expected_status(put->file))
+        err = svn_ra_serf__unexpected_status(put->put_handler);
+      else if (put->proppatch_handler)
+        err = check_proppatch_result(put->proppatch_handler, SVN_NO_ERROR);
+      else
+        err = SVN_NO_ERROR;
+
+      if (!err)
+        err = verify_result_checksum(put->file, scratch_pool);
+
+      ctx->pending_put_bytes -= put->body_size;
+      svn_pool_destroy(put->pool);
+
+      if (err)
+        {
+          /* Keep the list consistent: move the requests we did not
+             look at yet behind the ones we kept. */
+          for (i++; i < ctx->pending_puts->nelts; i++)
+            APR_ARRAY_IDX(ctx->pending_puts, j++, pending_put_t *)
+              = APR_ARRAY_IDX(ctx->pending_puts, i, pending_put_t *);
+
+          ctx->pending_puts->nelts = j;
+          return svn_error_trace(err);
+        }
+    }
+
+  ctx->pending_puts->nelts = j;
+
+  return SVN_NO_ERROR;
+}
+
+/* Run the session context of CTX until no more than MAX_REQUESTS queued
+   PUTs holding no more than MAX_BYTES svndiff bytes are pending. */
+static svn_error_t *
+wait_for_pending_puts(commit_context_t *ctx,
+                      int max_requests,
+                      apr_size_t max_bytes,
+                      apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__session_t *session = ctx->session;
+  apr_interval_time_t waittime_left = session->timeout;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(reap_pending_puts(ctx, iterpool));
+
+  while (ctx->pending_puts->nelts > max_requests
+         || (ctx->pending_puts->nelts && ctx->pending_put_bytes > max_bytes))
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_ra_serf__context_run(session, &waittime_left, iterpool));
+      SVN_ERR(reap_pending_puts(ctx, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the connection to pipeline the PUT requests of CTX on, opening
+   an auxiliary connection if needed.  Using a single connection keeps the
+   server writing one representation at a time into the transaction, while
+   the editor drive continues on the main connection. */
+static svn_error_t *
+get_put_connection(svn_ra_serf__connection_t **conn,
+                   commit_context_t *ctx)
+{
+  svn_ra_serf__session_t *sess = ctx->session;
+
+  if (!ctx->put_conn)
+    {
+      if (sess->num_conns == 1)
+        {
+          apr_status_t status;
+
+          sess->conns[1] = apr_pcalloc(sess->pool, sizeof(*sess->conns[1]));
+          sess->conns[1]->bkt_alloc = serf_bucket_allocator_create(sess->pool,
+                                                                   NULL, NULL);
+          sess->conns[1]->last_status_code = -1;
+          sess->conns[1]->session = sess;
+          status = serf_connection_create2(&sess->conns[1]->conn,
+                                           sess->context,
+                                           sess->session_url,
+                                           svn_ra_serf__conn_setup,
+                                           sess->conns[1],
+                                           svn_ra_serf__conn_closed,
+                                           sess->conns[1],
+                                           sess->pool);
+          if (status)
+            return svn_ra_serf__wrap_err(status, NULL);
+
+          sess->num_conns++;
+        }
+
+      ctx->put_conn = sess->conns[1];
+    }
+
+  *conn = ctx->put_conn;
+  return SVN_NO_ERROR;
+}
+
+/* Queue the PUT for the file CTX, followed by a PROPPATCH if the file has
+   property changes, on the PUT connection without waiting for the
+   responses.  The results are checked by reap_pending_puts(). */
+static svn_error_t *
+queue_put(file_context_t *ctx,
+          svn_boolean_t put_empty_file,
+          apr_pool_t *scratch_pool)
+{
+  commit_context_t *commit_ctx = ctx->commit_ctx;
+  pending_put_t *put;
+  put_response_ctx_t *prc;
+  file_context_t *file;
+  apr_pool_t *pool;
+  apr_size_t body_size = 0;
+
+  if (!put_empty_file)
+    {
+      SVN_ERR(svn_stream_close(ctx->stream));
+      body_size = svn_ra_serf__request_body_get_size(ctx->svndiff);
+    }
+
+  /* Stay within our budget before adding another request. */
+  SVN_ERR(wait_for_pending_puts(commit_ctx, MAX_PENDING_PUTS - 1,
+                                (body_size < MAX_PENDING_PUT_BYTES)
+                                  ? MAX_PENDING_PUT_BYTES - body_size
+                                  : 0,
+                                scratch_pool));
+
+  pool = ctx->put_pool ? ctx->put_pool : svn_pool_create(commit_ctx->pool);
+
+  /* The file baton dies with the driver's pool, so copy what the
+     request delegates need into POOL. */
+  file = apr_pmemdup(pool, ctx, sizeof(*ctx));
+  file->pool = pool;
+  file->parent_dir = NULL;
+  file->stream = NULL;
+  file->relpath = apr_pstrdup(pool, ctx->relpath);
+  file->name = svn_relpath_basename(file->relpath, NULL);
+  file->url = apr_pstrdup(pool, ctx->url);
+  file->working_url = apr_pstrdup(pool, ctx->working_url);
+  file->copy_path = apr_pstrdup(pool, ctx->copy_path);
+  file->base_checksum = apr_pstrdup(pool, ctx->base_checksum);
+  file->result_checksum = apr_pstrdup(pool, ctx->result_checksum);
+  file->prop_changes = apr_hash_make(pool);
+
+  if (apr_hash_count(ctx->prop_changes))
+    {
+      apr_hash_index_t *hi;
+
+      for (hi = apr_hash_first(scratch_pool, ctx->prop_changes);
+           hi;
+           hi = apr_hash_next(hi))
+        {
+          const svn_prop_t *prop = apr_hash_this_val(hi);
+          svn_prop_t *new_prop = apr_palloc(pool, sizeof(*new_prop));
+
+          new_prop->name = apr_pstrdup(pool, prop->name);
+          new_prop->value = svn_string_dup(prop->value, pool);
+
+          svn_hash_sets(file->prop_changes, new_prop->name, new_prop);
+        }
+    }
+
+  put = apr_pcalloc(pool, sizeof(*put));
+  put->pool = pool;
+  put->file = file;
+  put->body_size = body_size;
+
+  put->put_handler = create_put_handler(file, put_empty_file, pool);
+  SVN_ERR(get_put_connection(&put->put_handler->conn, commit_ctx));
+
+  /* Pick up the result checksum, if the server sends one. */
+  prc = apr_pcalloc(pool, sizeof(*prc));
+  prc->handler = put->put_handler;
+  prc->file_ctx = file;
+  put->put_handler->response_handler = put_response_handler;
+  put->put_handler->response_baton = prc;
+
+  svn_ra_serf__request_create(put->put_handler);
+
+  /* The PROPPATCH must not reach the server before the PUT that might
+     create the file, so queue it on the same connection. */
+  if (apr_hash_count(file->prop_changes))
+    {
+      proppatch_context_t *proppatch;
+
+      proppatch = apr_pcalloc(pool, sizeof(*proppatch));
+      proppatch->pool = pool;
+      proppatch->relpath = file->relpath;
+      proppatch->path = file->url;
+      proppatch->commit_ctx = commit_ctx;
+      proppatch->prop_changes = file->prop_changes;
+      proppatch->base_revision = file->base_revision;
+
+      put->proppatch_handler = create_proppatch_handler(commit_ctx->session,
+                                                        proppatch, pool);
+      put->proppatch_handler->conn = put->put_handler->conn;
+
+      svn_ra_serf__request_create(put->proppatch_handler);
+    }
+
+  APR_ARRAY_PUSH(commit_ctx->pending_puts, pending_put_t *) = put;
+  commit_ctx->pending_put_bytes += body_size;
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 close_file(void *file_baton,
            const char *text_checksum,
@@ -2149,48 +2511,30 @@ close_file(void *file_baton,
   if ((!ctx->svndiff) && ctx->added && (!ctx->copy_path))
     put_empty_file = TRUE;
 
-  /* If we have a stream of changes, push them to the server... */
-  if ((ctx->svndiff || put_empty_file) && !ctx->svndiff_sent)
+  /* If we pipeline our PUTs, just queue the request(s) for this file. */
+  if ((ctx->svndiff || put_empty_file) && !ctx->svndiff_sent
+      && ctx->commit_ctx->pending_puts)
     {
-      svn_ra_serf__handler_t *handler;
-      int expected_result;
+      SVN_ERR(queue_put(ctx, put_empty_file, scratch_pool));
 
-      handler = svn_ra_serf__create_handler(ctx->commit_ctx->session,
-                                            scratch_pool);
-
-      handler->method = "PUT";
-      handler->path = ctx->url;
+      ctx->commit_ctx->open_batons--;
 
-      handler->response_handler = svn_ra_serf__expect_empty_body;
-      handler->response_baton = handler;
+      return SVN_NO_ERROR;
+    }
 
-      if (put_empty_file)
-        {
-          handler->body_delegate = create_empty_put_body;
-          handler->body_delegate_baton = ctx;
-          handler->body_type = "text/plain";
-        }
-      else
-        {
-          SVN_ERR(svn_stream_close(ctx->stream));
+  /* If we have a stream of changes, push them to the server... */
+  if ((ctx->svndiff || put_empty_file) && !ctx->svndiff_sent)
+    {
+      svn_ra_serf__handler_t *handler;
 
-          svn_ra_serf__request_body_get_delegate(&handler->body_delegate,
-                                                 &handler->body_delegate_baton,
-                                                 ctx->svndiff);
-          handler->body_type = SVN_SVNDIFF_MIME_TYPE;
-        }
+      if (!put_empty_file)
+        SVN_ERR(svn_stream_close(ctx->stream));
 
-      handler->header_delegate = setup_put_headers;
-      handler->header_delegate_baton = ctx;
+      handler = create_put_handler(ctx, put_empty_file, scratch_pool);
 
       SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
 
-      if (ctx->added && ! ctx->copy_path)
-        expected_result = 201; /* Created */
-      else
-        expected_result = 204; /* Updated */
-
-      if (handler->sline.code != expected_result)
+      if (handler->sline.code != put_expected_status(ctx))
         return svn_error_trace(svn_ra_serf__unexpected_status(handler));
     }
 
@@ -2215,21 +2559,7 @@ close_file(void *file_baton,
                                  proppatch, scratch_pool));
     }
 
-  if (ctx->result_checksum && ctx->remote_result_checksum)
-    {
-      svn_checksum_t *result_checksum;
-
-      SVN_ERR(svn_checksum_parse_hex(&result_checksum, svn_checksum_md5,
-                                     ctx->result_checksum, scratch_pool));
-
-      if (!svn_checksum_match(result_checksum, ctx->remote_result_checksum))
-        return svn_checksum_mismatch_err(result_checksum,
-                                         ctx->remote_result_checksum,
-                                         scratch_pool,
-                                         _("Checksum mismatch for '%s'"),
-                                         svn_dirent_local_style(ctx->relpath,
-                                                                scratch_pool));
-    }
+  SVN_ERR(verify_result_checksum(ctx, scratch_pool));
 
   ctx->commit_ctx->open_batons--;
 
@@ -2251,6 +2581,10 @@ close_edit(void *edit_baton,
               SVN_ERR_FS_INCORRECT_EDITOR_COMPLETION, NULL,
               _("Closing editor with directories or files open"));
 
+  /* Wait for our pipelined PUTs to complete before we MERGE */
+  if (ctx->pending_puts)
+    SVN_ERR(wait_for_pending_puts(ctx, 0, 0, pool));
+
   /* MERGE our activity */
   SVN_ERR(svn_ra_serf__run_merge(&commit_info,
                                  ctx->session,
@@ -2309,6 +2643,14 @@ abort_edit(void *edit_baton,
      had a problem. We need to reset it, in order to use it again.  */
   serf_connection_reset(ctx->session->conns[0]->conn);
 
+  /* Drop whatever is still queued on the PUT connection. */
+  if (ctx->put_conn)
+    {
+      serf_connection_reset(ctx->put_conn->conn);
+      apr_array_clear(ctx->pending_puts);
+      ctx->pending_put_bytes = 0;
+    }
+
   /* DELETE our aborted activity */
   handler = svn_ra_serf__create_handler(ctx->session, pool);
 
@@ -2392,6 +2734,12 @@ svn_ra_serf__get_commit_editor(svn_ra_session_t *ra_session,
 
   ctx->deleted_entries = apr_hash_make(ctx->pool);
 
+  /* Pipelining PUTs relies on the server handling the requests of a
+     connection in order, one at a time. */
+  if (session->pipelined_commits && !session->http10 && !session->http20)
+    ctx->pending_puts = apr_array_make(ctx->pool, MAX_PENDING_PUTS,
+                                       sizeof(pending_put_t *));
+
   editor = svn_delta_default_editor(pool);
   editor->open_root = open_root;
   editor->delete_entry = delete_entry;
@@ -2409,8 +2757,11 @@ svn_ra_serf__get_commit_editor(svn_ra_session_t *ra_session,
   /* Only install the callback that allows streaming PUT request bodies
    * if the server has the necessary capability.  Otherwise, this will
    * fallback to the default implementation using the temporary files.
-   * See default_editor.c:apply_textdelta_stream(). */
-  if (session->supports_put_result_checksum)
+   * See default_editor.c:apply_textdelta_stream().
+   *
+   * Pipelined PUTs need the spooled request bodies, so don't install it
+   * in that case either. */
+  if (session->supports_put_result_checksum && !ctx->pending_puts)
     editor->apply_textdelta_stream = apply_textdelta_stream;
 
   *ret_editor = editor;
@@ -0,0 +1,266 @@
+/*
+ * get_blame.c :  ra_serf get_blame API implementation.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <serf.h>
+
+#include "svn_hash.h"
+#include "svn_base64.h"
+#include "svn_xml.h"
+
+#include "svn_private_config.h"
+
+#include "ra_serf.h"
+#include "../libsvn_ra/ra_loader.h"
+
+
+
+/*
+ * This enum represents the current state of our XML parsing for a REPORT.
+ */
+enum blame_state_e {
+  INITIAL = XML_STATE_INITIAL,
+  REPORT,
+  CHUNK,
+  REV_PROP
+};
+
+typedef struct blame_context_t {
+  apr_pool_t *pool;
+
+  /* parameters set by our caller */
+  const char *path;
+  svn_revnum_t start;
+  svn_revnum_t end;
+  const svn_diff_file_options_t *diff_options;
+
+  /* The revprops received for the current chunk, or NULL. */
+  apr_hash_t *rev_props;
+
+  /* The server sends the revprops only with the first chunk of each
+     revision.  Map svn_revnum_t to apr_hash_t *. */
+  apr_hash_t *rev_props_cache;
+
+  /* blame receiver function and baton */
+  svn_ra__blame_receiver_t receiver;
+  void *receiver_baton;
+} blame_context_t;
+
+#define S_ SVN_XML_NAMESPACE
+static const svn_ra_serf__xml_transition_t blame_ttable[] = {
+  { INITIAL, S_, "blame-report", REPORT,
+    FALSE, { NULL }, FALSE },
+
+  { REPORT, S_, "chunk", CHUNK,
+    FALSE, { "start-line", "line-count", "?rev", NULL }, TRUE },
+
+  { CHUNK, S_, "rev-prop", REV_PROP,
+    TRUE, { "name", "?encoding", NULL }, TRUE },
+
+  { 0 }
+};
+
+/* Conforms to svn_ra_serf__xml_closed_t  */
+static svn_error_t *
+blame_closed(svn_ra_serf__xml_estate_t *xes,
+             void *baton,
+             int leaving_state,
+             const svn_string_t *cdata,
+             apr_hash_t *attrs,
+             apr_pool_t *scratch_pool)
+{
+  blame_context_t *blame_ctx = baton;
+
+  if (leaving_state == REV_PROP)
+    {
+      const char *name = svn_hash_gets(attrs, "name");
+      const char *encoding = svn_hash_gets(attrs, "encoding");
+      const svn_string_t *value;
+
+      if (encoding && strcmp(encoding, "base64") == 0)
+        value = svn_base64_decode_string(cdata, blame_ctx->pool);
+      else
+        value = svn_string_dup(cdata, blame_ctx->pool);
+
+      if (!blame_ctx->rev_props)
+        blame_ctx->rev_props = apr_hash_make(blame_ctx->pool);
+
+      svn_hash_sets(blame_ctx->rev_props,
+                    apr_pstrdup(blame_ctx->pool, name), value);
+    }
+  else if (leaving_state == CHUNK)
+    {
+      const char *rev_str = svn_hash_gets(attrs, "rev");
+      apr_int64_t start_line, line_count;
+      svn_revnum_t rev = SVN_INVALID_REVNUM;
+      apr_hash_t *rev_props = NULL;
+
+      SVN_ERR(svn_cstring_atoi64(&start_line,
+                                 svn_hash_gets(attrs, "start-line")));
+      SVN_ERR(svn_cstring_atoi64(&line_count,
+                                 svn_hash_gets(attrs, "line-count")));
+
+      if (rev_str)
+        {
+          SVN_ERR(svn_revnum_parse(&rev, rev_str, NULL));
+
+          rev_props = apr_hash_get(blame_ctx->rev_props_cache, &rev,
+                                   sizeof(rev));
+          if (!rev_props)
+            {
+              svn_revnum_t *key = apr_palloc(blame_ctx->pool, sizeof(*key));
+
+              rev_props = blame_ctx->rev_props
+                        ? blame_ctx->rev_props
+                        : apr_hash_make(blame_ctx->pool);
+
+              *key = rev;
+              apr_hash_set(blame_ctx->rev_props_cache, key, sizeof(*key),
+                           rev_props);
+            }
+        }
+
+      /* Reset buffered info. */
+      blame_ctx->rev_props = NULL;
+
+      SVN_ERR(blame_ctx->receiver(blame_ctx->receiver_baton,
+                                  start_line, line_count, rev, rev_props,
+                                  scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_serf__request_body_delegate_t */
+static svn_error_t *
+create_blame_body(serf_bucket_t **body_bkt,
+                  void *baton,
+                  serf_bucket_alloc_t *alloc,
+                  apr_pool_t *pool /* request pool */,
+                  apr_pool_t *scratch_pool)
+{
+  serf_bucket_t *buckets;
+  blame_context_t *blame_ctx = baton;
+  const char *ignore_space;
+
+  buckets = serf_bucket_aggregate_create(alloc);
+
+  svn_ra_serf__add_open_tag_buckets(buckets, alloc,
+                                    "S:blame-report",
+                                    "xmlns:S", SVN_XML_NAMESPACE,
+                                    SVN_VA_NULL);
+
+  svn_ra_serf__add_tag_buckets(buckets,
+                               "S:path", blame_ctx->path,
+                               alloc);
+  svn_ra_serf__add_tag_buckets(buckets,
+                               "S:start-revision",
+                               apr_ltoa(pool, blame_ctx->start),
+                               alloc);
+  svn_ra_serf__add_tag_buckets(buckets,
+                               "S:end-revision",
+                               apr_ltoa(pool, blame_ctx->end),
+                               alloc);
+
+  switch (blame_ctx->diff_options->ignore_space)
+    {
+      case svn_diff_file_ignore_space_change:
+        ignore_space = "change";
+        break;
+      case svn_diff_file_ignore_space_all:
+        ignore_space = "all";
+        break;
+      default:
+        ignore_space = "none";
+        break;
+    }
+  svn_ra_serf__add_tag_buckets(buckets,
+                               "S:ignore-space", ignore_space,
+                               alloc);
+
+  if (blame_ctx->diff_options->ignore_eol_style)
+    svn_ra_serf__add_empty_tag_buckets(buckets, alloc,
+                                       "S:ignore-eol-style", SVN_VA_NULL);
+
+  svn_ra_serf__add_close_tag_buckets(buckets, alloc,
+                                     "S:blame-report");
+
+  *body_bkt = buckets;
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_ra_serf__get_blame(svn_ra_session_t *ra_session,
+                       const char *path,
+                       svn_revnum_t start,
+                       svn_revnum_t end,
+                       const svn_diff_file_options_t *diff_options,
+                       svn_ra__blame_receiver_t receiver,
+                       void *receiver_baton,
+                       apr_pool_t *scratch_pool)
+{
+  blame_context_t *blame_ctx;
+  svn_ra_serf__session_t *session = ra_session->priv;
+  svn_ra_serf__handler_t *handler;
+  svn_ra_serf__xml_context_t *xmlctx;
+  const char *req_url;
+
+  if (!session->supports_blame)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Server does not support server-side blame"));
+
+  blame_ctx = apr_pcalloc(scratch_pool, sizeof(*blame_ctx));
+  blame_ctx->pool = scratch_pool;
+  blame_ctx->receiver = receiver;
+  blame_ctx->receiver_baton = receiver_baton;
+  blame_ctx->path = path;
+  blame_ctx->start = start;
+  blame_ctx->end = end;
+  blame_ctx->diff_options = diff_options;
+  blame_ctx->rev_props_cache = apr_hash_make(scratch_pool);
+
+  SVN_ERR(svn_ra_serf__get_stable_url(&req_url, NULL /* latest_revnum */,
+                                      session,
+                                      NULL /* url */, end,
+                                      scratch_pool, scratch_pool));
+
+  xmlctx = svn_ra_serf__xml_context_create(blame_ttable,
+                                           NULL, blame_closed, NULL,
+                                           blame_ctx,
+                                           scratch_pool);
+  handler = svn_ra_serf__create_expat_handler(session, xmlctx, NULL,
+                                              scratch_pool);
+
+  handler->method = "REPORT";
+  handler->path = req_url;
+  handler->body_delegate = create_blame_body;
+  handler->body_delegate_baton = blame_ctx;
+  handler->body_type = "text/xml";
+
+  SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
+
+  if (handler->sline.code != 200)
+    SVN_ERR(svn_ra_serf__unexpected_status(handler));
+
+  return SVN_NO_ERROR;
+}
@@ -40,6 +40,7 @@
 #include "private/svn_dav_protocol.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_editor.h"
+#include "private/svn_ra_private.h"
 
 #include "blncache.h"
 
@@ -110,6 +111,11 @@ struct svn_ra_serf__session_t {
      fetch operations (updates, etc.) */
   apr_int64_t max_connections;
 
+  /* Should file contents be spooled and their PUT requests pipelined on
+     an auxiliary connection during commits, instead of being sent one by
+     one while the commit editor is driven? */
+  svn_boolean_t pipelined_commits;
+
   /* Are we using ssl */
   svn_boolean_t using_ssl;
 
@@ -273,6 +279,9 @@ struct svn_ra_serf__session_t {
    * to a successful PUT request. */
   svn_boolean_t supports_put_result_checksum;
 
+  /* Indicates whether the server can compute blame information itself. */
+  svn_boolean_t supports_blame;
+
   apr_interval_time_t conn_latency;
 };
 
@@ -1443,6 +1452,17 @@ svn_ra_serf__list(svn_ra_session_t *ra_session,
                   void *receiver_baton,
                   apr_pool_t *scratch_pool);
 
+/* Implements svn_ra__vtable_t.get_blame(). */
+svn_error_t *
+svn_ra_serf__get_blame(svn_ra_session_t *ra_session,
+                       const char *path,
+                       svn_revnum_t start,
+                       svn_revnum_t end,
+                       const svn_diff_file_options_t *diff_options,
+                       svn_ra__blame_receiver_t receiver,
+                       void *receiver_baton,
+                       apr_pool_t *scratch_pool);
+
 /* Request a mergeinfo-report from the URL attached to SESSION,
    and fill in the MERGEINFO hash with the results.
 
@@ -1636,6 +1656,10 @@ svn_ra_serf__request_body_get_delegate(svn_ra_serf__request_body_delegate_t *del
                                        void **baton,
                                        svn_ra_serf__request_body_t *body);
 
+/* Return the number of bytes written to BODY so far. */
+apr_size_t
+svn_ra_serf__request_body_get_size(svn_ra_serf__request_body_t *body);
+
 /* Release intermediate resources associated with BODY.  These resources
    (such as open file handles) will be automatically released when the
    pool used to construct BODY is cleared or destroyed, but this optional
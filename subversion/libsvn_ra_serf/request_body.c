@@ -221,6 +221,12 @@ svn_ra_serf__request_body_get_delegate(svn_ra_serf__request_body_delegate_t *del
   *baton = body;
 }
 
+apr_size_t
+svn_ra_serf__request_body_get_size(svn_ra_serf__request_body_t *body)
+{
+  return body->total_bytes;
+}
+
 svn_error_t *
 svn_ra_serf__request_body_cleanup(svn_ra_serf__request_body_t *body,
                                   apr_pool_t *scratch_pool)
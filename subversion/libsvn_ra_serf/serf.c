@@ -245,6 +245,12 @@ load_config(svn_ra_serf__session_t *session,
                                SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS,
                                SVN_CONFIG_DEFAULT_OPTION_HTTP_MAX_CONNECTIONS));
 
+  /* Should we pipeline the PUT requests of a commit. */
+  SVN_ERR(svn_config_get_bool(config, &session->pipelined_commits,
+                              SVN_CONFIG_SECTION_GLOBAL,
+                              SVN_CONFIG_OPTION_HTTP_PIPELINED_COMMITS,
+                              FALSE));
+
   /* Should we use chunked transfer encoding. */
   SVN_ERR(svn_config_get_tristate(config, &chunked_requests,
                                   SVN_CONFIG_SECTION_GLOBAL,
@@ -312,6 +318,12 @@ load_config(svn_ra_serf__session_t *session,
                                    SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS,
                                    session->max_connections));
 
+      /* Load the group pipelined commits flag. */
+      SVN_ERR(svn_config_get_bool(config, &session->pipelined_commits,
+                                  server_group,
+                                  SVN_CONFIG_OPTION_HTTP_PIPELINED_COMMITS,
+                                  session->pipelined_commits));
+
       /* Should we use chunked transfer encoding. */
       SVN_ERR(svn_config_get_tristate(config, &chunked_requests,
                                       server_group,
@@ -639,6 +651,7 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
                                    result_pool));
 
   /* max_connections */
+  /* pipelined_commits */
   /* using_ssl */
   /* using_compression */
   /* http10 */
@@ -759,6 +772,7 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   /* supports_svndiff1 */
   /* supports_svndiff2 */
   /* supports_put_result_checksum */
+  /* supports_blame */
   /* conn_latency */
 
   new_sess->context = serf_context_create(result_pool);
@@ -1064,6 +1078,7 @@ static const svn_ra__vtable_t serf_vtable = {
   svn_ra_serf__get_inherited_props,
   NULL /* set_svn_ra_open */,
   svn_ra_serf__list,
+  svn_ra_serf__get_blame,
   svn_ra_serf__register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
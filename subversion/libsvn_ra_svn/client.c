@@ -3242,6 +3242,95 @@ ra_svn_list(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+ra_svn_get_blame(svn_ra_session_t *session,
+                 const char *path,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 const svn_diff_file_options_t *diff_options,
+                 svn_ra__blame_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  const char *ignore_space;
+  apr_hash_t *rev_props_cache = apr_hash_make(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  if (!svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_BLAME))
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Server does not support server-side blame"));
+
+  switch (diff_options->ignore_space)
+    {
+      case svn_diff_file_ignore_space_change:
+        ignore_space = "change";
+        break;
+      case svn_diff_file_ignore_space_all:
+        ignore_space = "all";
+        break;
+      default:
+        ignore_space = "none";
+        break;
+    }
+
+  path = reparent_path(session, path, scratch_pool);
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(crrwb)",
+                                  "get-blame", path, start, end,
+                                  ignore_space,
+                                  diff_options->ignore_eol_style));
+
+  /* Handle auth request by server */
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+
+  /* Read and process the chunks.  The server sends the revision
+     properties only along with the first chunk of each revision. */
+  while (1)
+    {
+      svn_ra_svn__item_t *item;
+      svn_ra_svn__list_t *proplist;
+      apr_uint64_t start_line, line_count;
+      svn_revnum_t rev;
+      apr_hash_t *rev_props = NULL;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      if (is_done_response(item))
+        break;
+      if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Blame entry not a list"));
+      SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "nn(?r)l",
+                                      &start_line, &line_count, &rev,
+                                      &proplist));
+
+      if (SVN_IS_VALID_REVNUM(rev))
+        {
+          rev_props = apr_hash_get(rev_props_cache, &rev, sizeof(rev));
+          if (!rev_props)
+            {
+              svn_revnum_t *key = apr_palloc(scratch_pool, sizeof(*key));
+
+              *key = rev;
+              SVN_ERR(svn_ra_svn__parse_proplist(proplist, scratch_pool,
+                                                 &rev_props));
+              apr_hash_set(rev_props_cache, key, sizeof(*key), rev_props);
+            }
+        }
+
+      SVN_ERR(receiver(receiver_baton, (apr_int64_t)start_line,
+                       (apr_int64_t)line_count, rev, rev_props, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Read the actual command response. */
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+  return SVN_NO_ERROR;
+}
+
 static const svn_ra__vtable_t ra_svn_vtable = {
   svn_ra_svn_version,
   ra_svn_get_description,
@@ -3282,6 +3371,7 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   ra_svn_get_inherited_props,
   NULL /* ra_set_svn_ra_open */,
   ra_svn_list,
+  ra_svn_get_blame,
   ra_svn_register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
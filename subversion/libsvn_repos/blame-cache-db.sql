@@ -0,0 +1,61 @@
+/* blame-cache-db.sql -- schema of the server-side blame cache
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* The line-to-revision maps computed by svn_repos__get_blame().
+
+   PATH and REVISION identify the node-rev that has been annotated by
+   its created path and revision.  START and OPTIONS are the parameters
+   of the blame, with the diff options packed into an integer.  SHA1 is
+   the checksum of the node-rev's contents, to detect stale entries.
+   RUNS is a sequence of 7b/8b encoded (revision, line count) pairs. */
+CREATE TABLE blame_cache (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  start INTEGER NOT NULL,
+  options INTEGER NOT NULL,
+  sha1 TEXT NOT NULL,
+  runs BLOB NOT NULL,
+  PRIMARY KEY (path, start, options, revision)
+  );
+
+PRAGMA USER_VERSION = 1;
+
+-- STMT_SELECT_BLAME
+SELECT revision, sha1, runs
+FROM blame_cache
+WHERE path = ?1 AND start = ?2 AND options = ?3 AND revision <= ?4
+ORDER BY revision DESC
+LIMIT 1
+
+-- STMT_INSERT_BLAME
+INSERT OR REPLACE INTO blame_cache (path, start, options, revision, sha1,
+                                    runs)
+VALUES (?1, ?2, ?3, ?4, ?5, ?6)
+
+-- STMT_DELETE_OLDER_BLAMES
+/* Keep only the youngest entry per path.  Blames are mostly requested
+   for HEAD and older entries would only be used for older revisions. */
+DELETE FROM blame_cache
+WHERE path = ?1 AND start = ?2 AND options = ?3 AND revision < ?4
+
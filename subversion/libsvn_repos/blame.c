@@ -0,0 +1,605 @@
+/* blame.c --- annotate the lines of a file with their last change
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_diff.h"
+#include "svn_dirent_uri.h"
+#include "svn_fs.h"
+#include "svn_pools.h"
+#include "svn_props.h"
+#include "svn_repos.h"
+
+#include "private/svn_repos_private.h"
+#include "private/svn_sqlite.h"
+#include "private/svn_subr_private.h"
+
+#include "repos.h"
+#include "svn_private_config.h"
+
+#include "blame-cache-db.h"
+
+BLAME_CACHE_DB_SQL_DECLARE_STATEMENTS(statements);
+
+/* Theory of operation:
+
+   We walk the file's history just like a client would, using
+   svn_repos_get_file_revs2() but without requesting any deltas.
+   Whenever the contents changed, we diff the new fulltext against the
+   previous one and map every line of the new text to the revision that
+   last changed it.  Contrary to the client, we keep that map as a plain
+   array with one element per line because we need to rebuild it anyway.
+
+   Only the chunks of adjacent lines that share the same revision are
+   sent to the caller.  The text itself never leaves the server.
+
+   Without path-based authz, the result gets stored in the blame cache,
+   keyed by the created path and revision of the node that we annotated.
+   A later request for the same node is answered from the cache directly.
+   If the node changed since, we seed the line map from the youngest cache
+   entry within its history and only walk the revisions after that.  The
+   SHA-1 of the node's contents guards against using stale entries, e.g.
+   after the repository has been replaced.  The cache is strictly optional;
+   failing to read or write it must never fail the blame itself. */
+
+/* Meta data of a revision that changed the file. */
+typedef struct blame_rev_t
+{
+  /* The revision number or SVN_INVALID_REVNUM if the changes happened
+     before the start of the requested range. */
+  svn_revnum_t revision;
+
+  /* Its revision properties as provided by svn_repos_get_file_revs2().
+     NULL for SVN_INVALID_REVNUM and if not fetched yet. */
+  apr_hash_t *rev_props;
+} blame_rev_t;
+
+/* Baton type to be used with file_rev_handler and the diff output
+   callbacks. */
+typedef struct blame_baton_t
+{
+  /* The repository and the range of revisions to annotate. */
+  svn_repos_t *repos;
+  svn_revnum_t start;
+
+  /* How to compare lines. */
+  const svn_diff_file_options_t *diff_options;
+
+  /* All revisions that changed the file so far, as blame_rev_t *. */
+  apr_array_header_t *revs;
+
+  /* The created path and revision of the node being annotated.
+     NULL and SVN_INVALID_REVNUM if we don't use the cache. */
+  const char *node_path;
+  svn_revnum_t node_rev;
+
+  /* If not NULL, the cached runs for SEED_PATH@SEED_REV whose contents
+     have the checksum SEED_SHA1.  The first revision handled must match
+     those and its line map gets taken from SEED_RUNS instead of diffing. */
+  const svn_string_t *seed_runs;
+  const char *seed_path;
+  svn_revnum_t seed_rev;
+  const svn_checksum_t *seed_sha1;
+
+  /* The fulltext of the last revision handled and the index in REVS
+     for each of its lines. */
+  svn_string_t *last_text;
+  apr_array_header_t *last_lines;
+
+  /* The line map currently being built and the index of the revision
+     that it is built for. */
+  apr_array_header_t *lines;
+  int current;
+
+  /* LAST_TEXT and LAST_LINES live in LAST_POOL, the new ones in
+     CURRENT_POOL.  We flip them after each revision. */
+  apr_pool_t *last_pool;
+  apr_pool_t *current_pool;
+
+  /* For everything that lives as long as the whole operation. */
+  apr_pool_t *pool;
+
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} blame_baton_t;
+
+/* Implements svn_diff_output_fns_t.output_common.  Lines that did not
+   change keep their revision. */
+static svn_error_t *
+output_common(void *baton,
+              apr_off_t original_start,
+              apr_off_t original_length,
+              apr_off_t modified_start,
+              apr_off_t modified_length,
+              apr_off_t latest_start,
+              apr_off_t latest_length)
+{
+  blame_baton_t *b = baton;
+  apr_off_t i;
+
+  SVN_ERR_ASSERT(modified_start == b->lines->nelts);
+  SVN_ERR_ASSERT(original_start + modified_length <= b->last_lines->nelts);
+
+  for (i = 0; i < modified_length; ++i)
+    APR_ARRAY_PUSH(b->lines, int)
+      = APR_ARRAY_IDX(b->last_lines, original_start + i, int);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_diff_output_fns_t.output_diff_modified.  Lines that
+   changed belong to the current revision. */
+static svn_error_t *
+output_diff_modified(void *baton,
+                     apr_off_t original_start,
+                     apr_off_t original_length,
+                     apr_off_t modified_start,
+                     apr_off_t modified_length,
+                     apr_off_t latest_start,
+                     apr_off_t latest_length)
+{
+  blame_baton_t *b = baton;
+  apr_off_t i;
+
+  SVN_ERR_ASSERT(modified_start == b->lines->nelts);
+
+  for (i = 0; i < modified_length; ++i)
+    APR_ARRAY_PUSH(b->lines, int) = b->current;
+
+  return SVN_NO_ERROR;
+}
+
+static const svn_diff_output_fns_t output_fns = {
+        output_common,
+        output_diff_modified
+};
+
+/* Decode RUNS, as stored in the blame cache, into B->LINES allocated in
+   RESULT_POOL and add the revisions referenced to B->REVS, which must be
+   empty.  Return FALSE if RUNS is corrupt. */
+static svn_boolean_t
+seed_lines(blame_baton_t *b,
+           const svn_string_t *runs,
+           apr_pool_t *result_pool)
+{
+  const unsigned char *p = (const unsigned char *)runs->data;
+  const unsigned char *end = p + runs->len;
+  apr_hash_t *rev_index = apr_hash_make(result_pool);
+
+  b->lines = apr_array_make(result_pool, 16, sizeof(int));
+  while (p < end)
+    {
+      apr_int64_t value;
+      apr_uint64_t count;
+      svn_revnum_t revision;
+      int *index;
+
+      p = svn__decode_int(&value, p, end);
+      if (p)
+        p = svn__decode_uint(&count, p, end);
+      if (!p || value < SVN_INVALID_REVNUM || value > b->node_rev
+          || count == 0 || count > INT_MAX - b->lines->nelts)
+        {
+          apr_array_clear(b->revs);
+          return FALSE;
+        }
+
+      revision = (svn_revnum_t)value;
+      index = apr_hash_get(rev_index, &revision, sizeof(revision));
+      if (!index)
+        {
+          blame_rev_t *rev = apr_pcalloc(b->pool, sizeof(*rev));
+          rev->revision = revision;
+
+          index = apr_palloc(result_pool, sizeof(*index));
+          *index = b->revs->nelts;
+          APR_ARRAY_PUSH(b->revs, blame_rev_t *) = rev;
+          apr_hash_set(rev_index, &rev->revision, sizeof(rev->revision),
+                       index);
+        }
+
+      while (count--)
+        APR_ARRAY_PUSH(b->lines, int) = *index;
+    }
+
+  return TRUE;
+}
+
+/* Clear all state in B that has been collected by file_rev_handler. */
+static void
+reset_baton(blame_baton_t *b)
+{
+  apr_array_clear(b->revs);
+  svn_pool_clear(b->last_pool);
+  svn_pool_clear(b->current_pool);
+
+  b->seed_runs = NULL;
+  b->last_text = svn_string_create_empty(b->pool);
+  b->last_lines = apr_array_make(b->pool, 0, sizeof(int));
+  b->lines = b->last_lines;
+  b->current = -1;
+}
+
+/* Implements svn_file_rev_handler_t, updating the line map in BATON,
+   a blame_baton_t, for the contents of PATH in revision REVNUM. */
+static svn_error_t *
+file_rev_handler(void *baton,
+                 const char *path,
+                 svn_revnum_t revnum,
+                 apr_hash_t *rev_props,
+                 svn_boolean_t result_of_merge,
+                 svn_txdelta_window_handler_t *content_delta_handler,
+                 void **content_delta_baton,
+                 apr_array_header_t *prop_diffs,
+                 apr_pool_t *pool)
+{
+  blame_baton_t *b = baton;
+  blame_rev_t *rev;
+  svn_fs_root_t *root;
+  svn_stream_t *contents;
+  svn_filesize_t length;
+  svn_string_t *text;
+  svn_diff_t *diff;
+  apr_pool_t *swap;
+
+  if (b->cancel_func)
+    SVN_ERR(b->cancel_func(b->cancel_baton));
+
+  /* Property-only changes are not of interest. */
+  if (!content_delta_handler)
+    return SVN_NO_ERROR;
+
+  /* We read the fulltext ourselves. */
+  *content_delta_handler = NULL;
+  *content_delta_baton = NULL;
+
+  SVN_ERR(svn_fs_revision_root(&root, svn_repos_fs(b->repos), revnum, pool));
+
+  /* We keep two fulltexts in memory.  Leave huge files to the client,
+     which streams the deltas through temporary files instead. */
+  SVN_ERR(svn_fs_file_length(&length, root, path, pool));
+  if (length > SVN_REPOS__BLAME_MAX_TEXT_SIZE)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("Cannot annotate '%s' on the server because "
+                               "r%ld of it is larger than %d bytes"),
+                             path, revnum, SVN_REPOS__BLAME_MAX_TEXT_SIZE);
+
+  SVN_ERR(svn_fs_file_contents(&contents, root, path, pool));
+  SVN_ERR(svn_string_from_stream2(&text, contents, (apr_size_t)length,
+                                  b->current_pool));
+
+  if (b->seed_runs)
+    {
+      svn_checksum_t *sha1;
+
+      /* Continue from the cached line map, if it is what we expect. */
+      SVN_ERR(svn_checksum(&sha1, svn_checksum_sha1, text->data, text->len,
+                           pool));
+      if (revnum != b->seed_rev
+          || strcmp(path, b->seed_path) != 0
+          || !svn_checksum_match(sha1, b->seed_sha1)
+          || !seed_lines(b, b->seed_runs, b->current_pool))
+        return svn_error_create(SVN_ERR_CEASE_INVOCATION, NULL, NULL);
+
+      b->seed_runs = NULL;
+    }
+  else
+    {
+      rev = apr_pcalloc(b->pool, sizeof(*rev));
+      if (revnum < b->start)
+        {
+          rev->revision = SVN_INVALID_REVNUM;
+        }
+      else
+        {
+          rev->revision = revnum;
+          rev->rev_props = svn_prop_hash_dup(rev_props, b->pool);
+        }
+
+      b->current = b->revs->nelts;
+      APR_ARRAY_PUSH(b->revs, blame_rev_t *) = rev;
+
+      b->lines = apr_array_make(b->current_pool,
+                                MAX(b->last_lines->nelts, 16), sizeof(int));
+      SVN_ERR(svn_diff_mem_string_diff(&diff, b->last_text, text,
+                                       b->diff_options, pool));
+      SVN_ERR(svn_diff_output2(diff, b, &output_fns,
+                               b->cancel_func, b->cancel_baton));
+    }
+
+  b->last_text = text;
+  b->last_lines = b->lines;
+
+  svn_pool_clear(b->last_pool);
+  swap = b->last_pool;
+  b->last_pool = b->current_pool;
+  b->current_pool = swap;
+
+  return SVN_NO_ERROR;
+}
+
+/* Open the blame cache of REPOS in *SDB, creating it if necessary.
+   Allocate the result in RESULT_POOL and use SCRATCH_POOL for
+   temporaries. */
+static svn_error_t *
+open_blame_cache(svn_sqlite__db_t **sdb,
+                 svn_repos_t *repos,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  const char *db_path = svn_dirent_join(repos->path, SVN_REPOS__BLAME_CACHE,
+                                        scratch_pool);
+  int version;
+
+  SVN_ERR(svn_sqlite__open(sdb, db_path, svn_sqlite__mode_rwcreate,
+                           statements, 0, NULL, 0,
+                           result_pool, scratch_pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, *sdb,
+                                                        scratch_pool),
+                        *sdb);
+  if (version <= 0)
+    SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(*sdb,
+                                                      STMT_CREATE_SCHEMA),
+                          *sdb);
+
+  return SVN_NO_ERROR;
+}
+
+/* Look up the blame of PATH@END in the cache SDB with the parameters
+   given in B and OPTIONS.  If the cache has the full result, put it into
+   B->LAST_LINES and set *COMPLETE.  Otherwise, prepare B to continue
+   from the youngest usable cache entry, if any, and clear *COMPLETE.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+lookup_blame(svn_boolean_t *complete,
+             blame_baton_t *b,
+             svn_sqlite__db_t *sdb,
+             const char *path,
+             svn_revnum_t end,
+             int options,
+             apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  svn_revnum_t revision;
+  const svn_checksum_t *sha1;
+  svn_string_t *runs;
+
+  *complete = FALSE;
+
+  SVN_ERR(svn_fs_revision_root(&root, svn_repos_fs(b->repos), end,
+                               scratch_pool));
+  SVN_ERR(svn_fs_node_created_rev(&b->node_rev, root, path, scratch_pool));
+  SVN_ERR(svn_fs_node_created_path(&b->node_path, root, path, b->pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_BLAME));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srdr", b->node_path, b->start, options,
+                            b->node_rev));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (!have_row)
+    return svn_error_trace(svn_sqlite__reset(stmt));
+
+  runs = apr_pcalloc(b->pool, sizeof(*runs));
+  revision = svn_sqlite__column_revnum(stmt, 0);
+  SVN_ERR(svn_sqlite__column_checksum(&sha1, stmt, 1, b->pool));
+  runs->data = svn_sqlite__column_blob(stmt, 2, &runs->len, b->pool);
+  if (!runs->data)
+    runs->data = "";
+
+  SVN_ERR(svn_sqlite__reset(stmt));
+  if (!sha1 || sha1->kind != svn_checksum_sha1)
+    return SVN_NO_ERROR;
+
+  if (revision == b->node_rev)
+    {
+      svn_checksum_t *actual;
+
+      SVN_ERR(svn_fs_file_checksum(&actual, svn_checksum_sha1, root, path,
+                                   TRUE, scratch_pool));
+      if (svn_checksum_match(actual, sha1)
+          && seed_lines(b, runs, b->last_pool))
+        {
+          b->last_lines = b->lines;
+          *complete = TRUE;
+        }
+    }
+  else
+    {
+      /* An older node-rev at the same path.  Whether it is part of our
+         node's history will only be known once we walk it. */
+      b->seed_runs = runs;
+      b->seed_rev = revision;
+      b->seed_sha1 = sha1;
+      b->seed_path = b->node_path;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Store RUNS, the encoded line map in B, in the cache SDB, replacing
+   older entries for the same path and parameters given in B and OPTIONS.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+store_blame(svn_sqlite__db_t *sdb,
+            const blame_baton_t *b,
+            int options,
+            const svn_stringbuf_t *runs,
+            apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_checksum_t *sha1;
+
+  SVN_ERR(svn_checksum(&sha1, svn_checksum_sha1, b->last_text->data,
+                       b->last_text->len, scratch_pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_BLAME));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srdr", b->node_path, b->start, options,
+                            b->node_rev));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 5, sha1, scratch_pool));
+  SVN_ERR(svn_sqlite__bind_blob(stmt, 6, runs->data, runs->len));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_DELETE_OLDER_BLAMES));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srdr", b->node_path, b->start, options,
+                            b->node_rev));
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+svn_error_t *
+svn_repos__get_blame(svn_repos_t *repos,
+                     const char *path,
+                     svn_revnum_t start,
+                     svn_revnum_t end,
+                     const svn_diff_file_options_t *diff_options,
+                     svn_repos_authz_func_t authz_read_func,
+                     void *authz_read_baton,
+                     svn_repos__blame_receiver_t receiver,
+                     void *receiver_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool)
+{
+  blame_baton_t b;
+  svn_sqlite__db_t *sdb = NULL;
+  svn_stringbuf_t *runs = NULL;
+  svn_boolean_t complete = FALSE;
+  int options;
+  apr_pool_t *iterpool;
+  svn_error_t *err;
+  int i, first;
+
+  if (start > end)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("Cannot annotate '%s' backwards from "
+                               "r%ld to r%ld"), path, start, end);
+
+  b.repos = repos;
+  b.start = start;
+  b.diff_options = diff_options;
+  b.node_path = NULL;
+  b.node_rev = SVN_INVALID_REVNUM;
+  b.revs = apr_array_make(scratch_pool, 16, sizeof(blame_rev_t *));
+  b.last_pool = svn_pool_create(scratch_pool);
+  b.current_pool = svn_pool_create(scratch_pool);
+  b.pool = scratch_pool;
+  b.cancel_func = cancel_func;
+  b.cancel_baton = cancel_baton;
+  reset_baton(&b);
+
+  /* The cache key for DIFF_OPTIONS. */
+  options = diff_options->ignore_space
+          | (diff_options->ignore_eol_style ? 4 : 0);
+
+  /* With path-based authz, the cached history might not be ours to see. */
+  if (!authz_read_func)
+    {
+      err = open_blame_cache(&sdb, repos, scratch_pool, scratch_pool);
+      if (!err)
+        err = lookup_blame(&complete, &b, sdb, path, end, options,
+                           scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          if (sdb)
+            svn_error_clear(svn_sqlite__close(sdb));
+
+          sdb = NULL;
+          complete = FALSE;
+          reset_baton(&b);
+        }
+    }
+
+  if (!complete)
+    {
+      /* Start one revision early to find out what changed in START
+         itself, unless we continue from a cached result. */
+      err = svn_repos_get_file_revs2(repos, path,
+                                     b.seed_runs ? b.seed_rev
+                                                 : MAX(0, start - 1),
+                                     end, FALSE,
+                                     authz_read_func, authz_read_baton,
+                                     file_rev_handler, &b, scratch_pool);
+      if (err && err->apr_err == SVN_ERR_CEASE_INVOCATION)
+        {
+          /* The cache entry is not part of this node's history. */
+          svn_error_clear(err);
+          reset_baton(&b);
+          err = svn_repos_get_file_revs2(repos, path, MAX(0, start - 1), end,
+                                         FALSE,
+                                         authz_read_func, authz_read_baton,
+                                         file_rev_handler, &b, scratch_pool);
+        }
+      SVN_ERR(err);
+
+      if (sdb)
+        runs = svn_stringbuf_create_ensure(2 * SVN__MAX_ENCODED_UINT_LEN
+                                             * b.revs->nelts,
+                                           scratch_pool);
+    }
+
+  /* Send the runs of lines that share the same revision. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (first = 0, i = 1; i <= b.last_lines->nelts; ++i)
+    {
+      blame_rev_t *rev;
+
+      if (i < b.last_lines->nelts
+          && APR_ARRAY_IDX(b.last_lines, i, int)
+               == APR_ARRAY_IDX(b.last_lines, first, int))
+        continue;
+
+      svn_pool_clear(iterpool);
+      rev = APR_ARRAY_IDX(b.revs, APR_ARRAY_IDX(b.last_lines, first, int),
+                          blame_rev_t *);
+
+      /* Revisions taken from the cache come without their properties. */
+      if (!rev->rev_props && SVN_IS_VALID_REVNUM(rev->revision))
+        SVN_ERR(svn_fs_revision_proplist2(&rev->rev_props, svn_repos_fs(repos),
+                                          rev->revision, TRUE,
+                                          scratch_pool, iterpool));
+
+      if (runs)
+        {
+          unsigned char buffer[2 * SVN__MAX_ENCODED_UINT_LEN];
+          unsigned char *p = svn__encode_int(buffer, rev->revision);
+
+          p = svn__encode_uint(p, i - first);
+          svn_stringbuf_appendbytes(runs, (const char *)buffer, p - buffer);
+        }
+
+      SVN_ERR(receiver(receiver_baton, first, i - first, rev->revision,
+                       rev->rev_props, iterpool));
+      first = i;
+    }
+
+  /* Failing to update the cache is not a problem for the caller. */
+  if (runs)
+    svn_error_clear(store_blame(sdb, &b, options, runs, iterpool));
+  if (sdb)
+    svn_error_clear(svn_sqlite__close(sdb));
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(b.last_pool);
+  svn_pool_destroy(b.current_pool);
+
+  return SVN_NO_ERROR;
+}
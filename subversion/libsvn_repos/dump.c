@@ -23,6 +23,8 @@
 
 #include <stdarg.h>
 
+#include <apr_thread_proc.h>
+
 #include "svn_private_config.h"
 #include "svn_pools.h"
 #include "svn_error.h"
@@ -37,6 +39,7 @@
 #include "svn_checksum.h"
 #include "svn_props.h"
 #include "svn_sorts.h"
+#include "svn_cache_config.h"
 
 #include "private/svn_repos_private.h"
 #include "private/svn_mergeinfo_private.h"
@@ -44,6 +47,9 @@
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_cache.h"
+#include "private/svn_mutex.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_thread_cond.h"
 
 #define ARE_VALID_COPY_ARGS(p,r) ((p) && SVN_IS_VALID_REVNUM(r))
 
@@ -1978,9 +1984,491 @@ dump_filter_authz_func(svn_boolean_t *allowed,
 
 
 
-/* The main dumper. */
+/* Dump revision REV of REPOS to STREAM as part of a dump that starts at
+   START_REV.  INCREMENTAL, USE_DELTAS, INCLUDE_REVPROPS and INCLUDE_CHANGES
+   are as for svn_repos_dump_fs4().  AUTHZ_FUNC and AUTHZ_BATON are passed
+   directly to the repos layer.
+
+   Set *FOUND_OLD_REFERENCE and *FOUND_OLD_MERGEINFO if REV refers to
+   revisions older than START_REV; leave them untouched otherwise.  Send
+   warnings to NOTIFY_FUNC with NOTIFY_BATON.  Use SCRATCH_POOL for
+   temporaries.
+ */
+static svn_error_t *
+dump_revision(svn_stream_t *stream,
+              svn_repos_t *repos,
+              svn_revnum_t rev,
+              svn_revnum_t start_rev,
+              svn_boolean_t incremental,
+              svn_boolean_t use_deltas,
+              svn_boolean_t include_revprops,
+              svn_boolean_t include_changes,
+              svn_boolean_t *found_old_reference,
+              svn_boolean_t *found_old_mergeinfo,
+              svn_repos_notify_func_t notify_func,
+              void *notify_baton,
+              svn_repos_authz_func_t authz_func,
+              void *authz_baton,
+              apr_pool_t *scratch_pool)
+{
+  const svn_delta_editor_t *dump_editor;
+  void *dump_edit_baton = NULL;
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_fs_root_t *to_root;
+  svn_boolean_t use_deltas_for_rev;
+
+  /* Write the revision record. */
+  SVN_ERR(write_revision_record(stream, repos, rev, include_revprops,
+                                authz_func, authz_baton, scratch_pool));
+
+  /* When dumping revision 0, we just write out the revision record.
+     The parser might want to use its properties.
+     If we don't want revision changes at all, skip in any case. */
+  if (rev == 0 || !include_changes)
+    return SVN_NO_ERROR;
+
+  /* Fetch the editor which dumps nodes to a file.  Regardless of
+     what we've been told, don't use deltas for the first rev of a
+     non-incremental dump. */
+  use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
+  SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
+                          "", stream, found_old_reference,
+                          found_old_mergeinfo, NULL,
+                          notify_func, notify_baton,
+                          start_rev, use_deltas_for_rev, FALSE, FALSE,
+                          scratch_pool));
+
+  /* Drive the editor in one way or another. */
+  SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, scratch_pool));
+
+  /* If this is the first revision of a non-incremental dump,
+     we're in for a full tree dump.  Otherwise, we want to simply
+     replay the revision.  */
+  if ((rev == start_rev) && (! incremental))
+    {
+      /* Compare against revision 0, so everything appears to be added. */
+      svn_fs_root_t *from_root;
+      SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, scratch_pool));
+      SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
+                                   to_root, "",
+                                   dump_editor, dump_edit_baton,
+                                   authz_func, authz_baton,
+                                   FALSE, /* don't send text-deltas */
+                                   svn_depth_infinity,
+                                   FALSE, /* don't send entry props */
+                                   FALSE, /* don't ignore ancestry */
+                                   scratch_pool));
+    }
+  else
+    {
+      /* The normal case: compare consecutive revs. */
+      SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
+                                dump_editor, dump_edit_baton,
+                                authz_func, authz_baton, scratch_pool));
+
+      /* While our editor close_edit implementation is a no-op, we still
+         do this for completeness. */
+      SVN_ERR(dump_editor->close_edit(dump_edit_baton, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Revisions dumped ahead by the workers keep up to this much data in
+   memory before spilling it into temporary files. */
+#define DUMP_SPILL_BLOCKSIZE (64 * 1024)
+#define DUMP_SPILL_MAXSIZE (1024 * 1024)
+
+/* Number of revisions per worker that may be dumped ahead of the one
+   being written to the output stream. */
+#define DUMP_REVS_AHEAD_PER_WORKER 4
+
+/* A revision being dumped by a worker thread. */
+typedef struct dump_job_t
+{
+  svn_revnum_t rev;
+
+  /* Set when the results are valid.  Protected by the dump mutex. */
+  svn_boolean_t done;
+
+  /* Results.  OUTPUT is the dump data of REV.  NOTIFICATIONS contains
+     the svn_repos_notify_t * warnings issued while dumping it. */
+  svn_spillbuf_t *output;
+  apr_array_header_t *notifications;
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
+  svn_error_t *err;
+
+  /* Owns the job and all its results. */
+  apr_pool_t *pool;
+} dump_job_t;
+
+/* Shared state of a dump that runs in several threads. */
+typedef struct parallel_dump_t
+{
+  /* Parameters for opening the workers' repository instances. */
+  const char *repos_path;
+  apr_hash_t *fs_config;
+
+  /* Parameters of the dump, see svn_repos__dump_fs(). */
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+  svn_boolean_t incremental;
+  svn_boolean_t use_deltas;
+  svn_boolean_t include_revprops;
+  svn_boolean_t include_changes;
+  svn_boolean_t collect_warnings;
+  svn_repos_authz_func_t authz_func;
+  void *authz_baton;
+
+  /* Synchronization.  COND gets signalled upon any state change. */
+  svn_mutex__t *mutex;
+  svn_thread_cond__t *cond;
+
+  /* The jobs for revisions NEXT_TO_WRITE up to NEXT_TO_START - 1, indexed
+     by revision modulo WINDOW.  All protected by MUTEX. */
+  dump_job_t **jobs;
+  int window;
+  svn_revnum_t next_to_start;
+  svn_revnum_t next_to_write;
+
+  /* Set when the workers shall terminate.  Protected by MUTEX. */
+  svn_boolean_t shutdown;
+
+  /* apr_thread_t * of the workers. */
+  apr_array_header_t *threads;
+
+  /* Owns the synchronization objects and threads. */
+  apr_pool_t *pool;
+} parallel_dump_t;
+
+/* Implements svn_repos_notify_func_t.  Add a copy of NOTIFY to the
+   notifications of the dump_job_t BATON. */
+static void
+collect_warning(void *baton,
+                const svn_repos_notify_t *notify,
+                apr_pool_t *scratch_pool)
+{
+  dump_job_t *job = baton;
+  svn_repos_notify_t *copy = apr_pmemdup(job->pool, notify, sizeof(*notify));
+
+  copy->warning_str = apr_pstrdup(job->pool, notify->warning_str);
+  copy->path = apr_pstrdup(job->pool, notify->path);
+  APR_ARRAY_PUSH(job->notifications, svn_repos_notify_t *) = copy;
+}
+
+/* Dump revisions as jobs for DUMP until there are no more or shutdown
+   is requested, reading from REPOS.  If REPOS is NULL, fail all jobs
+   with a copy of OPEN_ERR.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+run_dump_jobs(parallel_dump_t *dump,
+              svn_repos_t *repos,
+              svn_error_t *open_err,
+              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      dump_job_t *job = NULL;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_pool_clear(iterpool);
+
+      /* Wait until the next revision may be started. */
+      SVN_ERR(svn_mutex__lock(dump->mutex));
+
+      while (!err && !dump->shutdown
+             && dump->next_to_start <= dump->end_rev
+             && dump->next_to_start - dump->next_to_write >= dump->window)
+        err = svn_thread_cond__wait(dump->cond, dump->mutex);
+
+      if (!err && !dump->shutdown && dump->next_to_start <= dump->end_rev)
+        {
+          apr_pool_t *pool = svn_pool_create(NULL);
+
+          job = apr_pcalloc(pool, sizeof(*job));
+          job->pool = pool;
+          job->rev = dump->next_to_start++;
+          dump->jobs[job->rev % dump->window] = job;
+        }
+
+      SVN_ERR(svn_mutex__unlock(dump->mutex, err));
+
+      if (!job)
+        break;
+
+      /* Do the actual work outside the lock. */
+      if (repos)
+        {
+          job->output = svn_spillbuf__create(DUMP_SPILL_BLOCKSIZE,
+                                             DUMP_SPILL_MAXSIZE, job->pool);
+          job->notifications = apr_array_make(job->pool, 0,
+                                              sizeof(svn_repos_notify_t *));
+          err = dump_revision(svn_stream__from_spillbuf(job->output,
+                                                        job->pool),
+                              repos, job->rev, dump->start_rev,
+                              dump->incremental, dump->use_deltas,
+                              dump->include_revprops, dump->include_changes,
+                              &job->found_old_reference,
+                              &job->found_old_mergeinfo,
+                              dump->collect_warnings ? collect_warning : NULL,
+                              job, dump->authz_func, dump->authz_baton,
+                              iterpool);
+        }
+      else
+        {
+          err = svn_error_dup(open_err);
+        }
+
+      /* Hand the results to the main thread. */
+      SVN_ERR(svn_mutex__lock(dump->mutex));
+
+      job->err = err;
+      job->done = TRUE;
+
+      SVN_ERR(svn_mutex__unlock(dump->mutex,
+                                svn_thread_cond__broadcast(dump->cond)));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function of the dump workers.  DATA is the parallel_dump_t. */
+static void * APR_THREAD_FUNC
+dump_worker(apr_thread_t *thread,
+            void *data)
+{
+  parallel_dump_t *dump = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  apr_hash_t *fs_config = NULL;
+  svn_repos_t *repos;
+  svn_error_t *err;
+
+  /* svn_fs_t instances must not be shared between threads.  Neither may
+     hashes be iterated concurrently, so get our own copy of the config. */
+  err = svn_mutex__lock(dump->mutex);
+  if (!err)
+    {
+      if (dump->fs_config)
+        fs_config = apr_hash_copy(pool, dump->fs_config);
+      err = svn_mutex__unlock(dump->mutex, SVN_NO_ERROR);
+    }
+
+  if (!err)
+    err = svn_repos_open3(&repos, dump->repos_path, fs_config, pool, pool);
+
+  /* Errors here are synchronization failures.  There is no good way to
+     report them to the main thread, which will probably get stuck on
+     the same mutex anyway. */
+  svn_error_clear(run_dump_jobs(dump, err ? NULL : repos, err, pool));
+  svn_error_clear(err);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(thread, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Stop the workers of DUMP and release all its resources. */
+static svn_error_t *
+stop_parallel_dump(parallel_dump_t *dump)
+{
+  int i;
+
+  SVN_ERR(svn_mutex__lock(dump->mutex));
+  dump->shutdown = TRUE;
+  SVN_ERR(svn_mutex__unlock(dump->mutex,
+                            svn_thread_cond__broadcast(dump->cond)));
+
+  for (i = 0; i < dump->threads->nelts; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, APR_ARRAY_IDX(dump->threads, i,
+                                             apr_thread_t *));
+    }
+
+  /* No more workers, so all remaining jobs are done. */
+  for (i = 0; i < dump->window; ++i)
+    if (dump->jobs[i])
+      {
+        svn_error_clear(dump->jobs[i]->err);
+        svn_pool_destroy(dump->jobs[i]->pool);
+      }
+
+  svn_pool_destroy(dump->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the revisions dumped by the workers of DUMP to STREAM in order.
+   Update *FOUND_OLD_REFERENCE and *FOUND_OLD_MERGEINFO and send the
+   collected warnings as well as progress notifications to NOTIFY_FUNC
+   with NOTIFY_BATON.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+write_parallel_dump(parallel_dump_t *dump,
+                    svn_stream_t *stream,
+                    svn_boolean_t *found_old_reference,
+                    svn_boolean_t *found_old_mergeinfo,
+                    svn_repos_notify_func_t notify_func,
+                    void *notify_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_repos_notify_t *notify = NULL;
+  svn_revnum_t rev;
+
+  if (notify_func)
+    notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
+                                     scratch_pool);
+
+  for (rev = dump->start_rev; rev <= dump->end_rev; rev++)
+    {
+      dump_job_t *job = NULL;
+      svn_error_t *err = SVN_NO_ERROR;
+      const char *data;
+      apr_size_t len;
+      int i;
+
+      svn_pool_clear(iterpool);
+
+      /* Check for cancellation. */
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      /* Wait for the worker to finish REV. */
+      SVN_ERR(svn_mutex__lock(dump->mutex));
+
+      while (!err
+             && !((job = dump->jobs[rev % dump->window]) && job->done))
+        err = svn_thread_cond__wait(dump->cond, dump->mutex);
+
+      SVN_ERR(svn_mutex__unlock(dump->mutex, err));
+
+      /* The job is ours now.  Send its results as if we had just
+         dumped REV ourselves. */
+      err = job->err;
+      job->err = SVN_NO_ERROR;
+
+      for (i = 0; !err && i < job->notifications->nelts; ++i)
+        notify_func(notify_baton,
+                    APR_ARRAY_IDX(job->notifications, i,
+                                  svn_repos_notify_t *),
+                    iterpool);
+
+      while (!err)
+        {
+          err = svn_spillbuf__read(&data, &len, job->output, iterpool);
+          if (err || !data)
+            break;
+
+          err = svn_stream_write(stream, data, &len);
+        }
+
+      *found_old_reference |= job->found_old_reference;
+      *found_old_mergeinfo |= job->found_old_mergeinfo;
+
+      /* Let the workers proceed with the next revisions. */
+      SVN_ERR(svn_mutex__lock(dump->mutex));
+      dump->jobs[rev % dump->window] = NULL;
+      dump->next_to_write = rev + 1;
+      SVN_ERR(svn_mutex__unlock(dump->mutex,
+                                svn_thread_cond__broadcast(dump->cond)));
+
+      svn_pool_destroy(job->pool);
+      SVN_ERR(err);
+
+      if (notify_func)
+        {
+          notify->revision = rev;
+          notify_func(notify_baton, notify, iterpool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Start the workers for a dump of REPOS with the given parameters and
+   return the shared state in *DUMP.  See svn_repos__dump_fs() for the
+   parameters.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+start_parallel_dump(parallel_dump_t **dump_p,
+                    svn_repos_t *repos,
+                    svn_revnum_t start_rev,
+                    svn_revnum_t end_rev,
+                    svn_boolean_t incremental,
+                    svn_boolean_t use_deltas,
+                    svn_boolean_t include_revprops,
+                    svn_boolean_t include_changes,
+                    svn_boolean_t collect_warnings,
+                    svn_repos_authz_func_t authz_func,
+                    void *authz_baton,
+                    int jobs,
+                    apr_hash_t *fs_config,
+                    apr_pool_t *scratch_pool)
+{
+  /* The threads are created from and release their memory to this pool,
+     so make it independent from any pool used by the main thread. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+  parallel_dump_t *dump = apr_pcalloc(pool, sizeof(*dump));
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  dump->pool = pool;
+  dump->repos_path = svn_repos_path(repos, pool);
+  dump->fs_config = fs_config;
+  dump->start_rev = start_rev;
+  dump->end_rev = end_rev;
+  dump->incremental = incremental;
+  dump->use_deltas = use_deltas;
+  dump->include_revprops = include_revprops;
+  dump->include_changes = include_changes;
+  dump->collect_warnings = collect_warnings;
+  dump->authz_func = authz_func;
+  dump->authz_baton = authz_baton;
+  dump->window = jobs * DUMP_REVS_AHEAD_PER_WORKER;
+  dump->jobs = apr_pcalloc(pool, dump->window * sizeof(*dump->jobs));
+  dump->next_to_start = start_rev;
+  dump->next_to_write = start_rev;
+  dump->threads = apr_array_make(pool, jobs, sizeof(apr_thread_t *));
+
+  SVN_ERR(svn_mutex__init(&dump->mutex, TRUE, pool));
+  SVN_ERR(svn_thread_cond__create(&dump->cond, pool));
+
+  for (i = 0; i < jobs; ++i)
+    {
+      apr_thread_t *thread;
+      apr_status_t status = apr_thread_create(&thread, NULL, dump_worker,
+                                              dump, pool);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, _("Can't create dump worker"));
+          break;
+        }
+
+      APR_ARRAY_PUSH(dump->threads, apr_thread_t *) = thread;
+    }
+
+  if (err)
+    return svn_error_compose_create(err, stop_parallel_dump(dump));
+
+  *dump_p = dump;
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
 svn_error_t *
-svn_repos_dump_fs4(svn_repos_t *repos,
+svn_repos__dump_fs(svn_repos_t *repos,
                    svn_stream_t *stream,
                    svn_revnum_t start_rev,
                    svn_revnum_t end_rev,
@@ -1992,12 +2480,12 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                    void *notify_baton,
                    svn_repos_dump_filter_func_t filter_func,
                    void *filter_baton,
+                   int jobs,
+                   apr_hash_t *fs_config,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
                    apr_pool_t *pool)
 {
-  const svn_delta_editor_t *dump_editor;
-  void *dump_edit_baton = NULL;
   svn_revnum_t rev;
   svn_fs_t *fs = svn_repos_fs(repos);
   apr_pool_t *iterpool = svn_pool_create(pool);
@@ -2010,6 +2498,13 @@ svn_repos_dump_fs4(svn_repos_t *repos,
   svn_repos_authz_func_t authz_func;
   dump_filter_baton_t authz_baton = {0};
 
+#if APR_HAS_THREADS
+  /* The workers share the process-wide caches with us. */
+  if (jobs > 1 && svn_cache_config_get()->single_threaded)
+    return svn_error_create(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                            _("Parallel dumps require thread-safe caches"));
+#endif
+
   /* Make sure we catch up on the latest revprop changes.  This is the only
    * time we will refresh the revprop data in this query. */
   SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
@@ -2068,6 +2563,31 @@ svn_repos_dump_fs4(svn_repos_t *repos,
   SVN_ERR(svn_stream_printf(stream, pool, SVN_REPOS_DUMPFILE_UUID
                             ": %s\n\n", uuid));
 
+#if APR_HAS_THREADS
+  /* Let worker threads dump the revisions ahead of us.  The output of
+     each revision does not depend on any other, so we simply write them
+     in order as they become available. */
+  if (jobs > 1 && start_rev < end_rev)
+    {
+      parallel_dump_t *dump;
+      svn_error_t *err;
+
+      SVN_ERR(start_parallel_dump(&dump, repos, start_rev, end_rev,
+                                  incremental, use_deltas, include_revprops,
+                                  include_changes, notify_func != NULL,
+                                  authz_func, &authz_baton,
+                                  (int)MIN(jobs, end_rev - start_rev + 1),
+                                  fs_config, pool));
+      err = write_parallel_dump(dump, stream, &found_old_reference,
+                                &found_old_mergeinfo, notify_func,
+                                notify_baton, cancel_func, cancel_baton,
+                                iterpool);
+      SVN_ERR(svn_error_compose_create(err, stop_parallel_dump(dump)));
+
+      goto dump_end;
+    }
+#endif
+
   /* Create a notify object that we can reuse in the loop. */
   if (notify_func)
     notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
@@ -2076,70 +2596,18 @@ svn_repos_dump_fs4(svn_repos_t *repos,
   /* Main loop:  we're going to dump revision REV.  */
   for (rev = start_rev; rev <= end_rev; rev++)
     {
-      svn_fs_root_t *to_root;
-      svn_boolean_t use_deltas_for_rev;
-
       svn_pool_clear(iterpool);
 
       /* Check for cancellation. */
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Write the revision record. */
-      SVN_ERR(write_revision_record(stream, repos, rev, include_revprops,
-                                    authz_func, &authz_baton, iterpool));
-
-      /* When dumping revision 0, we just write out the revision record.
-         The parser might want to use its properties.
-         If we don't want revision changes at all, skip in any case. */
-      if (rev == 0 || !include_changes)
-        goto loop_end;
-
-      /* Fetch the editor which dumps nodes to a file.  Regardless of
-         what we've been told, don't use deltas for the first rev of a
-         non-incremental dump. */
-      use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
-      SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
-                              "", stream, &found_old_reference,
-                              &found_old_mergeinfo, NULL,
-                              notify_func, notify_baton,
-                              start_rev, use_deltas_for_rev, FALSE, FALSE,
-                              iterpool));
-
-      /* Drive the editor in one way or another. */
-      SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, iterpool));
-
-      /* If this is the first revision of a non-incremental dump,
-         we're in for a full tree dump.  Otherwise, we want to simply
-         replay the revision.  */
-      if ((rev == start_rev) && (! incremental))
-        {
-          /* Compare against revision 0, so everything appears to be added. */
-          svn_fs_root_t *from_root;
-          SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, iterpool));
-          SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
-                                       to_root, "",
-                                       dump_editor, dump_edit_baton,
-                                       authz_func, &authz_baton,
-                                       FALSE, /* don't send text-deltas */
-                                       svn_depth_infinity,
-                                       FALSE, /* don't send entry props */
-                                       FALSE, /* don't ignore ancestry */
-                                       iterpool));
-        }
-      else
-        {
-          /* The normal case: compare consecutive revs. */
-          SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
-                                    dump_editor, dump_edit_baton,
-                                    authz_func, &authz_baton, iterpool));
-
-          /* While our editor close_edit implementation is a no-op, we still
-             do this for completeness. */
-          SVN_ERR(dump_editor->close_edit(dump_edit_baton, iterpool));
-        }
+      SVN_ERR(dump_revision(stream, repos, rev, start_rev, incremental,
+                            use_deltas, include_revprops, include_changes,
+                            &found_old_reference, &found_old_mergeinfo,
+                            notify_func, notify_baton,
+                            authz_func, &authz_baton, iterpool));
 
-    loop_end:
       if (notify_func)
         {
           notify->revision = rev;
@@ -2147,6 +2615,9 @@ svn_repos_dump_fs4(svn_repos_t *repos,
         }
     }
 
+#if APR_HAS_THREADS
+ dump_end:
+#endif
   if (notify_func)
     {
       /* Did we issue any warnings about references to revisions older than
@@ -2185,6 +2656,34 @@ svn_repos_dump_fs4(svn_repos_t *repos,
   return SVN_NO_ERROR;
 }
 
+/* The main dumper. */
+svn_error_t *
+svn_repos_dump_fs4(svn_repos_t *repos,
+                   svn_stream_t *stream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t incremental,
+                   svn_boolean_t use_deltas,
+                   svn_boolean_t include_revprops,
+                   svn_boolean_t include_changes,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_repos_dump_filter_func_t filter_func,
+                   void *filter_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  return svn_error_trace(svn_repos__dump_fs(repos, stream, start_rev, end_rev,
+                                            incremental, use_deltas,
+                                            include_revprops, include_changes,
+                                            notify_func, notify_baton,
+                                            filter_func, filter_baton,
+                                            1, NULL,
+                                            cancel_func, cancel_baton,
+                                            pool));
+}
+
 
 /*----------------------------------------------------------------------*/
 
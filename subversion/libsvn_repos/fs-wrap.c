@@ -111,6 +111,11 @@ svn_repos_fs_commit_txn(const char **conflict_p,
       return err;
     }
 
+  /* Keep the changed-paths index, if any, up to date.  The commit itself
+     has already succeeded and the index merely falls behind if this fails;
+     it will then be ignored until it gets rebuilt. */
+  svn_error_clear(svn_repos__log_index_update(repos, *new_rev, pool));
+
   /* Run post-commit hooks. */
   if ((err2 = svn_repos__hooks_post_commit(repos, hooks_env,
                                            *new_rev, txn_name, pool)))
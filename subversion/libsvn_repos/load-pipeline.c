@@ -0,0 +1,1145 @@
+/* load-pipeline.c --- parsing a 'dumpfile' ahead of its consumer.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* The pipeline consists of three stages:
+ *
+ *   - A parser thread reads the dump stream and records all parser
+ *     callbacks in batches.  Every batch ends with a node or revision
+ *     record.  Text contents get spooled into spill buffers.
+ *
+ *   - Decoder threads decode (i.e. decompress) the svndiff text deltas
+ *     of queued batches and store them as uncompressed svndiff.  Deltas
+ *     that are uncompressed svndiff0 already, which is what 'svnadmin
+ *     dump' and 'svnrdump dump' produce, pass through unchanged.
+ *
+ *   - The calling thread replays the batches, strictly in stream order,
+ *     to the actual vtable.  That is usually the FS loader, which must
+ *     commit all revisions from a single thread anyway.
+ */
+
+#include <string.h>
+
+#include <apr.h>
+
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#endif
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_delta.h"
+#include "svn_repos.h"
+#include "svn_string.h"
+#include "repos.h"
+#include "svn_private_config.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_thread_cond.h"
+
+/* Queued batches may use about this much memory before the parser
+ * thread waits for the consumer to catch up. */
+#define DEFAULT_MEMORY_LIMIT (64 * 1024 * 1024)
+
+/* Spill buffer parameters for text contents.  Larger texts get spilled
+ * to temporary files. */
+#define SPILL_BLOCKSIZE (64 * 1024)
+#define SPILL_MAXSIZE (1024 * 1024)
+
+#if APR_HAS_THREADS
+
+/* Kinds of recorded parser callbacks. */
+typedef enum event_kind_t
+{
+  event_magic_header,
+  event_uuid,
+  event_new_revision,
+  event_new_node,
+  event_set_revision_property,
+  event_set_node_property,
+  event_delete_node_property,
+  event_remove_node_props,
+  event_text,
+  event_close_node,
+  event_close_revision
+} event_kind_t;
+
+/* A recorded parser callback. */
+typedef struct event_t
+{
+  event_kind_t kind;
+
+  /* Version number for event_magic_header. */
+  int version;
+
+  /* UUID or property name, if applicable. */
+  const char *name;
+
+  /* Property value, if applicable. */
+  const svn_string_t *value;
+
+  /* Record headers for event_new_revision and event_new_node. */
+  apr_hash_t *headers;
+
+  /* Text contents for event_text.  IS_DELTA tells whether they are
+   * in svndiff format.  FOR_NODE tells whether they belong to a node
+   * or a revision record. */
+  svn_spillbuf_t *text;
+  svn_boolean_t is_delta;
+  svn_boolean_t for_node;
+
+  /* The first HEADER_LEN bytes of TEXT, if IS_DELTA is set.  The svndiff
+   * header tells the format version. */
+  char header[4];
+  apr_size_t header_len;
+
+  /* Next event in the same batch. */
+  struct event_t *next;
+} event_t;
+
+/* Processing states of a batch. */
+typedef enum batch_state_t
+{
+  /* Contains text deltas that still need decoding. */
+  batch_parsed,
+
+  /* A decoder thread is working on it. */
+  batch_decoding,
+
+  /* May be replayed. */
+  batch_ready
+} batch_state_t;
+
+/* A sequence of events, ending with a node or revision record. */
+typedef struct batch_t
+{
+  /* Recorded events in stream order. */
+  event_t *first;
+  event_t *last;
+
+  /* Whether any text deltas need decoding.  Set when the batch gets
+   * queued. */
+  svn_boolean_t has_deltas;
+
+  /* Processing state and decoding error, if any.
+   * Protected by the pipeline mutex once the batch has been queued. */
+  batch_state_t state;
+  svn_error_t *err;
+
+  /* Memory charged against the pipeline's limit. */
+  apr_size_t size;
+
+  /* Next batch in the queue. */
+  struct batch_t *next;
+
+  /* Root pool owning this batch and all its contents. */
+  apr_pool_t *pool;
+} batch_t;
+
+typedef struct pipeline_t pipeline_t;
+
+/* Revision and node batons given to the real parser. */
+typedef struct record_baton_t
+{
+  pipeline_t *pipeline;
+
+  /* Whether this is a node record, as opposed to a revision record. */
+  svn_boolean_t is_node;
+
+  /* Whether the text contents of the record are a delta. */
+  svn_boolean_t text_is_delta;
+} record_baton_t;
+
+struct pipeline_t
+{
+  /* The stream to parse.  Used by the parser thread only. */
+  svn_stream_t *stream;
+
+  /* Synchronization.  COND gets signalled upon any state change. */
+  svn_mutex__t *mutex;
+  svn_thread_cond__t *cond;
+
+  /* Queued batches in stream order.  Protected by MUTEX. */
+  batch_t *first;
+  batch_t *last;
+
+  /* Memory charged by all queued batches.  Protected by MUTEX. */
+  apr_size_t memory_used;
+  apr_size_t memory_limit;
+
+  /* Set when the parser thread has terminated.  PARSER_ERR is its
+   * result.  Both protected by MUTEX. */
+  svn_boolean_t parser_done;
+  svn_error_t *parser_err;
+
+  /* Set when all threads shall terminate.  Written under MUTEX. */
+  volatile svn_atomic_t shutdown;
+
+  /* The batch being recorded and a scratch pool.  Used by the parser
+   * thread only. */
+  batch_t *current;
+  apr_pool_t *parser_pool;
+
+  /* Record batons handed out to the real parser. */
+  record_baton_t rev_record;
+  record_baton_t node_record;
+
+  /* Whether there are decoder threads.  If not, the parser thread
+   * decodes the text deltas itself. */
+  svn_boolean_t has_decoders;
+
+  /* Provides the batch pools. */
+  svn_root_pools__t *batch_pools;
+
+  /* apr_thread_t * of the parser and decoder threads. */
+  apr_array_header_t *threads;
+
+  /* Owns the synchronization objects and threads. */
+  apr_pool_t *pool;
+};
+
+/* Return the approximate memory used by BATCH. */
+static apr_size_t
+batch_size(batch_t *batch)
+{
+  apr_size_t size = sizeof(*batch);
+  event_t *event;
+
+  for (event = batch->first; event; event = event->next)
+    {
+      size += sizeof(*event);
+      if (event->value)
+        size += event->value->len;
+      if (event->text)
+        size += svn_spillbuf__get_memory_size(event->text);
+    }
+
+  return size;
+}
+
+/* Return the batch being recorded in PIPELINE, starting a new one
+ * if necessary. */
+static batch_t *
+current_batch(pipeline_t *pipeline)
+{
+  if (!pipeline->current)
+    {
+      apr_pool_t *pool = svn_root_pools__acquire_pool(pipeline->batch_pools);
+      pipeline->current = apr_pcalloc(pool, sizeof(*pipeline->current));
+      pipeline->current->pool = pool;
+    }
+
+  return pipeline->current;
+}
+
+/* Append a new event of the given KIND to PIPELINE's current batch and
+ * return it. */
+static event_t *
+add_event(pipeline_t *pipeline,
+          event_kind_t kind)
+{
+  batch_t *batch = current_batch(pipeline);
+  event_t *event = apr_pcalloc(batch->pool, sizeof(*event));
+
+  event->kind = kind;
+  if (batch->last)
+    batch->last->next = event;
+  else
+    batch->first = event;
+  batch->last = event;
+
+  return event;
+}
+
+/* Return a deep copy of the const char * -> const char * hash HEADERS,
+ * allocated in RESULT_POOL. */
+static apr_hash_t *
+copy_headers(apr_hash_t *headers,
+             apr_pool_t *result_pool)
+{
+  apr_hash_t *copy = apr_hash_make(result_pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(result_pool, headers); hi; hi = apr_hash_next(hi))
+    svn_hash_sets(copy,
+                  apr_pstrdup(result_pool, apr_hash_this_key(hi)),
+                  apr_pstrdup(result_pool, apr_hash_this_val(hi)));
+
+  return copy;
+}
+
+/* Return whether HEADERS announce a text delta. */
+static svn_boolean_t
+has_text_delta(apr_hash_t *headers)
+{
+  const char *value = svn_hash_gets(headers, SVN_REPOS_DUMPFILE_TEXT_DELTA);
+  return value && !strcmp(value, "true");
+}
+
+/* Return whether EVENT is a text delta that is not in the uncompressed
+ * svndiff0 format already. */
+static svn_boolean_t
+needs_decoding(const event_t *event)
+{
+  return event->kind == event_text
+      && event->is_delta
+      && !(event->header_len == sizeof(event->header)
+           && memcmp(event->header, "SVN\0", sizeof(event->header)) == 0);
+}
+
+/* Replace the svndiff data of all text delta events in BATCH by their
+ * uncompressed equivalent.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+decode_batch(batch_t *batch,
+             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  event_t *event;
+
+  for (event = batch->first; event; event = event->next)
+    {
+      svn_spillbuf_t *decoded;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      svn_stream_t *parser;
+      const char *data;
+      apr_size_t len;
+
+      if (!needs_decoding(event))
+        continue;
+
+      svn_pool_clear(iterpool);
+
+      decoded = svn_spillbuf__create(SPILL_BLOCKSIZE, SPILL_MAXSIZE,
+                                     batch->pool);
+      svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                              svn_stream__from_spillbuf(decoded, batch->pool),
+                              0, SVN_DELTA_COMPRESSION_LEVEL_NONE,
+                              batch->pool);
+      parser = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE,
+                                         iterpool);
+
+      do
+        {
+          SVN_ERR(svn_spillbuf__read(&data, &len, event->text, iterpool));
+          if (data)
+            SVN_ERR(svn_stream_write(parser, data, &len));
+        }
+      while (data);
+
+      SVN_ERR(svn_stream_close(parser));
+      event->text = decoded;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue PIPELINE's current batch, if any.  Wait while the queue uses
+ * more than the memory limit.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+enqueue_batch(pipeline_t *pipeline,
+              apr_pool_t *scratch_pool)
+{
+  batch_t *batch = pipeline->current;
+  svn_error_t *err = SVN_NO_ERROR;
+  event_t *event;
+
+  if (!batch)
+    return SVN_NO_ERROR;
+
+  for (event = batch->first; event; event = event->next)
+    batch->has_deltas |= needs_decoding(event);
+
+  /* Without decoder threads, we do that work here. */
+  if (batch->has_deltas && !pipeline->has_decoders)
+    SVN_ERR(decode_batch(batch, scratch_pool));
+
+  batch->size = batch_size(batch);
+  batch->state = (batch->has_deltas && pipeline->has_decoders)
+               ? batch_parsed
+               : batch_ready;
+
+  SVN_ERR(svn_mutex__lock(pipeline->mutex));
+
+  while (!err && !pipeline->shutdown && pipeline->first
+         && pipeline->memory_used > pipeline->memory_limit)
+    err = svn_thread_cond__wait(pipeline->cond, pipeline->mutex);
+
+  if (!err && pipeline->shutdown)
+    err = svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  if (!err)
+    {
+      if (pipeline->last)
+        pipeline->last->next = batch;
+      else
+        pipeline->first = batch;
+      pipeline->last = batch;
+
+      pipeline->memory_used += batch->size;
+      pipeline->current = NULL;
+
+      err = svn_thread_cond__broadcast(pipeline->cond);
+    }
+
+  return svn_error_trace(svn_mutex__unlock(pipeline->mutex, err));
+}
+
+/*----------------------------------------------------------------------*/
+
+/** The recording vtable used by the parser thread **/
+
+static svn_error_t *
+record_magic_header(int version,
+                    void *parse_baton,
+                    apr_pool_t *pool)
+{
+  event_t *event = add_event(parse_baton, event_magic_header);
+  event->version = version;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_uuid(const char *uuid,
+            void *parse_baton,
+            apr_pool_t *pool)
+{
+  pipeline_t *pipeline = parse_baton;
+  event_t *event = add_event(pipeline, event_uuid);
+  event->name = apr_pstrdup(pipeline->current->pool, uuid);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_new_revision(void **revision_baton,
+                    apr_hash_t *headers,
+                    void *parse_baton,
+                    apr_pool_t *pool)
+{
+  pipeline_t *pipeline = parse_baton;
+  event_t *event = add_event(pipeline, event_new_revision);
+  event->headers = copy_headers(headers, pipeline->current->pool);
+
+  pipeline->rev_record.text_is_delta = has_text_delta(headers);
+  *revision_baton = &pipeline->rev_record;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_new_node(void **node_baton,
+                apr_hash_t *headers,
+                void *revision_baton,
+                apr_pool_t *pool)
+{
+  record_baton_t *rb = revision_baton;
+  pipeline_t *pipeline;
+  event_t *event;
+
+  /* We don't know our pipeline without an enclosing revision record.
+   * No vtable could make any sense of such a node, either. */
+  if (!rb)
+    return svn_error_create(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                            _("Node record outside of a revision record "
+                              "in dumpstream"));
+
+  pipeline = rb->pipeline;
+  event = add_event(pipeline, event_new_node);
+  event->headers = copy_headers(headers, pipeline->current->pool);
+
+  pipeline->node_record.text_is_delta = has_text_delta(headers);
+  *node_baton = &pipeline->node_record;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_set_revision_property(void *baton,
+                             const char *name,
+                             const svn_string_t *value)
+{
+  record_baton_t *rb = baton;
+  event_t *event = add_event(rb->pipeline, event_set_revision_property);
+  apr_pool_t *pool = rb->pipeline->current->pool;
+
+  event->name = apr_pstrdup(pool, name);
+  event->value = svn_string_dup(value, pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_set_node_property(void *baton,
+                         const char *name,
+                         const svn_string_t *value)
+{
+  record_baton_t *rb = baton;
+  event_t *event = add_event(rb->pipeline, event_set_node_property);
+  apr_pool_t *pool = rb->pipeline->current->pool;
+
+  event->name = apr_pstrdup(pool, name);
+  event->value = svn_string_dup(value, pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_delete_node_property(void *baton,
+                            const char *name)
+{
+  record_baton_t *rb = baton;
+  event_t *event = add_event(rb->pipeline, event_delete_node_property);
+  event->name = apr_pstrdup(rb->pipeline->current->pool, name);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_remove_node_props(void *baton)
+{
+  record_baton_t *rb = baton;
+  add_event(rb->pipeline, event_remove_node_props);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for the text delta streams returned by record_set_fulltext(). */
+typedef struct delta_text_baton_t
+{
+  event_t *event;
+  svn_stream_t *inner;
+} delta_text_baton_t;
+
+/* Implements svn_write_fn_t, writing to the spill buffer of BATON's
+ * event and remembering the svndiff header. */
+static svn_error_t *
+write_delta_text(void *baton,
+                 const char *data,
+                 apr_size_t *len)
+{
+  delta_text_baton_t *db = baton;
+  event_t *event = db->event;
+
+  if (event->header_len < sizeof(event->header))
+    {
+      apr_size_t count = sizeof(event->header) - event->header_len;
+      if (count > *len)
+        count = *len;
+
+      memcpy(event->header + event->header_len, data, count);
+      event->header_len += count;
+    }
+
+  return svn_error_trace(svn_stream_write(db->inner, data, len));
+}
+
+/* Implements svn_close_fn_t. */
+static svn_error_t *
+close_delta_text(void *baton)
+{
+  delta_text_baton_t *db = baton;
+  return svn_error_trace(svn_stream_close(db->inner));
+}
+
+/* The parser gets invoked with DELTAS_ARE_TEXT set, so this receives
+ * text deltas as well. */
+static svn_error_t *
+record_set_fulltext(svn_stream_t **stream,
+                    void *baton)
+{
+  record_baton_t *rb = baton;
+  event_t *event = add_event(rb->pipeline, event_text);
+  batch_t *batch = rb->pipeline->current;
+
+  event->text = svn_spillbuf__create(SPILL_BLOCKSIZE, SPILL_MAXSIZE,
+                                     batch->pool);
+  event->is_delta = rb->text_is_delta;
+  event->for_node = rb->is_node;
+
+  *stream = svn_stream__from_spillbuf(event->text, batch->pool);
+
+  /* We need to know the svndiff version later. */
+  if (event->is_delta)
+    {
+      delta_text_baton_t *db = apr_palloc(batch->pool, sizeof(*db));
+      db->event = event;
+      db->inner = *stream;
+
+      *stream = svn_stream_create(db, batch->pool);
+      svn_stream_set_write(*stream, write_delta_text);
+      svn_stream_set_close(*stream, close_delta_text);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_close_node(void *baton)
+{
+  record_baton_t *rb = baton;
+  add_event(rb->pipeline, event_close_node);
+
+  return svn_error_trace(enqueue_batch(rb->pipeline,
+                                       rb->pipeline->parser_pool));
+}
+
+static svn_error_t *
+record_close_revision(void *baton)
+{
+  record_baton_t *rb = baton;
+  add_event(rb->pipeline, event_close_revision);
+
+  return svn_error_trace(enqueue_batch(rb->pipeline,
+                                       rb->pipeline->parser_pool));
+}
+
+static const svn_repos_parse_fns3_t recording_vtable =
+{
+  record_magic_header,
+  record_uuid,
+  record_new_revision,
+  record_new_node,
+  record_set_revision_property,
+  record_set_node_property,
+  record_delete_node_property,
+  record_remove_node_props,
+  record_set_fulltext,
+  NULL /* apply_textdelta; never called with DELTAS_ARE_TEXT */,
+  record_close_node,
+  record_close_revision
+};
+
+/*----------------------------------------------------------------------*/
+
+/** Worker threads **/
+
+/* Implements svn_cancel_func_t for the parser thread.
+ * BATON is the pipeline_t. */
+static svn_error_t *
+check_shutdown(void *baton)
+{
+  pipeline_t *pipeline = baton;
+  if (svn_atomic_read(&pipeline->shutdown))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function of the parser.  DATA is the pipeline_t. */
+static void * APR_THREAD_FUNC
+parser_thread(apr_thread_t *thread,
+              void *data)
+{
+  pipeline_t *pipeline = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  svn_error_t *err;
+
+  pipeline->parser_pool = svn_pool_create(pool);
+  err = svn_repos_parse_dumpstream3(pipeline->stream, &recording_vtable,
+                                    pipeline, TRUE, check_shutdown, pipeline,
+                                    pool);
+
+  /* Queue whatever follows the last record, e.g. a lone magic header. */
+  if (!err)
+    err = enqueue_batch(pipeline, pool);
+
+  /* Discard any incomplete batch. */
+  if (pipeline->current)
+    {
+      svn_root_pools__release_pool(pipeline->current->pool,
+                                   pipeline->batch_pools);
+      pipeline->current = NULL;
+    }
+
+  /* Errors here are synchronization failures.  There is no good way to
+     report them to the main thread, which will probably get stuck on
+     the same mutex anyway. */
+  svn_error_clear(svn_mutex__lock(pipeline->mutex));
+  pipeline->parser_done = TRUE;
+  pipeline->parser_err = err;
+  err = svn_thread_cond__broadcast(pipeline->cond);
+  svn_error_clear(svn_mutex__unlock(pipeline->mutex, err));
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(thread, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Return the first batch in PIPELINE's queue that needs decoding, or NULL.
+ * The caller must hold the pipeline mutex. */
+static batch_t *
+find_parsed_batch(pipeline_t *pipeline)
+{
+  batch_t *batch;
+  for (batch = pipeline->first; batch; batch = batch->next)
+    if (batch->state == batch_parsed)
+      return batch;
+
+  return NULL;
+}
+
+/* Decode batches from PIPELINE's queue until there will be no more or
+ * shutdown is requested.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+run_decoder(pipeline_t *pipeline,
+            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      batch_t *batch = NULL;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_pool_clear(iterpool);
+
+      /* Wait for the next batch to decode. */
+      SVN_ERR(svn_mutex__lock(pipeline->mutex));
+
+      while (!err && !pipeline->shutdown
+             && !(batch = find_parsed_batch(pipeline))
+             && !pipeline->parser_done)
+        err = svn_thread_cond__wait(pipeline->cond, pipeline->mutex);
+
+      if (pipeline->shutdown)
+        batch = NULL;
+      if (batch)
+        batch->state = batch_decoding;
+
+      SVN_ERR(svn_mutex__unlock(pipeline->mutex, err));
+
+      if (!batch)
+        break;
+
+      /* Do the actual work outside the lock. */
+      err = decode_batch(batch, iterpool);
+
+      /* Hand the result to the main thread. */
+      SVN_ERR(svn_mutex__lock(pipeline->mutex));
+
+      batch->err = err;
+      batch->state = batch_ready;
+
+      SVN_ERR(svn_mutex__unlock(pipeline->mutex,
+                                svn_thread_cond__broadcast(pipeline->cond)));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function of the decoders.  DATA is the pipeline_t. */
+static void * APR_THREAD_FUNC
+decoder_thread(apr_thread_t *thread,
+               void *data)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  /* See parser_thread() for why we drop the error. */
+  svn_error_clear(run_decoder(data, pool));
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(thread, APR_SUCCESS);
+
+  return NULL;
+}
+
+/*----------------------------------------------------------------------*/
+
+/** Replaying batches in the calling thread **/
+
+/* State of the replay, mirroring that of svn_repos_parse_dumpstream3(). */
+typedef struct replay_t
+{
+  const svn_repos_parse_fns3_t *parse_fns;
+  void *parse_baton;
+
+  /* Batons of the current records. */
+  void *rev_baton;
+  void *node_baton;
+
+  /* Cleared after each revision and node, respectively. */
+  apr_pool_t *revpool;
+  apr_pool_t *nodepool;
+
+  /* For everything else. */
+  apr_pool_t *pool;
+} replay_t;
+
+/* Send the text in EVENT to REPLAY's vtable.
+ * Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+replay_text(replay_t *replay,
+            event_t *event,
+            apr_pool_t *scratch_pool)
+{
+  const svn_repos_parse_fns3_t *parse_fns = replay->parse_fns;
+  void *baton = event->for_node ? replay->node_baton : replay->rev_baton;
+  svn_stream_t *stream = NULL;
+  const char *data;
+  apr_size_t len;
+
+  if (event->is_delta)
+    {
+      svn_txdelta_window_handler_t handler = NULL;
+      void *handler_baton;
+
+      if (parse_fns->apply_textdelta)
+        SVN_ERR(parse_fns->apply_textdelta(&handler, &handler_baton, baton));
+      if (handler)
+        stream = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE,
+                                           scratch_pool);
+    }
+  else if (parse_fns->set_fulltext)
+    {
+      SVN_ERR(parse_fns->set_fulltext(&stream, baton));
+    }
+
+  if (!stream)
+    return SVN_NO_ERROR;
+
+  do
+    {
+      SVN_ERR(svn_spillbuf__read(&data, &len, event->text, scratch_pool));
+      if (data)
+        SVN_ERR(svn_stream_write(stream, data, &len));
+    }
+  while (data);
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Send all events in BATCH to REPLAY's vtable.
+ * Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+replay_batch(replay_t *replay,
+             batch_t *batch,
+             apr_pool_t *scratch_pool)
+{
+  const svn_repos_parse_fns3_t *parse_fns = replay->parse_fns;
+  event_t *event;
+
+  for (event = batch->first; event; event = event->next)
+    switch (event->kind)
+      {
+        case event_magic_header:
+          if (parse_fns->magic_header_record)
+            SVN_ERR(parse_fns->magic_header_record(event->version,
+                                                   replay->parse_baton,
+                                                   replay->pool));
+          break;
+
+        case event_uuid:
+          if (parse_fns->uuid_record)
+            SVN_ERR(parse_fns->uuid_record(event->name, replay->parse_baton,
+                                           replay->pool));
+          break;
+
+        case event_new_revision:
+          /* The revision outlives this batch. */
+          replay->rev_baton = NULL;
+          if (parse_fns->new_revision_record)
+            {
+              apr_hash_t *headers = copy_headers(event->headers,
+                                                 replay->revpool);
+              SVN_ERR(parse_fns->new_revision_record(&replay->rev_baton,
+                                                     headers,
+                                                     replay->parse_baton,
+                                                     replay->revpool));
+            }
+          break;
+
+        case event_new_node:
+          replay->node_baton = NULL;
+          if (parse_fns->new_node_record)
+            SVN_ERR(parse_fns->new_node_record(&replay->node_baton,
+                                               event->headers,
+                                               replay->rev_baton,
+                                               replay->nodepool));
+          break;
+
+        case event_set_revision_property:
+          /* Revision properties must survive until the revision gets
+           * closed, which will usually happen in a later batch. */
+          if (parse_fns->set_revision_property)
+            SVN_ERR(parse_fns->set_revision_property(
+                        replay->rev_baton,
+                        apr_pstrdup(replay->revpool, event->name),
+                        svn_string_dup(event->value, replay->revpool)));
+          break;
+
+        case event_set_node_property:
+          if (parse_fns->set_node_property)
+            SVN_ERR(parse_fns->set_node_property(replay->node_baton,
+                                                 event->name, event->value));
+          break;
+
+        case event_delete_node_property:
+          if (parse_fns->delete_node_property)
+            SVN_ERR(parse_fns->delete_node_property(replay->node_baton,
+                                                    event->name));
+          break;
+
+        case event_remove_node_props:
+          if (parse_fns->remove_node_props)
+            SVN_ERR(parse_fns->remove_node_props(replay->node_baton));
+          break;
+
+        case event_text:
+          SVN_ERR(replay_text(replay, event, scratch_pool));
+          break;
+
+        case event_close_node:
+          if (parse_fns->close_node)
+            SVN_ERR(parse_fns->close_node(replay->node_baton));
+          replay->node_baton = NULL;
+          svn_pool_clear(replay->nodepool);
+          break;
+
+        case event_close_revision:
+          if (parse_fns->close_revision)
+            SVN_ERR(parse_fns->close_revision(replay->rev_baton));
+          replay->rev_baton = NULL;
+          svn_pool_clear(replay->revpool);
+          break;
+      }
+
+  return SVN_NO_ERROR;
+}
+
+/* Replay all batches from PIPELINE in order to REPLAY's vtable until the
+ * parser is done.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+consume_batches(pipeline_t *pipeline,
+                replay_t *replay,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      batch_t *batch;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_pool_clear(iterpool);
+
+      /* Wait for the next batch in stream order to become ready. */
+      SVN_ERR(svn_mutex__lock(pipeline->mutex));
+
+      while (!err
+             && !(pipeline->first && pipeline->first->state == batch_ready)
+             && !(pipeline->parser_done && !pipeline->first))
+        err = svn_thread_cond__wait(pipeline->cond, pipeline->mutex);
+
+      batch = err ? NULL : pipeline->first;
+      if (batch)
+        {
+          pipeline->first = batch->next;
+          if (!pipeline->first)
+            pipeline->last = NULL;
+        }
+
+      SVN_ERR(svn_mutex__unlock(pipeline->mutex, err));
+
+      if (!batch)
+        break;
+
+      err = batch->err;
+      batch->err = SVN_NO_ERROR;
+      if (!err)
+        err = replay_batch(replay, batch, iterpool);
+
+      /* Make room for the parser. */
+      svn_error_clear(svn_mutex__lock(pipeline->mutex));
+      pipeline->memory_used -= batch->size;
+      svn_error_clear(svn_mutex__unlock(pipeline->mutex,
+                              svn_thread_cond__broadcast(pipeline->cond)));
+
+      svn_root_pools__release_pool(batch->pool, pipeline->batch_pools);
+      SVN_ERR(err);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Start the parser thread and JOBS-2 decoder threads for PIPELINE. */
+static svn_error_t *
+start_threads(pipeline_t *pipeline,
+              int jobs)
+{
+  apr_thread_t *thread;
+  apr_status_t status;
+  int i;
+
+  /* The calling thread replays the batches, one more parses the stream
+   * and the remaining ones decode text deltas. */
+  pipeline->has_decoders = jobs > 2;
+  for (i = 2; i < jobs; ++i)
+    {
+      status = apr_thread_create(&thread, NULL, decoder_thread, pipeline,
+                                 pipeline->pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create decoder thread"));
+
+      APR_ARRAY_PUSH(pipeline->threads, apr_thread_t *) = thread;
+    }
+
+  status = apr_thread_create(&thread, NULL, parser_thread, pipeline,
+                             pipeline->pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create parser thread"));
+
+  APR_ARRAY_PUSH(pipeline->threads, apr_thread_t *) = thread;
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop all threads of PIPELINE and release all remaining batches.
+ * Return the parser error, if any. */
+static svn_error_t *
+stop_threads(pipeline_t *pipeline)
+{
+  batch_t *batch;
+  svn_error_t *err;
+  int i;
+
+  SVN_ERR(svn_mutex__lock(pipeline->mutex));
+  svn_atomic_set(&pipeline->shutdown, TRUE);
+  SVN_ERR(svn_mutex__unlock(pipeline->mutex,
+                            svn_thread_cond__broadcast(pipeline->cond)));
+
+  for (i = 0; i < pipeline->threads->nelts; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, APR_ARRAY_IDX(pipeline->threads, i,
+                                             apr_thread_t *));
+    }
+
+  /* No more threads, so no more locking required. */
+  for (batch = pipeline->first; batch; )
+    {
+      batch_t *next = batch->next;
+      svn_error_clear(batch->err);
+      svn_root_pools__release_pool(batch->pool, pipeline->batch_pools);
+      batch = next;
+    }
+
+  pipeline->first = NULL;
+  pipeline->last = NULL;
+
+  err = pipeline->parser_err;
+  pipeline->parser_err = SVN_NO_ERROR;
+
+  return svn_error_trace(err);
+}
+
+#endif
+
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      int jobs,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  pipeline_t *pipeline;
+  replay_t replay;
+  svn_error_t *err;
+  svn_error_t *parser_err;
+
+  if (jobs > 1)
+    {
+      pipeline = apr_pcalloc(pool, sizeof(*pipeline));
+      pipeline->stream = stream;
+      pipeline->memory_limit = DEFAULT_MEMORY_LIMIT;
+      pipeline->rev_record.pipeline = pipeline;
+      pipeline->rev_record.is_node = FALSE;
+      pipeline->node_record.pipeline = pipeline;
+      pipeline->node_record.is_node = TRUE;
+      pipeline->threads = apr_array_make(pool, jobs - 1,
+                                         sizeof(apr_thread_t *));
+
+      /* The threads are created from and release their memory to this
+         pool, so make it independent from any pool used by the caller. */
+      pipeline->pool = svn_pool_create(NULL);
+
+      SVN_ERR(svn_mutex__init(&pipeline->mutex, TRUE, pipeline->pool));
+      SVN_ERR(svn_thread_cond__create(&pipeline->cond, pipeline->pool));
+      SVN_ERR(svn_root_pools__create2(&pipeline->batch_pools, jobs, 0));
+
+      /* REPLAY.POOL is a sub-pool of POOL and gets used by PARSE_FNS while
+         the parser thread reads STREAM.  That is only safe because our
+         caller guarantees that STREAM does not share POOL's allocator
+         unless that allocator is thread-safe. */
+      replay.parse_fns = parse_fns;
+      replay.parse_baton = parse_baton;
+      replay.rev_baton = NULL;
+      replay.node_baton = NULL;
+      replay.pool = svn_pool_create(pool);
+      replay.revpool = svn_pool_create(replay.pool);
+      replay.nodepool = svn_pool_create(replay.pool);
+
+      err = start_threads(pipeline, jobs);
+      if (!err)
+        err = consume_batches(pipeline, &replay, cancel_func, cancel_baton,
+                              replay.pool);
+
+      /* A parser that got shut down because we failed reports that as
+         cancellation, which is not news to anybody. */
+      parser_err = stop_threads(pipeline);
+      if (err && parser_err && parser_err->apr_err == SVN_ERR_CANCELLED)
+        svn_error_clear(parser_err);
+      else
+        err = svn_error_compose_create(err, parser_err);
+
+      svn_pool_destroy(replay.pool);
+      svn_root_pools__destroy(pipeline->batch_pools);
+      svn_pool_destroy(pipeline->pool);
+
+      return svn_error_trace(err);
+    }
+#endif
+
+  return svn_error_trace(svn_repos_parse_dumpstream3(stream, parse_fns,
+                                                     parse_baton, FALSE,
+                                                     cancel_func,
+                                                     cancel_baton, pool));
+}
@@ -0,0 +1,95 @@
+/* log-index-db.sql -- schema of the changed-paths index
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* For every revision, all paths that got changed in it as well as all of
+   their parent paths, i.e. every path that has changes at or below it.
+   Paths are absolute FS paths. */
+CREATE TABLE changed_paths (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  PRIMARY KEY (path, revision)
+  );
+
+/* The mergeinfo changes per revision and path, as returned by
+   svn_repos__fs_mergeinfo_changed().  Revisions without mergeinfo
+   changes have no entries.  DELETED and ADDED are mergeinfo strings. */
+CREATE TABLE mergeinfo_changes (
+  revision INTEGER NOT NULL,
+  path TEXT NOT NULL,
+  deleted TEXT NOT NULL,
+  added TEXT NOT NULL,
+  PRIMARY KEY (revision, path)
+  );
+
+/* Single-row table recording the youngest revision that has been
+   indexed.  All revisions up to and including it are in CHANGED_PATHS. */
+CREATE TABLE indexed (
+  id INTEGER NOT NULL PRIMARY KEY,
+  youngest INTEGER NOT NULL
+  );
+
+INSERT INTO indexed (id, youngest) VALUES (0, -1);
+
+PRAGMA USER_VERSION = 1;
+
+-- STMT_GET_YOUNGEST
+SELECT youngest
+FROM indexed
+WHERE id = 0
+
+-- STMT_SET_YOUNGEST
+/* Never go backwards; concurrent updates may finish out of order. */
+UPDATE indexed
+SET youngest = ?1
+WHERE id = 0 AND youngest < ?1
+
+-- STMT_RESET_YOUNGEST
+UPDATE indexed
+SET youngest = -1
+WHERE id = 0
+
+-- STMT_INSERT_CHANGED_PATH
+INSERT OR IGNORE INTO changed_paths (path, revision)
+VALUES (?1, ?2)
+
+-- STMT_SELECT_CHANGED_REVISIONS
+SELECT revision
+FROM changed_paths
+WHERE path = ?1 AND revision >= ?2 AND revision <= ?3
+ORDER BY revision DESC
+
+-- STMT_DELETE_ALL_CHANGED_PATHS
+DELETE FROM changed_paths
+
+-- STMT_INSERT_MERGEINFO_CHANGE
+INSERT OR REPLACE INTO mergeinfo_changes (revision, path, deleted, added)
+VALUES (?1, ?2, ?3, ?4)
+
+-- STMT_SELECT_MERGEINFO_CHANGES
+SELECT path, deleted, added
+FROM mergeinfo_changes
+WHERE revision = ?1
+
+-- STMT_DELETE_ALL_MERGEINFO_CHANGES
+DELETE FROM mergeinfo_changes
@@ -56,6 +56,9 @@ typedef struct log_callbacks_t
   void *revision_receiver_baton;
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
+
+  /* The changed-paths index of the repository.  May be NULL. */
+  svn_repos__log_index_t *log_index;
 } log_callbacks_t;
 
 
@@ -609,18 +612,16 @@ next_history_rev(const apr_array_header_t *histories)
   return next_rev;
 }
 
-/* Set *DELETED_MERGEINFO_CATALOG and *ADDED_MERGEINFO_CATALOG to
-   catalogs describing how mergeinfo values on paths (which are the
-   keys of those catalogs) were changed in REV. */
 /* ### TODO: This would make a *great*, useful public function,
    ### svn_repos_fs_mergeinfo_changed()!  -- cmpilato  */
-static svn_error_t *
-fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
-                     svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
-                     svn_fs_t *fs,
-                     svn_revnum_t rev,
-                     apr_pool_t *result_pool,
-                     apr_pool_t *scratch_pool)
+svn_error_t *
+svn_repos__fs_mergeinfo_changed(
+  svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
+  svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
+  svn_fs_t *fs,
+  svn_revnum_t rev,
+  apr_pool_t *result_pool,
+  apr_pool_t *scratch_pool)
 {
   svn_fs_root_t *root;
   apr_pool_t *iterpool, *iterator_pool;
@@ -877,11 +878,14 @@ fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
 
 /* Determine what (if any) mergeinfo for PATHS was modified in
    revision REV, returning the differences for added mergeinfo in
-   *ADDED_MERGEINFO and deleted mergeinfo in *DELETED_MERGEINFO. */
+   *ADDED_MERGEINFO and deleted mergeinfo in *DELETED_MERGEINFO.
+   If LOG_INDEX is not NULL, take the raw mergeinfo changes of REV
+   from there instead of the FS, as far as it covers REV. */
 static svn_error_t *
 get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
                                svn_mergeinfo_t *deleted_mergeinfo,
                                svn_fs_t *fs,
+                               svn_repos__log_index_t *log_index,
                                const apr_array_header_t *paths,
                                svn_revnum_t rev,
                                apr_pool_t *result_pool,
@@ -906,11 +910,22 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
   if (! paths->nelts)
     return SVN_NO_ERROR;
 
-  /* Fetch the mergeinfo changes for REV. */
-  err = fs_mergeinfo_changed(&deleted_mergeinfo_catalog,
-                             &added_mergeinfo_catalog,
-                             fs, rev,
-                             scratch_pool, scratch_pool);
+  /* Fetch the mergeinfo changes for REV, preferably from the index. */
+  added_mergeinfo_catalog = NULL;
+  if (log_index)
+    SVN_ERR(svn_repos__log_index_mergeinfo_changed(&deleted_mergeinfo_catalog,
+                                                   &added_mergeinfo_catalog,
+                                                   log_index, rev,
+                                                   scratch_pool,
+                                                   scratch_pool));
+
+  if (added_mergeinfo_catalog)
+    err = SVN_NO_ERROR;
+  else
+    err = svn_repos__fs_mergeinfo_changed(&deleted_mergeinfo_catalog,
+                                          &added_mergeinfo_catalog,
+                                          fs, rev,
+                                          scratch_pool, scratch_pool);
   if (err)
     {
       if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
@@ -1372,10 +1387,10 @@ send_log(svn_revnum_t rev,
 
       /* Pass a scratch pool to ensure no temporary state stored
          by the receiver callback persists. */
-      scratch_pool = svn_pool_create(pool);
+      scratch_pool = svn_pool__create_arena(pool);
       SVN_ERR(callbacks->revision_receiver(callbacks->revision_receiver_baton,
                                            &log_entry, scratch_pool));
-      svn_pool_destroy(scratch_pool);
+      svn_pool__destroy_arena(scratch_pool);
     }
 
   return SVN_NO_ERROR;
@@ -2075,7 +2090,9 @@ do_logs(svn_fs_t *fs,
                 }
               SVN_ERR(get_combined_mergeinfo_changes(&added_mergeinfo,
                                                      &deleted_mergeinfo,
-                                                     fs, cur_paths,
+                                                     fs,
+                                                     callbacks->log_index,
+                                                     cur_paths,
                                                      current,
                                                      iterpool, iterpool));
               has_children = (apr_hash_count(added_mergeinfo) > 0
@@ -2303,6 +2320,129 @@ get_paths_history_as_mergeinfo(svn_mergeinfo_t *paths_history_mergeinfo,
   return SVN_NO_ERROR;
 }
 
+/* Send the log for PATHS between START and END, like do_logs() does
+   without merge tracking, but look up the revisions in INDEX instead of
+   walking the node histories.  INDEX must cover END.
+
+   INDEX lists the revisions in which a given path or anything below it
+   got changed.  Restricting that to the location segments of each path,
+   i.e. to the times the respective node lived at that path, and adding
+   the revisions in which the node has been copied or added, gives us the
+   node history.  All other parameters are as for svn_repos_get_logs5(). */
+static svn_error_t *
+get_logs_from_index(svn_repos__log_index_t *index,
+                    svn_repos_t *repos,
+                    const apr_array_header_t *paths,
+                    svn_revnum_t start,
+                    svn_revnum_t end,
+                    int limit,
+                    svn_boolean_t strict_node_history,
+                    const apr_array_header_t *revprops,
+                    svn_boolean_t descending_order,
+                    const log_callbacks_t *callbacks,
+                    apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *revs = apr_array_make(scratch_pool, 16,
+                                            sizeof(svn_revnum_t));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_fs_root_t *root;
+  int i, count;
+
+  SVN_ERR(svn_fs_revision_root(&root, repos->fs, end, scratch_pool));
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *this_path = APR_ARRAY_IDX(paths, i, const char *);
+      struct location_segment_baton loc_seg_baton;
+      int k;
+
+      svn_pool_clear(iterpool);
+
+      /* Same check as in get_path_histories(). */
+      if (callbacks->authz_read_func)
+        {
+          svn_boolean_t readable;
+          SVN_ERR(callbacks->authz_read_func(&readable, root, this_path,
+                                             callbacks->authz_read_baton,
+                                             iterpool));
+          if (! readable)
+            return svn_error_create(SVN_ERR_AUTHZ_UNREADABLE, NULL, NULL);
+        }
+
+      /* Get the full segments, youngest first.  Limiting them to START
+         would make us mistake the truncated start for a copy. */
+      loc_seg_baton.pool = iterpool;
+      loc_seg_baton.history_segments =
+        apr_array_make(iterpool, 4, sizeof(svn_location_segment_t *));
+      SVN_ERR(svn_repos_node_location_segments(repos, this_path, end,
+                                               end, 0,
+                                               location_segment_receiver,
+                                               &loc_seg_baton,
+                                               callbacks->authz_read_func,
+                                               callbacks->authz_read_baton,
+                                               iterpool));
+
+      for (k = 0; k < loc_seg_baton.history_segments->nelts; k++)
+        {
+          svn_location_segment_t *segment
+            = APR_ARRAY_IDX(loc_seg_baton.history_segments, k,
+                            svn_location_segment_t *);
+
+          if (segment->range_end < start)
+            break;
+
+          /* Skip gaps in the node's history. */
+          if (segment->path)
+            {
+              const char *fspath
+                = svn_fspath__canonicalize(segment->path, iterpool);
+
+              SVN_ERR(svn_repos__log_index_get_revs(
+                        revs, index, fspath,
+                        MAX(segment->range_start, start),
+                        segment->range_end, iterpool));
+
+              /* The node got copied or added here. */
+              if (segment->range_start >= start)
+                APR_ARRAY_PUSH(revs, svn_revnum_t) = segment->range_start;
+            }
+
+          if (strict_node_history)
+            break;
+        }
+    }
+
+  /* Combine the revisions of all paths, youngest first. */
+  svn_sort__array(revs, svn_sort_compare_revisions);
+  for (i = 0, count = 0; i < revs->nelts; i++)
+    {
+      svn_revnum_t rev = APR_ARRAY_IDX(revs, i, svn_revnum_t);
+      if (count == 0 || APR_ARRAY_IDX(revs, count - 1, svn_revnum_t) != rev)
+        APR_ARRAY_IDX(revs, count++, svn_revnum_t) = rev;
+    }
+  revs->nelts = count;
+
+  /* Send the youngest or oldest LIMIT revisions, depending on the
+     requested order. */
+  if (limit > 0 && count > limit)
+    count = limit;
+  for (i = 0; i < count; i++)
+    {
+      svn_revnum_t rev
+        = descending_order ? APR_ARRAY_IDX(revs, i, svn_revnum_t)
+                           : APR_ARRAY_IDX(revs, revs->nelts - 1 - i,
+                                           svn_revnum_t);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(send_log(rev, repos->fs, NULL, NULL,
+                       FALSE, FALSE, revprops, FALSE,
+                       callbacks, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_repos_get_logs5(svn_repos_t *repos,
                     const apr_array_header_t *paths,
@@ -2332,6 +2472,7 @@ svn_repos_get_logs5(svn_repos_t *repos,
   callbacks.revision_receiver_baton = revision_receiver_baton;
   callbacks.authz_read_func = authz_read_func;
   callbacks.authz_read_baton = authz_read_baton;
+  callbacks.log_index = NULL;
 
   if (revprops)
     {
@@ -2443,6 +2584,19 @@ svn_repos_get_logs5(svn_repos_t *repos,
       return SVN_NO_ERROR;
     }
 
+  /* Without merge tracking, the changed-paths index gives us the
+     revisions to report directly, provided it covers the range.  With
+     merge tracking, it still saves us from re-calculating the mergeinfo
+     changes of every revision. */
+  SVN_ERR(svn_repos__log_index_open(&callbacks.log_index, repos, end,
+                                    scratch_pool, scratch_pool));
+  if (callbacks.log_index && ! include_merged_revisions)
+    return svn_error_trace(get_logs_from_index(callbacks.log_index, repos,
+                                               paths, start, end, limit,
+                                               strict_node_history,
+                                               revprops, descending_order,
+                                               &callbacks, scratch_pool));
+
   /* If we are including merged revisions, then create mergeinfo that
      represents all of PATHS' history between START and END.  We will use
      this later to squelch duplicate log revisions that might exist in
@@ -0,0 +1,473 @@
+/* log_index.c --- the changed-paths index used by svn_repos_get_logs5()
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_dirent_uri.h"
+#include "svn_fs.h"
+#include "svn_hash.h"
+#include "svn_mergeinfo.h"
+#include "svn_pools.h"
+#include "svn_repos.h"
+#include "svn_sorts.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_sqlite.h"
+
+#include "repos.h"
+#include "svn_private_config.h"
+
+#include "log-index-db.h"
+
+LOG_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+/* Theory of operation:
+
+   The index lists for every revision all changed paths plus all of their
+   parent directories.  Thus, looking up a path yields all revisions in
+   which something at or below that path got changed.  Combined with the
+   location segments of a node, this is the node's history without having
+   to walk it step by step.
+
+   It also caches the mergeinfo changes of each revision such that
+   'svn log -g' does not need to find and parse them over and over again.
+
+   The index is optional and only gets maintained when it exists.  It
+   records the youngest revision covered; queries beyond that revision
+   must not use it.  Commits keep it up to date, catching up on a few
+   missing revisions if necessary.  Everything else, e.g. a long-running
+   load, requires svn_repos__log_index_build() to get it back in sync. */
+
+/* Maximum number of revisions that a commit will add to the index.
+   Lagging further behind requires an explicit rebuild. */
+#define MAX_CATCH_UP_REVISIONS 16
+
+/* Number of revisions to add per SQLite transaction while building
+   the index. */
+#define BUILD_BATCH_SIZE 100
+
+struct svn_repos__log_index_t
+{
+  /* The index database. */
+  svn_sqlite__db_t *sdb;
+
+  /* Youngest revision covered by the index. */
+  svn_revnum_t youngest;
+};
+
+/* Return the path of the index DB in REPOS, allocated in RESULT_POOL. */
+static const char *
+log_index_path(svn_repos_t *repos,
+               apr_pool_t *result_pool)
+{
+  return svn_dirent_join(repos->path, SVN_REPOS__LOG_INDEX, result_pool);
+}
+
+/* Open the index DB in REPOS and return it in *SDB.  If it does not exist
+   and CREATE is not set, set *SDB to NULL.  Allocate the result in
+   RESULT_POOL and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+open_index_db(svn_sqlite__db_t **sdb,
+              svn_repos_t *repos,
+              svn_boolean_t create,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  const char *db_path = log_index_path(repos, scratch_pool);
+  int version;
+
+  if (!create)
+    {
+      svn_node_kind_t kind;
+      SVN_ERR(svn_io_check_path(db_path, &kind, scratch_pool));
+      if (kind != svn_node_file)
+        {
+          *sdb = NULL;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  SVN_ERR(svn_sqlite__open(sdb, db_path,
+                           create ? svn_sqlite__mode_rwcreate
+                                  : svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, 0,
+                           result_pool, scratch_pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, *sdb,
+                                                        scratch_pool),
+                        *sdb);
+  if (version <= 0)
+    SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(*sdb,
+                                                      STMT_CREATE_SCHEMA),
+                          *sdb);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *YOUNGEST to the youngest revision covered by the index in SDB. */
+static svn_error_t *
+get_youngest(svn_revnum_t *youngest,
+             svn_sqlite__db_t *sdb)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_YOUNGEST));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *youngest = have_row ? svn_sqlite__column_revnum(stmt, 0)
+                       : SVN_INVALID_REVNUM;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Add the mergeinfo changes of revision REVISION in FS to the index
+   in SDB.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+index_mergeinfo_changes(svn_sqlite__db_t *sdb,
+                        svn_fs_t *fs,
+                        svn_revnum_t revision,
+                        apr_pool_t *scratch_pool)
+{
+  svn_mergeinfo_catalog_t deleted_catalog, added_catalog;
+  apr_hash_index_t *hi;
+  svn_sqlite__stmt_t *stmt;
+  svn_error_t *err;
+
+  err = svn_repos__fs_mergeinfo_changed(&deleted_catalog, &added_catalog,
+                                        fs, revision,
+                                        scratch_pool, scratch_pool);
+
+  /* Like 'svn log -g' itself, treat invalid mergeinfo as no change
+     (issue #3896). */
+  if (err && err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                    STMT_INSERT_MERGEINFO_CHANGE));
+  for (hi = apr_hash_first(scratch_pool, added_catalog);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *path = apr_hash_this_key(hi);
+      svn_mergeinfo_t added = apr_hash_this_val(hi);
+      svn_mergeinfo_t deleted = svn_hash_gets(deleted_catalog, path);
+      svn_string_t *added_str, *deleted_str;
+
+      SVN_ERR(svn_mergeinfo_to_string(&added_str, added, scratch_pool));
+      SVN_ERR(svn_mergeinfo_to_string(&deleted_str, deleted, scratch_pool));
+      SVN_ERR(svn_sqlite__bindf(stmt, "rsss", revision, path,
+                                deleted_str->data, added_str->data));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the changes of revision REVISION in FS to the index in SDB.
+   Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+index_revision(svn_sqlite__db_t *sdb,
+               svn_fs_t *fs,
+               svn_revnum_t revision,
+               apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  apr_hash_t *paths = svn_hash__make(scratch_pool);
+  apr_hash_index_t *hi;
+  svn_sqlite__stmt_t *stmt;
+
+  /* Collect all changed paths and their parents, without duplicates. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool,
+                                scratch_pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      const char *path = change->path.data;
+      while (!svn_hash_gets(paths, path))
+        {
+          path = apr_pstrdup(scratch_pool, path);
+          svn_hash_sets(paths, path, path);
+          if (svn_fspath__is_root(path, strlen(path)))
+            break;
+
+          path = svn_fspath__dirname(path, scratch_pool);
+        }
+
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_CHANGED_PATH));
+  for (hi = apr_hash_first(scratch_pool, paths); hi; hi = apr_hash_next(hi))
+    {
+      SVN_ERR(svn_sqlite__bindf(stmt, "sr", apr_hash_this_key(hi),
+                                revision));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  SVN_ERR(index_mergeinfo_changes(sdb, fs, revision, scratch_pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_YOUNGEST));
+  SVN_ERR(svn_sqlite__bindf(stmt, "r", revision));
+
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+/* Baton for index_revisions() and catch_up(). */
+typedef struct index_revisions_baton_t
+{
+  svn_fs_t *fs;
+  svn_revnum_t start;
+  svn_revnum_t end;
+} index_revisions_baton_t;
+
+/* Add revisions BATON->START to BATON->END to the index in SDB.
+   Implements svn_sqlite__transaction_callback_t. */
+static svn_error_t *
+index_revisions(void *baton,
+                svn_sqlite__db_t *sdb,
+                apr_pool_t *scratch_pool)
+{
+  index_revisions_baton_t *b = baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t revision;
+
+  for (revision = b->start; revision <= b->end; ++revision)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(index_revision(sdb, b->fs, revision, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add all revisions up to BATON->END to the index in SDB that are not
+   in there, yet, unless that would be more than MAX_CATCH_UP_REVISIONS.
+   Implements svn_sqlite__transaction_callback_t. */
+static svn_error_t *
+catch_up(void *baton,
+         svn_sqlite__db_t *sdb,
+         apr_pool_t *scratch_pool)
+{
+  index_revisions_baton_t *b = baton;
+  svn_revnum_t youngest;
+
+  /* Somebody else may have been faster. */
+  SVN_ERR(get_youngest(&youngest, sdb));
+  if (youngest >= b->end || b->end - youngest > MAX_CATCH_UP_REVISIONS)
+    return SVN_NO_ERROR;
+
+  b->start = youngest + 1;
+  return svn_error_trace(index_revisions(b, sdb, scratch_pool));
+}
+
+svn_error_t *
+svn_repos__log_index_update(svn_repos_t *repos,
+                            svn_revnum_t revision,
+                            apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  index_revisions_baton_t baton;
+
+  SVN_ERR(open_index_db(&sdb, repos, FALSE, scratch_pool, scratch_pool));
+  if (!sdb)
+    return SVN_NO_ERROR;
+
+  /* Read and update the youngest indexed revision atomically. */
+  baton.fs = repos->fs;
+  baton.end = revision;
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__with_immediate_transaction(sdb, catch_up,
+                                                               &baton,
+                                                               scratch_pool),
+                        sdb);
+
+  return svn_error_trace(svn_sqlite__close(sdb));
+}
+
+svn_error_t *
+svn_repos__log_index_open(svn_repos__log_index_t **index,
+                          svn_repos_t *repos,
+                          svn_revnum_t revision,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_revnum_t youngest;
+
+  *index = NULL;
+
+  SVN_ERR(open_index_db(&sdb, repos, FALSE, result_pool, scratch_pool));
+  if (!sdb)
+    return SVN_NO_ERROR;
+
+  SVN_SQLITE__ERR_CLOSE(get_youngest(&youngest, sdb), sdb);
+  if (youngest < revision)
+    return svn_error_trace(svn_sqlite__close(sdb));
+
+  *index = apr_pcalloc(result_pool, sizeof(**index));
+  (*index)->sdb = sdb;
+  (*index)->youngest = youngest;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__log_index_get_revs(apr_array_header_t *revs,
+                              svn_repos__log_index_t *index,
+                              const char *fspath,
+                              svn_revnum_t start,
+                              svn_revnum_t end,
+                              apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR_ASSERT(end <= index->youngest);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, index->sdb,
+                                    STMT_SELECT_CHANGED_REVISIONS));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srr", fspath, start, end));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      APR_ARRAY_PUSH(revs, svn_revnum_t) = svn_sqlite__column_revnum(stmt, 0);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_repos__log_index_mergeinfo_changed(
+  svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
+  svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
+  svn_repos__log_index_t *index,
+  svn_revnum_t rev,
+  apr_pool_t *result_pool,
+  apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  if (rev > index->youngest)
+    {
+      *deleted_mergeinfo_catalog = NULL;
+      *added_mergeinfo_catalog = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  *deleted_mergeinfo_catalog = svn_hash__make(result_pool);
+  *added_mergeinfo_catalog = svn_hash__make(result_pool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, index->sdb,
+                                    STMT_SELECT_MERGEINFO_CHANGES));
+  SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, rev));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const char *path = svn_sqlite__column_text(stmt, 0, result_pool);
+      svn_mergeinfo_t deleted, added;
+      svn_error_t *err;
+
+      err = svn_mergeinfo_parse(&deleted,
+                                svn_sqlite__column_text(stmt, 1, NULL),
+                                result_pool);
+      if (!err)
+        err = svn_mergeinfo_parse(&added,
+                                  svn_sqlite__column_text(stmt, 2, NULL),
+                                  result_pool);
+      if (err)
+        return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+
+      svn_hash_sets(*deleted_mergeinfo_catalog, path, deleted);
+      svn_hash_sets(*added_mergeinfo_catalog, path, added);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_repos__log_index_build(svn_repos_t *repos,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_sqlite__stmt_t *stmt;
+  svn_revnum_t head;
+  index_revisions_baton_t baton;
+  svn_error_t *err;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(open_index_db(&sdb, repos, TRUE, scratch_pool, iterpool));
+
+  /* Start from scratch.  Reset the youngest revision as well, such that
+     nobody will rely on the index until we caught up again. */
+  SVN_ERR(svn_sqlite__begin_immediate_transaction(sdb));
+  err = svn_sqlite__get_statement(&stmt, sdb, STMT_RESET_YOUNGEST);
+  if (!err)
+    err = svn_sqlite__step_done(stmt);
+  if (!err)
+    err = svn_sqlite__get_statement(&stmt, sdb,
+                                    STMT_DELETE_ALL_CHANGED_PATHS);
+  if (!err)
+    err = svn_sqlite__step_done(stmt);
+  if (!err)
+    err = svn_sqlite__get_statement(&stmt, sdb,
+                                    STMT_DELETE_ALL_MERGEINFO_CHANGES);
+  if (!err)
+    err = svn_sqlite__step_done(stmt);
+  SVN_ERR(svn_sqlite__finish_transaction(sdb, err));
+
+  /* Add all revisions in batches.  Commits will stop adding revisions
+     while we are lagging behind, so continue until we reach HEAD. */
+  baton.fs = repos->fs;
+  baton.start = 0;
+  SVN_ERR(svn_fs_youngest_rev(&head, repos->fs, iterpool));
+  while (baton.start <= head)
+    {
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      baton.end = MIN(head, baton.start + BUILD_BATCH_SIZE - 1);
+      SVN_ERR(svn_sqlite__with_transaction(sdb, index_revisions, &baton,
+                                           iterpool));
+
+      baton.start = baton.end + 1;
+      if (baton.start > head)
+        SVN_ERR(svn_fs_youngest_rev(&head, repos->fs, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_sqlite__close(sdb));
+}
@@ -21,6 +21,7 @@
  * ====================================================================
  */
 
+#include "svn_cache_config.h"
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
 #include "svn_path.h"
@@ -36,8 +37,15 @@
 
 #include "private/svn_dep_compat.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_thread_cond.h"
+
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#endif
 
 #define NUM_CACHED_SOURCE_ROOTS 4
 
@@ -100,6 +108,9 @@ typedef struct revision_info_t
   svn_string_t* author;        /* name of the revisions' author */
 } revision_info_t;
 
+/* State of the text delta workers, see start_delta_prefetch(). */
+typedef struct delta_prefetch_t delta_prefetch_t;
+
 /* A structure used by the routines within the `reporter' vtable,
    driven by the client as it describes its working copy revisions. */
 typedef struct report_baton_t
@@ -144,6 +155,14 @@ typedef struct report_baton_t
   /* This will not change. So, fetch it once and reuse it. */
   svn_string_t *repos_uuid;
   apr_pool_t *pool;
+
+  /* Parameters set by svn_repos__report_set_delta_threads() and the
+     worker state during the editor drive.  PREFETCH is NULL while no
+     workers are running. */
+  int delta_threads;
+  apr_size_t delta_memory_limit;
+  apr_hash_t *fs_config;
+  delta_prefetch_t *prefetch;
 } report_baton_t;
 
 /* The type of a function that accepts changes to an object's property
@@ -163,6 +182,10 @@ static svn_error_t *delta_dirs(report_baton_t *b, svn_revnum_t s_rev,
                                svn_depth_t requested_depth,
                                apr_pool_t *pool);
 
+static svn_boolean_t is_depth_upgrade(svn_depth_t wc_depth,
+                                      svn_depth_t requested_depth,
+                                      svn_node_kind_t kind);
+
 /* --- READING PREVIOUSLY STORED REPORT INFORMATION --- */
 
 static svn_error_t *
@@ -398,6 +421,559 @@ any_path_info(report_baton_t *b, const char *prefix)
   return relevant(b->lookahead, prefix, strlen(prefix));
 }
 
+/* --- COMPUTING TEXT DELTAS AHEAD OF THE EDITOR DRIVE --- */
+
+/* With svn_repos__report_set_delta_threads(), worker threads compute the
+   text deltas of files added by the edit before the drive reaches them.
+   The editor drive itself stays on the calling thread and in canonical
+   order; delta_files() merely sends the precomputed windows instead of
+   computing them inline.
+
+   FS objects must not be shared between threads, so each worker opens
+   its own instance of the repository FS.  Only the main thread enqueues
+   and consumes jobs.  Jobs it does not get to consume (e.g. because the
+   path turned out to be unreadable) are abandoned and released by the
+   worker once done. */
+
+/* Default for the maximum amount of memory held by computed but not yet
+   sent delta windows. */
+#define DEFAULT_DELTA_MEMORY_LIMIT (64 * 1024 * 1024)
+
+/* Files larger than this fraction of the memory limit are never
+   prefetched. */
+#define MAX_DELTA_SIZE_FRACTION 16
+
+/* Extra memory we charge per job for the window structures etc. */
+#define DELTA_JOB_OVERHEAD 1024
+
+/* Processing state of a delta_job_t. */
+typedef enum delta_job_state_t
+{
+  delta_job_queued,
+  delta_job_running,
+  delta_job_done
+} delta_job_state_t;
+
+/* Text delta of a single file, computed against the empty stream. */
+typedef struct delta_job_t
+{
+  /* The file in the target root. */
+  const char *t_path;
+
+  /* Thread-safe root pool owning this structure and its results. */
+  apr_pool_t *pool;
+
+  /* Amount of memory charged against the limit for this job. */
+  apr_size_t reserved;
+
+  /* The following are protected by the prefetch mutex. */
+  delta_job_state_t state;
+  svn_boolean_t abandoned;
+  struct delta_job_t *next;  /* Next queued job */
+
+  /* Results, valid once STATE is delta_job_done.  WINDOWS contains
+     svn_txdelta_window_t * elements. */
+  apr_array_header_t *windows;
+  svn_error_t *err;
+} delta_job_t;
+
+struct delta_prefetch_t
+{
+  /* Parameters for opening the workers' FS instances. */
+  const char *fs_path;
+  apr_hash_t *fs_config;
+  svn_revnum_t t_rev;
+
+  /* Synchronization.  COND gets signalled upon any state change. */
+  svn_mutex__t *mutex;
+  svn_thread_cond__t *cond;
+
+  /* Jobs not yet started, in FIFO order.  Protected by MUTEX. */
+  delta_job_t *first;
+  delta_job_t *last;
+
+  /* Memory charged by all jobs not yet released.  Protected by MUTEX. */
+  apr_size_t memory_used;
+  apr_size_t memory_limit;
+
+  /* Set when the workers shall terminate.  Protected by MUTEX. */
+  svn_boolean_t shutdown;
+
+  /* Non-abandoned jobs by t_path.  Used by the main thread only. */
+  apr_hash_t *jobs;
+
+  /* apr_thread_t * of the workers. */
+  apr_array_header_t *threads;
+
+  /* Owns the synchronization objects and threads. */
+  apr_pool_t *pool;
+};
+
+/* Release the memory held by JOB in PREFETCH.
+   The caller must hold the prefetch mutex. */
+static void
+release_delta_job(delta_prefetch_t *prefetch,
+                  delta_job_t *job)
+{
+  prefetch->memory_used -= job->reserved;
+  svn_error_clear(job->err);
+  svn_pool_destroy(job->pool);
+}
+
+/* Set JOB->WINDOWS to the text delta windows of JOB->T_PATH in ROOT
+   against the empty stream.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+compute_delta(delta_job_t *job,
+              svn_fs_root_t *root,
+              apr_pool_t *scratch_pool)
+{
+  svn_txdelta_stream_t *dstream;
+  svn_txdelta_window_t *window;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_fs_get_file_delta_stream(&dstream, NULL, NULL, root,
+                                       job->t_path, scratch_pool));
+
+  job->windows = apr_array_make(job->pool, 4, sizeof(window));
+  do
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_txdelta_next_window(&window, dstream, iterpool));
+      if (window)
+        APR_ARRAY_PUSH(job->windows, svn_txdelta_window_t *)
+          = svn_txdelta_window_dup(window, job->pool);
+    }
+  while (window);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Process jobs from PREFETCH's queue until shutdown is requested, reading
+   from ROOT.  If ROOT is NULL, fail all jobs with a copy of OPEN_ERR.
+   Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+run_delta_jobs(delta_prefetch_t *prefetch,
+               svn_fs_root_t *root,
+               svn_error_t *open_err,
+               apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      delta_job_t *job = NULL;
+      svn_boolean_t shutdown;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_pool_clear(iterpool);
+
+      /* Wait for the next job. */
+      SVN_ERR(svn_mutex__lock(prefetch->mutex));
+
+      while (!err && !prefetch->shutdown && !prefetch->first)
+        err = svn_thread_cond__wait(prefetch->cond, prefetch->mutex);
+
+      shutdown = prefetch->shutdown;
+      if (!err && !shutdown)
+        {
+          job = prefetch->first;
+          prefetch->first = job->next;
+          if (!prefetch->first)
+            prefetch->last = NULL;
+
+          job->next = NULL;
+          if (job->abandoned)
+            {
+              release_delta_job(prefetch, job);
+              job = NULL;
+            }
+          else
+            {
+              job->state = delta_job_running;
+            }
+        }
+
+      SVN_ERR(svn_mutex__unlock(prefetch->mutex, err));
+
+      if (shutdown)
+        break;
+      if (!job)
+        continue;
+
+      /* Do the actual work outside the lock. */
+      if (root)
+        err = compute_delta(job, root, iterpool);
+      else
+        err = svn_error_dup(open_err);
+
+      /* Hand the results to the main thread. */
+      SVN_ERR(svn_mutex__lock(prefetch->mutex));
+
+      job->err = err;
+      job->state = delta_job_done;
+      if (job->abandoned)
+        release_delta_job(prefetch, job);
+
+      SVN_ERR(svn_mutex__unlock(prefetch->mutex,
+                                svn_thread_cond__broadcast(prefetch->cond)));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function of the delta workers.  DATA is the delta_prefetch_t. */
+static void * APR_THREAD_FUNC
+delta_worker(apr_thread_t *thread,
+             void *data)
+{
+  delta_prefetch_t *prefetch = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  svn_fs_t *fs;
+  svn_fs_root_t *root = NULL;
+  svn_error_t *err;
+
+  err = svn_fs_open2(&fs, prefetch->fs_path, prefetch->fs_config,
+                     pool, pool);
+  if (!err)
+    err = svn_fs_revision_root(&root, fs, prefetch->t_rev, pool);
+
+  /* Errors here are synchronization failures.  There is no good way to
+     report them to the main thread, which will probably get stuck on
+     the same mutex anyway. */
+  svn_error_clear(run_delta_jobs(prefetch, err ? NULL : root, err, pool));
+  svn_error_clear(err);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(thread, APR_SUCCESS);
+
+  return NULL;
+}
+
+#endif
+
+/* Start B->DELTA_THREADS delta workers for the report B and set
+   B->PREFETCH.  This is a no-op if APR does not support threads or if
+   the caches have been configured for single-threaded use.
+   Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+start_delta_prefetch(report_baton_t *b,
+                     apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  delta_prefetch_t *prefetch;
+  int i;
+
+  /* The workers' FS instances share the global membuffer cache with ours.
+     Without synchronization, that would corrupt it. */
+  if (svn_cache_config_get()->single_threaded)
+    return SVN_NO_ERROR;
+
+  prefetch = apr_pcalloc(b->pool, sizeof(*prefetch));
+
+  /* The threads are created from and release their memory to this pool,
+     so make it independent from any pool used by the main thread. */
+  prefetch->pool = svn_pool_create(NULL);
+  prefetch->fs_path = svn_fs_path(b->repos->fs, b->pool);
+  prefetch->fs_config = b->fs_config;
+  prefetch->t_rev = b->t_rev;
+  prefetch->memory_limit = b->delta_memory_limit
+                         ? b->delta_memory_limit
+                         : DEFAULT_DELTA_MEMORY_LIMIT;
+  prefetch->jobs = apr_hash_make(b->pool);
+  prefetch->threads = apr_array_make(b->pool, b->delta_threads,
+                                     sizeof(apr_thread_t *));
+
+  SVN_ERR(svn_mutex__init(&prefetch->mutex, TRUE, prefetch->pool));
+  SVN_ERR(svn_thread_cond__create(&prefetch->cond, prefetch->pool));
+
+  /* Set B->PREFETCH now such that the workers get stopped even if we
+     fail to create some of them. */
+  b->prefetch = prefetch;
+  for (i = 0; i < b->delta_threads; ++i)
+    {
+      apr_thread_t *thread;
+      apr_status_t status = apr_thread_create(&thread, NULL, delta_worker,
+                                              prefetch, prefetch->pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create delta worker"));
+
+      APR_ARRAY_PUSH(prefetch->threads, apr_thread_t *) = thread;
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop the delta workers of B, if any, and release all their resources. */
+static svn_error_t *
+stop_delta_prefetch(report_baton_t *b)
+{
+  delta_prefetch_t *prefetch = b->prefetch;
+  apr_hash_index_t *hi;
+  delta_job_t *job;
+
+  if (!prefetch)
+    return SVN_NO_ERROR;
+
+  b->prefetch = NULL;
+
+  SVN_ERR(svn_mutex__lock(prefetch->mutex));
+  prefetch->shutdown = TRUE;
+  SVN_ERR(svn_mutex__unlock(prefetch->mutex,
+                            svn_thread_cond__broadcast(prefetch->cond)));
+
+#if APR_HAS_THREADS
+  {
+    int i;
+    for (i = 0; i < prefetch->threads->nelts; ++i)
+      {
+        apr_status_t retval;
+        apr_thread_join(&retval, APR_ARRAY_IDX(prefetch->threads, i,
+                                               apr_thread_t *));
+      }
+  }
+#endif
+
+  /* No more workers.  Queued jobs are either abandoned or still in JOBS;
+     all others have been released already or are in JOBS as well. */
+  for (job = prefetch->first; job; )
+    {
+      delta_job_t *next = job->next;
+      if (job->abandoned)
+        release_delta_job(prefetch, job);
+
+      job = next;
+    }
+
+  for (hi = apr_hash_first(b->pool, prefetch->jobs); hi; hi = apr_hash_next(hi))
+    release_delta_job(prefetch, apr_hash_this_val(hi));
+
+  svn_pool_destroy(prefetch->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue delta jobs for the files among T_ORDERED_ENTRIES (within T_PATH)
+   that the report B will add without a source, as long as the memory
+   limit permits.  S_ENTRIES, WC_DEPTH and REQUESTED_DEPTH are as in
+   delta_dirs().  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+prefetch_deltas(report_baton_t *b,
+                const char *t_path,
+                apr_array_header_t *t_ordered_entries,
+                apr_hash_t *s_entries,
+                svn_depth_t wc_depth,
+                svn_depth_t requested_depth,
+                apr_pool_t *scratch_pool)
+{
+  delta_prefetch_t *prefetch = b->prefetch;
+  apr_array_header_t *jobs;
+  apr_pool_t *iterpool;
+  apr_size_t max_size = prefetch->memory_limit / MAX_DELTA_SIZE_FRACTION;
+  svn_error_t *err;
+  int i;
+
+  /* Added files may be sent as copies in that case. */
+  if (!b->text_deltas || b->send_copyfrom_args)
+    return SVN_NO_ERROR;
+
+  /* Collect the candidates.  This follows the logic in delta_dirs(). */
+  jobs = apr_array_make(scratch_pool, t_ordered_entries->nelts,
+                        sizeof(delta_job_t *));
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < t_ordered_entries->nelts; ++i)
+    {
+      const svn_fs_dirent_t *t_entry
+         = APR_ARRAY_IDX(t_ordered_entries, i, svn_fs_dirent_t *);
+      const char *t_fullpath;
+      svn_filesize_t length;
+      apr_pool_t *job_pool;
+      delta_job_t *job;
+
+      svn_pool_clear(iterpool);
+
+      if (t_entry->kind != svn_node_file)
+        continue;
+
+      if (!is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
+        {
+          if (requested_depth == svn_depth_unknown
+              && wc_depth < svn_depth_files)
+            continue;
+
+          if (s_entries && svn_hash_gets(s_entries, t_entry->name))
+            continue;
+        }
+
+      t_fullpath = svn_fspath__join(t_path, t_entry->name, iterpool);
+      SVN_ERR(svn_fs_file_length(&length, b->t_root, t_fullpath, iterpool));
+      if (length > max_size)
+        continue;
+
+      /* Job pools must be thread-safe. */
+      job_pool = svn_pool_create(NULL);
+      job = apr_pcalloc(job_pool, sizeof(*job));
+      job->pool = job_pool;
+      job->t_path = apr_pstrdup(job_pool, t_fullpath);
+      job->reserved = (apr_size_t)length + DELTA_JOB_OVERHEAD;
+      job->state = delta_job_queued;
+
+      APR_ARRAY_PUSH(jobs, delta_job_t *) = job;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Queue as many of them as the memory limit permits. */
+  SVN_ERR(svn_mutex__lock(prefetch->mutex));
+
+  for (i = 0; i < jobs->nelts; ++i)
+    {
+      delta_job_t *job = APR_ARRAY_IDX(jobs, i, delta_job_t *);
+
+      if (prefetch->memory_used + job->reserved > prefetch->memory_limit)
+        break;
+
+      prefetch->memory_used += job->reserved;
+      if (prefetch->last)
+        prefetch->last->next = job;
+      else
+        prefetch->first = job;
+      prefetch->last = job;
+
+      svn_hash_sets(prefetch->jobs, job->t_path, job);
+    }
+
+  err = (i > 0) ? svn_thread_cond__broadcast(prefetch->cond) : SVN_NO_ERROR;
+  SVN_ERR(svn_mutex__unlock(prefetch->mutex, err));
+
+  /* Drop the ones that did not fit. */
+  for (; i < jobs->nelts; ++i)
+    svn_pool_destroy(APR_ARRAY_IDX(jobs, i, delta_job_t *)->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Abandon the delta jobs for the entries in T_ORDERED_ENTRIES within
+   T_PATH that have not been consumed by send_prefetched_delta().
+   Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+abandon_deltas(report_baton_t *b,
+               const char *t_path,
+               apr_array_header_t *t_ordered_entries,
+               apr_pool_t *scratch_pool)
+{
+  delta_prefetch_t *prefetch = b->prefetch;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (!apr_hash_count(prefetch->jobs))
+    return SVN_NO_ERROR;
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < t_ordered_entries->nelts; ++i)
+    {
+      const svn_fs_dirent_t *t_entry
+         = APR_ARRAY_IDX(t_ordered_entries, i, svn_fs_dirent_t *);
+      const char *t_fullpath;
+      delta_job_t *job;
+
+      svn_pool_clear(iterpool);
+
+      if (t_entry->kind != svn_node_file)
+        continue;
+
+      t_fullpath = svn_fspath__join(t_path, t_entry->name, iterpool);
+      job = svn_hash_gets(prefetch->jobs, t_fullpath);
+      if (!job)
+        continue;
+
+      svn_hash_sets(prefetch->jobs, t_fullpath, NULL);
+
+      SVN_ERR(svn_mutex__lock(prefetch->mutex));
+      if (job->state == delta_job_done)
+        release_delta_job(prefetch, job);
+      else
+        job->abandoned = TRUE;
+      SVN_ERR(svn_mutex__unlock(prefetch->mutex, SVN_NO_ERROR));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* If B has a delta job for T_PATH, send its windows to DHANDLER / DBATON
+   and set *SENT to TRUE.  Otherwise, or if the job has not been started
+   yet or failed, set *SENT to FALSE; the caller must then send the delta
+   itself.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+send_prefetched_delta(svn_boolean_t *sent,
+                      report_baton_t *b,
+                      const char *t_path,
+                      svn_txdelta_window_handler_t dhandler,
+                      void *dbaton,
+                      apr_pool_t *scratch_pool)
+{
+  delta_prefetch_t *prefetch = b->prefetch;
+  delta_job_t *job = svn_hash_gets(prefetch->jobs, t_path);
+  svn_boolean_t started;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  *sent = FALSE;
+  if (!job)
+    return SVN_NO_ERROR;
+
+  svn_hash_sets(prefetch->jobs, t_path, NULL);
+
+  /* Rather than waiting for a job that has not been started yet, we let
+     the worker skip it and compute the delta ourselves. */
+  SVN_ERR(svn_mutex__lock(prefetch->mutex));
+
+  started = (job->state != delta_job_queued);
+  if (started)
+    {
+      while (!err && job->state != delta_job_done)
+        err = svn_thread_cond__wait(prefetch->cond, prefetch->mutex);
+    }
+  else
+    {
+      job->abandoned = TRUE;
+    }
+
+  SVN_ERR(svn_mutex__unlock(prefetch->mutex, err));
+
+  if (!started)
+    return SVN_NO_ERROR;
+
+  /* Failures will be reported when the caller tries to compute the
+     delta itself. */
+  if (!job->err)
+    {
+      for (i = 0; !err && i < job->windows->nelts; ++i)
+        err = dhandler(APR_ARRAY_IDX(job->windows, i, svn_txdelta_window_t *),
+                       dbaton);
+
+      if (!err)
+        err = dhandler(NULL, dbaton);
+
+      *sent = TRUE;
+    }
+
+  SVN_ERR(svn_mutex__lock(prefetch->mutex));
+  release_delta_job(prefetch, job);
+  SVN_ERR(svn_mutex__unlock(prefetch->mutex, SVN_NO_ERROR));
+
+  return svn_error_trace(err);
+}
+
 /* --- DRIVING THE EDITOR ONCE THE REPORT IS FINISHED --- */
 
 /* While driving the editor, the target root will remain constant, but
@@ -710,6 +1286,16 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
     {
       if (b->text_deltas)
         {
+          /* Maybe, a worker has already computed the delta for us. */
+          if (b->prefetch && s_path == NULL)
+            {
+              svn_boolean_t sent;
+              SVN_ERR(send_prefetched_delta(&sent, b, t_path, dhandler,
+                                            dbaton, pool));
+              if (sent)
+                return SVN_NO_ERROR;
+            }
+
           /* if we send deltas against empty streams, we may use our
              zero-copy code. */
           if (b->zero_copy_limit > 0 && s_path == NULL)
@@ -1095,6 +1681,40 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
     }
 }
 
+/* Set *CHANGED to those of the svn_fs_dirent_t * in T_ORDERED_ENTRIES
+   that may have to be read when updating from the source entries
+   S_ENTRIES, i.e. new ones and ones that point to a different node than
+   the source entry of the same name.  Keep their order and allocate the
+   result in RESULT_POOL. */
+static void
+changed_entries(apr_array_header_t **changed,
+                const apr_array_header_t *t_ordered_entries,
+                apr_hash_t *s_entries,
+                svn_depth_t wc_depth,
+                svn_depth_t requested_depth,
+                apr_pool_t *result_pool)
+{
+  int i;
+
+  *changed = apr_array_make(result_pool, t_ordered_entries->nelts,
+                            sizeof(svn_fs_dirent_t *));
+  for (i = 0; i < t_ordered_entries->nelts; ++i)
+    {
+      svn_fs_dirent_t *t_entry
+         = APR_ARRAY_IDX(t_ordered_entries, i, svn_fs_dirent_t *);
+      const svn_fs_dirent_t *s_entry
+         = s_entries ? svn_hash_gets(s_entries, t_entry->name) : NULL;
+
+      if (s_entry
+          && s_entry->kind == t_entry->kind
+          && !is_depth_upgrade(wc_depth, requested_depth, t_entry->kind)
+          && svn_fs_compare_ids(s_entry->id, t_entry->id) == 0)
+        continue;
+
+      APR_ARRAY_PUSH(*changed, svn_fs_dirent_t *) = t_entry;
+    }
+}
+
 /* A helper macro for when we have to recurse into subdirectories. */
 #define DEPTH_BELOW_HERE(depth) ((depth) == svn_depth_immediates) ? \
                                  svn_depth_empty : (depth)
@@ -1162,8 +1782,9 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
 {
   apr_hash_t *s_entries = NULL, *t_entries;
   apr_hash_index_t *hi;
-  apr_pool_t *subpool = svn_pool_create(pool);
+  apr_pool_t *subpool = svn_pool__create_arena(pool);
   apr_array_header_t *t_ordered_entries = NULL;
+  apr_array_header_t *t_changed_entries;
   int i;
 
   /* Compare the property lists.  If we're starting empty, pass a NULL
@@ -1304,6 +1925,18 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
       /* Loop over the dirents in the target. */
       SVN_ERR(svn_fs_dir_optimal_order(&t_ordered_entries, b->t_root,
                                        t_entries, subpool, iterpool));
+
+      /* We are about to read those that changed.  Let the FS fetch them
+         in one sweep instead of many scattered reads as we go. */
+      changed_entries(&t_changed_entries, t_ordered_entries, s_entries,
+                      wc_depth, requested_depth, iterpool);
+      if (t_changed_entries->nelts)
+        SVN_ERR(svn_fs_dir_prefetch(b->t_root, t_changed_entries, iterpool));
+
+      if (b->prefetch)
+        SVN_ERR(prefetch_deltas(b, t_path, t_ordered_entries, s_entries,
+                                wc_depth, requested_depth, iterpool));
+
       for (i = 0; i < t_ordered_entries->nelts; ++i)
         {
           const svn_fs_dirent_t *t_entry
@@ -1350,10 +1983,14 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                                iterpool));
         }
 
+      /* Release whatever the loop above did not send. */
+      if (b->prefetch)
+        SVN_ERR(abandon_deltas(b, t_path, t_ordered_entries, iterpool));
+
       /* iterpool is destroyed by destroying its parent (subpool) below */
     }
 
-  svn_pool_destroy(subpool);
+  svn_pool__destroy_arena(subpool);
 
   return SVN_NO_ERROR;
 }
@@ -1472,8 +2109,15 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
     b->s_roots[i] = NULL;
 
   {
-    svn_error_t *err = svn_error_trace(drive(b, s_rev, info, pool));
+    svn_error_t *err = SVN_NO_ERROR;
 
+    if (b->delta_threads > 0)
+      err = start_delta_prefetch(b, pool);
+
+    if (!err)
+      err = svn_error_trace(drive(b, s_rev, info, pool));
+
+    err = svn_error_compose_create(err, stop_delta_prefetch(b));
     if (err == SVN_NO_ERROR)
       return svn_error_trace(b->editor->close_edit(b->edit_baton, pool));
 
@@ -1634,8 +2278,29 @@ svn_repos_begin_report3(void **report_baton,
                                           1000000 /* maxsize */,
                                           pool);
   b->repos_uuid = svn_string_create(uuid, pool);
+  b->delta_threads = 0;
+  b->delta_memory_limit = 0;
+  b->fs_config = NULL;
+  b->prefetch = NULL;
 
   /* Hand reporter back to client. */
   *report_baton = b;
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_repos__report_set_delta_threads(void *report_baton,
+                                    int threads,
+                                    apr_size_t memory_limit,
+                                    apr_hash_t *fs_config)
+{
+  report_baton_t *b = report_baton;
+
+#if APR_HAS_THREADS
+  b->delta_threads = threads;
+  b->delta_memory_limit = memory_limit;
+  b->fs_config = fs_config;
+#endif
+
+  return SVN_NO_ERROR;
+}
@@ -1849,7 +1849,9 @@ struct hotcopy_ctx_t {
 
 /* Copy the repository structure of PATH to BATON->DEST, with exception of
  * @c SVN_REPOS__DB_DIR, @c SVN_REPOS__LOCK_DIR and @c SVN_REPOS__FORMAT;
- * those directories and files are handled separately.
+ * those directories and files are handled separately.  The optional
+ * @c SVN_REPOS__LOG_INDEX and @c SVN_REPOS__BLAME_CACHE are not copied
+ * at all.
  *
  * BATON is a (struct hotcopy_ctx_t *).  BATON->SRC_LEN is the length
  * of PATH.
@@ -1892,6 +1894,14 @@ static svn_error_t *hotcopy_structure(void *baton,
           (svn_dirent_get_longest_ancestor(SVN_REPOS__FORMAT, sub_path, pool),
            SVN_REPOS__FORMAT) == 0)
         return SVN_NO_ERROR;
+
+      /* The changed-paths index may not match the copied revisions. */
+      if (strcmp(sub_path, SVN_REPOS__LOG_INDEX) == 0)
+        return SVN_NO_ERROR;
+
+      /* The blame cache gets rebuilt on demand. */
+      if (strcmp(sub_path, SVN_REPOS__BLAME_CACHE) == 0)
+        return SVN_NO_ERROR;
     }
 
   target = svn_dirent_join(ctx->dest, sub_path, pool);
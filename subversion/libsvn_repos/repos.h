@@ -28,6 +28,7 @@
 
 #include "svn_fs.h"
 #include "svn_config.h"
+#include "svn_mergeinfo.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -70,6 +71,12 @@ extern "C" {
 #define SVN_REPOS__DB_LOCKFILE "db.lock" /* Our Berkeley lockfile. */
 #define SVN_REPOS__DB_LOGS_LOCKFILE "db-logs.lock" /* BDB logs lockfile. */
 
+/* The optional changed-paths index, see log_index.c. */
+#define SVN_REPOS__LOG_INDEX "log-index.db"
+
+/* The server-side blame cache, see blame.c. */
+#define SVN_REPOS__BLAME_CACHE "blame-cache.db"
+
 /* In the repository hooks directory, look for these files. */
 #define SVN_REPOS__HOOK_START_COMMIT    "start-commit"
 #define SVN_REPOS__HOOK_PRE_COMMIT      "pre-commit"
@@ -387,6 +394,72 @@ svn_repos__prev_location(svn_revnum_t *appeared_rev,
                          const char *path,
                          apr_pool_t *pool);
 
+/* Set *DELETED_MERGEINFO_CATALOG and *ADDED_MERGEINFO_CATALOG to
+   catalogs describing how mergeinfo values on paths (which are the
+   keys of those catalogs) were changed in REV in FS.  Allocate the
+   results in RESULT_POOL and use SCRATCH_POOL for temporaries.
+
+   This is implemented in log.c. */
+svn_error_t *
+svn_repos__fs_mergeinfo_changed(
+  svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
+  svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
+  svn_fs_t *fs,
+  svn_revnum_t rev,
+  apr_pool_t *result_pool,
+  apr_pool_t *scratch_pool);
+
+
+/*** Changed-paths Index ***/
+
+/* An open changed-paths index. */
+typedef struct svn_repos__log_index_t svn_repos__log_index_t;
+
+/* Set *INDEX to the changed-paths index of REPOS, allocated in
+   RESULT_POOL.  If REPOS does not have such an index or it does not
+   cover REVISION, yet, set *INDEX to NULL.  Use SCRATCH_POOL for
+   temporary allocations. */
+svn_error_t *
+svn_repos__log_index_open(svn_repos__log_index_t **index,
+                          svn_repos_t *repos,
+                          svn_revnum_t revision,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/* Append to REVS all revisions between START and END, inclusive, in
+   which FSPATH or anything below it got changed, according to INDEX.
+   The revisions will be added in descending order.  END must be covered
+   by INDEX.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__log_index_get_revs(apr_array_header_t *revs,
+                              svn_repos__log_index_t *index,
+                              const char *fspath,
+                              svn_revnum_t start,
+                              svn_revnum_t end,
+                              apr_pool_t *scratch_pool);
+
+/* Set *DELETED_MERGEINFO_CATALOG and *ADDED_MERGEINFO_CATALOG to the
+   mergeinfo changes in REV as recorded in INDEX, in the same format as
+   svn_repos__fs_mergeinfo_changed() returns them.  If INDEX does not
+   cover REV, set both to NULL.  Allocate the results in RESULT_POOL and
+   use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__log_index_mergeinfo_changed(
+  svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
+  svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
+  svn_repos__log_index_t *index,
+  svn_revnum_t rev,
+  apr_pool_t *result_pool,
+  apr_pool_t *scratch_pool);
+
+/* If REPOS has a changed-paths index, add REVISION to it, catching up on
+   a limited number of previous revisions as well if necessary.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__log_index_update(svn_repos_t *repos,
+                            svn_revnum_t revision,
+                            apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -35,6 +35,7 @@
 
 #include "checksum.h"
 #include "fnv1a.h"
+#include "md5_sha1.h"
 
 #include "private/svn_subr_private.h"
 
@@ -475,7 +476,8 @@ svn_checksum(svn_checksum_t **checksum,
              apr_size_t len,
              apr_pool_t *pool)
 {
-  apr_sha1_ctx_t sha1_ctx;
+  svn_md5__context_t md5_ctx;
+  svn_sha1__context_t sha1_ctx;
 
   SVN_ERR(validate_kind(kind));
   *checksum = svn_checksum_create(kind, pool);
@@ -483,13 +485,15 @@ svn_checksum(svn_checksum_t **checksum,
   switch (kind)
     {
       case svn_checksum_md5:
-        apr_md5((unsigned char *)(*checksum)->digest, data, len);
+        svn_md5__init(&md5_ctx);
+        svn_md5__update(&md5_ctx, data, len);
+        svn_md5__final((unsigned char *)(*checksum)->digest, &md5_ctx);
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_init(&sha1_ctx);
-        apr_sha1_update(&sha1_ctx, data, (unsigned int)len);
-        apr_sha1_final((unsigned char *)(*checksum)->digest, &sha1_ctx);
+        svn_sha1__init(&sha1_ctx);
+        svn_sha1__update(&sha1_ctx, data, len);
+        svn_sha1__final((unsigned char *)(*checksum)->digest, &sha1_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -545,13 +549,13 @@ svn_checksum_ctx_create(svn_checksum_kind_t kind,
   switch (kind)
     {
       case svn_checksum_md5:
-        ctx->apr_ctx = apr_palloc(pool, sizeof(apr_md5_ctx_t));
-        apr_md5_init(ctx->apr_ctx);
+        ctx->apr_ctx = apr_palloc(pool, sizeof(svn_md5__context_t));
+        svn_md5__init(ctx->apr_ctx);
         break;
 
       case svn_checksum_sha1:
-        ctx->apr_ctx = apr_palloc(pool, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        ctx->apr_ctx = apr_palloc(pool, sizeof(svn_sha1__context_t));
+        svn_sha1__init(ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -575,13 +579,11 @@ svn_checksum_ctx_reset(svn_checksum_ctx_t *ctx)
   switch (ctx->kind)
     {
       case svn_checksum_md5:
-        memset(ctx->apr_ctx, 0, sizeof(apr_md5_ctx_t));
-        apr_md5_init(ctx->apr_ctx);
+        svn_md5__init(ctx->apr_ctx);
         break;
 
       case svn_checksum_sha1:
-        memset(ctx->apr_ctx, 0, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        svn_sha1__init(ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -607,11 +609,11 @@ svn_checksum_update(svn_checksum_ctx_t *ctx,
   switch (ctx->kind)
     {
       case svn_checksum_md5:
-        apr_md5_update(ctx->apr_ctx, data, len);
+        svn_md5__update(ctx->apr_ctx, data, len);
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_update(ctx->apr_ctx, data, (unsigned int)len);
+        svn_sha1__update(ctx->apr_ctx, data, len);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -640,11 +642,11 @@ svn_checksum_final(svn_checksum_t **checksum,
   switch (ctx->kind)
     {
       case svn_checksum_md5:
-        apr_md5_final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
+        svn_md5__final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
+        svn_sha1__final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -665,6 +667,71 @@ svn_checksum_final(svn_checksum_t **checksum,
   return SVN_NO_ERROR;
 }
 
+struct svn_checksum__md5_sha1_ctx_t
+{
+  svn_md5__context_t md5;
+  svn_sha1__context_t sha1;
+  svn_boolean_t with_sha1;
+};
+
+svn_checksum__md5_sha1_ctx_t *
+svn_checksum__md5_sha1_ctx_create(svn_boolean_t with_sha1,
+                                  apr_pool_t *pool)
+{
+  svn_checksum__md5_sha1_ctx_t *ctx = apr_palloc(pool, sizeof(*ctx));
+
+  ctx->with_sha1 = with_sha1;
+  svn_checksum__md5_sha1_ctx_reset(ctx);
+
+  return ctx;
+}
+
+void
+svn_checksum__md5_sha1_ctx_reset(svn_checksum__md5_sha1_ctx_t *ctx)
+{
+  svn_md5__init(&ctx->md5);
+  if (ctx->with_sha1)
+    svn_sha1__init(&ctx->sha1);
+}
+
+void
+svn_checksum__md5_sha1_update(svn_checksum__md5_sha1_ctx_t *ctx,
+                              const void *data,
+                              apr_size_t len)
+{
+  if (ctx->with_sha1)
+    svn_md5_sha1__update(&ctx->md5, &ctx->sha1, data, len);
+  else
+    svn_md5__update(&ctx->md5, data, len);
+}
+
+void
+svn_checksum__md5_sha1_final(svn_checksum_t **md5_checksum,
+                             svn_checksum_t **sha1_checksum,
+                             svn_checksum__md5_sha1_ctx_t *ctx,
+                             apr_pool_t *result_pool)
+{
+  svn_checksum_t *checksum;
+
+  checksum = svn_checksum_create(svn_checksum_md5, result_pool);
+  svn_md5__final((unsigned char *)checksum->digest, &ctx->md5);
+  if (md5_checksum)
+    *md5_checksum = checksum;
+
+  if (ctx->with_sha1)
+    {
+      checksum = svn_checksum_create(svn_checksum_sha1, result_pool);
+      svn_sha1__final((unsigned char *)checksum->digest, &ctx->sha1);
+    }
+  else
+    {
+      checksum = NULL;
+    }
+
+  if (sha1_checksum)
+    *sha1_checksum = checksum;
+}
+
 apr_size_t
 svn_checksum_size(const svn_checksum_t *checksum)
 {
@@ -854,3 +921,74 @@ svn_checksum__wrap_write_stream_fnv1a_32x4(apr_uint32_t *digest,
 
   return result;
 }
+
+/* Baton used by write_handler_md5_sha1 and close_handler_md5_sha1.
+ */
+typedef struct md5_sha1_stream_baton_t
+{
+  /* Stream we are wrapping. Forward write() and close() operations to it. */
+  svn_stream_t *inner_stream;
+
+  /* Build both checksums in here. */
+  svn_checksum__md5_sha1_ctx_t *context;
+
+  /* Write the final checksums here. May be NULL. */
+  svn_checksum_t **md5_checksum;
+  svn_checksum_t **sha1_checksum;
+
+  /* Allocate the resulting checksums here. */
+  apr_pool_t *pool;
+} md5_sha1_stream_baton_t;
+
+/* Implement svn_write_fn_t.
+ * Update checksums and pass data on to inner stream.
+ */
+static svn_error_t *
+write_handler_md5_sha1(void *baton,
+                       const char *data,
+                       apr_size_t *len)
+{
+  md5_sha1_stream_baton_t *b = baton;
+
+  svn_checksum__md5_sha1_update(b->context, data, *len);
+  SVN_ERR(svn_stream_write(b->inner_stream, data, len));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_close_fn_t.
+ * Finalize checksum calculation and write results. Close inner stream.
+ */
+static svn_error_t *
+close_handler_md5_sha1(void *baton)
+{
+  md5_sha1_stream_baton_t *b = baton;
+
+  svn_checksum__md5_sha1_final(b->md5_checksum, b->sha1_checksum,
+                               b->context, b->pool);
+
+  return svn_error_trace(svn_stream_close(b->inner_stream));
+}
+
+svn_stream_t *
+svn_checksum__wrap_write_stream_md5_sha1(svn_checksum_t **md5_checksum,
+                                         svn_checksum_t **sha1_checksum,
+                                         svn_stream_t *inner_stream,
+                                         apr_pool_t *pool)
+{
+  svn_stream_t *outer_stream;
+
+  md5_sha1_stream_baton_t *baton = apr_pcalloc(pool, sizeof(*baton));
+  baton->inner_stream = inner_stream;
+  baton->context = svn_checksum__md5_sha1_ctx_create(sha1_checksum != NULL,
+                                                     pool);
+  baton->md5_checksum = md5_checksum;
+  baton->sha1_checksum = sha1_checksum;
+  baton->pool = pool;
+
+  outer_stream = svn_stream_create(baton, pool);
+  svn_stream_set_write(outer_stream, write_handler_md5_sha1);
+  svn_stream_set_close(outer_stream, close_handler_md5_sha1);
+
+  return outer_stream;
+}
@@ -0,0 +1,331 @@
+/*
+ * checksum_batch.c:   calculate checksums of independent files concurrently
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_thread_proc.h>
+
+#include "svn_checksum.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+
+
+/* Number of threads to use if the caller did not specify a limit. */
+#define DEFAULT_BATCH_THREADS 4
+
+/* Size of the read buffer used by each thread. */
+#define READ_BUFFER_SIZE 0x10000
+
+/* Shared state of all threads working on the same batch of jobs. */
+typedef struct batch_t
+{
+  /* The svn_checksum__job_t * to process. */
+  apr_array_header_t *jobs;
+
+  /* Index of the next job to process. */
+  volatile svn_atomic_t next;
+
+  /* Set when the remaining jobs shall be skipped. */
+  volatile svn_atomic_t cancelled;
+} batch_t;
+
+/* Per-thread state. */
+typedef struct worker_t
+{
+  /* The batch that we work on. */
+  batch_t *batch;
+
+  /* The file we read from last and its path.  Consecutive jobs tend to
+   * read from the same file, so we keep it open.  Both are NULL if there
+   * is no such file. */
+  apr_file_t *file;
+  const char *file_path;
+
+  /* READ_BUFFER_SIZE bytes of read buffer. */
+  unsigned char *buffer;
+
+  /* Pool containing FILE and FILE_PATH. */
+  apr_pool_t *file_pool;
+
+  /* Used for everything else.  Not shared with other threads. */
+  apr_pool_t *pool;
+} worker_t;
+
+/* Initialize WORKER for BATCH, allocating in the unshared POOL. */
+static void
+init_worker(worker_t *worker,
+            batch_t *batch,
+            apr_pool_t *pool)
+{
+  worker->batch = batch;
+  worker->file = NULL;
+  worker->file_path = NULL;
+  worker->buffer = apr_palloc(pool, READ_BUFFER_SIZE);
+  worker->file_pool = svn_pool_create(pool);
+  worker->pool = pool;
+}
+
+/* Read the data described by JOB using WORKER's resources and fill in
+ * JOB's checksums and size.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+process_job(worker_t *worker,
+            svn_checksum__job_t *job,
+            apr_pool_t *scratch_pool)
+{
+  svn_checksum_ctx_t *ctx = NULL;
+  svn_checksum__md5_sha1_ctx_t *md5_sha1_ctx = NULL;
+  svn_checksum_t *checksum;
+  svn_checksum_t *md5_checksum = NULL;
+  apr_off_t remaining = job->length;
+  apr_off_t offset = job->offset;
+
+  /* Re-use the file handle if we still have the right file open. */
+  if (!worker->file_path || strcmp(worker->file_path, job->abspath))
+    {
+      svn_pool_clear(worker->file_pool);
+      worker->file = NULL;
+      worker->file_path = NULL;
+
+      SVN_ERR(svn_io_file_open(&worker->file, job->abspath, APR_READ,
+                               APR_OS_DEFAULT, worker->file_pool));
+      worker->file_path = apr_pstrdup(worker->file_pool, job->abspath);
+    }
+
+  SVN_ERR(svn_io_file_seek(worker->file, APR_SET, &offset, scratch_pool));
+
+  if (job->with_md5)
+    md5_sha1_ctx = svn_checksum__md5_sha1_ctx_create(TRUE, scratch_pool);
+  else
+    ctx = svn_checksum_ctx_create(job->kind, scratch_pool);
+
+  /* Negative lengths mean "read up to EOF". */
+  while (remaining)
+    {
+      apr_size_t to_read = READ_BUFFER_SIZE;
+      svn_boolean_t eof = FALSE;
+
+      if (remaining < 0)
+        {
+          SVN_ERR(svn_io_file_read_full2(worker->file, worker->buffer,
+                                         to_read, &to_read, &eof,
+                                         scratch_pool));
+        }
+      else
+        {
+          if (remaining < (apr_off_t)to_read)
+            to_read = (apr_size_t)remaining;
+
+          SVN_ERR(svn_io_file_read_full2(worker->file, worker->buffer,
+                                         to_read, NULL, NULL,
+                                         scratch_pool));
+          remaining -= to_read;
+        }
+
+      if (md5_sha1_ctx)
+        svn_checksum__md5_sha1_update(md5_sha1_ctx, worker->buffer, to_read);
+      else
+        SVN_ERR(svn_checksum_update(ctx, worker->buffer, to_read));
+
+      job->size += to_read;
+      if (eof)
+        break;
+    }
+
+  if (md5_sha1_ctx)
+    svn_checksum__md5_sha1_final(&md5_checksum, &checksum, md5_sha1_ctx,
+                                 scratch_pool);
+  else
+    SVN_ERR(svn_checksum_final(&checksum, ctx, scratch_pool));
+
+  /* The result checksums have been allocated by the calling thread.
+   * Only fill in their digests. */
+  memcpy((unsigned char *)job->checksum->digest, checksum->digest,
+         svn_checksum_size(checksum));
+  if (md5_checksum)
+    memcpy((unsigned char *)job->md5_checksum->digest, md5_checksum->digest,
+           svn_checksum_size(md5_checksum));
+
+  return SVN_NO_ERROR;
+}
+
+/* Process jobs from WORKER's batch until there are none left or the batch
+ * got cancelled.  If CANCEL_FUNC is not NULL, invoke it with CANCEL_BATON
+ * after each job and cancel the batch if it returns an error.
+ */
+static svn_error_t *
+run_jobs(worker_t *worker,
+         svn_cancel_func_t cancel_func,
+         void *cancel_baton)
+{
+  batch_t *batch = worker->batch;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (!err && !svn_atomic_read(&batch->cancelled))
+    {
+      svn_checksum__job_t *job;
+      apr_uint32_t i = svn_atomic_inc(&batch->next);
+      if (i >= (apr_uint32_t)batch->jobs->nelts)
+        break;
+
+      svn_pool_clear(iterpool);
+
+      job = APR_ARRAY_IDX(batch->jobs, i, svn_checksum__job_t *);
+      job->err = process_job(worker, job, iterpool);
+
+      if (cancel_func)
+        {
+          err = cancel_func(cancel_baton);
+          if (err)
+            svn_atomic_set(&batch->cancelled, TRUE);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#if APR_HAS_THREADS
+
+/* Thread function of the additional checksum workers.
+ * DATA is the batch_t to work on.
+ */
+static void * APR_THREAD_FUNC
+batch_worker(apr_thread_t *thread,
+             void *data)
+{
+  worker_t worker;
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  init_worker(&worker, data, pool);
+
+  /* Without a cancellation function, there is nothing that could fail. */
+  svn_error_clear(run_jobs(&worker, NULL, NULL));
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(thread, APR_SUCCESS);
+
+  return NULL;
+}
+
+#endif
+
+svn_error_t *
+svn_checksum__compute_batch(apr_array_header_t *jobs,
+                            int max_threads,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  batch_t batch;
+  worker_t worker;
+  svn_error_t *err;
+  int i;
+
+#if APR_HAS_THREADS
+  apr_pool_t *threads_pool = NULL;
+  apr_array_header_t *threads = NULL;
+#endif
+
+  /* Allocate all results here, so the workers don't need to access
+   * RESULT_POOL. */
+  for (i = 0; i < jobs->nelts; ++i)
+    {
+      svn_checksum__job_t *job = APR_ARRAY_IDX(jobs, i,
+                                               svn_checksum__job_t *);
+      SVN_ERR_ASSERT(!job->with_md5 || job->kind == svn_checksum_sha1);
+
+      job->checksum = svn_checksum_create(job->kind, result_pool);
+      job->md5_checksum = job->with_md5
+                        ? svn_checksum_create(svn_checksum_md5, result_pool)
+                        : NULL;
+      job->size = 0;
+      job->err = SVN_NO_ERROR;
+    }
+
+  batch.jobs = jobs;
+  batch.next = 0;
+  batch.cancelled = FALSE;
+
+  if (max_threads <= 0)
+    max_threads = DEFAULT_BATCH_THREADS;
+
+#if APR_HAS_THREADS
+  /* The calling thread will be one of the workers. */
+  if (max_threads > 1 && jobs->nelts > 1)
+    {
+      int thread_count = MIN(max_threads, jobs->nelts) - 1;
+
+      /* The threads release their memory to this pool upon exit,
+       * so keep it independent from SCRATCH_POOL. */
+      threads_pool = svn_pool_create(NULL);
+      threads = apr_array_make(scratch_pool, thread_count,
+                               sizeof(apr_thread_t *));
+
+      for (i = 0; i < thread_count; ++i)
+        {
+          apr_thread_t *thread;
+
+          /* If we can't start more threads, we simply process the
+           * remaining jobs with the ones we already have. */
+          if (apr_thread_create(&thread, NULL, batch_worker, &batch,
+                                threads_pool))
+            break;
+
+          APR_ARRAY_PUSH(threads, apr_thread_t *) = thread;
+        }
+    }
+#endif
+
+  init_worker(&worker, &batch, svn_pool_create(scratch_pool));
+  err = run_jobs(&worker, cancel_func, cancel_baton);
+
+#if APR_HAS_THREADS
+  if (threads)
+    {
+      for (i = 0; i < threads->nelts; ++i)
+        {
+          apr_status_t retval;
+          apr_thread_join(&retval, APR_ARRAY_IDX(threads, i,
+                                                 apr_thread_t *));
+        }
+
+      svn_pool_destroy(threads_pool);
+    }
+#endif
+
+  svn_pool_destroy(worker.pool);
+
+  return svn_error_trace(err);
+}
@@ -1155,6 +1155,9 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###                              HTTP operation."                   NL
         "###   http-chunked-requests      Whether to use chunked transfer"   NL
         "###                              encoding for HTTP requests body."  NL
+        "###   http-pipelined-commits     Whether to spool file contents and"NL
+        "###                              pipeline their uploads during"     NL
+        "###                              commits (yes/no)."                 NL
         "###   http-auth-types            List of HTTP authentication types."NL
         "###   ssl-authority-files        List of files, each of a trusted CA"
                                                                              NL
@@ -1555,6 +1558,45 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### returning an error.  The default is 10000, i.e. 10 seconds."    NL
         "### Longer values may be useful when exclusive locking is enabled." NL
         "# busy-timeout = 10000"                                             NL
+        "### Set the number of threads that install files into working"      NL
+        "### copies, e.g. during checkout and update.  The working copy"     NL
+        "### database is still updated by a single thread.  The default is"  NL
+        "### 1, i.e. files are installed one after the other."               NL
+        "# install-threads = 1"                                              NL
+        "### Set the number of nodes that checkout, update and switch"       NL
+        "### record in the working copy database in one transaction.  Use"   NL
+        "### 0 to give each node its own transaction."                       NL
+        "# update-batch-size = 256"                                          NL
+        "### Set to true to store large pristine texts in chunks that are"   NL
+        "### shared between similar texts, e.g. between the revisions of"    NL
+        "### a binary file, to save disk space.  Older clients refuse"       NL
+        "### working copies once they store chunked texts."                  NL
+        "# pristine-chunking = false"                                        NL
+        "### Set the path of a directory in which working copies share"      NL
+        "### their pristine texts, e.g. when checking out many branches."    NL
+        "### Working copies on the same volume hard-link the texts instead"  NL
+        "### of storing their own copies, and checkout and update over http" NL
+        "### don't download texts found there.  Run 'svn cleanup"            NL
+        "### --vacuum-pristines' to remove texts no working copy uses."      NL
+        "# shared-pristine-store ="                                          NL
+        "### Set to true to detect modified files by comparing the checksum" NL
+        "### of the working file with the one recorded for its pristine"     NL
+        "### text, instead of comparing the files byte by byte.  This reads" NL
+        "### only the working file, which is faster when pristine texts are" NL
+        "### chunked or reading them is slow for another reason."            NL
+        "# compare-by-checksum = false"                                      NL
+        "### Set to true to let 'svn cleanup --vacuum-pristines' release the"NL
+        "### unused space of the working copy database in small steps, so it"NL
+        "### can report progress and be cancelled.  The first cleanup with"  NL
+        "### this enabled still compacts the whole database once."           NL
+        "# incremental-vacuum = false"                                       NL
+        "### Set to true to check out and update files without fetching"     NL
+        "### their text.  Such files are recorded in the working copy but"   NL
+        "### not created on disk until 'svn hydrate' fetches them or a"      NL
+        "### command needs their text.  Files whose text was fetched keep"   NL
+        "### being updated as usual.  Older clients refuse working copies"   NL
+        "### once they record files without their text."                     NL
+        "# lazy-fetch = false"                                               NL
         ;
 
       err = svn_io_file_open(&f, path,
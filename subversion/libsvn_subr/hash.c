@@ -103,7 +103,6 @@ svn_hash__read_entry(svn_hash__entry_t *entry,
   svn_stringbuf_t *buf;
   svn_boolean_t eof;
   apr_size_t len;
-  char c;
 
   svn_error_t *err;
   apr_uint64_t ui64;
@@ -138,17 +137,15 @@ svn_hash__read_entry(svn_hash__entry_t *entry,
                                 _("Serialized hash malformed key length"));
       entry->keylen = (apr_size_t)ui64;
 
-      /* Now read that much into a buffer. */
+      /* Now read that much into a buffer, plus the extra newline after
+         the key data.  Doing it in one go saves a stream round-trip. */
       entry->key = apr_palloc(pool, entry->keylen + 1);
-      SVN_ERR(svn_stream_read_full(stream, entry->key, &entry->keylen));
-      entry->key[entry->keylen] = '\0';
-
-      /* Suck up extra newline after key data */
-      len = 1;
-      SVN_ERR(svn_stream_read_full(stream, &c, &len));
-      if (c != '\n')
+      len = entry->keylen + 1;
+      SVN_ERR(svn_stream_read_full(stream, entry->key, &len));
+      if (len != entry->keylen + 1 || entry->key[entry->keylen] != '\n')
         return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
                                 _("Serialized hash malformed key data"));
+      entry->key[entry->keylen] = '\0';
 
       /* Read a val length line */
       SVN_ERR(svn_stream_readline(stream, &buf, "\n", &eof, pool));
@@ -163,16 +160,14 @@ svn_hash__read_entry(svn_hash__entry_t *entry,
                                     _("Serialized hash malformed value length"));
           entry->vallen = (apr_size_t)ui64;
 
+          /* Read the value together with the newline after it. */
           entry->val = apr_palloc(pool, entry->vallen + 1);
-          SVN_ERR(svn_stream_read_full(stream, entry->val, &entry->vallen));
-          entry->val[entry->vallen] = '\0';
-
-          /* Suck up extra newline after val data */
-          len = 1;
-          SVN_ERR(svn_stream_read_full(stream, &c, &len));
-          if (c != '\n')
+          len = entry->vallen + 1;
+          SVN_ERR(svn_stream_read_full(stream, entry->val, &len));
+          if (len != entry->vallen + 1 || entry->val[entry->vallen] != '\n')
             return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
                                     _("Serialized hash malformed value data"));
+          entry->val[entry->vallen] = '\0';
         }
       else
         return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
@@ -189,17 +184,15 @@ svn_hash__read_entry(svn_hash__entry_t *entry,
                                 _("Serialized hash malformed key length"));
       entry->keylen = (apr_size_t)ui64;
 
-      /* Now read that much into a buffer. */
+      /* Now read that much into a buffer, plus the extra newline after
+         the key data.  Doing it in one go saves a stream round-trip. */
       entry->key = apr_palloc(pool, entry->keylen + 1);
-      SVN_ERR(svn_stream_read_full(stream, entry->key, &entry->keylen));
-      entry->key[entry->keylen] = '\0';
-
-      /* Suck up extra newline after key data */
-      len = 1;
-      SVN_ERR(svn_stream_read_full(stream, &c, &len));
-      if (c != '\n')
+      len = entry->keylen + 1;
+      SVN_ERR(svn_stream_read_full(stream, entry->key, &len));
+      if (len != entry->keylen + 1 || entry->key[entry->keylen] != '\n')
         return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
                                 _("Serialized hash malformed key data"));
+      entry->key[entry->keylen] = '\0';
 
       /* Remove this hash entry. */
       entry->vallen = 0;
@@ -4325,6 +4325,32 @@ svn_io_file_rename2(const char *from_path, const char *to_path,
 }
 
 
+svn_error_t *
+svn_io__file_link(const char *from_path,
+                  const char *to_path,
+                  apr_pool_t *pool)
+{
+  apr_status_t status;
+  const char *from_path_apr, *to_path_apr;
+
+  SVN_ERR(cstring_from_utf8(&from_path_apr, from_path, pool));
+  SVN_ERR(cstring_from_utf8(&to_path_apr, to_path, pool));
+
+#if APR_VERSION_AT_LEAST(1, 4, 0)
+  status = apr_file_link(from_path_apr, to_path_apr);
+#else
+  status = APR_ENOTIMPL;
+#endif
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't link '%s' to '%s'"),
+                              svn_dirent_local_style(to_path, pool),
+                              svn_dirent_local_style(from_path, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_io_file_move(const char *from_path, const char *to_path,
                  apr_pool_t *pool)
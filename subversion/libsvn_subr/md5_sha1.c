@@ -0,0 +1,742 @@
+/*
+ * md5_sha1.c :  MD5 and SHA-1 implementations used by the checksum code.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+#include <apr.h>
+
+#include "private/svn_atomic.h"
+#include "md5_sha1.h"
+
+/* We replace the APR implementations because those are the main CPU
+ * hog when importing, committing or checking out large files.
+ *
+ * MD5 cannot be vectorized but the implementation below avoids all the
+ * byte shuffling of the reference code.  For SHA-1, many CPUs provide
+ * dedicated instructions that are about 3 to 5 times faster than any
+ * plain C code.  We use them whenever the compiler can generate them
+ * and, on x86, the CPU reports them at runtime.
+ */
+
+/* Select the SHA-1 implementations that the compiler can provide. */
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#  define SVN_SHA1_X86_SHA
+#  include <cpuid.h>
+#  include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) \
+    && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))
+#  define SVN_SHA1_ARM_SHA
+#  include <arm_neon.h>
+#endif
+
+/* Size of the chunks in which svn_md5_sha1__update() interleaves the
+ * two algorithms.  Small enough to remain in the L1 cache. */
+#define INTERLEAVE_CHUNK_SIZE 0x1000
+
+/* Return the 32 bit little-endian value at P.  Compilers turn this into
+ * a single load instruction where possible. */
+static APR_INLINE apr_uint32_t
+load_le32(const unsigned char *p)
+{
+  return  (apr_uint32_t)p[0]
+       | ((apr_uint32_t)p[1] << 8)
+       | ((apr_uint32_t)p[2] << 16)
+       | ((apr_uint32_t)p[3] << 24);
+}
+
+/* Return the 32 bit big-endian value at P. */
+static APR_INLINE apr_uint32_t
+load_be32(const unsigned char *p)
+{
+  return ((apr_uint32_t)p[0] << 24)
+       | ((apr_uint32_t)p[1] << 16)
+       | ((apr_uint32_t)p[2] << 8)
+       |  (apr_uint32_t)p[3];
+}
+
+/* Store VALUE at P in little-endian byte order. */
+static APR_INLINE void
+store_le32(unsigned char *p, apr_uint32_t value)
+{
+  p[0] = (unsigned char)value;
+  p[1] = (unsigned char)(value >> 8);
+  p[2] = (unsigned char)(value >> 16);
+  p[3] = (unsigned char)(value >> 24);
+}
+
+/* Store VALUE at P in big-endian byte order. */
+static APR_INLINE void
+store_be32(unsigned char *p, apr_uint32_t value)
+{
+  p[0] = (unsigned char)(value >> 24);
+  p[1] = (unsigned char)(value >> 16);
+  p[2] = (unsigned char)(value >> 8);
+  p[3] = (unsigned char)value;
+}
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+/* Feed LEN bytes at DATA through the block function BLOCKS, using the
+ * 64 byte BUFFER for incomplete blocks.  *LENGTH is the total number of
+ * bytes processed so far and will be updated. */
+static void
+buffered_update(svn_md5_sha1__blocks_t blocks,
+                apr_uint32_t *state,
+                apr_uint64_t *length,
+                unsigned char *buffer,
+                const unsigned char *data,
+                apr_size_t len)
+{
+  apr_size_t used = (apr_size_t)(*length & 63);
+
+  *length += len;
+
+  /* Complete the buffered block first. */
+  if (used)
+    {
+      apr_size_t to_copy = 64 - used;
+      if (to_copy > len)
+        to_copy = len;
+
+      memcpy(buffer + used, data, to_copy);
+      data += to_copy;
+      len -= to_copy;
+
+      if (used + to_copy < 64)
+        return;
+
+      blocks(state, buffer, 1);
+    }
+
+  /* Process all full blocks directly from DATA. */
+  if (len >= 64)
+    {
+      blocks(state, data, len / 64);
+      data += len & ~(apr_size_t)63;
+      len &= 63;
+    }
+
+  memcpy(buffer, data, len);
+}
+
+/* Append the final padding plus the message length in bits in either
+ * BIG_ENDIAN or little-endian notation and process the remaining blocks
+ * through BLOCKS. */
+static void
+buffered_final(svn_md5_sha1__blocks_t blocks,
+               apr_uint32_t *state,
+               apr_uint64_t length,
+               unsigned char *buffer,
+               svn_boolean_t big_endian)
+{
+  apr_size_t used = (apr_size_t)(length & 63);
+  apr_uint64_t bits = length << 3;
+
+  buffer[used++] = 0x80;
+  if (used > 56)
+    {
+      memset(buffer + used, 0, 64 - used);
+      blocks(state, buffer, 1);
+      used = 0;
+    }
+
+  memset(buffer + used, 0, 56 - used);
+  if (big_endian)
+    {
+      store_be32(buffer + 56, (apr_uint32_t)(bits >> 32));
+      store_be32(buffer + 60, (apr_uint32_t)bits);
+    }
+  else
+    {
+      store_le32(buffer + 56, (apr_uint32_t)bits);
+      store_le32(buffer + 60, (apr_uint32_t)(bits >> 32));
+    }
+
+  blocks(state, buffer, 1);
+}
+
+
+/*** MD5 ***/
+
+#define MD5_F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MD5_G(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))
+#define MD5_H(x, y, z) ((x) ^ (y) ^ (z))
+#define MD5_I(x, y, z) ((y) ^ ((x) | ~(z)))
+
+#define MD5_STEP(f, a, b, c, d, x, t, s)        \
+  do {                                          \
+    (a) += f((b), (c), (d)) + (x) + (t);        \
+    (a) = ROTL32((a), (s)) + (b);               \
+  } while (0)
+
+/* Implements svn_md5_sha1__blocks_t for MD5. */
+static void
+md5_blocks(apr_uint32_t *state,
+           const unsigned char *data,
+           apr_size_t count)
+{
+  apr_uint32_t a = state[0];
+  apr_uint32_t b = state[1];
+  apr_uint32_t c = state[2];
+  apr_uint32_t d = state[3];
+
+  for (; count > 0; --count, data += 64)
+    {
+      apr_uint32_t x[16];
+      apr_uint32_t sa = a, sb = b, sc = c, sd = d;
+      int i;
+
+      for (i = 0; i < 16; ++i)
+        x[i] = load_le32(data + 4 * i);
+
+      MD5_STEP(MD5_F, a, b, c, d, x[ 0], 0xd76aa478,  7);
+      MD5_STEP(MD5_F, d, a, b, c, x[ 1], 0xe8c7b756, 12);
+      MD5_STEP(MD5_F, c, d, a, b, x[ 2], 0x242070db, 17);
+      MD5_STEP(MD5_F, b, c, d, a, x[ 3], 0xc1bdceee, 22);
+      MD5_STEP(MD5_F, a, b, c, d, x[ 4], 0xf57c0faf,  7);
+      MD5_STEP(MD5_F, d, a, b, c, x[ 5], 0x4787c62a, 12);
+      MD5_STEP(MD5_F, c, d, a, b, x[ 6], 0xa8304613, 17);
+      MD5_STEP(MD5_F, b, c, d, a, x[ 7], 0xfd469501, 22);
+      MD5_STEP(MD5_F, a, b, c, d, x[ 8], 0x698098d8,  7);
+      MD5_STEP(MD5_F, d, a, b, c, x[ 9], 0x8b44f7af, 12);
+      MD5_STEP(MD5_F, c, d, a, b, x[10], 0xffff5bb1, 17);
+      MD5_STEP(MD5_F, b, c, d, a, x[11], 0x895cd7be, 22);
+      MD5_STEP(MD5_F, a, b, c, d, x[12], 0x6b901122,  7);
+      MD5_STEP(MD5_F, d, a, b, c, x[13], 0xfd987193, 12);
+      MD5_STEP(MD5_F, c, d, a, b, x[14], 0xa679438e, 17);
+      MD5_STEP(MD5_F, b, c, d, a, x[15], 0x49b40821, 22);
+
+      MD5_STEP(MD5_G, a, b, c, d, x[ 1], 0xf61e2562,  5);
+      MD5_STEP(MD5_G, d, a, b, c, x[ 6], 0xc040b340,  9);
+      MD5_STEP(MD5_G, c, d, a, b, x[11], 0x265e5a51, 14);
+      MD5_STEP(MD5_G, b, c, d, a, x[ 0], 0xe9b6c7aa, 20);
+      MD5_STEP(MD5_G, a, b, c, d, x[ 5], 0xd62f105d,  5);
+      MD5_STEP(MD5_G, d, a, b, c, x[10], 0x02441453,  9);
+      MD5_STEP(MD5_G, c, d, a, b, x[15], 0xd8a1e681, 14);
+      MD5_STEP(MD5_G, b, c, d, a, x[ 4], 0xe7d3fbc8, 20);
+      MD5_STEP(MD5_G, a, b, c, d, x[ 9], 0x21e1cde6,  5);
+      MD5_STEP(MD5_G, d, a, b, c, x[14], 0xc33707d6,  9);
+      MD5_STEP(MD5_G, c, d, a, b, x[ 3], 0xf4d50d87, 14);
+      MD5_STEP(MD5_G, b, c, d, a, x[ 8], 0x455a14ed, 20);
+      MD5_STEP(MD5_G, a, b, c, d, x[13], 0xa9e3e905,  5);
+      MD5_STEP(MD5_G, d, a, b, c, x[ 2], 0xfcefa3f8,  9);
+      MD5_STEP(MD5_G, c, d, a, b, x[ 7], 0x676f02d9, 14);
+      MD5_STEP(MD5_G, b, c, d, a, x[12], 0x8d2a4c8a, 20);
+
+      MD5_STEP(MD5_H, a, b, c, d, x[ 5], 0xfffa3942,  4);
+      MD5_STEP(MD5_H, d, a, b, c, x[ 8], 0x8771f681, 11);
+      MD5_STEP(MD5_H, c, d, a, b, x[11], 0x6d9d6122, 16);
+      MD5_STEP(MD5_H, b, c, d, a, x[14], 0xfde5380c, 23);
+      MD5_STEP(MD5_H, a, b, c, d, x[ 1], 0xa4beea44,  4);
+      MD5_STEP(MD5_H, d, a, b, c, x[ 4], 0x4bdecfa9, 11);
+      MD5_STEP(MD5_H, c, d, a, b, x[ 7], 0xf6bb4b60, 16);
+      MD5_STEP(MD5_H, b, c, d, a, x[10], 0xbebfbc70, 23);
+      MD5_STEP(MD5_H, a, b, c, d, x[13], 0x289b7ec6,  4);
+      MD5_STEP(MD5_H, d, a, b, c, x[ 0], 0xeaa127fa, 11);
+      MD5_STEP(MD5_H, c, d, a, b, x[ 3], 0xd4ef3085, 16);
+      MD5_STEP(MD5_H, b, c, d, a, x[ 6], 0x04881d05, 23);
+      MD5_STEP(MD5_H, a, b, c, d, x[ 9], 0xd9d4d039,  4);
+      MD5_STEP(MD5_H, d, a, b, c, x[12], 0xe6db99e5, 11);
+      MD5_STEP(MD5_H, c, d, a, b, x[15], 0x1fa27cf8, 16);
+      MD5_STEP(MD5_H, b, c, d, a, x[ 2], 0xc4ac5665, 23);
+
+      MD5_STEP(MD5_I, a, b, c, d, x[ 0], 0xf4292244,  6);
+      MD5_STEP(MD5_I, d, a, b, c, x[ 7], 0x432aff97, 10);
+      MD5_STEP(MD5_I, c, d, a, b, x[14], 0xab9423a7, 15);
+      MD5_STEP(MD5_I, b, c, d, a, x[ 5], 0xfc93a039, 21);
+      MD5_STEP(MD5_I, a, b, c, d, x[12], 0x655b59c3,  6);
+      MD5_STEP(MD5_I, d, a, b, c, x[ 3], 0x8f0ccc92, 10);
+      MD5_STEP(MD5_I, c, d, a, b, x[10], 0xffeff47d, 15);
+      MD5_STEP(MD5_I, b, c, d, a, x[ 1], 0x85845dd1, 21);
+      MD5_STEP(MD5_I, a, b, c, d, x[ 8], 0x6fa87e4f,  6);
+      MD5_STEP(MD5_I, d, a, b, c, x[15], 0xfe2ce6e0, 10);
+      MD5_STEP(MD5_I, c, d, a, b, x[ 6], 0xa3014314, 15);
+      MD5_STEP(MD5_I, b, c, d, a, x[13], 0x4e0811a1, 21);
+      MD5_STEP(MD5_I, a, b, c, d, x[ 4], 0xf7537e82,  6);
+      MD5_STEP(MD5_I, d, a, b, c, x[11], 0xbd3af235, 10);
+      MD5_STEP(MD5_I, c, d, a, b, x[ 2], 0x2ad7d2bb, 15);
+      MD5_STEP(MD5_I, b, c, d, a, x[ 9], 0xeb86d391, 21);
+
+      a += sa;
+      b += sb;
+      c += sc;
+      d += sd;
+    }
+
+  state[0] = a;
+  state[1] = b;
+  state[2] = c;
+  state[3] = d;
+}
+
+void
+svn_md5__init(svn_md5__context_t *context)
+{
+  context->state[0] = 0x67452301;
+  context->state[1] = 0xefcdab89;
+  context->state[2] = 0x98badcfe;
+  context->state[3] = 0x10325476;
+  context->length = 0;
+}
+
+void
+svn_md5__update(svn_md5__context_t *context,
+                const void *data,
+                apr_size_t len)
+{
+  buffered_update(md5_blocks, context->state, &context->length,
+                  context->buffer, data, len);
+}
+
+void
+svn_md5__final(unsigned char *digest,
+               svn_md5__context_t *context)
+{
+  int i;
+
+  buffered_final(md5_blocks, context->state, context->length,
+                 context->buffer, FALSE);
+  for (i = 0; i < 4; ++i)
+    store_le32(digest + 4 * i, context->state[i]);
+}
+
+
+/*** SHA-1 ***/
+
+#define SHA1_K0 0x5a827999
+#define SHA1_K1 0x6ed9eba1
+#define SHA1_K2 0x8f1bbcdc
+#define SHA1_K3 0xca62c1d6
+
+#define SHA1_F0(b, c, d) ((d) ^ ((b) & ((c) ^ (d))))
+#define SHA1_F1(b, c, d) ((b) ^ (c) ^ (d))
+#define SHA1_F2(b, c, d) (((b) & (c)) | ((d) & ((b) | (c))))
+#define SHA1_F3(b, c, d) ((b) ^ (c) ^ (d))
+
+/* Return the schedule word W[I] for I >= 16, updating the ring buffer W
+ * of the last 16 words. */
+#define SHA1_W(w, i)                                                    \
+  ((w)[(i) & 15] = ROTL32((w)[((i) - 3) & 15] ^ (w)[((i) - 8) & 15]     \
+                          ^ (w)[((i) - 14) & 15] ^ (w)[(i) & 15], 1))
+
+#define SHA1_STEP(f, k, a, b, c, d, e, x)                       \
+  do {                                                          \
+    (e) += ROTL32((a), 5) + f((b), (c), (d)) + (k) + (x);       \
+    (b) = ROTL32((b), 30);                                      \
+  } while (0)
+
+/* Implements svn_md5_sha1__blocks_t for SHA-1 in portable C. */
+static void
+sha1_blocks_c(apr_uint32_t *state,
+              const unsigned char *data,
+              apr_size_t count)
+{
+  apr_uint32_t a = state[0];
+  apr_uint32_t b = state[1];
+  apr_uint32_t c = state[2];
+  apr_uint32_t d = state[3];
+  apr_uint32_t e = state[4];
+
+  for (; count > 0; --count, data += 64)
+    {
+      apr_uint32_t w[16];
+      apr_uint32_t sa = a, sb = b, sc = c, sd = d, se = e;
+      int i;
+
+      for (i = 0; i < 16; ++i)
+        w[i] = load_be32(data + 4 * i);
+
+      /* Five steps per iteration rotate the variables back into place. */
+      for (i = 0; i < 15; i += 5)
+        {
+          SHA1_STEP(SHA1_F0, SHA1_K0, a, b, c, d, e, w[i]);
+          SHA1_STEP(SHA1_F0, SHA1_K0, e, a, b, c, d, w[i + 1]);
+          SHA1_STEP(SHA1_F0, SHA1_K0, d, e, a, b, c, w[i + 2]);
+          SHA1_STEP(SHA1_F0, SHA1_K0, c, d, e, a, b, w[i + 3]);
+          SHA1_STEP(SHA1_F0, SHA1_K0, b, c, d, e, a, w[i + 4]);
+        }
+
+      SHA1_STEP(SHA1_F0, SHA1_K0, a, b, c, d, e, w[15]);
+      SHA1_STEP(SHA1_F0, SHA1_K0, e, a, b, c, d, SHA1_W(w, 16));
+      SHA1_STEP(SHA1_F0, SHA1_K0, d, e, a, b, c, SHA1_W(w, 17));
+      SHA1_STEP(SHA1_F0, SHA1_K0, c, d, e, a, b, SHA1_W(w, 18));
+      SHA1_STEP(SHA1_F0, SHA1_K0, b, c, d, e, a, SHA1_W(w, 19));
+
+      for (i = 20; i < 40; i += 5)
+        {
+          SHA1_STEP(SHA1_F1, SHA1_K1, a, b, c, d, e, SHA1_W(w, i));
+          SHA1_STEP(SHA1_F1, SHA1_K1, e, a, b, c, d, SHA1_W(w, i + 1));
+          SHA1_STEP(SHA1_F1, SHA1_K1, d, e, a, b, c, SHA1_W(w, i + 2));
+          SHA1_STEP(SHA1_F1, SHA1_K1, c, d, e, a, b, SHA1_W(w, i + 3));
+          SHA1_STEP(SHA1_F1, SHA1_K1, b, c, d, e, a, SHA1_W(w, i + 4));
+        }
+
+      for (i = 40; i < 60; i += 5)
+        {
+          SHA1_STEP(SHA1_F2, SHA1_K2, a, b, c, d, e, SHA1_W(w, i));
+          SHA1_STEP(SHA1_F2, SHA1_K2, e, a, b, c, d, SHA1_W(w, i + 1));
+          SHA1_STEP(SHA1_F2, SHA1_K2, d, e, a, b, c, SHA1_W(w, i + 2));
+          SHA1_STEP(SHA1_F2, SHA1_K2, c, d, e, a, b, SHA1_W(w, i + 3));
+          SHA1_STEP(SHA1_F2, SHA1_K2, b, c, d, e, a, SHA1_W(w, i + 4));
+        }
+
+      for (i = 60; i < 80; i += 5)
+        {
+          SHA1_STEP(SHA1_F3, SHA1_K3, a, b, c, d, e, SHA1_W(w, i));
+          SHA1_STEP(SHA1_F3, SHA1_K3, e, a, b, c, d, SHA1_W(w, i + 1));
+          SHA1_STEP(SHA1_F3, SHA1_K3, d, e, a, b, c, SHA1_W(w, i + 2));
+          SHA1_STEP(SHA1_F3, SHA1_K3, c, d, e, a, b, SHA1_W(w, i + 3));
+          SHA1_STEP(SHA1_F3, SHA1_K3, b, c, d, e, a, SHA1_W(w, i + 4));
+        }
+
+      a += sa;
+      b += sb;
+      c += sc;
+      d += sd;
+      e += se;
+    }
+
+  state[0] = a;
+  state[1] = b;
+  state[2] = c;
+  state[3] = d;
+  state[4] = e;
+}
+
+#ifdef SVN_SHA1_X86_SHA
+
+/* Four rounds using the x86 SHA extensions.  E_NEXT gets updated with the
+ * schedule words MSG and used for the rounds, E_SAVE receives the state
+ * that becomes the E for the next four rounds.  FUNC selects the round
+ * function and constants. */
+#define SHA1_X86_ROUNDS4(e_next, e_save, msg, func)             \
+  do {                                                          \
+    e_next = _mm_sha1nexte_epu32(e_next, msg);                  \
+    e_save = abcd;                                              \
+    abcd = _mm_sha1rnds4_epu32(abcd, e_next, func);             \
+  } while (0)
+
+/* Implements svn_md5_sha1__blocks_t for SHA-1 using the x86 SHA
+ * extensions.  Must only be called if the CPU supports them. */
+__attribute__((target("sha,sse4.1")))
+static void
+sha1_blocks_x86(apr_uint32_t *state,
+                const unsigned char *data,
+                apr_size_t count)
+{
+  const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL,
+                                      0x08090a0b0c0d0e0fULL);
+  __m128i abcd, abcd_save, e0, e0_save, e1;
+  __m128i msg0, msg1, msg2, msg3;
+
+  abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0x1b);
+  e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+  for (; count > 0; --count, data += 64)
+    {
+      abcd_save = abcd;
+      e0_save = e0;
+
+      msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data), mask);
+      msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)),
+                              mask);
+      msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)),
+                              mask);
+      msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)),
+                              mask);
+
+      /* Rounds 0-3 */
+      e0 = _mm_add_epi32(e0, msg0);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+      /* Rounds 4-15 */
+      SHA1_X86_ROUNDS4(e1, e0, msg1, 0);
+      msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+
+      SHA1_X86_ROUNDS4(e0, e1, msg2, 0);
+      msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+      msg0 = _mm_xor_si128(msg0, msg2);
+
+      SHA1_X86_ROUNDS4(e1, e0, msg3, 0);
+      msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+      msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+      msg1 = _mm_xor_si128(msg1, msg3);
+
+      /* Rounds 16-63, fully pipelined message schedule */
+      SHA1_X86_ROUNDS4(e0, e1, msg0, 0);
+      msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+      msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+      msg2 = _mm_xor_si128(msg2, msg0);
+
+      SHA1_X86_ROUNDS4(e1, e0, msg1, 1);
+      msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+      msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+      msg3 = _mm_xor_si128(msg3, msg1);
+
+      SHA1_X86_ROUNDS4(e0, e1, msg2, 1);
+      msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+      msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+      msg0 = _mm_xor_si128(msg0, msg2);
+
+      SHA1_X86_ROUNDS4(e1, e0, msg3, 1);
+      msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+      msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+      msg1 = _mm_xor_si128(msg1, msg3);
+
+      SHA1_X86_ROUNDS4(e0, e1, msg0, 1);
+      msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+      msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+      msg2 = _mm_xor_si128(msg2, msg0);
+
+      SHA1_X86_ROUNDS4(e1, e0, msg1, 1);
+      msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+      msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+      msg3 = _mm_xor_si128(msg3, msg1);
+
+      SHA1_X86_ROUNDS4(e0, e1, msg2, 2);
+      msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+      msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+      msg0 = _mm_xor_si128(msg0, msg2);
+
+      SHA1_X86_ROUNDS4(e1, e0, msg3, 2);
+      msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+      msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+      msg1 = _mm_xor_si128(msg1, msg3);
+
+      SHA1_X86_ROUNDS4(e0, e1, msg0, 2);
+      msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+      msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+      msg2 = _mm_xor_si128(msg2, msg0);
+
+      SHA1_X86_ROUNDS4(e1, e0, msg1, 2);
+      msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+      msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+      msg3 = _mm_xor_si128(msg3, msg1);
+
+      SHA1_X86_ROUNDS4(e0, e1, msg2, 2);
+      msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+      msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+      msg0 = _mm_xor_si128(msg0, msg2);
+
+      SHA1_X86_ROUNDS4(e1, e0, msg3, 3);
+      msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+      msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+      msg1 = _mm_xor_si128(msg1, msg3);
+
+      /* Rounds 64-79, winding down the message schedule */
+      SHA1_X86_ROUNDS4(e0, e1, msg0, 3);
+      msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+      msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+      msg2 = _mm_xor_si128(msg2, msg0);
+
+      SHA1_X86_ROUNDS4(e1, e0, msg1, 3);
+      msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+      msg3 = _mm_xor_si128(msg3, msg1);
+
+      SHA1_X86_ROUNDS4(e0, e1, msg2, 3);
+      msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+
+      SHA1_X86_ROUNDS4(e1, e0, msg3, 3);
+
+      e0 = _mm_sha1nexte_epu32(e0, e0_save);
+      abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+
+  _mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = (apr_uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+/* Return TRUE if the CPU supports the x86 SHA extensions as well as the
+ * SSE versions that we use alongside them. */
+static svn_boolean_t
+x86_has_sha(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    return FALSE;
+  if (!(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1))
+    return FALSE;
+
+  if (__get_cpuid_max(0, NULL) < 7)
+    return FALSE;
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+  return (ebx & (1 << 29)) != 0;
+}
+
+#endif /* SVN_SHA1_X86_SHA */
+
+#ifdef SVN_SHA1_ARM_SHA
+
+/* Four rounds using the ARMv8 crypto extensions.  OP selects the round
+ * function, E the current state, E_NEXT receives the state for the next
+ * four rounds and I is the index of the schedule words MSG[I % 4]. */
+#define SHA1_ARM_ROUNDS4(op, k, e, e_next, i)                          \
+  do {                                                                  \
+    uint32x4_t tmp = vaddq_u32(msg[(i) % 4], vdupq_n_u32(k));           \
+    e_next = vsha1h_u32(vgetq_lane_u32(abcd, 0));                       \
+    abcd = op(abcd, e, tmp);                                            \
+    if ((i) < 16)                                                       \
+      msg[(i) % 4] = vsha1su1q_u32(vsha1su0q_u32(msg[(i) % 4],          \
+                                                 msg[((i) + 1) % 4],    \
+                                                 msg[((i) + 2) % 4]),   \
+                                   msg[((i) + 3) % 4]);                 \
+  } while (0)
+
+/* Implements svn_md5_sha1__blocks_t for SHA-1 using the ARMv8 crypto
+ * extensions. */
+static void
+sha1_blocks_arm(apr_uint32_t *state,
+                const unsigned char *data,
+                apr_size_t count)
+{
+  uint32x4_t abcd = vld1q_u32(state);
+  uint32_t e0 = state[4];
+  uint32_t e1;
+
+  for (; count > 0; --count, data += 64)
+    {
+      uint32x4_t abcd_save = abcd;
+      uint32_t e0_save = e0;
+      uint32x4_t msg[4];
+      int i;
+
+      for (i = 0; i < 4; ++i)
+        msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+
+      SHA1_ARM_ROUNDS4(vsha1cq_u32, SHA1_K0, e0, e1, 0);
+      SHA1_ARM_ROUNDS4(vsha1cq_u32, SHA1_K0, e1, e0, 1);
+      SHA1_ARM_ROUNDS4(vsha1cq_u32, SHA1_K0, e0, e1, 2);
+      SHA1_ARM_ROUNDS4(vsha1cq_u32, SHA1_K0, e1, e0, 3);
+      SHA1_ARM_ROUNDS4(vsha1cq_u32, SHA1_K0, e0, e1, 4);
+
+      SHA1_ARM_ROUNDS4(vsha1pq_u32, SHA1_K1, e1, e0, 5);
+      SHA1_ARM_ROUNDS4(vsha1pq_u32, SHA1_K1, e0, e1, 6);
+      SHA1_ARM_ROUNDS4(vsha1pq_u32, SHA1_K1, e1, e0, 7);
+      SHA1_ARM_ROUNDS4(vsha1pq_u32, SHA1_K1, e0, e1, 8);
+      SHA1_ARM_ROUNDS4(vsha1pq_u32, SHA1_K1, e1, e0, 9);
+
+      SHA1_ARM_ROUNDS4(vsha1mq_u32, SHA1_K2, e0, e1, 10);
+      SHA1_ARM_ROUNDS4(vsha1mq_u32, SHA1_K2, e1, e0, 11);
+      SHA1_ARM_ROUNDS4(vsha1mq_u32, SHA1_K2, e0, e1, 12);
+      SHA1_ARM_ROUNDS4(vsha1mq_u32, SHA1_K2, e1, e0, 13);
+      SHA1_ARM_ROUNDS4(vsha1mq_u32, SHA1_K2, e0, e1, 14);
+
+      SHA1_ARM_ROUNDS4(vsha1pq_u32, SHA1_K3, e1, e0, 15);
+      SHA1_ARM_ROUNDS4(vsha1pq_u32, SHA1_K3, e0, e1, 16);
+      SHA1_ARM_ROUNDS4(vsha1pq_u32, SHA1_K3, e1, e0, 17);
+      SHA1_ARM_ROUNDS4(vsha1pq_u32, SHA1_K3, e0, e1, 18);
+      SHA1_ARM_ROUNDS4(vsha1pq_u32, SHA1_K3, e1, e0, 19);
+
+      abcd = vaddq_u32(abcd, abcd_save);
+      e0 += e0_save;
+    }
+
+  vst1q_u32(state, abcd);
+  state[4] = e0;
+}
+
+#endif /* SVN_SHA1_ARM_SHA */
+
+/* The SHA-1 block function to use on this machine. */
+static svn_md5_sha1__blocks_t sha1_blocks = sha1_blocks_c;
+
+/* Implements svn_atomic__str_init_func_t.  Select SHA1_BLOCKS. */
+static const char *
+select_sha1_blocks(void *baton)
+{
+#if defined(SVN_SHA1_X86_SHA)
+  if (x86_has_sha())
+    sha1_blocks = sha1_blocks_x86;
+#elif defined(SVN_SHA1_ARM_SHA)
+  sha1_blocks = sha1_blocks_arm;
+#endif
+
+  return NULL;
+}
+
+void
+svn_sha1__init(svn_sha1__context_t *context)
+{
+  static volatile svn_atomic_t init_status = 0;
+  svn_atomic__init_once_no_error(&init_status, select_sha1_blocks, NULL);
+
+  context->state[0] = 0x67452301;
+  context->state[1] = 0xefcdab89;
+  context->state[2] = 0x98badcfe;
+  context->state[3] = 0x10325476;
+  context->state[4] = 0xc3d2e1f0;
+  context->length = 0;
+  context->blocks = sha1_blocks;
+}
+
+void
+svn_sha1__update(svn_sha1__context_t *context,
+                 const void *data,
+                 apr_size_t len)
+{
+  buffered_update(context->blocks, context->state, &context->length,
+                  context->buffer, data, len);
+}
+
+void
+svn_sha1__final(unsigned char *digest,
+                svn_sha1__context_t *context)
+{
+  int i;
+
+  buffered_final(context->blocks, context->state, context->length,
+                 context->buffer, TRUE);
+  for (i = 0; i < 5; ++i)
+    store_be32(digest + 4 * i, context->state[i]);
+}
+
+
+/*** Both ***/
+
+void
+svn_md5_sha1__update(svn_md5__context_t *md5,
+                     svn_sha1__context_t *sha1,
+                     const void *data,
+                     apr_size_t len)
+{
+  const unsigned char *p = data;
+
+  /* The second pass over each chunk will be served from the L1 cache. */
+  while (len > 0)
+    {
+      apr_size_t chunk = len < INTERLEAVE_CHUNK_SIZE
+                       ? len
+                       : INTERLEAVE_CHUNK_SIZE;
+
+      svn_md5__update(md5, p, chunk);
+      svn_sha1__update(sha1, p, chunk);
+
+      p += chunk;
+      len -= chunk;
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * md5_sha1.h :  MD5 and SHA-1 implementations used by the checksum code.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_SUBR_MD5_SHA1_H
+#define SVN_LIBSVN_SUBR_MD5_SHA1_H
+
+#include <apr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Process COUNT consecutive 64 byte blocks at DATA, updating STATE.
+ */
+typedef void (*svn_md5_sha1__blocks_t)(apr_uint32_t *state,
+                                       const unsigned char *data,
+                                       apr_size_t count);
+
+/* MD5 checksum creation context.  May be allocated on the stack.
+ */
+typedef struct svn_md5__context_t
+{
+  apr_uint32_t state[4];
+  apr_uint64_t length;
+  unsigned char buffer[64];
+} svn_md5__context_t;
+
+/* Initialize the MD5 checksum CONTEXT.
+ */
+void
+svn_md5__init(svn_md5__context_t *context);
+
+/* Feed LEN bytes from DATA into the MD5 checksum CONTEXT.
+ */
+void
+svn_md5__update(svn_md5__context_t *context,
+                const void *data,
+                apr_size_t len);
+
+/* Write the MD5 digest over all data fed into CONTEXT to DIGEST, which
+ * must provide space for 16 bytes.  CONTEXT must be initialized again
+ * before being reused.
+ */
+void
+svn_md5__final(unsigned char *digest,
+               svn_md5__context_t *context);
+
+/* SHA-1 checksum creation context.  May be allocated on the stack.
+ */
+typedef struct svn_sha1__context_t
+{
+  apr_uint32_t state[5];
+  apr_uint64_t length;
+  unsigned char buffer[64];
+
+  /* Block function, selected by what the CPU supports. */
+  svn_md5_sha1__blocks_t blocks;
+} svn_sha1__context_t;
+
+/* Initialize the SHA-1 checksum CONTEXT.
+ */
+void
+svn_sha1__init(svn_sha1__context_t *context);
+
+/* Feed LEN bytes from DATA into the SHA-1 checksum CONTEXT.
+ */
+void
+svn_sha1__update(svn_sha1__context_t *context,
+                 const void *data,
+                 apr_size_t len);
+
+/* Write the SHA-1 digest over all data fed into CONTEXT to DIGEST, which
+ * must provide space for 20 bytes.  CONTEXT must be initialized again
+ * before being reused.
+ */
+void
+svn_sha1__final(unsigned char *digest,
+                svn_sha1__context_t *context);
+
+/* Feed LEN bytes from DATA into both, the MD5 context MD5 and the SHA-1
+ * context SHA1.  This is equivalent to calling svn_md5__update() and
+ * svn_sha1__update() but reads the DATA from memory only once.
+ */
+void
+svn_md5_sha1__update(svn_md5__context_t *md5,
+                     svn_sha1__context_t *sha1,
+                     const void *data,
+                     apr_size_t len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_SUBR_MD5_SHA1_H */
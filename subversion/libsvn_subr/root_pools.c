@@ -21,11 +21,31 @@
  * ====================================================================
  */
 
+#include <apr_thread_proc.h>
+
 #include "svn_pools.h"
+#include "svn_string.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_mutex.h"
 
+/* Number of unused pools that we keep in the shared list if the creator
+ * of the container did not specify a limit. */
+#define DEFAULT_MAX_UNUSED 64
+
+/* The pool that a thread released last, kept for its next acquisition.
+ * This is allocated in POOL itself after clearing it.
+ */
+typedef struct thread_slot_t
+{
+  /* The container that POOL belongs to. */
+  svn_root_pools__t *pools;
+
+  /* The cached pool. */
+  apr_pool_t *pool;
+} thread_slot_t;
+
 struct svn_root_pools__t
 {
   /* unused pools.
@@ -36,10 +56,95 @@ struct svn_root_pools__t
   /* Mutex to serialize access to UNUSED_POOLS */
   svn_mutex__t *mutex;
 
+  /* Pools released while UNUSED_POOLS already holds this many entries
+   * get destroyed instead of being recycled. */
+  int max_unused;
+
+  /* Maximum number of free bytes that the allocator of each pool
+   * retains. */
+  apr_size_t max_free;
+
+#if APR_HAS_THREADS
+  /* Thread-local storage for the thread_slot_t of each thread.
+   * NULL if not available. */
+  apr_threadkey_t *thread_slot_key;
+#endif
+
+  /* Owns this structure, i.e. the pool of its private allocator. */
+  apr_pool_t *pool;
+
+  /* Statistics.  See svn_root_pools__info_t. */
+  volatile svn_atomic_t acquired;
+  volatile svn_atomic_t thread_hits;
+  volatile svn_atomic_t created;
+  volatile svn_atomic_t reclaimed;
+  volatile svn_atomic_t in_use;
+  volatile svn_atomic_t thread_cached;
 };
 
+/* Return a new root pool with an allocator configured for POOLS. */
+static apr_pool_t *
+create_root_pool(svn_root_pools__t *pools)
+{
+  apr_allocator_t *allocator = svn_pool_create_allocator(FALSE);
+  apr_allocator_max_free_set(allocator, pools->max_free);
+  svn_atomic_inc(&pools->created);
+
+  return apr_allocator_owner_get(allocator);
+}
+
+/* Put the cleared POOL back into the shared list of POOLS, unless that
+ * is full already.  In the latter case or if we can't access the list,
+ * destroy POOL.
+ */
+static void
+put_unused_pool(apr_pool_t *pool,
+                svn_root_pools__t *pools)
+{
+  svn_boolean_t reclaim = TRUE;
+  svn_error_t *err = svn_mutex__lock(pools->mutex);
+  if (err)
+    {
+      svn_error_clear(err);
+    }
+  else
+    {
+      if (pools->unused_pools->nelts < pools->max_unused)
+        {
+          APR_ARRAY_PUSH(pools->unused_pools, apr_pool_t *) = pool;
+          reclaim = FALSE;
+        }
+
+      svn_error_clear(svn_mutex__unlock(pools->mutex, SVN_NO_ERROR));
+    }
+
+  if (reclaim)
+    {
+      svn_pool_destroy(pool);
+      svn_atomic_inc(&pools->reclaimed);
+    }
+}
+
+#if APR_HAS_THREADS
+
+/* Destructor for the thread_slot_t in DATA, called when its thread
+ * terminates.  Hand the cached pool over to the other threads. */
+static void
+thread_slot_dtor(void *data)
+{
+  thread_slot_t *slot = data;
+  svn_root_pools__t *pools = slot->pools;
+
+  svn_atomic_dec(&pools->thread_cached);
+  put_unused_pool(slot->pool, pools);
+}
+
+#endif
+
 svn_error_t *
-svn_root_pools__create(svn_root_pools__t **pools)
+svn_root_pools__create2(svn_root_pools__t **pools,
+                        int max_unused,
+                        apr_size_t max_free)
 {
   /* the collection of root pools must be managed independently from
      any other pool */
@@ -48,8 +153,20 @@ svn_root_pools__create(svn_root_pools__t **pools)
 
   /* construct result object */
   svn_root_pools__t *result = apr_pcalloc(pool, sizeof(*result));
+  result->pool = pool;
   SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
   result->unused_pools = apr_array_make(pool, 16, sizeof(apr_pool_t *));
+  result->max_unused = max_unused > 0 ? max_unused : DEFAULT_MAX_UNUSED;
+  result->max_free = max_free > 0
+                   ? max_free
+                   : SVN_ALLOCATOR_RECOMMENDED_MAX_FREE;
+
+#if APR_HAS_THREADS
+  /* Without thread-local storage, we simply use the shared list only. */
+  if (apr_threadkey_private_create(&result->thread_slot_key,
+                                   thread_slot_dtor, pool))
+    result->thread_slot_key = NULL;
+#endif
 
   /* done */
   *pools = result;
@@ -57,6 +174,41 @@ svn_root_pools__create(svn_root_pools__t **pools)
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_root_pools__create(svn_root_pools__t **pools)
+{
+  return svn_error_trace(svn_root_pools__create2(pools, 0, 0));
+}
+
+void
+svn_root_pools__destroy(svn_root_pools__t *pools)
+{
+  int i;
+
+#if APR_HAS_THREADS
+  /* Other threads have handed their cached pools back when terminating.
+   * Only the calling thread may still have one. */
+  if (pools->thread_slot_key)
+    {
+      void *data = NULL;
+      if (!apr_threadkey_private_get(&data, pools->thread_slot_key)
+          && data)
+        {
+          thread_slot_t *slot = data;
+          apr_threadkey_private_set(NULL, pools->thread_slot_key);
+          svn_pool_destroy(slot->pool);
+        }
+
+      apr_threadkey_private_delete(pools->thread_slot_key);
+    }
+#endif
+
+  for (i = 0; i < pools->unused_pools->nelts; ++i)
+    svn_pool_destroy(APR_ARRAY_IDX(pools->unused_pools, i, apr_pool_t *));
+
+  svn_pool_destroy(pools->pool);
+}
+
 /* Return a currently unused connection pool in *POOL. If no such pool
  * exists, create a new root pool and return that in *POOL.
  */
@@ -67,7 +219,7 @@ acquire_pool_internal(apr_pool_t **pool,
   SVN_ERR(svn_mutex__lock(pools->mutex));
   *pool = pools->unused_pools->nelts
         ? *(apr_pool_t **)apr_array_pop(pools->unused_pools)
-        : apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+        : create_root_pool(pools);
   SVN_ERR(svn_mutex__unlock(pools->mutex, SVN_NO_ERROR));
 
   return SVN_NO_ERROR;
@@ -77,12 +229,36 @@ apr_pool_t *
 svn_root_pools__acquire_pool(svn_root_pools__t *pools)
 {
   apr_pool_t *pool;
-  svn_error_t *err = acquire_pool_internal(&pool, pools);
+  svn_error_t *err;
+
+  svn_atomic_inc(&pools->acquired);
+  svn_atomic_inc(&pools->in_use);
+
+#if APR_HAS_THREADS
+  /* Try the pool that this thread released last.  No locking needed. */
+  if (pools->thread_slot_key)
+    {
+      void *data = NULL;
+      if (!apr_threadkey_private_get(&data, pools->thread_slot_key)
+          && data
+          && !apr_threadkey_private_set(NULL, pools->thread_slot_key))
+        {
+          thread_slot_t *slot = data;
+
+          svn_atomic_dec(&pools->thread_cached);
+          svn_atomic_inc(&pools->thread_hits);
+
+          return slot->pool;
+        }
+    }
+#endif
+
+  err = acquire_pool_internal(&pool, pools);
   if (err)
     {
       /* Mutex failure?!  Well, try to continue with unrecycled data. */
       svn_error_clear(err);
-      pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+      pool = create_root_pool(pools);
     }
 
   return pool;
@@ -92,19 +268,251 @@ void
 svn_root_pools__release_pool(apr_pool_t *pool,
                              svn_root_pools__t *pools)
 {
+  svn_pool_clear(pool);
+  svn_atomic_dec(&pools->in_use);
+
+#if APR_HAS_THREADS
+  /* Keep the pool for the next acquisition in this thread, if we don't
+   * have one cached already. */
+  if (pools->thread_slot_key)
+    {
+      void *data = NULL;
+      if (!apr_threadkey_private_get(&data, pools->thread_slot_key)
+          && !data)
+        {
+          thread_slot_t *slot = apr_palloc(pool, sizeof(*slot));
+          slot->pools = pools;
+          slot->pool = pool;
+
+          if (!apr_threadkey_private_set(slot, pools->thread_slot_key))
+            {
+              svn_atomic_inc(&pools->thread_cached);
+              return;
+            }
+        }
+    }
+#endif
+
+  put_unused_pool(pool, pools);
+}
+
+svn_root_pools__info_t *
+svn_root_pools__get_info(svn_root_pools__t *pools,
+                         apr_pool_t *result_pool)
+{
+  svn_root_pools__info_t *info = apr_pcalloc(result_pool, sizeof(*info));
   svn_error_t *err;
 
-  svn_pool_clear(pool);
+  info->acquired = svn_atomic_read(&pools->acquired);
+  info->thread_hits = svn_atomic_read(&pools->thread_hits);
+  info->created = svn_atomic_read(&pools->created);
+  info->reclaimed = svn_atomic_read(&pools->reclaimed);
+  info->in_use = svn_atomic_read(&pools->in_use);
+  info->thread_cached = svn_atomic_read(&pools->thread_cached);
+  info->max_unused = pools->max_unused;
+  info->max_free = pools->max_free;
 
+  /* Statistics are informational only.  Report 0 if we can't lock. */
   err = svn_mutex__lock(pools->mutex);
   if (err)
     {
       svn_error_clear(err);
-      svn_pool_destroy(pool);
     }
   else
     {
-      APR_ARRAY_PUSH(pools->unused_pools, apr_pool_t *) = pool;
+      info->unused = pools->unused_pools->nelts;
       svn_error_clear(svn_mutex__unlock(pools->mutex, SVN_NO_ERROR));
     }
+
+  info->max_retained = (apr_uint64_t)(info->unused + info->thread_cached)
+                     * info->max_free;
+
+  return info;
+}
+
+svn_string_t *
+svn_root_pools__format_info(const svn_root_pools__info_t *info,
+                            apr_pool_t *result_pool)
+{
+  enum { _1kB = 1024 };
+
+  double hit_rate = (100.0 * (double)info->thread_hits)
+                  / (double)(info->acquired ? info->acquired : 1);
+
+  return svn_string_createf(result_pool,
+                            "root pools\n"
+                            "acquired: %" APR_UINT64_T_FMT
+                            ", %" APR_UINT64_T_FMT
+                            " from thread cache (%5.2f%%)\n"
+                            "created : %" APR_UINT64_T_FMT
+                            ", %" APR_UINT64_T_FMT " reclaimed\n"
+                            "pools   : %" APR_SIZE_T_FMT " in use, %"
+                            APR_SIZE_T_FMT " unused, %" APR_SIZE_T_FMT
+                            " thread-cached (max. %d unused)\n"
+                            "retained: up to %" APR_UINT64_T_FMT
+                            " kB free memory (max. %" APR_SIZE_T_FMT
+                            " kB per pool)\n",
+                            info->acquired,
+                            info->thread_hits, hit_rate,
+                            info->created,
+                            info->reclaimed,
+                            info->in_use, info->unused,
+                            info->thread_cached,
+                            info->max_unused,
+                            info->max_retained / _1kB,
+                            info->max_free / _1kB);
+}
+
+/*** Arena pools. ***/
+
+#if !APR_POOL_DEBUG
+
+/* Maximum number of free bytes that the per-thread allocator retains. */
+#define ARENA_MAX_FREE (1024 * 1024)
+
+/* Per-thread allocator for arenas.
+ */
+typedef struct arena_cache_t
+{
+  /* Owner of ALLOCATOR and of this structure. */
+  apr_pool_t *pool;
+
+  /* Not thread-safe and caches up to ARENA_MAX_FREE bytes. */
+  apr_allocator_t *allocator;
+
+  /* Number of arenas that have not been destroyed yet. */
+  apr_size_t live;
+
+  /* Set when the owning thread has terminated while arenas were still
+   * alive.  Their parents have been leaked as well then, so we leak the
+   * allocator rather than pulling it from under them. */
+  svn_boolean_t orphaned;
+} arena_cache_t;
+
+/* Return a new arena cache. */
+static arena_cache_t *
+create_arena_cache(void)
+{
+  apr_allocator_t *allocator = svn_pool_create_allocator(FALSE);
+  apr_pool_t *pool = apr_allocator_owner_get(allocator);
+  arena_cache_t *cache = apr_pcalloc(pool, sizeof(*cache));
+
+  apr_allocator_max_free_set(allocator, ARENA_MAX_FREE);
+  cache->pool = pool;
+  cache->allocator = allocator;
+
+  return cache;
+}
+
+#if APR_HAS_THREADS
+
+/* Thread-local storage for the arena_cache_t * of each thread. */
+static apr_threadkey_t *arena_cache_key = NULL;
+
+/* Destructor for the thread-local arena cache in DATA. */
+static void
+arena_cache_dtor(void *data)
+{
+  arena_cache_t *cache = data;
+  if (cache->live)
+    cache->orphaned = TRUE;
+  else
+    svn_pool_destroy(cache->pool);
+}
+
+/* Implements svn_atomic__str_init_func_t.  Create ARENA_CACHE_KEY.
+ * If that fails, ARENA_CACHE_KEY remains NULL and arenas degrade to
+ * standard sub-pools. */
+static const char *
+arena_init_once(void *baton)
+{
+  /* The thread-local storage must outlive all threads, so this pool
+   * never gets destroyed. */
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+  if (apr_threadkey_private_create(&arena_cache_key, arena_cache_dtor, pool))
+    arena_cache_key = NULL;
+
+  return NULL;
+}
+
+#endif
+
+/* Return the arena cache of the current thread or NULL, if there is
+ * none and we can't create it. */
+static arena_cache_t *
+get_arena_cache(void)
+{
+#if APR_HAS_THREADS
+  static volatile svn_atomic_t init_status = 0;
+  void *data = NULL;
+
+  svn_atomic__init_once_no_error(&init_status, arena_init_once, NULL);
+  if (!arena_cache_key)
+    return NULL;
+
+  if (apr_threadkey_private_get(&data, arena_cache_key))
+    return NULL;
+
+  if (!data)
+    {
+      arena_cache_t *cache = create_arena_cache();
+      if (apr_threadkey_private_set(cache, arena_cache_key))
+        {
+          svn_pool_destroy(cache->pool);
+          return NULL;
+        }
+
+      data = cache;
+    }
+
+  return data;
+#else
+  static arena_cache_t *cache = NULL;
+  if (!cache)
+    cache = create_arena_cache();
+
+  return cache;
+#endif
+}
+
+/* Pool cleanup function registered with each arena.  Its memory goes
+ * back to the allocator of the arena_cache_t in DATA. */
+static apr_status_t
+arena_cleanup(void *data)
+{
+  arena_cache_t *cache = data;
+  --cache->live;
+
+  return APR_SUCCESS;
+}
+
+#endif /* !APR_POOL_DEBUG */
+
+apr_pool_t *
+svn_pool__create_arena(apr_pool_t *parent_pool)
+{
+#if !APR_POOL_DEBUG
+  arena_cache_t *cache = get_arena_cache();
+  if (cache)
+    {
+      /* A true sub-pool, so APR destroys it along with PARENT_POOL, but
+       * one that takes its memory from our per-thread allocator. */
+      apr_pool_t *arena_pool = svn_pool_create_ex(parent_pool,
+                                                  cache->allocator);
+
+      ++cache->live;
+      apr_pool_cleanup_register(arena_pool, cache, arena_cleanup,
+                                apr_pool_cleanup_null);
+
+      return arena_pool;
+    }
+#endif
+
+  return svn_pool_create(parent_pool);
+}
+
+void
+svn_pool__destroy_arena(apr_pool_t *arena_pool)
+{
+  svn_pool_destroy(arena_pool);
 }
@@ -20,7 +20,12 @@
  * ====================================================================
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <apr_pools.h>
+#include <apr_strings.h>
 
 #include "svn_types.h"
 #include "svn_error.h"
@@ -28,6 +33,7 @@
 #include "svn_io.h"
 #include "svn_dirent_uri.h"
 #include "svn_checksum.h"
+#include "svn_ctype.h"
 
 #include "internal_statements.h"
 
@@ -134,6 +140,19 @@ svn_sqlite__dbg_enable_errorlog(void)
 }
 
 
+/* Execution statistics of a single prepared statement.  */
+typedef struct stmt_profile_t
+{
+  /* Number of times the statement was executed. */
+  apr_int64_t calls;
+
+  /* Number of rows returned over all executions. */
+  apr_int64_t rows;
+
+  /* Total time spent in sqlite3_step() for this statement. */
+  apr_interval_time_t time;
+} stmt_profile_t;
+
 struct svn_sqlite__db_t
 {
   sqlite3 *db3;
@@ -142,6 +161,10 @@ struct svn_sqlite__db_t
   svn_sqlite__stmt_t **prepared_stmts;
   apr_pool_t *state_pool;
 
+  /* When profiling is enabled, the statistics of all statements, indexed
+     like PREPARED_STMTS.  NULL otherwise. */
+  stmt_profile_t *profile;
+
 #ifdef SVN_UNICODE_NORMALIZATION_FIXES
   /* Buffers for SQLite extensoins. */
   svn_membuf_t sqlext_buf1;
@@ -155,6 +178,10 @@ struct svn_sqlite__stmt_t
   sqlite3_stmt *s3stmt;
   svn_sqlite__db_t *db;
   svn_boolean_t needs_reset;
+
+  /* Index of this statement in DB->PREPARED_STMTS, or -1 if it is not
+     stored there. */
+  int stmt_idx;
 };
 
 struct svn_sqlite__context_t
@@ -245,11 +272,12 @@ exec_sql2(svn_sqlite__db_t *db, const char *sql, int ignored_err)
 
 static svn_error_t *
 prepare_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
-                  const char *text, apr_pool_t *result_pool)
+                  const char *text, int stmt_idx, apr_pool_t *result_pool)
 {
   *stmt = apr_palloc(result_pool, sizeof(**stmt));
   (*stmt)->db = db;
   (*stmt)->needs_reset = FALSE;
+  (*stmt)->stmt_idx = stmt_idx;
 
   SQLITE_ERR(sqlite3_prepare_v2(db->db3, text, -1, &(*stmt)->s3stmt, NULL), db);
 
@@ -274,7 +302,7 @@ svn_sqlite__get_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
 
   if (db->prepared_stmts[stmt_idx] == NULL)
     SVN_ERR(prepare_statement(&db->prepared_stmts[stmt_idx], db,
-                              db->statement_strings[stmt_idx],
+                              db->statement_strings[stmt_idx], stmt_idx,
                               db->state_pool));
 
   *stmt = db->prepared_stmts[stmt_idx];
@@ -299,7 +327,7 @@ get_internal_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
 
   if (db->prepared_stmts[prep_idx] == NULL)
     SVN_ERR(prepare_statement(&db->prepared_stmts[prep_idx], db,
-                              internal_statements[stmt_idx],
+                              internal_statements[stmt_idx], prep_idx,
                               db->state_pool));
 
   *stmt = db->prepared_stmts[prep_idx];
@@ -344,7 +372,23 @@ svn_sqlite__step_row(svn_sqlite__stmt_t *stmt)
 svn_error_t *
 svn_sqlite__step(svn_boolean_t *got_row, svn_sqlite__stmt_t *stmt)
 {
-  int sqlite_result = sqlite3_step(stmt->s3stmt);
+  int sqlite_result;
+
+  if (stmt->db->profile && stmt->stmt_idx >= 0)
+    {
+      stmt_profile_t *profile = &stmt->db->profile[stmt->stmt_idx];
+      apr_time_t start = apr_time_now();
+
+      sqlite_result = sqlite3_step(stmt->s3stmt);
+
+      profile->time += apr_time_now() - start;
+      if (!stmt->needs_reset)
+        profile->calls++;
+      if (sqlite_result == SQLITE_ROW)
+        profile->rows++;
+    }
+  else
+    sqlite_result = sqlite3_step(stmt->s3stmt);
 
   if (sqlite_result != SQLITE_DONE && sqlite_result != SQLITE_ROW)
     {
@@ -772,7 +816,8 @@ svn_sqlite__read_schema_version(int *version,
 {
   svn_sqlite__stmt_t *stmt;
 
-  SVN_ERR(prepare_statement(&stmt, db, "PRAGMA user_version;", scratch_pool));
+  SVN_ERR(prepare_statement(&stmt, db, "PRAGMA user_version;", -1,
+                            scratch_pool));
   SVN_ERR(svn_sqlite__step_row(stmt));
 
   *version = svn_sqlite__column_int(stmt, 0);
@@ -917,6 +962,162 @@ internal_open(svn_sqlite__db_t *db, const char *path, svn_sqlite__mode_t mode,
 }
 
 
+/* Maximum length of the statement text shown in a profile table. */
+#define PROFILE_LABEL_MAX 60
+
+/* Return the text of the statement at index STMT_IDX in
+   DB->PREPARED_STMTS with all whitespace runs collapsed to a single
+   space and cut to at most PROFILE_LABEL_MAX characters, allocated in
+   RESULT_POOL. */
+static const char *
+profile_label(svn_sqlite__db_t *db, int stmt_idx, apr_pool_t *result_pool)
+{
+  const char *text = (stmt_idx < db->nbr_statements)
+                        ? db->statement_strings[stmt_idx]
+                        : internal_statements[stmt_idx - db->nbr_statements];
+  svn_stringbuf_t *label = svn_stringbuf_create_empty(result_pool);
+  svn_boolean_t pending_space = FALSE;
+
+  for (; *text && label->len < PROFILE_LABEL_MAX; text++)
+    {
+      if (svn_ctype_isspace(*text))
+        {
+          pending_space = (label->len > 0);
+          continue;
+        }
+
+      if (pending_space)
+        svn_stringbuf_appendbyte(label, ' ');
+      svn_stringbuf_appendbyte(label, *text);
+      pending_space = FALSE;
+    }
+
+  while (svn_ctype_isspace(*text))
+    text++;
+  if (*text)
+    svn_stringbuf_appendcstr(label, "...");
+
+  return label->data;
+}
+
+/* qsort() callback ordering pointers into a single stmt_profile_t array
+   by descending total time, then by position. */
+static int
+compare_profile_entries(const void *a, const void *b)
+{
+  const stmt_profile_t *entry_a = *(const stmt_profile_t * const *)a;
+  const stmt_profile_t *entry_b = *(const stmt_profile_t * const *)b;
+
+  if (entry_a->time != entry_b->time)
+    return (entry_a->time > entry_b->time) ? -1 : 1;
+
+  return (entry_a < entry_b) ? -1 : (entry_a > entry_b);
+}
+
+/* Return the statistics collected for DB as a table with one line per
+   executed statement, slowest first, allocated in RESULT_POOL.  DB must
+   have profiling enabled. */
+static svn_stringbuf_t *
+format_profile(svn_sqlite__db_t *db, apr_pool_t *result_pool)
+{
+  int nbr_entries = db->nbr_statements + STMT_INTERNAL_LAST;
+  const stmt_profile_t **order = apr_palloc(result_pool,
+                                            nbr_entries * sizeof(*order));
+  const char *filename = sqlite3_db_filename(db->db3, "main");
+  svn_stringbuf_t *table;
+  int nbr_used = 0;
+  int i;
+
+  for (i = 0; i < nbr_entries; i++)
+    if (db->profile[i].calls > 0)
+      order[nbr_used++] = &db->profile[i];
+
+  qsort(order, nbr_used, sizeof(*order), compare_profile_entries);
+
+  table = svn_stringbuf_createf(result_pool,
+                                "SQLite statement profile for '%s'\n"
+                                "%6s %10s %10s %12s  %s\n",
+                                (filename && *filename) ? filename
+                                                        : ":memory:",
+                                "stmt", "calls", "rows", "time (ms)",
+                                "statement");
+
+  for (i = 0; i < nbr_used; i++)
+    {
+      const stmt_profile_t *profile = order[i];
+      int stmt_idx = (int)(profile - db->profile);
+      const char *idx_str;
+
+      if (stmt_idx < db->nbr_statements)
+        idx_str = apr_itoa(result_pool, stmt_idx);
+      else
+        idx_str = apr_psprintf(result_pool, "i%d",
+                               stmt_idx - db->nbr_statements);
+
+      svn_stringbuf_appendcstr(
+        table,
+        apr_psprintf(result_pool,
+                     "%6s %10" APR_INT64_T_FMT " %10" APR_INT64_T_FMT
+                     " %12.3f  %s\n",
+                     idx_str, profile->calls, profile->rows,
+                     profile->time / 1000.0,
+                     profile_label(db, stmt_idx, result_pool)));
+    }
+
+  return table;
+}
+
+/* Append the statistics collected for DB to the file named by the
+   SVN_SQLITE_PROFILE environment variable, or to stderr if that is "-".
+   This is called from a pool cleanup, so errors are ignored. */
+static void
+write_profile_from_env(svn_sqlite__db_t *db)
+{
+  const char *target = getenv("SVN_SQLITE_PROFILE");
+  apr_pool_t *pool;
+  svn_stringbuf_t *table;
+  FILE *out;
+
+  if (!target || !*target)
+    return;
+
+  /* DB's own pool is being cleaned up. */
+  pool = svn_pool_create(NULL);
+  table = format_profile(db, pool);
+
+  if (strcmp(target, "-") == 0)
+    fputs(table->data, stderr);
+  else if ((out = fopen(target, "a")) != NULL)
+    {
+      fputs(table->data, out);
+      fclose(out);
+    }
+
+  svn_pool_destroy(pool);
+}
+
+void
+svn_sqlite__profile_enable(svn_sqlite__db_t *db)
+{
+  if (!db->profile)
+    db->profile = apr_pcalloc(db->state_pool,
+                              (db->nbr_statements + STMT_INTERNAL_LAST)
+                                * sizeof(*db->profile));
+}
+
+svn_error_t *
+svn_sqlite__profile_write(svn_stream_t *stream,
+                          svn_sqlite__db_t *db,
+                          apr_pool_t *scratch_pool)
+{
+  if (!db->profile)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_stream_puts(stream,
+                                         format_profile(db, scratch_pool)
+                                           ->data));
+}
+
 /* APR cleanup function used to close the database when its pool is destroyed.
    DATA should be the svn_sqlite__db_t handle for the database. */
 static apr_status_t
@@ -931,6 +1132,9 @@ close_apr(void *data)
   if (db->db3 == NULL)
     return APR_SUCCESS;
 
+  if (db->profile)
+    write_profile_from_env(db);
+
   /* Finalize any prepared statements. */
   if (db->prepared_stmts)
     {
@@ -1218,6 +1422,9 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
   (*db)->state_pool = result_pool;
   apr_pool_cleanup_register(result_pool, *db, close_apr, apr_pool_cleanup_null);
 
+  if (getenv("SVN_SQLITE_PROFILE"))
+    svn_sqlite__profile_enable(*db);
+
   return SVN_NO_ERROR;
 }
 
@@ -325,6 +325,30 @@ svn_stream_printf_from_utf8(svn_stream_t *stream,
   return svn_error_trace(svn_stream_puts(stream, translated));
 }
 
+/* Return the first occurrence of the EOL_LEN bytes long EOL sequence
+ * within the LEN bytes at DATA or NULL, if there is none.  Unlike strstr(),
+ * this is not limited by NULs in DATA and uses memchr(), which typically
+ * scans whole machine words or vector registers at a time. */
+static const char *
+find_eol(const char *data,
+         apr_size_t len,
+         const char *eol,
+         apr_size_t eol_len)
+{
+  const char *end = data + len;
+
+  while ((apr_size_t)(end - data) >= eol_len)
+    {
+      data = memchr(data, eol[0], end - data - eol_len + 1);
+      if (data == NULL || memcmp(data + 1, eol + 1, eol_len - 1) == 0)
+        return data;
+
+      ++data;
+    }
+
+  return NULL;
+}
+
 /* Default implementation for svn_stream_readline().
  * Returns the line read from STREAM in *STRINGBUF, and indicates
  * end-of-file in *EOF.  EOL must point to the desired end-of-line
@@ -962,7 +986,8 @@ readline_apr_generic(apr_file_t *file,
       buf->data[buf->len] = '\0';
 
       /* Do we have the EOL now? */
-      eol_pos = strstr(search_start, eol);
+      eol_pos = find_eol(search_start, buf->data + buf->len - search_start,
+                         eol, eol_len);
       if (eol_pos)
         {
           svn_stringbuf_chop(buf, buf->data + buf->len - eol_pos);
@@ -986,6 +1011,67 @@ readline_apr_generic(apr_file_t *file,
     }
 }
 
+/* Read a line terminated by EOL from FILE one byte at a time.  This is
+ * for files that don't support seeking and is otherwise similar to
+ * readline_apr_generic(). */
+static svn_error_t *
+readline_apr_bytewise(apr_file_t *file,
+                      svn_stringbuf_t **stringbuf,
+                      const char *eol,
+                      svn_boolean_t *eof,
+                      apr_pool_t *pool)
+{
+  svn_stringbuf_t *buf;
+  const char *match;
+  char c;
+
+  buf = svn_stringbuf_create_ensure(SVN__LINE_CHUNK_SIZE, pool);
+  for (match = eol; *match; )
+    {
+      svn_error_t *err = svn_io_file_getc(&c, file, pool);
+      if (err)
+        {
+          if (!APR_STATUS_IS_EOF(err->apr_err))
+            return svn_error_trace(err);
+
+          svn_error_clear(err);
+          *eof = TRUE;
+          *stringbuf = buf;
+          return SVN_NO_ERROR;
+        }
+
+      match = (c == *match) ? match + 1 : eol;
+      svn_stringbuf_appendbyte(buf, c);
+    }
+
+  svn_stringbuf_chop(buf, match - eol);
+  *eof = FALSE;
+  *stringbuf = buf;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_stream_readline_fn_t for APR files that don't support
+ * seeking, e.g. STDIN.  For LF, apr_file_gets() scans APR's read buffer,
+ * which is much faster than the default implementation that goes through
+ * the whole stream stack for every single byte. */
+static svn_error_t *
+readline_handler_apr_unseekable(void *baton,
+                                svn_stringbuf_t **stringbuf,
+                                const char *eol,
+                                svn_boolean_t *eof,
+                                apr_pool_t *pool)
+{
+  struct baton_apr *btn = baton;
+
+  if (eol[0] == '\n' && eol[1] == '\0')
+    return svn_error_trace(readline_apr_lf(btn->file, stringbuf,
+                                           eof, pool));
+  else
+    return svn_error_trace(readline_apr_bytewise(btn->file, stringbuf,
+                                                 eol, eof, pool));
+}
+
 static svn_error_t *
 readline_handler_apr(void *baton,
                      svn_stringbuf_t **stringbuf,
@@ -1092,6 +1178,10 @@ make_stream_from_apr_file(apr_file_t *file,
       svn_stream_set_seek(stream, seek_handler_apr);
       svn_stream_set_readline(stream, readline_handler_apr);
     }
+  else
+    {
+      svn_stream_set_readline(stream, readline_handler_apr_unseekable);
+    }
 
   svn_stream_set_data_available(stream, data_available_handler_apr);
   stream->file = file;
@@ -1610,6 +1700,37 @@ svn_stringbuf_from_stream(svn_stringbuf_t **result,
   return SVN_NO_ERROR;
 }
 
+/* Common implementation of the readline handlers for in-memory streams.
+ * Return the line starting at offset *AMT_READ within the LEN bytes at DATA
+ * in *STRINGBUF, allocated in POOL, and advance *AMT_READ behind its EOL.
+ * Set *EOF if there is no EOL. */
+static void
+readline_from_buffer(svn_stringbuf_t **stringbuf,
+                     svn_boolean_t *eof,
+                     const char *data,
+                     apr_size_t len,
+                     apr_size_t *amt_read,
+                     const char *eol,
+                     apr_pool_t *pool)
+{
+  const char *pos = data + *amt_read;
+  apr_size_t eol_len = strlen(eol);
+  const char *eol_pos = find_eol(pos, len - *amt_read, eol, eol_len);
+
+  if (eol_pos)
+    {
+      *eof = FALSE;
+      *stringbuf = svn_stringbuf_ncreate(pos, eol_pos - pos, pool);
+      *amt_read += (eol_pos - pos + eol_len);
+    }
+  else
+    {
+      *eof = TRUE;
+      *stringbuf = svn_stringbuf_ncreate(pos, len - *amt_read, pool);
+      *amt_read = len;
+    }
+}
+
 struct stringbuf_stream_baton
 {
   svn_stringbuf_t *str;
@@ -1702,25 +1823,9 @@ readline_handler_stringbuf(void *baton,
                            apr_pool_t *pool)
 {
   struct stringbuf_stream_baton *btn = baton;
-  const char *pos = btn->str->data + btn->amt_read;
-  const char *eol_pos;
 
-  eol_pos = strstr(pos, eol);
-  if (eol_pos)
-    {
-      apr_size_t eol_len = strlen(eol);
-
-      *eof = FALSE;
-      *stringbuf = svn_stringbuf_ncreate(pos, eol_pos - pos, pool);
-      btn->amt_read += (eol_pos - pos + eol_len);
-    }
-  else
-    {
-      *eof = TRUE;
-      *stringbuf = svn_stringbuf_ncreate(pos, btn->str->len - btn->amt_read,
-                                         pool);
-      btn->amt_read = btn->str->len;
-    }
+  readline_from_buffer(stringbuf, eof, btn->str->data, btn->str->len,
+                       &btn->amt_read, eol, pool);
 
   return SVN_NO_ERROR;
 }
@@ -1832,25 +1937,9 @@ readline_handler_string(void *baton,
                         apr_pool_t *pool)
 {
   struct string_stream_baton *btn = baton;
-  const char *pos = btn->str->data + btn->amt_read;
-  const char *eol_pos;
 
-  eol_pos = strstr(pos, eol);
-  if (eol_pos)
-    {
-      apr_size_t eol_len = strlen(eol);
-
-      *eof = FALSE;
-      *stringbuf = svn_stringbuf_ncreate(pos, eol_pos - pos, pool);
-      btn->amt_read += (eol_pos - pos + eol_len);
-    }
-  else
-    {
-      *eof = TRUE;
-      *stringbuf = svn_stringbuf_ncreate(pos, btn->str->len - btn->amt_read,
-                                         pool);
-      btn->amt_read = btn->str->len;
-    }
+  readline_from_buffer(stringbuf, eof, btn->str->data, btn->str->len,
+                       &btn->amt_read, eol, pool);
 
   return SVN_NO_ERROR;
 }
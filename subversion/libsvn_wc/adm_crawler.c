@@ -127,7 +127,9 @@ svn_wc_restore(svn_wc_context_t *wc_ctx,
                                wc_ctx->db, local_abspath,
                                scratch_pool, scratch_pool));
 
-  if (status != svn_wc__db_status_normal
+  /* Files whose text was not fetched have nothing to restore */
+  if ((status != svn_wc__db_status_normal
+       || (kind == svn_node_file && checksum == NULL))
       && !((status == svn_wc__db_status_added
             || status == svn_wc__db_status_incomplete)
            && (kind == svn_node_dir
@@ -265,12 +265,13 @@ svn_wc__get_pristine_contents(svn_stream_t **contents,
                                "because it has an unexpected status"),
                              svn_dirent_local_style(local_abspath,
                                                     scratch_pool));
-  if (sha1_checksum)
-    SVN_ERR(svn_wc__db_pristine_read(contents, size, db, local_abspath,
-                                     sha1_checksum,
-                                     result_pool, scratch_pool));
-  else
-    *contents = NULL;
+  else if (!sha1_checksum)
+    return svn_error_trace(svn_wc__unfetched_error(local_abspath,
+                                                   scratch_pool));
+
+  SVN_ERR(svn_wc__db_pristine_read(contents, size, db, local_abspath,
+                                   sha1_checksum,
+                                   result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -86,6 +86,8 @@ cleanup_internal(svn_wc__db_t *db,
                  svn_boolean_t vacuum_pristines,
                  svn_cancel_func_t cancel_func,
                  void *cancel_baton,
+                 svn_wc_notify_func2_t notify_func,
+                 void *notify_baton,
                  apr_pool_t *scratch_pool)
 {
   int wc_format;
@@ -128,7 +130,10 @@ cleanup_internal(svn_wc__db_t *db,
       SVN_ERR(svn_wc__adm_cleanup_tmp_area(db, dir_abspath, scratch_pool));
 
       /* Remove unreferenced pristine texts */
-      SVN_ERR(svn_wc__db_pristine_cleanup(db, dir_abspath, scratch_pool));
+      SVN_ERR(svn_wc__db_pristine_cleanup(db, dir_abspath,
+                                          cancel_func, cancel_baton,
+                                          notify_func, notify_baton,
+                                          scratch_pool));
     }
 
   if (fix_recorded_timestamps)
@@ -191,6 +196,7 @@ svn_wc_cleanup4(svn_wc_context_t *wc_ctx,
                            fix_recorded_timestamps,
                            vacuum_pristines,
                            cancel_func, cancel_baton,
+                           notify_func, notify_baton,
                            scratch_pool));
 
   /* The DAV cache suffers from flakiness from time to time, and the
@@ -200,7 +206,8 @@ svn_wc_cleanup4(svn_wc_context_t *wc_ctx,
                                                       scratch_pool));
 
   if (vacuum_pristines)
-    SVN_ERR(svn_wc__db_vacuum(db, local_abspath, scratch_pool));
+    SVN_ERR(svn_wc__db_vacuum(db, local_abspath, cancel_func, cancel_baton,
+                              notify_func, notify_baton, scratch_pool));
 
   /* We're done with this DB, so proactively close it.  */
   if (break_locks)
@@ -655,6 +655,24 @@ copy_or_move(svn_boolean_t *record_move_on_delete,
           break;
       }
 
+    /* A copy needs the text of its files */
+    {
+      apr_array_header_t *unfetched;
+
+      SVN_ERR(svn_wc__db_base_get_unfetched(&unfetched, db, src_abspath,
+                                            svn_depth_infinity,
+                                            scratch_pool, scratch_pool));
+      if (unfetched->nelts > 0)
+        return svn_error_createf(
+                 SVN_ERR_WC_PATH_UNEXPECTED_STATUS, NULL,
+                 _("Cannot copy '%s' as the text of '%s' was not fetched; "
+                   "run 'svn hydrate' first"),
+                 svn_dirent_local_style(src_abspath, scratch_pool),
+                 svn_dirent_local_style(APR_ARRAY_IDX(unfetched, 0,
+                                                      const char *),
+                                        scratch_pool));
+    }
+
      if (is_move && ! strcmp(src_abspath, src_wcroot_abspath))
       {
         return svn_error_createf(SVN_ERR_WC_PATH_UNEXPECTED_STATUS, NULL,
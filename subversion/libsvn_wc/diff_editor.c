@@ -457,7 +457,10 @@ svn_wc__diff_base_working_diff(svn_wc__db_t *db,
   if (files_same && !props_mod)
     return SVN_NO_ERROR; /* Cheap exit */
 
-  assert(checksum);
+  /* Files added without their text have nothing to compare against */
+  if (!checksum)
+    return svn_error_trace(svn_wc__unfetched_error(local_abspath,
+                                                   scratch_pool));
 
   if (!SVN_IS_VALID_REVNUM(revision))
     revision = db_revision;
@@ -2047,6 +2050,11 @@ open_file(const char *path,
                                    eb->db, fb->local_abspath,
                                    fb->pool, fb->pool));
 
+  /* The repository sends changes against a text we don't have */
+  if (!fb->base_checksum)
+    return svn_error_trace(svn_wc__unfetched_error(fb->local_abspath,
+                                                   fb->pool));
+
   SVN_ERR(eb->processor->file_opened(&fb->pfb, &fb->skip,
                                      fb->relpath,
                                      fb->left_src,
@@ -2250,7 +2258,9 @@ close_file(void *file_baton,
                                                 &local_props,
                                                 eb->db, fb->local_abspath,
                                                 scratch_pool, scratch_pool));
-          assert(checksum);
+          if (!checksum)
+            return svn_error_trace(svn_wc__unfetched_error(fb->local_abspath,
+                                                           scratch_pool));
           SVN_ERR(svn_wc__db_pristine_get_path(&localfile,
                                                eb->db, eb->anchor_abspath,
                                                checksum,
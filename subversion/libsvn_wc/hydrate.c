@@ -0,0 +1,195 @@
+/*
+ * hydrate.c:  fetching the text of files added without it
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* In a working copy with the lazy-fetch option set, the update editor
+ * records added files in BASE without a checksum and doesn't create their
+ * working files.  The code here fetches the text of such files, installs
+ * it in the pristine store and creates the working files, after which the
+ * files are no different from files that were fetched during the update.
+ */
+
+#include "svn_wc.h"
+#include "svn_pools.h"
+#include "svn_io.h"
+#include "svn_dirent_uri.h"
+
+#include "wc.h"
+#include "wc_db.h"
+#include "workqueue.h"
+
+#include "private/svn_wc_private.h"
+#include "svn_private_config.h"
+
+
+/* Fetch the text of the file LOCAL_ABSPATH in DB, which was recorded
+   without its text, using FETCH_TEXT_FUNC with FETCH_TEXT_BATON.  Record
+   the text and queue installing the working file if the file is present
+   in the working copy but not on disk.  */
+static svn_error_t *
+hydrate_file(svn_wc__db_t *db,
+             const char *local_abspath,
+             svn_boolean_t use_commit_times,
+             svn_wc__fetch_text_func_t fetch_text_func,
+             void *fetch_text_baton,
+             apr_pool_t *scratch_pool)
+{
+  svn_wc__db_status_t status;
+  svn_revnum_t revision;
+  const char *repos_relpath;
+  const char *repos_root_url;
+  svn_stream_t *stream;
+  svn_wc__db_install_data_t *install_data;
+  svn_checksum_t *sha1_checksum;
+  svn_checksum_t *md5_checksum;
+  svn_skel_t *work_item = NULL;
+  svn_node_kind_t on_disk;
+  svn_error_t *err;
+
+  SVN_ERR(svn_wc__write_check(db, svn_dirent_dirname(local_abspath,
+                                                     scratch_pool),
+                              scratch_pool));
+
+  SVN_ERR(svn_wc__db_base_get_info(NULL, NULL, &revision, &repos_relpath,
+                                   &repos_root_url, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   db, local_abspath,
+                                   scratch_pool, scratch_pool));
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&stream, &install_data,
+                                              &sha1_checksum, &md5_checksum,
+                                              db, local_abspath,
+                                              scratch_pool, scratch_pool));
+
+  err = fetch_text_func(fetch_text_baton, stream, repos_root_url,
+                        repos_relpath, revision, scratch_pool);
+  err = svn_error_compose_create(err, svn_stream_close(stream));
+  if (err)
+    return svn_error_trace(
+                svn_error_compose_create(
+                        err,
+                        svn_wc__db_pristine_install_abort(install_data,
+                                                          scratch_pool)));
+
+  SVN_ERR(svn_wc__db_pristine_install(install_data, sha1_checksum,
+                                      md5_checksum, scratch_pool));
+
+  /* Files that are deleted or replaced locally don't get a working file */
+  SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL,
+                               db, local_abspath,
+                               scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_check_path(local_abspath, &on_disk, scratch_pool));
+
+  if (status == svn_wc__db_status_normal && on_disk == svn_node_none)
+    SVN_ERR(svn_wc__wq_build_file_install(&work_item, db, local_abspath,
+                                          NULL, use_commit_times, TRUE,
+                                          scratch_pool, scratch_pool));
+
+  SVN_ERR(svn_wc__db_base_set_fetched(db, local_abspath, sha1_checksum,
+                                      work_item, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__unfetched_error(const char *local_abspath,
+                        apr_pool_t *scratch_pool)
+{
+  return svn_error_createf(SVN_ERR_WC_PATH_UNEXPECTED_STATUS, NULL,
+                           _("The text of '%s' was not fetched; "
+                             "run 'svn hydrate' first"),
+                           svn_dirent_local_style(local_abspath,
+                                                  scratch_pool));
+}
+
+svn_error_t *
+svn_wc__get_unfetched(apr_array_header_t **local_abspaths,
+                      svn_wc_context_t *wc_ctx,
+                      const char *local_abspath,
+                      svn_depth_t depth,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  return svn_error_trace(svn_wc__db_base_get_unfetched(local_abspaths,
+                                                       wc_ctx->db,
+                                                       local_abspath, depth,
+                                                       result_pool,
+                                                       scratch_pool));
+}
+
+svn_error_t *
+svn_wc__hydrate(svn_wc_context_t *wc_ctx,
+                const char *local_abspath,
+                svn_depth_t depth,
+                svn_boolean_t use_commit_times,
+                svn_wc__fetch_text_func_t fetch_text_func,
+                void *fetch_text_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                svn_wc_notify_func2_t notify_func,
+                void *notify_baton,
+                apr_pool_t *scratch_pool)
+{
+  svn_wc__db_t *db = wc_ctx->db;
+  apr_array_header_t *unfetched;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  SVN_ERR(svn_wc__db_base_get_unfetched(&unfetched, db, local_abspath, depth,
+                                        scratch_pool, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < unfetched->nelts; i++)
+    {
+      const char *file_abspath = APR_ARRAY_IDX(unfetched, i, const char *);
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(hydrate_file(db, file_abspath, use_commit_times,
+                           fetch_text_func, fetch_text_baton, iterpool));
+
+      /* Create the working file right away, so an interrupted run leaves
+         usable files behind */
+      SVN_ERR(svn_wc__wq_run(db, file_abspath, cancel_func, cancel_baton,
+                             iterpool));
+
+      if (notify_func)
+        notify_func(notify_baton,
+                    svn_wc_create_notify(file_abspath,
+                                         svn_wc_notify_text_fetched,
+                                         iterpool),
+                    iterpool);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
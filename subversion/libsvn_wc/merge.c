@@ -535,8 +535,11 @@ preserve_pre_merge_files(svn_skel_t **work_items,
   /* The workingqueue requires its paths to be in the subtree
      relative to the wcroot path they are executed in.
 
-     Make our LEFT and RIGHT files 'local' if they aren't... */
-  if (! svn_dirent_is_ancestor(wcroot_abspath, left_abspath))
+     Make our LEFT and RIGHT files 'local' if they aren't, and copy
+     temporary files that may be gone before the work queue runs, like
+     reassembled chunked pristine texts... */
+  if (! svn_dirent_is_ancestor(wcroot_abspath, left_abspath)
+      || svn_dirent_is_ancestor(temp_dir_abspath, left_abspath))
     {
       SVN_ERR(svn_io_open_unique_file3(NULL, &tmp_left, temp_dir_abspath,
                                        svn_io_file_del_none,
@@ -553,7 +556,8 @@ preserve_pre_merge_files(svn_skel_t **work_items,
   else
     tmp_left = left_abspath;
 
-  if (! svn_dirent_is_ancestor(wcroot_abspath, right_abspath))
+  if (! svn_dirent_is_ancestor(wcroot_abspath, right_abspath)
+      || svn_dirent_is_ancestor(temp_dir_abspath, right_abspath))
     {
       SVN_ERR(svn_io_open_unique_file3(NULL, &tmp_right, temp_dir_abspath,
                                        svn_io_file_del_none,
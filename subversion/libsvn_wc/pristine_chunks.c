@@ -0,0 +1,439 @@
+/*
+ * pristine_chunks.c :  content-defined chunking of pristine texts
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_sha1.h>
+
+#include "svn_pools.h"
+#include "svn_io.h"
+#include "svn_dirent_uri.h"
+#include "svn_checksum.h"
+#include "svn_string.h"
+#include "svn_hash.h"
+#include "svn_sorts.h"
+
+#include "pristine_chunks.h"
+
+#include "svn_private_config.h"
+
+/* The first line of every manifest. */
+#define MANIFEST_HEADER "SVN-pristine-chunks 1"
+
+/* Chunks are never smaller than this, except for the last one of a text,
+   and never larger than CHUNK_MAX_SIZE. */
+#define CHUNK_MIN_SIZE (16 * 1024)
+#define CHUNK_MAX_SIZE (256 * 1024)
+
+/* A chunk ends where the rolling hash has none of these bits set.  With
+   16 bits, chunks are CHUNK_MIN_SIZE + 64k bytes long on average. */
+#define CHUNK_BOUNDARY_MASK APR_UINT64_C(0xffff000000000000)
+
+/* One entry of a manifest. */
+typedef struct chunk_t
+{
+  /* The SHA-1 of the chunk's contents, as a hex string. */
+  const char *name;
+
+  /* The length of the chunk in bytes. */
+  apr_size_t size;
+} chunk_t;
+
+/* Fill GEAR with the random values that the rolling hash adds for each
+   byte.  Chunk boundaries, and thus chunk names, depend on them, so they
+   must never change for a given manifest format. */
+static void
+init_gear(apr_uint64_t gear[256])
+{
+  apr_uint64_t state = APR_UINT64_C(0x5356a4e3c7b1d209);
+  int i;
+
+  /* splitmix64 */
+  for (i = 0; i < 256; ++i)
+    {
+      apr_uint64_t z = (state += APR_UINT64_C(0x9e3779b97f4a7c15));
+      z = (z ^ (z >> 30)) * APR_UINT64_C(0xbf58476d1ce4e5b9);
+      z = (z ^ (z >> 27)) * APR_UINT64_C(0x94d049bb133111eb);
+      gear[i] = z ^ (z >> 31);
+    }
+}
+
+/* Return the length of the chunk at the start of the LEN bytes in DATA.
+   LEN is less than CHUNK_MAX_SIZE only at the end of the text. */
+static apr_size_t
+find_chunk_end(const unsigned char *data,
+               apr_size_t len,
+               const apr_uint64_t gear[256])
+{
+  apr_uint64_t hash = 0;
+  apr_size_t i;
+
+  if (len <= CHUNK_MIN_SIZE)
+    return len;
+
+  /* The hash only depends on the last 64 bytes, so skip ahead. */
+  for (i = CHUNK_MIN_SIZE - 64; i < len; ++i)
+    {
+      hash = (hash << 1) + gear[data[i]];
+      if (i >= CHUNK_MIN_SIZE && (hash & CHUNK_BOUNDARY_MASK) == 0)
+        return i + 1;
+    }
+
+  return len;
+}
+
+/* Return the path of the chunk NAME in CHUNKS_DIR_ABSPATH, allocated in
+   RESULT_POOL.  Like pristine texts, chunks are spread over
+   sub-directories named by the first two characters of their names. */
+static const char *
+get_chunk_path(const char *chunks_dir_abspath,
+               const char *name,
+               apr_pool_t *result_pool)
+{
+  return svn_dirent_join_many(result_pool, chunks_dir_abspath,
+                              apr_pstrmemdup(result_pool, name, 2),
+                              name, SVN_VA_NULL);
+}
+
+/* Add the LEN bytes in DATA as a chunk to CHUNKS_DIR_ABSPATH unless it is
+   there already, and append its manifest line to MANIFEST. */
+static svn_error_t *
+store_chunk(svn_stringbuf_t *manifest,
+            const char *chunks_dir_abspath,
+            const unsigned char *data,
+            apr_size_t len,
+            apr_pool_t *scratch_pool)
+{
+  svn_checksum_t *checksum;
+  const char *name;
+  const char *chunk_abspath;
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, data, len,
+                       scratch_pool));
+  name = svn_checksum_to_cstring_display(checksum, scratch_pool);
+  chunk_abspath = get_chunk_path(chunks_dir_abspath, name, scratch_pool);
+
+  SVN_ERR(svn_io_check_path(chunk_abspath, &kind, scratch_pool));
+  if (kind == svn_node_none)
+    {
+      SVN_ERR(svn_io_make_dir_recursively(
+                svn_dirent_dirname(chunk_abspath, scratch_pool),
+                scratch_pool));
+      SVN_ERR(svn_io_write_atomic2(chunk_abspath, data, len, NULL, FALSE,
+                                   scratch_pool));
+      SVN_ERR(svn_io_set_file_read_only(chunk_abspath, FALSE, scratch_pool));
+    }
+
+  svn_stringbuf_appendcstr(manifest, name);
+  svn_stringbuf_appendcstr(manifest,
+                           apr_psprintf(scratch_pool, " %" APR_SIZE_T_FMT
+                                        "\n", len));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__pristine_chunks_store(const char *manifest_abspath,
+                              const char *chunks_dir_abspath,
+                              const char *source_abspath,
+                              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_stringbuf_t *manifest = svn_stringbuf_create(MANIFEST_HEADER "\n",
+                                                   scratch_pool);
+  unsigned char *buffer = apr_palloc(scratch_pool, CHUNK_MAX_SIZE);
+  apr_uint64_t gear[256];
+  svn_stream_t *source;
+  apr_size_t len = 0;
+
+  init_gear(gear);
+  SVN_ERR(svn_stream_open_readonly(&source, source_abspath,
+                                   scratch_pool, scratch_pool));
+
+  while (TRUE)
+    {
+      apr_size_t read_len = CHUNK_MAX_SIZE - len;
+      apr_size_t chunk_len;
+
+      svn_pool_clear(iterpool);
+
+      /* Keep the buffer filled, so a short buffer means the end. */
+      SVN_ERR(svn_stream_read_full(source, (char *)buffer + len, &read_len));
+      len += read_len;
+      if (len == 0)
+        break;
+
+      chunk_len = find_chunk_end(buffer, len, gear);
+      SVN_ERR(store_chunk(manifest, chunks_dir_abspath, buffer, chunk_len,
+                          iterpool));
+
+      len -= chunk_len;
+      memmove(buffer, buffer + chunk_len, len);
+    }
+
+  svn_pool_destroy(iterpool);
+  SVN_ERR(svn_stream_close(source));
+
+  SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(manifest_abspath,
+                                                         scratch_pool),
+                                      scratch_pool));
+  SVN_ERR(svn_io_write_atomic2(manifest_abspath, manifest->data,
+                               manifest->len, NULL, FALSE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CHUNKS to the chunk_t * entries of the manifest MANIFEST_ABSPATH,
+   allocated in RESULT_POOL. */
+static svn_error_t *
+read_manifest(apr_array_header_t **chunks,
+              const char *manifest_abspath,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  int i;
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, manifest_abspath,
+                                   scratch_pool));
+  lines = svn_cstring_split(contents->data, "\n", FALSE, scratch_pool);
+
+  if (lines->nelts == 0
+      || strcmp(APR_ARRAY_IDX(lines, 0, const char *), MANIFEST_HEADER))
+    return svn_error_createf(SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
+                             _("'%s' is not a pristine chunk manifest"),
+                             svn_dirent_local_style(manifest_abspath,
+                                                    scratch_pool));
+
+  *chunks = apr_array_make(result_pool, lines->nelts - 1,
+                           sizeof(chunk_t *));
+  for (i = 1; i < lines->nelts; ++i)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      const char *space = strchr(line, ' ');
+      chunk_t *chunk = apr_palloc(result_pool, sizeof(*chunk));
+      apr_uint64_t size;
+
+      svn_error_t *err;
+
+      if (space && space - line == 2 * APR_SHA1_DIGESTSIZE)
+        err = svn_cstring_strtoui64(&size, space + 1, 1, CHUNK_MAX_SIZE, 10);
+      else
+        err = svn_error_create(SVN_ERR_BAD_CHECKSUM_PARSE, NULL, NULL);
+
+      if (err)
+        return svn_error_createf(SVN_ERR_WC_CORRUPT_TEXT_BASE, err,
+                                 _("Invalid line %d in pristine chunk "
+                                   "manifest '%s'"), i + 1,
+                                 svn_dirent_local_style(manifest_abspath,
+                                                        scratch_pool));
+
+      chunk->name = apr_pstrmemdup(result_pool, line, space - line);
+      chunk->size = (apr_size_t)size;
+      APR_ARRAY_PUSH(*chunks, chunk_t *) = chunk;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for the stream returned by svn_wc__pristine_chunks_open(). */
+typedef struct chunks_baton_t
+{
+  const char *chunks_dir_abspath;
+  apr_array_header_t *chunks;
+
+  /* The index of the chunk being read and its contents, if opened, with
+     the number of bytes still to read from it. */
+  int current;
+  svn_stream_t *chunk_stream;
+  apr_size_t remaining;
+
+  /* Holds CHUNK_STREAM. */
+  apr_pool_t *chunk_pool;
+} chunks_baton_t;
+
+/* Implements svn_read_fn_t, reading the chunks one after the other.
+   Always fills the buffer unless at the end of the text. */
+static svn_error_t *
+read_handler_chunks(void *baton,
+                    char *buffer,
+                    apr_size_t *len)
+{
+  chunks_baton_t *b = baton;
+  apr_size_t total = 0;
+
+  while (total < *len)
+    {
+      apr_size_t read_len;
+      const chunk_t *chunk;
+
+      if (!b->chunk_stream)
+        {
+          if (b->current >= b->chunks->nelts)
+            break;
+
+          chunk = APR_ARRAY_IDX(b->chunks, b->current, const chunk_t *);
+          svn_pool_clear(b->chunk_pool);
+          SVN_ERR(svn_stream_open_readonly(&b->chunk_stream,
+                                           get_chunk_path(
+                                             b->chunks_dir_abspath,
+                                             chunk->name, b->chunk_pool),
+                                           b->chunk_pool, b->chunk_pool));
+          b->remaining = chunk->size;
+        }
+
+      chunk = APR_ARRAY_IDX(b->chunks, b->current, const chunk_t *);
+      read_len = MIN(*len - total, b->remaining);
+      SVN_ERR(svn_stream_read_full(b->chunk_stream, buffer + total,
+                                   &read_len));
+
+      total += read_len;
+      b->remaining -= read_len;
+
+      if (b->remaining == 0 || read_len == 0)
+        {
+          if (b->remaining)
+            return svn_error_createf(SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
+                                     _("Pristine chunk '%s' is truncated"),
+                                     chunk->name);
+
+          SVN_ERR(svn_stream_close(b->chunk_stream));
+          b->chunk_stream = NULL;
+          b->current++;
+        }
+    }
+
+  *len = total;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t. */
+static svn_error_t *
+close_handler_chunks(void *baton)
+{
+  chunks_baton_t *b = baton;
+
+  if (b->chunk_stream)
+    SVN_ERR(svn_stream_close(b->chunk_stream));
+
+  svn_pool_destroy(b->chunk_pool);
+  b->chunk_stream = NULL;
+  b->current = b->chunks->nelts;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__pristine_chunks_open(svn_stream_t **contents,
+                             const char *manifest_abspath,
+                             const char *chunks_dir_abspath,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  chunks_baton_t *baton = apr_pcalloc(result_pool, sizeof(*baton));
+
+  SVN_ERR(read_manifest(&baton->chunks, manifest_abspath,
+                        result_pool, scratch_pool));
+  baton->chunks_dir_abspath = apr_pstrdup(result_pool, chunks_dir_abspath);
+  baton->chunk_pool = svn_pool_create(result_pool);
+
+  *contents = svn_stream_create(baton, result_pool);
+  svn_stream_set_read2(*contents, read_handler_chunks, read_handler_chunks);
+  svn_stream_set_close(*contents, close_handler_chunks);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__pristine_chunks_collect(apr_hash_t *referenced,
+                                const char *manifest_abspath,
+                                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *hash_pool = apr_hash_pool_get(referenced);
+  apr_array_header_t *chunks;
+  int i;
+
+  SVN_ERR(read_manifest(&chunks, manifest_abspath,
+                        scratch_pool, scratch_pool));
+
+  for (i = 0; i < chunks->nelts; ++i)
+    {
+      const chunk_t *chunk = APR_ARRAY_IDX(chunks, i, const chunk_t *);
+
+      if (!svn_hash_gets(referenced, chunk->name))
+        svn_hash_sets(referenced, apr_pstrdup(hash_pool, chunk->name), "");
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__pristine_chunks_sweep(const char *chunks_dir_abspath,
+                              apr_hash_t *referenced,
+                              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_t *subdirs;
+  apr_hash_index_t *hi;
+  svn_error_t *err;
+
+  err = svn_io_get_dirents3(&subdirs, chunks_dir_abspath, TRUE,
+                            scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  for (hi = apr_hash_first(scratch_pool, subdirs); hi; hi = apr_hash_next(hi))
+    {
+      const char *subdir_abspath;
+      apr_hash_t *names;
+      apr_hash_index_t *hi2;
+
+      svn_pool_clear(iterpool);
+
+      subdir_abspath = svn_dirent_join(chunks_dir_abspath,
+                                       apr_hash_this_key(hi), iterpool);
+      SVN_ERR(svn_io_get_dirents3(&names, subdir_abspath, TRUE,
+                                  iterpool, iterpool));
+
+      for (hi2 = apr_hash_first(iterpool, names); hi2;
+           hi2 = apr_hash_next(hi2))
+        {
+          const char *name = apr_hash_this_key(hi2);
+
+          if (!svn_hash_gets(referenced, name))
+            SVN_ERR(svn_io_remove_file2(svn_dirent_join(subdir_abspath,
+                                                        name, iterpool),
+                                        TRUE, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
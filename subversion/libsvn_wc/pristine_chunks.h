@@ -0,0 +1,95 @@
+/*
+ * pristine_chunks.h :  content-defined chunking of pristine texts
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* A chunked pristine text is stored as a manifest file listing the
+ * chunks that make up the text, in order.  The chunks themselves are
+ * files named by the SHA-1 of their contents in a chunk directory shared
+ * by all pristine texts of a working copy, so texts that differ only in
+ * a few places share most of their chunks.
+ *
+ * Chunk boundaries are found with a rolling hash over the contents, such
+ * that an insertion or deletion only changes the chunks around it.
+ *
+ * The manifest is a header line followed by one "<sha1-hex> <size>" line
+ * per chunk.  Nothing here accesses the working copy database, so all
+ * functions may be called from any thread.
+ */
+
+#ifndef SVN_LIBSVN_WC_PRISTINE_CHUNKS_H
+#define SVN_LIBSVN_WC_PRISTINE_CHUNKS_H
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+
+#include "svn_types.h"
+#include "svn_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/* Pristine texts smaller than this are never chunked. */
+#define SVN_WC__PRISTINE_CHUNKS_MIN_TEXT_SIZE (1024 * 1024)
+
+/* Split the file SOURCE_ABSPATH into chunks, add those not yet present
+   to CHUNKS_DIR_ABSPATH and write the manifest to MANIFEST_ABSPATH,
+   replacing any existing file.  Create missing directories.  */
+svn_error_t *
+svn_wc__pristine_chunks_store(const char *manifest_abspath,
+                              const char *chunks_dir_abspath,
+                              const char *source_abspath,
+                              apr_pool_t *scratch_pool);
+
+/* Set *CONTENTS to a readable stream returning the text described by the
+   manifest MANIFEST_ABSPATH, assembled from the chunks in
+   CHUNKS_DIR_ABSPATH.  The manifest is read right away; an error with
+   an ENOENT status is returned if it does not exist.  Allocate the stream
+   in RESULT_POOL.  */
+svn_error_t *
+svn_wc__pristine_chunks_open(svn_stream_t **contents,
+                             const char *manifest_abspath,
+                             const char *chunks_dir_abspath,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
+/* Add the names of all chunks referenced by the manifest MANIFEST_ABSPATH
+   to the set REFERENCED, allocated in its pool.  */
+svn_error_t *
+svn_wc__pristine_chunks_collect(apr_hash_t *referenced,
+                                const char *manifest_abspath,
+                                apr_pool_t *scratch_pool);
+
+/* Remove all chunks from CHUNKS_DIR_ABSPATH whose names are not in the
+   set REFERENCED, as filled by svn_wc__pristine_chunks_collect().  Do
+   nothing if the directory does not exist.  */
+svn_error_t *
+svn_wc__pristine_chunks_sweep(const char *chunks_dir_abspath,
+                              apr_hash_t *referenced,
+                              apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_WC_PRISTINE_CHUNKS_H */
@@ -95,6 +95,11 @@
  * PROPS_MOD should be TRUE if the file's properties have been changed,
  * otherwise FALSE.
  *
+ * If PRISTINE_CHECKSUM is not NULL, PRISTINE_STREAM is NULL and
+ * EXACT_COMPARISON is FALSE: compare the SHA-1 checksum of the translated
+ * VERSIONED_FILE_ABSPATH with PRISTINE_CHECKSUM instead, without reading
+ * the pristine text.
+ *
  * PRISTINE_STREAM will be closed before a successful return.
  *
  * DB is a wc_db; use SCRATCH_POOL for temporary allocation.
@@ -106,6 +111,7 @@ compare_and_verify(svn_boolean_t *modified_p,
                    svn_filesize_t versioned_file_size,
                    svn_stream_t *pristine_stream,
                    svn_filesize_t pristine_size,
+                   const svn_checksum_t *pristine_checksum,
                    svn_boolean_t has_props,
                    svn_boolean_t props_mod,
                    svn_boolean_t exact_comparison,
@@ -146,7 +152,10 @@ compare_and_verify(svn_boolean_t *modified_p,
       *modified_p = TRUE;
 
       /* ### Why did we open the pristine? */
-      return svn_error_trace(svn_stream_close(pristine_stream));
+      if (pristine_stream)
+        return svn_error_trace(svn_stream_close(pristine_stream));
+
+      return SVN_NO_ERROR;
     }
 
   /* ### Other checks possible? */
@@ -198,8 +207,20 @@ compare_and_verify(svn_boolean_t *modified_p,
         }
     }
 
-  SVN_ERR(svn_stream_contents_same2(&same, pristine_stream, v_stream,
-                                    scratch_pool));
+  if (pristine_checksum)
+    {
+      svn_checksum_t *v_checksum;
+
+      SVN_ERR_ASSERT(!exact_comparison);
+
+      SVN_ERR(svn_stream_contents_checksum(&v_checksum, v_stream,
+                                           pristine_checksum->kind,
+                                           scratch_pool, scratch_pool));
+      same = svn_checksum_match(v_checksum, pristine_checksum);
+    }
+  else
+    SVN_ERR(svn_stream_contents_same2(&same, pristine_stream, v_stream,
+                                      scratch_pool));
 
   *modified_p = (! same);
 
@@ -218,6 +239,7 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
   svn_wc__db_status_t status;
   svn_node_kind_t kind;
   const svn_checksum_t *checksum;
+  const svn_checksum_t *pristine_checksum;
   svn_filesize_t recorded_size;
   apr_time_t recorded_mod_time;
   svn_boolean_t has_props;
@@ -234,6 +256,18 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
                                db, local_abspath,
                                scratch_pool, scratch_pool));
 
+  /* A file whose text was not fetched is only modified if someone put a
+     working file in its place */
+  if (!checksum && kind == svn_node_file
+      && status == svn_wc__db_status_normal)
+    {
+      svn_node_kind_t on_disk;
+
+      SVN_ERR(svn_io_check_path(local_abspath, &on_disk, scratch_pool));
+      *modified_p = (on_disk != svn_node_none);
+      return SVN_NO_ERROR;
+    }
+
   /* If we don't have a pristine or the node has a status that allows a
      pristine, just say that the node is modified */
   if (!checksum
@@ -302,9 +336,24 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
     }
 
  compare_them:
-  SVN_ERR(svn_wc__db_pristine_read(&pristine_stream, &pristine_size,
-                                   db, local_abspath, checksum,
-                                   scratch_pool, scratch_pool));
+  if (!exact_comparison && svn_wc__db_pristine_get_compare_by_checksum(db))
+    {
+      /* The checksum recorded for the pristine text is the checksum of
+         the working file in normal form if it is unmodified, so only
+         the working file needs to be read. */
+      SVN_ERR(svn_wc__db_pristine_read(NULL, &pristine_size,
+                                       db, local_abspath, checksum,
+                                       scratch_pool, scratch_pool));
+      pristine_stream = NULL;
+      pristine_checksum = checksum;
+    }
+  else
+    {
+      SVN_ERR(svn_wc__db_pristine_read(&pristine_stream, &pristine_size,
+                                       db, local_abspath, checksum,
+                                       scratch_pool, scratch_pool));
+      pristine_checksum = NULL;
+    }
 
   /* Check all bytes, and verify checksum if requested. */
   {
@@ -312,6 +361,7 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
     err = compare_and_verify(modified_p, db,
                              local_abspath, dirent->filesize,
                              pristine_stream, pristine_size,
+                             pristine_checksum,
                              has_props, props_mod,
                              exact_comparison,
                              scratch_pool);
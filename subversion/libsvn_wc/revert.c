@@ -382,6 +382,11 @@ revert_restore(svn_boolean_t *run_wq,
         }
     }
 
+  /* A file whose text was not fetched has no working file to restore */
+  if (info && info->status == svn_wc__db_status_normal
+      && info->kind == svn_node_file && !info->has_checksum)
+    metadata_only = TRUE;
+
   if (!metadata_only)
     {
       SVN_ERR(revert_wc_data(run_wq,
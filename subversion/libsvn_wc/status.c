@@ -29,6 +29,8 @@
 #include <apr_pools.h>
 #include <apr_file_io.h>
 #include <apr_hash.h>
+#include <apr_time.h>
+#include <apr_thread_proc.h>
 
 #include "svn_pools.h"
 #include "svn_types.h"
@@ -46,11 +48,18 @@
 
 #include "wc.h"
 #include "props.h"
+#include "adm_files.h"
 
 #include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_editor.h"
+#include "private/svn_mutex.h"
+#include "private/svn_thread_cond.h"
+
+/* ### Same value as wc_db.c */
+#define SDB_FILE  "wc.db"
 
 
 /* The file internal variant of svn_wc_status3_t, with slightly more
@@ -75,6 +84,12 @@ typedef struct svn_wc__internal_status_t
 } svn_wc__internal_status_t;
 
 
+/* Reads directories ahead of the status walk in worker threads. */
+typedef struct dirents_prefetch_t dirents_prefetch_t;
+
+/* Tells the status walk which directories have not changed on disk. */
+typedef struct status_cache_t status_cache_t;
+
 /*** Baton used for walking the local status */
 struct walk_status_baton
 {
@@ -100,6 +115,15 @@ struct walk_status_baton
 
   /* Repository locks, if set. */
   apr_hash_t *repos_locks;
+
+  /*** Threading ***/
+  /* Reads directories ahead of the walk, if not NULL. */
+  dirents_prefetch_t *prefetch;
+
+  /*** File system watcher ***/
+  /* The status cache, if a watcher journals changes to this working
+     copy.  NULL otherwise. */
+  status_cache_t *status_cache;
 };
 
 /*** Editor batons ***/
@@ -413,9 +437,13 @@ assemble_status(svn_wc__internal_status_t **status,
       if (!dirent || dirent->kind != expected_kind)
         {
           /* A present or added node should be on disk, so it is
-             reported missing or obstructed.  */
+             reported missing or obstructed.  Files whose text was not
+             fetched have no working file. */
           if (!dirent || dirent->kind == svn_node_none)
-            node_status = svn_wc_status_missing;
+            {
+              if (info->kind != svn_node_file || info->has_checksum)
+                node_status = svn_wc_status_missing;
+            }
           else
             node_status = svn_wc_status_obstructed;
         }
@@ -460,7 +488,13 @@ assemble_status(svn_wc__internal_status_t **status,
              expensive on network drives as a filestat usually can't
              be cached there */
           if (!info->has_checksum)
-            text_modified_p = TRUE; /* Local addition -> Modified */
+            {
+              /* Local addition -> Modified, as is a working file of a
+                 file whose text was not fetched */
+              text_modified_p = (info->status != svn_wc__db_status_normal
+                                 || (dirent
+                                     && dirent->kind != svn_node_none));
+            }
           else if (ignore_text_mods
                   ||(dirent
                      && info->recorded_size != SVN_INVALID_FILESIZE
@@ -785,6 +819,456 @@ assemble_unversioned(svn_wc__internal_status_t **status,
 }
 
 
+/*** Skipping directories a file system watcher saw no changes in ***/
+
+/* Name of the status cache in the administrative area of the wcroot. */
+#define STATUS_CACHE "status-cache"
+
+/* Start of the first line of the status cache, including the format. */
+#define STATUS_CACHE_HEADER "SVN-status-cache 1"
+
+/* Milliseconds to wait for the watcher to journal our cookie file. */
+#define COOKIE_TIMEOUT 2000
+
+/* Microseconds between looking for the cookie entry in the journal. */
+#define COOKIE_POLL_INTERVAL 5000
+
+/* The status cache connects the journal of a file system watcher (see
+   SVN_WC__WATCH_JOURNAL) with the result of the previous status walk.
+
+   It is a text file.  The first line holds STATUS_CACHE_HEADER followed
+   by the watcher's session, the journal offset and the size and mtime of
+   wc.db, all as of the start of the walk that wrote it.  Each further
+   line is the wcroot-relative path of a directory whose on-disk state
+   differed from wc.db in that walk.
+
+   A directory neither listed there nor in the journal entries written
+   since that walk still looks exactly as it looked then.  So the next
+   walk can take its children from wc.db without reading it. */
+struct status_cache_t
+{
+  /* The working copy root. */
+  const char *wcroot_abspath;
+
+  /* The current watcher session and the length of its journal up to the
+     last complete entry. */
+  const char *session;
+  apr_off_t journal_size;
+
+  /* wc.db as of the start of the walk. */
+  apr_off_t db_size;
+  apr_time_t db_mtime;
+
+  /* Directories (const char * relpaths) that may have changed on disk
+     since the last walk.  NULL if that is unknown, in which case every
+     directory has to be read. */
+  apr_hash_t *changed;
+
+  /* Directories (const char * relpaths) whose on-disk state differed
+     from wc.db in this walk. */
+  apr_hash_t *dirty;
+
+  /* Set if DIRTY cannot be written to the status cache. */
+  svn_boolean_t unsaveable;
+};
+
+/* Add the relpaths in the newline terminated lines of DATA to the hash
+   CHANGED, allocated in RESULT_POOL.  Ignore an incomplete last line.
+   Return FALSE if DATA contains SVN_WC__WATCH_JOURNAL_OVERFLOW. */
+static svn_boolean_t
+add_changed_dirs(apr_hash_t *changed,
+                 const svn_stringbuf_t *data,
+                 apr_pool_t *result_pool)
+{
+  const char *line = data->data;
+  const char *end = data->data + data->len;
+  const char *eol;
+
+  while ((eol = memchr(line, '\n', end - line)))
+    {
+      const char *relpath = apr_pstrmemdup(result_pool, line, eol - line);
+
+      if (!strcmp(relpath, SVN_WC__WATCH_JOURNAL_OVERFLOW))
+        return FALSE;
+
+      if (strncmp(relpath, SVN_WC__WATCH_JOURNAL_COOKIE,
+                  sizeof(SVN_WC__WATCH_JOURNAL_COOKIE) - 1))
+        svn_hash_sets(changed, relpath, "");
+      line = eol + 1;
+    }
+
+  return TRUE;
+}
+
+/* Return TRUE if HEADER is the first line of a status cache written
+   during the same watcher session as CACHE and while wc.db looked as it
+   does now.  Set *OFFSET to the journal offset recorded there. */
+static svn_boolean_t
+status_cache_matches(apr_off_t *offset,
+                     const status_cache_t *cache,
+                     const char *header,
+                     apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *words;
+  apr_int64_t values[3];
+  int i;
+
+  if (strncmp(header, STATUS_CACHE_HEADER " ", sizeof(STATUS_CACHE_HEADER)))
+    return FALSE;
+
+  words = svn_cstring_split(header + sizeof(STATUS_CACHE_HEADER), " ",
+                            FALSE, scratch_pool);
+  if (words->nelts != 4
+      || strcmp(APR_ARRAY_IDX(words, 0, const char *), cache->session))
+    return FALSE;
+
+  for (i = 0; i < 3; i++)
+    {
+      svn_error_t *err = svn_cstring_atoi64(&values[i],
+                                            APR_ARRAY_IDX(words, i + 1,
+                                                          const char *));
+      if (err)
+        {
+          svn_error_clear(err);
+          return FALSE;
+        }
+    }
+
+  *offset = (apr_off_t)values[0];
+
+  return values[1] == cache->db_size && values[2] == cache->db_mtime;
+}
+
+/* Set *ENTRIES to the contents of JOURNAL from its current position on,
+   allocated in RESULT_POOL.  Before that, create a cookie file in the
+   administrative area of WCROOT_ABSPATH and wait until the watcher has
+   journaled it, i.e. all changes that happened before this call.  Set
+   *SYNCED to FALSE if that did not happen in time.  Use SCRATCH_POOL for
+   temporaries, including the cookie file. */
+static svn_error_t *
+read_journal_synced(svn_boolean_t *synced,
+                    svn_stringbuf_t **entries,
+                    apr_file_t *journal,
+                    const char *wcroot_abspath,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  apr_time_t deadline = apr_time_now()
+                        + apr_time_from_msec(COOKIE_TIMEOUT);
+  char *buffer = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  const char *cookie_abspath;
+  const char *cookie_entry = NULL;
+  apr_file_t *cookie;
+  svn_error_t *err;
+
+  /* Without a cookie, e.g. in a read-only working copy, we can't tell
+     whether the watcher is up to date. */
+  err = svn_io_open_uniquely_named(&cookie, &cookie_abspath,
+                                   svn_wc__adm_child(wcroot_abspath, NULL,
+                                                     scratch_pool),
+                                   SVN_WC__WATCH_COOKIE_PREFIX, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   scratch_pool, scratch_pool);
+  if (!err)
+    {
+      SVN_ERR(svn_io_file_close(cookie, scratch_pool));
+      cookie_entry = apr_pstrcat(scratch_pool,
+                                 "\n" SVN_WC__WATCH_JOURNAL_COOKIE,
+                                 svn_dirent_basename(cookie_abspath, NULL),
+                                 "\n", SVN_VA_NULL);
+    }
+  svn_error_clear(err);
+
+  *synced = FALSE;
+  *entries = svn_stringbuf_create_empty(result_pool);
+
+  while (TRUE)
+    {
+      svn_boolean_t eof = FALSE;
+
+      while (!eof)
+        {
+          apr_size_t len;
+
+          SVN_ERR(svn_io_file_read_full2(journal, buffer,
+                                         SVN__STREAM_CHUNK_SIZE, &len, &eof,
+                                         scratch_pool));
+          svn_stringbuf_appendbytes(*entries, buffer, len);
+        }
+
+      /* ENTRIES start at the beginning of a line. */
+      if (cookie_entry
+          && (!strncmp((*entries)->data, cookie_entry + 1,
+                       strlen(cookie_entry + 1))
+              || strstr((*entries)->data, cookie_entry)))
+        {
+          *synced = TRUE;
+          break;
+        }
+
+      if (!cookie_entry || apr_time_now() >= deadline)
+        break;
+
+      apr_sleep(COOKIE_POLL_INTERVAL);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CACHE to the status cache of the working copy containing
+   LOCAL_ABSPATH in DB.  Set it to NULL if no file system watcher is
+   currently journaling changes for this working copy.  Allocate the
+   result in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+open_status_cache(status_cache_t **cache,
+                  svn_wc__db_t *db,
+                  const char *local_abspath,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  status_cache_t *result;
+  const char *wcroot_abspath;
+  apr_file_t *journal;
+  svn_stringbuf_t *header;
+  svn_stringbuf_t *cache_data;
+  svn_stringbuf_t *entries;
+  apr_finfo_t finfo;
+  apr_off_t offset;
+  svn_boolean_t eof;
+  svn_boolean_t synced = FALSE;
+  apr_size_t len;
+  svn_error_t *err;
+
+  *cache = NULL;
+
+  SVN_ERR(svn_wc__db_get_wcroot(&wcroot_abspath, db, local_abspath,
+                                result_pool, scratch_pool));
+
+  err = svn_io_file_open(&journal,
+                         svn_wc__adm_child(wcroot_abspath,
+                                           SVN_WC__WATCH_JOURNAL,
+                                           scratch_pool),
+                         APR_READ, APR_OS_DEFAULT, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* The watcher holds an exclusive lock on its journal as long as it
+     runs.  If we can lock it, nobody journals the changes any more. */
+  err = svn_io_lock_open_file(journal, FALSE, TRUE, scratch_pool);
+  if (!err || !APR_STATUS_IS_EAGAIN(err->apr_err))
+    {
+      if (!err)
+        err = svn_io_unlock_open_file(journal, scratch_pool);
+      svn_error_clear(err);
+
+      return svn_error_trace(svn_io_file_close(journal, scratch_pool));
+    }
+  svn_error_clear(err);
+
+  SVN_ERR(svn_io_file_readline(journal, &header, NULL, &eof, APR_SIZE_MAX,
+                               scratch_pool, scratch_pool));
+  if (eof
+      || strncmp(header->data, SVN_WC__WATCH_JOURNAL_HEADER " ",
+                 sizeof(SVN_WC__WATCH_JOURNAL_HEADER)))
+    return svn_error_trace(svn_io_file_close(journal, scratch_pool));
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->wcroot_abspath = wcroot_abspath;
+  result->session = apr_pstrdup(result_pool, header->data
+                                  + sizeof(SVN_WC__WATCH_JOURNAL_HEADER));
+  result->dirty = apr_hash_make(result_pool);
+
+  SVN_ERR(svn_io_stat(&finfo, svn_wc__adm_child(wcroot_abspath, SDB_FILE,
+                                                scratch_pool),
+                      APR_FINFO_SIZE | APR_FINFO_MTIME, scratch_pool));
+  result->db_size = finfo.size;
+  result->db_mtime = finfo.mtime;
+
+  SVN_ERR(svn_io_file_get_offset(&offset, journal, scratch_pool));
+
+  err = svn_stringbuf_from_file2(&cache_data,
+                                 svn_wc__adm_child(wcroot_abspath,
+                                                   STATUS_CACHE,
+                                                   scratch_pool),
+                                 scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      cache_data = NULL;
+    }
+  else
+    SVN_ERR(err);
+
+  /* Continue reading the journal where the last walk stopped. */
+  if (cache_data)
+    {
+      const char *eol = strchr(cache_data->data, '\n');
+      apr_off_t cache_offset;
+
+      if (eol
+          && status_cache_matches(&cache_offset, result,
+                                  apr_pstrmemdup(scratch_pool,
+                                                 cache_data->data,
+                                                 eol - cache_data->data),
+                                  scratch_pool)
+          && cache_offset >= offset)
+        {
+          result->changed = apr_hash_make(result_pool);
+          svn_stringbuf_remove(cache_data, 0, eol + 1 - cache_data->data);
+          add_changed_dirs(result->changed, cache_data, result_pool);
+
+          offset = cache_offset;
+          SVN_ERR(svn_io_file_seek(journal, APR_SET, &offset,
+                                   scratch_pool));
+        }
+    }
+
+  /* The watcher may still be catching up with recent changes.  That only
+     matters if we are going to skip directories. */
+  if (result->changed)
+    SVN_ERR(read_journal_synced(&synced, &entries, journal, wcroot_abspath,
+                                scratch_pool, scratch_pool));
+  else
+    SVN_ERR(svn_stringbuf_from_stream(&entries,
+                                      svn_stream_from_aprfile2(journal,
+                                                               FALSE,
+                                                               scratch_pool),
+                                      0, scratch_pool));
+
+  /* The watcher may be just writing the last entry. */
+  len = entries->len;
+  while (len > 0 && entries->data[len - 1] != '\n')
+    len--;
+  result->journal_size = offset + len;
+
+  if (result->changed
+      && (!synced
+          || !add_changed_dirs(result->changed, entries, result_pool)))
+    result->changed = NULL;
+
+  *cache = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the dirents (svn_io_dirent2_t *) that the children NODES, as
+   returned by svn_wc__db_read_children_info(), have on disk if they look
+   as recorded in wc.db.  Allocate the result in RESULT_POOL. */
+static apr_hash_t *
+recorded_dirents(apr_hash_t *nodes,
+                 apr_pool_t *result_pool)
+{
+  apr_hash_t *dirents = apr_hash_make(result_pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(result_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+      svn_io_dirent2_t *dirent;
+
+      if (info->status == svn_wc__db_status_not_present
+          || info->status == svn_wc__db_status_excluded
+          || info->status == svn_wc__db_status_server_excluded
+          || info->kind == svn_node_unknown)
+        continue;
+
+      dirent = svn_io_dirent2_create(result_pool);
+      dirent->kind = (info->kind == svn_node_dir) ? svn_node_dir
+                                                  : svn_node_file;
+      dirent->special = info->special;
+      dirent->filesize = info->recorded_size;
+      dirent->mtime = info->recorded_time;
+
+      apr_hash_set(dirents, apr_hash_this_key(hi),
+                   apr_hash_this_key_len(hi), dirent);
+    }
+
+  return dirents;
+}
+
+/* Return TRUE if CACHE knows that the directory LOCAL_ABSPATH has not
+   changed on disk since the last walk.  CACHE may be NULL. */
+static svn_boolean_t
+dir_unchanged(const status_cache_t *cache,
+              const char *local_abspath)
+{
+  const char *relpath;
+
+  if (!cache || !cache->changed)
+    return FALSE;
+
+  relpath = svn_dirent_skip_ancestor(cache->wcroot_abspath, local_abspath);
+
+  return relpath && !svn_hash_gets(cache->changed, relpath);
+}
+
+/* Record in CACHE that the on-disk state of LOCAL_ABSPATH differs from
+   wc.db, i.e. its parent directory needs to be read in the next walk as
+   well.  CACHE may be NULL. */
+static void
+mark_dirty(status_cache_t *cache,
+           const char *local_abspath,
+           apr_pool_t *scratch_pool)
+{
+  const char *relpath;
+  apr_pool_t *result_pool;
+
+  if (!cache)
+    return;
+
+  relpath = svn_dirent_skip_ancestor(cache->wcroot_abspath,
+                                     svn_dirent_dirname(local_abspath,
+                                                        scratch_pool));
+  if (!relpath || svn_hash_gets(cache->dirty, relpath))
+    return;
+
+  if (strchr(relpath, '\n'))
+    cache->unsaveable = TRUE;
+
+  result_pool = apr_hash_pool_get(cache->dirty);
+  svn_hash_sets(cache->dirty, apr_pstrdup(result_pool, relpath), "");
+}
+
+/* Write CACHE for the next walk.  The walk that used it must have read
+   the whole working copy, including text modifications. */
+static svn_error_t *
+save_status_cache(const status_cache_t *cache,
+                  apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *data;
+  apr_hash_index_t *hi;
+
+  if (cache->unsaveable)
+    return SVN_NO_ERROR;
+
+  data = svn_stringbuf_createf(scratch_pool,
+                               STATUS_CACHE_HEADER " %s %" APR_OFF_T_FMT
+                               " %" APR_OFF_T_FMT " %" APR_TIME_T_FMT "\n",
+                               cache->session, cache->journal_size,
+                               cache->db_size, cache->db_mtime);
+
+  for (hi = apr_hash_first(scratch_pool, cache->dirty);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_stringbuf_appendcstr(data, apr_hash_this_key(hi));
+      svn_stringbuf_appendbyte(data, '\n');
+    }
+
+  return svn_error_trace(
+           svn_io_write_atomic2(svn_wc__adm_child(cache->wcroot_abspath,
+                                                  STATUS_CACHE,
+                                                  scratch_pool),
+                                data->data, data->len,
+                                NULL /* copy_perms_path */,
+                                FALSE /* flush_to_disk */,
+                                scratch_pool));
+}
+
 /* Given an ENTRY object representing PATH, build a status structure
    and pass it off to the STATUS_FUNC/STATUS_BATON.  All other
    arguments are the same as those passed to assemble_status().  */
@@ -833,6 +1317,13 @@ send_status_structure(const struct walk_status_baton *wb,
                           wb->ignore_text_mods, wb->check_working_copy,
                           repos_lock, scratch_pool, scratch_pool));
 
+  if (!dirent
+      || (statstruct
+          && (statstruct->s.node_status == svn_wc_status_missing
+              || statstruct->s.node_status == svn_wc_status_obstructed
+              || statstruct->s.text_status == svn_wc_status_modified)))
+    mark_dirty(wb->status_cache, local_abspath, scratch_pool);
+
   if (statstruct && status_func)
     return svn_error_trace((*status_func)(status_baton, local_abspath,
                                           &statstruct->s,
@@ -995,6 +1486,8 @@ send_unversioned_item(const struct walk_status_baton *wb,
   svn_wc__internal_status_t *status;
   const char *base_name = svn_dirent_basename(local_abspath, NULL);
 
+  mark_dirty(wb->status_cache, local_abspath, scratch_pool);
+
   is_ignored = svn_wc_match_ignore_list(base_name, patterns, scratch_pool);
   SVN_ERR(assemble_unversioned(&status,
                                wb->db, local_abspath,
@@ -1023,6 +1516,380 @@ send_unversioned_item(const struct walk_status_baton *wb,
   return SVN_NO_ERROR;
 }
 
+/*** Reading directories ahead of the status walk ***/
+
+/* Number of threads reading directories ahead of the status walk. */
+#define DIRENTS_PREFETCH_THREADS 4
+
+/* Maximum number of directories read ahead but not consumed yet.  This
+   limits the memory used for the prefetched dirents. */
+#define DIRENTS_PREFETCH_MAX_JOBS 1024
+
+/* Processing states of a dirents_job_t. */
+typedef enum dirents_job_state_t
+{
+  dirents_job_queued,
+  dirents_job_running,
+  dirents_job_done
+} dirents_job_state_t;
+
+/* A directory to read ahead of the walk. */
+typedef struct dirents_job_t
+{
+  /* The directory to read.  Allocated in POOL. */
+  const char *local_abspath;
+
+  /* All following fields are protected by the prefetch mutex. */
+  dirents_job_state_t state;
+
+  /* Set when the walk read the directory itself because the job had
+     not been started yet.  The worker that dequeues it will release it. */
+  svn_boolean_t abandoned;
+
+  /* Next job in the queue. */
+  struct dirents_job_t *next;
+
+  /* Results, valid once STATE is dirents_job_done.  As returned by
+     svn_io_get_dirents3(). */
+  apr_hash_t *dirents;
+  svn_error_t *err;
+
+  /* Owns the job and its results. */
+  apr_pool_t *pool;
+} dirents_job_t;
+
+struct dirents_prefetch_t
+{
+  /* Passed to svn_io_get_dirents3(). */
+  svn_boolean_t only_check_type;
+
+  /* Synchronization.  COND gets signalled upon any state change. */
+  svn_mutex__t *mutex;
+  svn_thread_cond__t *cond;
+
+  /* Jobs not yet started, in the order the walk will need them.
+     Protected by MUTEX. */
+  dirents_job_t *first;
+
+  /* Number of jobs not released yet.  Protected by MUTEX. */
+  int job_count;
+
+  /* Set when the workers shall terminate.  Protected by MUTEX. */
+  svn_boolean_t shutdown;
+
+  /* Jobs not yet consumed by the walk, by local_abspath.  Used by the
+     main thread only. */
+  apr_hash_t *jobs;
+
+  /* apr_thread_t * of the workers. */
+  apr_array_header_t *threads;
+
+  /* Owns the synchronization objects and threads. */
+  apr_pool_t *pool;
+};
+
+/* Implements apr_pool_cleanup_t.  Destroy the pool DATA. */
+static apr_status_t
+destroy_job_pool(void *data)
+{
+  svn_pool_destroy(data);
+  return APR_SUCCESS;
+}
+
+#if APR_HAS_THREADS
+
+/* Read directories queued in PREFETCH until shutdown is requested.
+   Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+run_dirents_jobs(dirents_prefetch_t *prefetch,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      dirents_job_t *job = NULL;
+      svn_boolean_t shutdown;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_pool_clear(iterpool);
+
+      /* Wait for the next job. */
+      SVN_ERR(svn_mutex__lock(prefetch->mutex));
+
+      while (!err && !prefetch->shutdown && !prefetch->first)
+        err = svn_thread_cond__wait(prefetch->cond, prefetch->mutex);
+
+      shutdown = prefetch->shutdown;
+      if (!err && !shutdown)
+        {
+          job = prefetch->first;
+          prefetch->first = job->next;
+          job->next = NULL;
+
+          if (job->abandoned)
+            {
+              prefetch->job_count--;
+              svn_pool_destroy(job->pool);
+              job = NULL;
+            }
+          else
+            {
+              job->state = dirents_job_running;
+            }
+        }
+
+      SVN_ERR(svn_mutex__unlock(prefetch->mutex, err));
+
+      if (shutdown)
+        break;
+      if (!job)
+        continue;
+
+      /* Do the actual work outside the lock. */
+      err = svn_io_get_dirents3(&job->dirents, job->local_abspath,
+                                prefetch->only_check_type,
+                                job->pool, iterpool);
+
+      /* Hand the results to the walk. */
+      SVN_ERR(svn_mutex__lock(prefetch->mutex));
+
+      job->err = err;
+      job->state = dirents_job_done;
+
+      SVN_ERR(svn_mutex__unlock(prefetch->mutex,
+                                svn_thread_cond__broadcast(prefetch->cond)));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function of the dirents workers.  DATA is the
+   dirents_prefetch_t. */
+static void * APR_THREAD_FUNC
+dirents_worker(apr_thread_t *thread,
+               void *data)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  /* Errors here are synchronization failures.  There is no good way to
+     report them to the main thread, which will probably get stuck on
+     the same mutex anyway. */
+  svn_error_clear(run_dirents_jobs(data, pool));
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(thread, APR_SUCCESS);
+
+  return NULL;
+}
+
+#endif
+
+/* Start the workers that read directories ahead of a status walk and
+   return them in *PREFETCH.  ONLY_CHECK_TYPE will be passed to
+   svn_io_get_dirents3().  Set *PREFETCH to NULL if APR does not support
+   threads.  Allocate the result in RESULT_POOL. */
+static svn_error_t *
+start_dirents_prefetch(dirents_prefetch_t **prefetch_p,
+                       svn_boolean_t only_check_type,
+                       apr_pool_t *result_pool)
+{
+#if APR_HAS_THREADS
+  dirents_prefetch_t *prefetch = apr_pcalloc(result_pool, sizeof(*prefetch));
+  int i;
+
+  /* The threads are created from and release their memory to this pool,
+     so make it independent from any pool used by the main thread. */
+  prefetch->pool = svn_pool_create(NULL);
+  prefetch->only_check_type = only_check_type;
+  prefetch->jobs = apr_hash_make(result_pool);
+  prefetch->threads = apr_array_make(result_pool, DIRENTS_PREFETCH_THREADS,
+                                     sizeof(apr_thread_t *));
+
+  SVN_ERR(svn_mutex__init(&prefetch->mutex, TRUE, prefetch->pool));
+  SVN_ERR(svn_thread_cond__create(&prefetch->cond, prefetch->pool));
+
+  /* Set *PREFETCH_P now such that the workers get stopped even if we
+     fail to create some of them. */
+  *prefetch_p = prefetch;
+  for (i = 0; i < DIRENTS_PREFETCH_THREADS; ++i)
+    {
+      apr_thread_t *thread;
+      apr_status_t status = apr_thread_create(&thread, NULL, dirents_worker,
+                                              prefetch, prefetch->pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create status worker"));
+
+      APR_ARRAY_PUSH(prefetch->threads, apr_thread_t *) = thread;
+    }
+#else
+  *prefetch_p = NULL;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop the workers of PREFETCH, if any, and release all its resources. */
+static svn_error_t *
+stop_dirents_prefetch(dirents_prefetch_t *prefetch)
+{
+  apr_hash_index_t *hi;
+  dirents_job_t *job;
+
+  if (!prefetch)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(prefetch->mutex));
+  prefetch->shutdown = TRUE;
+  SVN_ERR(svn_mutex__unlock(prefetch->mutex,
+                            svn_thread_cond__broadcast(prefetch->cond)));
+
+#if APR_HAS_THREADS
+  {
+    int i;
+    for (i = 0; i < prefetch->threads->nelts; ++i)
+      {
+        apr_status_t retval;
+        apr_thread_join(&retval, APR_ARRAY_IDX(prefetch->threads, i,
+                                               apr_thread_t *));
+      }
+  }
+#endif
+
+  /* No more workers.  Queued jobs are either abandoned or still in JOBS,
+     just like all finished ones that have not been consumed. */
+  for (job = prefetch->first; job; )
+    {
+      dirents_job_t *next = job->next;
+      if (job->abandoned)
+        svn_pool_destroy(job->pool);
+      job = next;
+    }
+
+  for (hi = apr_hash_first(prefetch->pool, prefetch->jobs);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      job = apr_hash_this_val(hi);
+      svn_error_clear(job->err);
+      svn_pool_destroy(job->pool);
+    }
+
+  svn_pool_destroy(prefetch->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue the directories LOCAL_ABSPATHS (const char *) in PREFETCH such
+   that the workers will read them before all directories queued earlier.
+   The walk is depth-first, so it will need them first as well.  Skip
+   directories if too many have been read ahead already. */
+static svn_error_t *
+queue_dirents(dirents_prefetch_t *prefetch,
+              const apr_array_header_t *local_abspaths)
+{
+  dirents_job_t *first = NULL;
+  dirents_job_t *last = NULL;
+  int i;
+
+  if (!local_abspaths->nelts)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(prefetch->mutex));
+
+  for (i = 0;
+       i < local_abspaths->nelts
+         && prefetch->job_count < DIRENTS_PREFETCH_MAX_JOBS;
+       ++i)
+    {
+      apr_pool_t *pool = svn_pool_create(NULL);
+      dirents_job_t *job = apr_pcalloc(pool, sizeof(*job));
+
+      job->pool = pool;
+      job->local_abspath = apr_pstrdup(pool,
+                                       APR_ARRAY_IDX(local_abspaths, i,
+                                                     const char *));
+      job->state = dirents_job_queued;
+      svn_hash_sets(prefetch->jobs, job->local_abspath, job);
+
+      if (last)
+        last->next = job;
+      else
+        first = job;
+      last = job;
+
+      prefetch->job_count++;
+    }
+
+  if (last)
+    {
+      last->next = prefetch->first;
+      prefetch->first = first;
+    }
+
+  return svn_error_trace(svn_mutex__unlock(
+                           prefetch->mutex,
+                           last ? svn_thread_cond__broadcast(prefetch->cond)
+                                : SVN_NO_ERROR));
+}
+
+/* Set *DIRENTS to the entries of LOCAL_ABSPATH as returned by
+   svn_io_get_dirents3(), using the results of PREFETCH if it has been
+   queued there.  Otherwise, read the directory here.  PREFETCH may be
+   NULL.  Allocate the result in RESULT_POOL and use SCRATCH_POOL for
+   temporaries. */
+static svn_error_t *
+get_dirents(apr_hash_t **dirents,
+            dirents_prefetch_t *prefetch,
+            const char *local_abspath,
+            svn_boolean_t only_check_type,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  dirents_job_t *job = prefetch ? svn_hash_gets(prefetch->jobs,
+                                                local_abspath)
+                                : NULL;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (job)
+    {
+      svn_hash_sets(prefetch->jobs, local_abspath, NULL);
+
+      SVN_ERR(svn_mutex__lock(prefetch->mutex));
+
+      /* Waiting for the workers to get to it would take longer than
+         doing it ourselves. */
+      if (job->state == dirents_job_queued)
+        {
+          job->abandoned = TRUE;
+          job = NULL;
+        }
+      else
+        {
+          while (!err && job->state != dirents_job_done)
+            err = svn_thread_cond__wait(prefetch->cond, prefetch->mutex);
+
+          prefetch->job_count--;
+        }
+
+      SVN_ERR(svn_mutex__unlock(prefetch->mutex, err));
+    }
+
+  if (!job)
+    return svn_error_trace(svn_io_get_dirents3(dirents, local_abspath,
+                                               only_check_type,
+                                               result_pool, scratch_pool));
+
+  /* The results live as long as RESULT_POOL. */
+  apr_pool_cleanup_register(result_pool, job->pool, destroy_job_pool,
+                            apr_pool_cleanup_null);
+  *dirents = job->dirents;
+
+  return svn_error_trace(job->err);
+}
+
 static svn_error_t *
 get_dir_status(const struct walk_status_baton *wb,
                const char *local_abspath,
@@ -1234,6 +2101,7 @@ get_dir_status(const struct walk_status_baton *wb,
   apr_array_header_t *sorted_children;
   apr_array_header_t *collected_ignore_patterns = NULL;
   apr_pool_t *iterpool;
+  svn_boolean_t unchanged;
   svn_error_t *err;
   int i;
 
@@ -1243,13 +2111,19 @@ get_dir_status(const struct walk_status_baton *wb,
   if (depth == svn_depth_unknown)
     depth = svn_depth_infinity;
 
-  iterpool = svn_pool_create(scratch_pool);
+  /* This is called for every directory in the tree.  Use a recycled pool. */
+  iterpool = svn_pool__create_arena(scratch_pool);
+
+  /* If a file system watcher saw nothing change here since the last walk,
+     which found everything as recorded in wc.db, don't read the disk. */
+  unchanged = wb->check_working_copy
+              && dir_unchanged(wb->status_cache, local_abspath);
 
-  if (wb->check_working_copy)
+  if (wb->check_working_copy && !unchanged)
     {
-      err = svn_io_get_dirents3(&dirents, local_abspath,
-                                wb->ignore_text_mods /* only_check_type*/,
-                                scratch_pool, iterpool);
+      err = get_dirents(&dirents, wb->prefetch, local_abspath,
+                        wb->ignore_text_mods /* only_check_type*/,
+                        scratch_pool, iterpool);
       if (err
           && (APR_STATUS_IS_ENOENT(err->apr_err)
               || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
@@ -1283,6 +2157,9 @@ get_dir_status(const struct walk_status_baton *wb,
                                         !wb->check_working_copy,
                                         scratch_pool, iterpool));
 
+  if (unchanged)
+    dirents = recorded_dirents(nodes, scratch_pool);
+
   all_children = apr_hash_overlay(scratch_pool, nodes, dirents);
   if (apr_hash_count(conflicts) > 0)
     all_children = apr_hash_overlay(scratch_pool, conflicts, all_children);
@@ -1340,6 +2217,38 @@ get_dir_status(const struct walk_status_baton *wb,
   sorted_children = svn_sort__hash(all_children,
                                    svn_sort_compare_items_lexically,
                                    scratch_pool);
+
+  /* Let the workers read the subdirectories that we will descend into,
+     while we take care of this one.  See one_child_status(). */
+  if (wb->prefetch && depth == svn_depth_infinity)
+    {
+      apr_array_header_t *subdirs = apr_array_make(iterpool, 0,
+                                                    sizeof(const char *));
+
+      for (i = 0; i < sorted_children->nelts; i++)
+        {
+          svn_sort__item_t item = APR_ARRAY_IDX(sorted_children, i,
+                                                svn_sort__item_t);
+          const struct svn_wc__db_info_t *child_info
+            = apr_hash_get(nodes, item.key, item.klen);
+          const char *child_abspath;
+
+          if (!child_info
+              || !child_info->has_descendants
+              || child_info->status == svn_wc__db_status_not_present
+              || child_info->status == svn_wc__db_status_excluded
+              || child_info->status == svn_wc__db_status_server_excluded
+              || (child_info->kind == svn_node_unknown
+                  && child_info->status == svn_wc__db_status_normal))
+            continue;
+
+          child_abspath = svn_dirent_join(local_abspath, item.key, iterpool);
+          if (!dir_unchanged(wb->status_cache, child_abspath))
+            APR_ARRAY_PUSH(subdirs, const char *) = child_abspath;
+        }
+
+      SVN_ERR(queue_dirents(wb->prefetch, subdirs));
+    }
   for (i = 0; i < sorted_children->nelts; i++)
     {
       const void *key;
@@ -1382,7 +2291,7 @@ get_dir_status(const struct walk_status_baton *wb,
     }
 
   /* Destroy our subpools. */
-  svn_pool_destroy(iterpool);
+  svn_pool__destroy_arena(iterpool);
 
   return SVN_NO_ERROR;
 }
@@ -2513,6 +3422,8 @@ svn_wc__get_status_editor(const svn_delta_editor_t **editor,
   eb->wb.check_working_copy = check_working_copy;
   eb->wb.repos_locks      = NULL;
   eb->wb.repos_root       = NULL;
+  eb->wb.prefetch         = NULL;
+  eb->wb.status_cache     = NULL;
 
   SVN_ERR(svn_wc__db_externals_defined_below(&eb->wb.externals,
                                              wc_ctx->db, eb->target_abspath,
@@ -2644,6 +3555,8 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   wb.check_working_copy = TRUE;
   wb.repos_root = NULL;
   wb.repos_locks = NULL;
+  wb.prefetch = NULL;
+  wb.status_cache = NULL;
 
   /* Use the caller-provided ignore patterns if provided; the build-time
      configured defaults otherwise. */
@@ -2690,7 +3603,18 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
       && info->status != svn_wc__db_status_excluded
       && info->status != svn_wc__db_status_server_excluded)
     {
-      SVN_ERR(get_dir_status(&wb,
+      /* Only deep walks have enough directories to read ahead. */
+      err = SVN_NO_ERROR;
+      if (depth == svn_depth_infinity || depth == svn_depth_unknown)
+        err = start_dirents_prefetch(&wb.prefetch, ignore_text_mods,
+                                     scratch_pool);
+
+      if (!err)
+        err = open_status_cache(&wb.status_cache, db, local_abspath,
+                                scratch_pool, scratch_pool);
+
+      if (!err)
+        err = get_dir_status(&wb,
                              local_abspath,
                              FALSE /* skip_root */,
                              NULL, NULL, NULL,
@@ -2702,7 +3626,18 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
                              no_ignore,
                              status_func, status_baton,
                              cancel_func, cancel_baton,
-                             scratch_pool));
+                             scratch_pool);
+
+      /* The next walk can build on this one if it has seen everything. */
+      if (!err
+          && wb.status_cache
+          && !ignore_text_mods
+          && (depth == svn_depth_infinity || depth == svn_depth_unknown)
+          && !strcmp(local_abspath, wb.status_cache->wcroot_abspath))
+        err = save_status_cache(wb.status_cache, scratch_pool);
+
+      SVN_ERR(svn_error_compose_create(err,
+                                       stop_dirents_prefetch(wb.prefetch)));
     }
   else
     {
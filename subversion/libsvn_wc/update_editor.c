@@ -209,6 +209,10 @@ struct edit_baton
      of conflict checks to be omitted. */
   svn_boolean_t clean_checkout;
 
+  /* If set, files are added without fetching their text.  See
+     svn_wc__db_get_lazy_fetch(). */
+  svn_boolean_t lazy_fetch;
+
   /* If this is a 'switch' operation, the new relpath of target_abspath,
      else NULL. */
   const char *switch_repos_relpath;
@@ -469,7 +473,7 @@ get_empty_tmp_file(const char **tmp_filename,
 }
 
 /* An APR pool cleanup handler.  This runs the working queue for an
-   editor baton. */
+   editor baton and ends its batch of database changes. */
 static apr_status_t
 cleanup_edit_baton(void *edit_baton)
 {
@@ -480,6 +484,10 @@ cleanup_edit_baton(void *edit_baton)
   err = svn_wc__wq_run(eb->db, eb->wcroot_abspath,
                        NULL /* cancel_func */, NULL /* cancel_baton */,
                        pool);
+  err = svn_error_compose_create(err,
+                                 svn_wc__db_batch_end(eb->db,
+                                                      eb->wcroot_abspath,
+                                                      pool));
 
   if (err)
     {
@@ -733,6 +741,10 @@ struct file_baton
      continues as semi-shadowed update */
   svn_boolean_t edit_obstructed;
 
+  /* Set if the text of this file is not fetched, either because it is added
+     in a lazy-fetch working copy or because its text was never fetched */
+  svn_boolean_t text_deferred;
+
   /* The (new) changed_* information, cached to avoid retrieving it later */
   svn_revnum_t changed_rev;
   apr_time_t changed_date;
@@ -2173,6 +2185,7 @@ add_directory(const char *path,
                                 : NULL,
                               db->pool, scratch_pool));
 
+  SVN_ERR(svn_wc__db_batch_node(eb->db, eb->wcroot_abspath, scratch_pool));
   SVN_ERR(svn_wc__db_base_add_incomplete_directory(
                                      eb->db, db->local_abspath,
                                      db->new_repos_relpath,
@@ -2187,9 +2200,14 @@ add_directory(const char *path,
                                      scratch_pool));
 
   /* Make sure there is a real directory at LOCAL_ABSPATH, unless we are just
-     updating the DB */
+     updating the DB.  The disk must not run ahead of wc.db, so commit the
+     batch containing the new node first. */
   if (!db->shadowed)
-    SVN_ERR(svn_wc__ensure_directory(db->local_abspath, scratch_pool));
+    {
+      SVN_ERR(svn_wc__db_batch_commit(eb->db, eb->wcroot_abspath,
+                                      scratch_pool));
+      SVN_ERR(svn_wc__ensure_directory(db->local_abspath, scratch_pool));
+    }
 
   if (tree_conflict != NULL)
     {
@@ -2796,6 +2814,8 @@ close_directory(void *dir_baton,
 
       /* Update the BASE data for the directory and mark the directory
          complete */
+      SVN_ERR(svn_wc__db_batch_node(eb->db, eb->wcroot_abspath,
+                                    scratch_pool));
       SVN_ERR(svn_wc__db_base_add_directory(
                 eb->db, db->local_abspath,
                 eb->wcroot_abspath,
@@ -3499,6 +3519,10 @@ open_file(const char *path,
                                   fb->old_repos_relpath, eb, pb,
                                   fb->pool, scratch_pool));
 
+  /* A file recorded without its text can't apply deltas; it stays without
+     text until its text is fetched */
+  fb->text_deferred = (fb->original_checksum == NULL);
+
   /* Is this path a conflict victim? */
   if (fb->shadowed)
     conflicted = FALSE; /* Conflict applies to WORKING */
@@ -3632,6 +3656,19 @@ apply_textdelta(void *file_baton,
 
   SVN_ERR(mark_file_edited(fb, pool));
 
+  if (eb->lazy_fetch && fb->adding_file
+      && !fb->obstruction_found && !fb->add_existed)
+    fb->text_deferred = TRUE;
+
+  /* Discard the text of files that don't fetch it.  The RA layers skip
+     retrieving text for the noop handler where they can. */
+  if (fb->text_deferred)
+    {
+      *handler = svn_delta_noop_window_handler;
+      *handler_baton = NULL;
+      return SVN_NO_ERROR;
+    }
+
   /* Parse checksum or sets expected_base_checksum to NULL */
   SVN_ERR(svn_checksum_parse_hex(&expected_base_checksum, svn_checksum_md5,
                                  expected_checksum, pool));
@@ -4372,7 +4409,13 @@ close_file(void *file_baton,
       SVN_ERR_ASSERT(new_base_props != NULL && new_actual_props != NULL);
 
       /* Merge the text. This will queue some additional work.  */
-      if (!fb->obstruction_found && !fb->edit_obstructed)
+      if (fb->text_deferred)
+        {
+          /* There is no local text to install or merge into */
+          install_pristine = FALSE;
+          content_state = svn_wc_notify_state_unchanged;
+        }
+      else if (!fb->obstruction_found && !fb->edit_obstructed)
         {
           svn_error_t *err;
           err = merge_file(&work_item, &conflict_skel,
@@ -4441,7 +4484,7 @@ close_file(void *file_baton,
                                             scratch_pool);
         }
       else if (lock_state == svn_wc_notify_lock_state_unlocked
-               && !fb->obstruction_found)
+               && !fb->obstruction_found && !fb->text_deferred)
         {
           /* If a lock was removed and we didn't update the text contents, we
              might need to set the file read-only.
@@ -4558,6 +4601,7 @@ close_file(void *file_baton,
         svn_hash_sets(eb->wcroot_iprops, fb->local_abspath, NULL);
     }
 
+  SVN_ERR(svn_wc__db_batch_node(eb->db, eb->wcroot_abspath, scratch_pool));
   SVN_ERR(svn_wc__db_base_add_file(eb->db, fb->local_abspath,
                                    eb->wcroot_abspath,
                                    fb->new_repos_relpath,
@@ -4568,6 +4612,7 @@ close_file(void *file_baton,
                                    fb->changed_date,
                                    fb->changed_author,
                                    new_checksum,
+                                   fb->text_deferred,
                                    (dav_prop_changes->nelts > 0)
                                      ? svn_prop_array_to_hash(
                                                       dav_prop_changes,
@@ -4849,9 +4894,11 @@ close_edit(void *edit_baton,
      cleanup at the end of this function. */
   apr_pool_cleanup_kill(eb->pool, eb, cleanup_edit_baton);
 
-  SVN_ERR(svn_wc__wq_run(eb->db, eb->wcroot_abspath,
-                         eb->cancel_func, eb->cancel_baton,
-                         eb->pool));
+  SVN_ERR(svn_error_compose_create(
+            svn_wc__wq_run(eb->db, eb->wcroot_abspath,
+                           eb->cancel_func, eb->cancel_baton,
+                           eb->pool),
+            svn_wc__db_batch_end(eb->db, eb->wcroot_abspath, eb->pool)));
 
   /* The edit is over, free its pool.
      ### No, this is wrong.  Who says this editor/baton won't be used
@@ -4973,10 +5020,14 @@ make_editor(svn_revnum_t *target_revision,
   eb->allow_unver_obstructions = allow_unver_obstructions;
   eb->adds_as_modification     = adds_as_modification;
   eb->clean_checkout           = clean_checkout;
+  eb->lazy_fetch               = svn_wc__db_get_lazy_fetch(db);
   eb->skipped_trees            = apr_hash_make(edit_pool);
   eb->dir_dirents              = apr_hash_make(edit_pool);
   eb->ext_patterns             = preserved_exts;
 
+  /* Record the nodes of the edit in batches.  The cleanup handler ends
+     the batch if the edit is not closed. */
+  SVN_ERR(svn_wc__db_batch_begin(db, eb->wcroot_abspath, scratch_pool));
   apr_pool_cleanup_register(edit_pool, eb, cleanup_edit_baton,
                             apr_pool_cleanup_null);
 
@@ -506,7 +506,7 @@ svn_wc__fetch_base_func(const char **filename,
     }
 
   SVN_ERR(svn_wc__db_pristine_get_path(filename, sfb->db, local_abspath,
-                                       checksum, scratch_pool, scratch_pool));
+                                       checksum, result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
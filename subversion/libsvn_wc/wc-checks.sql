@@ -172,8 +172,9 @@ AND (kind IS NULL
               OR changed_revision IS NOT NULL
               OR changed_author IS NOT NULL
               OR (changed_date IS NOT NULL AND changed_date != 0)))
+     /* BASE files may lack their text; see svn_wc__db_get_lazy_fetch() */
      OR (CASE WHEN kind = MAP_FILE AND repos_path IS NOT NULL
-                                   THEN checksum IS NULL
+                                   THEN checksum IS NULL AND op_depth > 0
                                    ELSE checksum IS NOT NULL END)
      OR (CASE WHEN kind = MAP_DIR THEN depth IS NULL
                                   ELSE depth IS NOT NULL END)
@@ -699,9 +699,12 @@ WHERE l.op_depth = 0
 
 
 /* ------------------------------------------------------------------------- */
-/* Format 32 ....  */
-/* -- STMT_UPGRADE_TO_32
-PRAGMA user_version = 32; */
+
+/* Format 32 has the same schema as format 31.  It only keeps older clients
+   away from working copies that use newer features, see
+   SVN_WC__FEATURES_VERSION. */
+-- STMT_UPGRADE_TO_32
+PRAGMA user_version = 32;
 
 
 /* ------------------------------------------------------------------------- */
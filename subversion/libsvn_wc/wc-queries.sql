@@ -474,6 +474,19 @@ WHERE wc_id = ?1 AND local_relpath = ?2 AND op_depth = 0
 SELECT dav_cache FROM nodes
 WHERE wc_id = ?1 AND local_relpath = ?2 AND op_depth = 0
 
+/* Files recorded without their text; see svn_wc__db_get_lazy_fetch() */
+-- STMT_SELECT_UNFETCHED_FILES
+SELECT local_relpath FROM nodes
+WHERE wc_id = ?1
+  AND (local_relpath = ?2 OR IS_STRICT_DESCENDANT_OF(local_relpath, ?2))
+  AND op_depth = 0 AND kind = MAP_FILE AND presence = MAP_NORMAL
+  AND checksum IS NULL
+
+-- STMT_UPDATE_BASE_NODE_FETCHED
+UPDATE nodes SET checksum = ?3
+WHERE wc_id = ?1 AND local_relpath = ?2 AND op_depth = 0
+  AND checksum IS NULL
+
 -- STMT_SELECT_DELETION_INFO
 SELECT b.presence, w.presence, w.op_depth, w.moved_to
 FROM nodes w
@@ -880,6 +893,9 @@ INSERT INTO work_queue (work) VALUES (?1)
 -- STMT_SELECT_WORK_ITEM
 SELECT id, work FROM work_queue ORDER BY id LIMIT 1
 
+-- STMT_SELECT_WORK_ITEMS
+SELECT id, work FROM work_queue ORDER BY id LIMIT ?1
+
 -- STMT_DELETE_WORK_ITEM
 DELETE FROM work_queue WHERE id = ?1
 
@@ -937,6 +953,20 @@ WHERE wc_id = ?1
 -- STMT_VACUUM
 VACUUM
 
+-- STMT_PRAGMA_AUTO_VACUUM
+PRAGMA auto_vacuum
+
+-- STMT_PRAGMA_AUTO_VACUUM_INCREMENTAL
+PRAGMA auto_vacuum = INCREMENTAL
+
+-- STMT_PRAGMA_FREELIST_COUNT
+PRAGMA freelist_count
+
+/* Release at most 1024 free pages, i.e. 4 MB with the default page size,
+   so that a single step doesn't take long. */
+-- STMT_INCREMENTAL_VACUUM
+PRAGMA incremental_vacuum(1024)
+
 -- STMT_SELECT_CONFLICT_VICTIMS
 SELECT local_relpath, conflict_data
 FROM actual_node
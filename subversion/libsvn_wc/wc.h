@@ -161,11 +161,20 @@ extern "C" {
  * == 1.9.x shipped with format 31
  * == 1.10.x shipped with format 31
  *
+ * Format 32 has the same schema as format 31.  A working copy gets it when
+ * it first stores a pristine text in chunks, or records a file without its
+ * text in lazy-fetch mode, neither of which older clients can handle.  New
+ * working copies still start with format 31.
+ *
  * Please document any further format changes here.
  */
 
 #define SVN_WC__VERSION 31
 
+/* The format of working copies that use features which older clients
+   don't know about.  See svn_wc__db_util_require_features(). */
+#define SVN_WC__FEATURES_VERSION 32
+
 
 /* Formats <= this have no concept of "revert text-base/props".  */
 #define SVN_WC__NO_REVERT_FILES 4
@@ -726,6 +735,13 @@ svn_wc__externals_find_target_dups(apr_array_header_t **duplicate_targets,
                                    apr_pool_t *pool,
                                    apr_pool_t *scratch_pool);
 
+/* Return an error saying that the text of the file LOCAL_ABSPATH was not
+ * fetched, which happens in lazy-fetch working copies until the file is
+ * hydrated.  See hydrate.c. */
+svn_error_t *
+svn_wc__unfetched_error(const char *local_abspath,
+                        apr_pool_t *scratch_pool);
+
 svn_error_t *
 svn_wc__node_has_local_mods(svn_boolean_t *modified,
                             svn_boolean_t *all_edits_are_deletes,
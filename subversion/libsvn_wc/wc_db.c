@@ -145,6 +145,7 @@ typedef struct insert_base_baton_t {
 
   /* for inserting files */
   const svn_checksum_t *checksum;
+  svn_boolean_t unfetched; /* file without text; CHECKSUM is NULL */
 
   /* for inserting symlinks */
   const char *target;
@@ -747,6 +748,10 @@ insert_base_node(const insert_base_baton_t *pibb,
   present = (pibb->status == svn_wc__db_status_normal
              || pibb->status == svn_wc__db_status_incomplete);
 
+  /* Older clients take files without text for corrupt. */
+  if (pibb->kind == svn_node_file && present && pibb->unfetched)
+    SVN_ERR(svn_wc__db_util_require_features(wcroot->sdb, scratch_pool));
+
   SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb, STMT_INSERT_NODE));
   SVN_ERR(svn_sqlite__bindf(stmt, "isdsisr"
                             "tstr"               /* 8 - 11 */
@@ -771,6 +776,7 @@ insert_base_node(const insert_base_baton_t *pibb,
   if (pibb->kind == svn_node_file && present)
     {
       if (!pibb->checksum
+          && !pibb->unfetched
           && pibb->status != svn_wc__db_status_not_present
           && pibb->status != svn_wc__db_status_excluded
           && pibb->status != svn_wc__db_status_server_excluded)
@@ -1765,6 +1771,7 @@ svn_wc__db_base_add_file(svn_wc__db_t *db,
                          apr_time_t changed_date,
                          const char *changed_author,
                          const svn_checksum_t *checksum,
+                         svn_boolean_t unfetched,
                          apr_hash_t *dav_cache,
                          svn_boolean_t delete_working,
                          svn_boolean_t update_actual_props,
@@ -1787,7 +1794,7 @@ svn_wc__db_base_add_file(svn_wc__db_t *db,
   SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(revision));
   SVN_ERR_ASSERT(props != NULL);
   SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(changed_rev));
-  SVN_ERR_ASSERT(checksum != NULL);
+  SVN_ERR_ASSERT(unfetched ? checksum == NULL : checksum != NULL);
 
   SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
                               wri_abspath, scratch_pool, scratch_pool));
@@ -1811,6 +1818,7 @@ svn_wc__db_base_add_file(svn_wc__db_t *db,
   ibb.changed_author = changed_author;
 
   ibb.checksum = checksum;
+  ibb.unfetched = unfetched;
 
   ibb.dav_cache = dav_cache;
   ibb.iprops = new_iprops;
@@ -13597,6 +13605,205 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
 }
 
 
+/* The body of svn_wc__db_wq_record_and_fetch_batch().
+ */
+static svn_error_t *
+wq_fetch_batch(apr_array_header_t **ids,
+               apr_array_header_t **work_items,
+               svn_wc__db_wcroot_t *wcroot,
+               const apr_array_header_t *completed_ids,
+               int max_items,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int i;
+
+  for (i = 0; i < completed_ids->nelts; i++)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_DELETE_WORK_ITEM));
+      SVN_ERR(svn_sqlite__bind_int64(stmt, 1,
+                                     APR_ARRAY_IDX(completed_ids, i,
+                                                   apr_uint64_t)));
+
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  *ids = apr_array_make(result_pool, max_items, sizeof(apr_uint64_t));
+  *work_items = apr_array_make(result_pool, max_items, sizeof(svn_skel_t *));
+
+  if (max_items == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_WORK_ITEMS));
+  SVN_ERR(svn_sqlite__bind_int(stmt, 1, max_items));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  while (have_row)
+    {
+      apr_size_t len;
+      const void *val;
+
+      APR_ARRAY_PUSH(*ids, apr_uint64_t) = svn_sqlite__column_int64(stmt, 0);
+
+      val = svn_sqlite__column_blob(stmt, 1, &len, result_pool);
+      APR_ARRAY_PUSH(*work_items, svn_skel_t *)
+        = svn_skel__parse(val, len, result_pool);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_wc__db_wq_record_and_fetch_batch(apr_array_header_t **ids,
+                                     apr_array_header_t **work_items,
+                                     svn_wc__db_t *db,
+                                     const char *wri_abspath,
+                                     const apr_array_header_t *completed_ids,
+                                     apr_hash_t *record_map,
+                                     int max_items,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_WC__DB_WITH_TXN(
+    svn_error_compose_create(
+            wq_fetch_batch(ids, work_items, wcroot, completed_ids,
+                           max_items, result_pool, scratch_pool),
+            record_map ? wq_record(wcroot, record_map, scratch_pool)
+                       : SVN_NO_ERROR),
+    wcroot);
+
+  return SVN_NO_ERROR;
+}
+
+int
+svn_wc__db_wq_get_install_threads(svn_wc__db_t *db)
+{
+  return db->install_threads;
+}
+
+
+/* Commit the open batch transaction of WCROOT, if any. */
+static svn_error_t *
+batch_commit(svn_wc__db_wcroot_t *wcroot)
+{
+  if (wcroot->batch_nodes < 0)
+    return SVN_NO_ERROR;
+
+  /* Whatever the outcome, the transaction is over. */
+  wcroot->batch_nodes = -1;
+
+  return svn_error_trace(svn_sqlite__finish_transaction(wcroot->sdb,
+                                                        SVN_NO_ERROR));
+}
+
+svn_error_t *
+svn_wc__db_batch_begin(svn_wc__db_t *db,
+                       const char *wri_abspath,
+                       apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  wcroot->batch_depth++;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_batch_node(svn_wc__db_t *db,
+                      const char *wri_abspath,
+                      apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  if (db->batch_size == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  if (wcroot->batch_depth == 0)
+    return SVN_NO_ERROR;
+
+  if (wcroot->batch_nodes >= db->batch_size)
+    SVN_ERR(batch_commit(wcroot));
+
+  if (wcroot->batch_nodes < 0)
+    {
+      /* Take the write lock right away, just like every change would. */
+      SVN_ERR(svn_sqlite__begin_immediate_transaction(wcroot->sdb));
+      wcroot->batch_nodes = 0;
+    }
+
+  wcroot->batch_nodes++;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_batch_commit(svn_wc__db_t *db,
+                        const char *wri_abspath,
+                        apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  return svn_error_trace(batch_commit(wcroot));
+}
+
+svn_error_t *
+svn_wc__db_batch_end(svn_wc__db_t *db,
+                     const char *wri_abspath,
+                     apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_ERR_ASSERT(wcroot->batch_depth > 0);
+
+  if (--wcroot->batch_depth > 0)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(batch_commit(wcroot));
+}
+
 
 /* ### temporary API. remove before release.  */
 svn_error_t *
@@ -15835,6 +16042,124 @@ svn_wc__db_base_get_lock_tokens_recursive(apr_hash_t **lock_tokens,
 }
 
 
+svn_boolean_t
+svn_wc__db_get_lazy_fetch(svn_wc__db_t *db)
+{
+  return db->lazy_fetch;
+}
+
+
+svn_error_t *
+svn_wc__db_base_get_unfetched(apr_array_header_t **local_abspaths,
+                              svn_wc__db_t *db,
+                              const char *local_abspath,
+                              svn_depth_t depth,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int max_depth;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath,
+                                                db, local_abspath,
+                                                scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  /* Only files are selected, so immediates is the same as files */
+  if (depth == svn_depth_empty)
+    max_depth = relpath_depth(local_relpath);
+  else if (depth == svn_depth_files || depth == svn_depth_immediates)
+    max_depth = relpath_depth(local_relpath) + 1;
+  else
+    max_depth = -1;
+
+  *local_abspaths = apr_array_make(result_pool, 0, sizeof(const char *));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_UNFETCHED_FILES));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, local_relpath));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const char *child_relpath = svn_sqlite__column_text(stmt, 0, NULL);
+
+      if (max_depth < 0 || relpath_depth(child_relpath) <= max_depth)
+        APR_ARRAY_PUSH(*local_abspaths, const char *)
+          = svn_dirent_join(wcroot->abspath, child_relpath, result_pool);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+
+/* The body of svn_wc__db_base_set_fetched(). */
+static svn_error_t *
+base_set_fetched(svn_wc__db_wcroot_t *wcroot,
+                 const char *local_relpath,
+                 const svn_checksum_t *sha1_checksum,
+                 const svn_skel_t *work_items,
+                 apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  int affected_rows;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_UPDATE_BASE_NODE_FETCHED));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, local_relpath));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 3, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__update(&affected_rows, stmt));
+
+  if (affected_rows != 1)
+    return svn_error_createf(SVN_ERR_WC_PATH_NOT_FOUND, NULL,
+                             _("The file '%s' has no text to fetch."),
+                             path_for_error_message(wcroot, local_relpath,
+                                                    scratch_pool));
+
+  SVN_ERR(add_work_items(wcroot->sdb, work_items, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc__db_base_set_fetched(svn_wc__db_t *db,
+                            const char *local_abspath,
+                            const svn_checksum_t *sha1_checksum,
+                            const svn_skel_t *work_items,
+                            apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+  SVN_ERR_ASSERT(sha1_checksum != NULL
+                 && sha1_checksum->kind == svn_checksum_sha1);
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath,
+                                                db, local_abspath,
+                                                scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_WC__DB_WITH_TXN(
+    base_set_fetched(wcroot, local_relpath, sha1_checksum, work_items,
+                     scratch_pool),
+    wcroot);
+
+  /* The checksum is cached by the entries code */
+  SVN_ERR(flush_entries(wcroot, local_abspath, svn_depth_empty,
+                        scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
 /* If EXPRESSION is false, cause the caller to return an SVN_ERR_WC_CORRUPT
  * error, showing EXPRESSION and the caller's LOCAL_RELPATH in the message. */
 #define VERIFY(expression) \
@@ -16060,18 +16385,97 @@ svn_wc__db_bump_format(int *result_format,
   return svn_error_trace(err);
 }
 
+/* Set *VALUE to the integer returned by the PRAGMA statement STMT_IDX
+   in SDB. */
+static svn_error_t *
+read_pragma_int(apr_int64_t *value,
+                svn_sqlite__db_t *sdb,
+                int stmt_idx)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, stmt_idx));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  *value = svn_sqlite__column_int64(stmt, 0);
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
 svn_error_t *
 svn_wc__db_vacuum(svn_wc__db_t *db,
                   const char *local_abspath,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  svn_wc_notify_func2_t notify_func,
+                  void *notify_baton,
                   apr_pool_t *scratch_pool)
 {
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
+  apr_int64_t auto_vacuum;
+  apr_int64_t total;
+  apr_int64_t remaining;
+  apr_pool_t *iterpool;
 
   SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath,
                                                 db, local_abspath,
                                                 scratch_pool, scratch_pool));
-  SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb, STMT_VACUUM));
+
+  if (!db->incremental_vacuum)
+    {
+      SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb, STMT_VACUUM));
+      return SVN_NO_ERROR;
+    }
+
+  /* 2 is INCREMENTAL.  Switching an existing database to that mode only
+     takes effect with the next full vacuum, which also leaves no free
+     pages to release. */
+  SVN_ERR(read_pragma_int(&auto_vacuum, wcroot->sdb,
+                          STMT_PRAGMA_AUTO_VACUUM));
+  if (auto_vacuum != 2)
+    {
+      SVN_ERR(svn_sqlite__exec_statements(
+                wcroot->sdb, STMT_PRAGMA_AUTO_VACUUM_INCREMENTAL));
+      SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb, STMT_VACUUM));
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(read_pragma_int(&total, wcroot->sdb, STMT_PRAGMA_FREELIST_COUNT));
+
+  iterpool = svn_pool_create(scratch_pool);
+  remaining = total;
+  while (remaining > 0)
+    {
+      apr_int64_t previous = remaining;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb,
+                                          STMT_INCREMENTAL_VACUUM));
+      SVN_ERR(read_pragma_int(&remaining, wcroot->sdb,
+                              STMT_PRAGMA_FREELIST_COUNT));
+
+      /* Another client may be using pages as fast as we release them,
+         so stop once a step doesn't help. */
+      if (remaining >= previous)
+        remaining = 0;
+
+      if (notify_func)
+        {
+          svn_wc_notify_t *notify
+            = svn_wc_create_notify(wcroot->abspath,
+                                   svn_wc_notify_cleanup_vacuum_progress,
+                                   iterpool);
+
+          notify->progress = total - MIN(remaining, total);
+          notify->progress_total = total;
+          notify_func(notify_baton, notify, iterpool);
+        }
+    }
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
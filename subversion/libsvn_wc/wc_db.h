@@ -484,7 +484,10 @@ svn_wc__db_base_add_incomplete_directory(svn_wc__db_t *db,
    CHANGED_AUTHOR>.
 
    The checksum of the file contents is given in CHECKSUM. An entry in
-   the pristine text base is NOT required when this API is called.
+   the pristine text base is NOT required when this API is called.  If
+   UNFETCHED is TRUE, CHECKSUM must be NULL and the file is recorded
+   without its text, as done in lazy-fetch working copies; see
+   svn_wc__db_get_lazy_fetch().  Otherwise CHECKSUM must not be NULL.
 
    If DAV_CACHE is not NULL, sets LOCAL_ABSPATH's dav cache to the specified
    data.
@@ -518,6 +521,7 @@ svn_wc__db_base_add_file(svn_wc__db_t *db,
                          apr_time_t changed_date,
                          const char *changed_author,
                          const svn_checksum_t *checksum,
+                         svn_boolean_t unfetched,
                          apr_hash_t *dav_cache,
                          svn_boolean_t delete_working,
                          svn_boolean_t update_actual_props,
@@ -890,6 +894,38 @@ svn_wc__db_base_get_lock_tokens_recursive(apr_hash_t **lock_tokens,
                                           apr_pool_t *result_pool,
                                           apr_pool_t *scratch_pool);
 
+/* Return TRUE if DB is configured to add files from the repository
+   without their text.  Such files are recorded in BASE with a NULL
+   checksum and have no working file until their text is fetched; see
+   svn_wc__db_base_set_fetched().  */
+svn_boolean_t
+svn_wc__db_get_lazy_fetch(svn_wc__db_t *db);
+
+/* Set *LOCAL_ABSPATHS to an array of const char * absolute paths of all
+   BASE files within DEPTH of LOCAL_ABSPATH in DB that were recorded
+   without their text, in no particular order.
+
+   Allocate the array and its items in RESULT_POOL.  */
+svn_error_t *
+svn_wc__db_base_get_unfetched(apr_array_header_t **local_abspaths,
+                              svn_wc__db_t *db,
+                              const char *local_abspath,
+                              svn_depth_t depth,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+/* Record SHA1_CHECKSUM as the checksum of the text of the BASE file
+   LOCAL_ABSPATH, which was recorded without its text.  The pristine text
+   must already be installed.  Queue WORK_ITEMS in the same transaction.
+
+   Return SVN_ERR_WC_PATH_NOT_FOUND if LOCAL_ABSPATH is not such a file.  */
+svn_error_t *
+svn_wc__db_base_set_fetched(svn_wc__db_t *db,
+                            const char *local_abspath,
+                            const svn_checksum_t *sha1_checksum,
+                            const svn_skel_t *work_items,
+                            apr_pool_t *scratch_pool);
+
 /* ### anything else needed for maintaining the BASE tree? */
 
 
@@ -900,7 +936,10 @@ svn_wc__db_base_get_lock_tokens_recursive(apr_hash_t **lock_tokens,
 */
 
 /* Set *PRISTINE_ABSPATH to the path to the pristine text file
-   identified by SHA1_CHECKSUM.  Error if it does not exist.
+   identified by SHA1_CHECKSUM.  Error if it does not exist, or if
+   SHA1_CHECKSUM is NULL as for files added without their text.  A chunked
+   text gets reassembled into a temporary file, which will be removed
+   when RESULT_POOL is cleared.
 
    ### This is temporary - callers should not be looking at the file
    directly.
@@ -925,6 +964,40 @@ svn_wc__db_pristine_get_future_path(const char **pristine_abspath,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
 
+/* Set *CONTENTS to a readable stream of the pristine text identified by
+   SHA1_CHECKSUM in the working copy at WCROOT_ABSPATH, whether it is
+   stored as a file or in chunks.  Like svn_wc__db_pristine_get_future_path()
+   this does not access the database, so it may be used from any thread;
+   the caller must make sure that the text is in the store.
+
+   Allocate the stream in RESULT_POOL. */
+svn_error_t *
+svn_wc__db_pristine_read_future(svn_stream_t **contents,
+                                const char *wcroot_abspath,
+                                const svn_checksum_t *sha1_checksum,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
+
+/* Set *CONTENTS to a readable stream of the pristine text identified by
+   SHA1_CHECKSUM in the shared pristine store of DB, or to NULL if there is
+   no shared store or the text is not in it.
+
+   Allocate the stream in RESULT_POOL. */
+svn_error_t *
+svn_wc__db_pristine_read_shared(svn_stream_t **contents,
+                                svn_wc__db_t *db,
+                                const svn_checksum_t *sha1_checksum,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
+
+/* Return TRUE if DB is configured to detect text modifications by
+   comparing the checksum of the working file with the recorded checksum
+   of its pristine text, rather than by reading the pristine text.  */
+svn_boolean_t
+svn_wc__db_pristine_get_compare_by_checksum(svn_wc__db_t *db);
+
 
 /* If requested set *CONTENTS to a readable stream that will yield the pristine
    text identified by SHA1_CHECKSUM (must be a SHA-1 checksum) within the WC
@@ -1040,10 +1113,23 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
                            apr_pool_t *scratch_pool);
 
 
-/* Remove all unreferenced pristines in the WC of WRI_ABSPATH in DB. */
+/* Remove all unreferenced pristines in the WC of WRI_ABSPATH in DB, and
+   all texts that no working copy uses from the shared pristine store.
+
+   The pristines are removed in a series of short transactions.  After
+   each of them, report the progress to NOTIFY_FUNC with NOTIFY_BATON
+   as svn_wc_notify_cleanup_pristines_progress, if it is not NULL.  The
+   directories of the pristine store are read by several threads.
+
+   If CANCEL_FUNC is not NULL, invoke it with CANCEL_BATON between the
+   steps. */
 svn_error_t *
 svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                             const char *wri_abspath,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            svn_wc_notify_func2_t notify_func,
+                            void *notify_baton,
                             apr_pool_t *scratch_pool);
 
 
@@ -3028,6 +3114,87 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
 
+/* Variant of svn_wc__db_wq_record_and_fetch_next() for running several
+   work items at once.  In one transaction, mark all work items in
+   COMPLETED_IDS (apr_uint64_t) as completed, record the timestamps and
+   sizes in RECORD_MAP (if not NULL) and fetch up to MAX_ITEMS of the
+   remaining work items.
+
+   Set *IDS (apr_uint64_t) and *WORK_ITEMS (svn_skel_t *) to the fetched
+   work items, in the order they were queued.  Both will be empty if there
+   are no work items left or MAX_ITEMS is 0.
+
+   RESULT_POOL will be used to allocate the results, and SCRATCH_POOL
+   will be used for all temporary allocations.  */
+svn_error_t *
+svn_wc__db_wq_record_and_fetch_batch(apr_array_header_t **ids,
+                                     apr_array_header_t **work_items,
+                                     svn_wc__db_t *db,
+                                     const char *wri_abspath,
+                                     const apr_array_header_t *completed_ids,
+                                     apr_hash_t *record_map,
+                                     int max_items,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
+
+/* Return the number of threads that svn_wc__wq_run() may use to install
+   files in the working copies of DB, as configured.  1 means that all
+   work items are run one after the other.  */
+int
+svn_wc__db_wq_get_install_threads(svn_wc__db_t *db);
+
+
+/* @} */
+
+
+/* @defgroup svn_wc__db_batch  Batching changes to many nodes
+   @{
+
+   Recording each node in its own transaction makes checkouts of large
+   trees spend much of their time in SQLite transaction overhead.  Between
+   svn_wc__db_batch_begin() and svn_wc__db_batch_end(), all changes to the
+   working copy containing WRI_ABSPATH are made in batch transactions of up
+   to SVN_CONFIG_OPTION_UPDATE_BATCH_SIZE nodes each.  Every change still
+   runs in its own savepoint, so a failing change is rolled back as usual
+   and the changes before it remain in the batch.
+
+   The disk must not be changed for changes that are not yet committed, so
+   svn_wc__wq_run() commits the batch first.  Callers that change the disk
+   directly have to call svn_wc__db_batch_commit() themselves.
+*/
+
+/* Start batching changes to the working copy containing WRI_ABSPATH.
+   Calls may be nested; batching lasts until the outermost call has been
+   ended by svn_wc__db_batch_end().  */
+svn_error_t *
+svn_wc__db_batch_begin(svn_wc__db_t *db,
+                       const char *wri_abspath,
+                       apr_pool_t *scratch_pool);
+
+/* Tell DB that the changes to another node in the working copy containing
+   WRI_ABSPATH are about to be made.  If batching, open a batch
+   transaction if none is open, or commit the open one and start a new
+   one if it contains as many nodes as configured.  */
+svn_error_t *
+svn_wc__db_batch_node(svn_wc__db_t *db,
+                      const char *wri_abspath,
+                      apr_pool_t *scratch_pool);
+
+/* Commit the open batch transaction of the working copy containing
+   WRI_ABSPATH, if any.  Batching continues with the next call to
+   svn_wc__db_batch_node().  */
+svn_error_t *
+svn_wc__db_batch_commit(svn_wc__db_t *db,
+                        const char *wri_abspath,
+                        apr_pool_t *scratch_pool);
+
+/* End the batching started by the matching svn_wc__db_batch_begin().
+   Commit the open batch transaction when batching stops.  */
+svn_error_t *
+svn_wc__db_batch_end(svn_wc__db_t *db,
+                     const char *wri_abspath,
+                     apr_pool_t *scratch_pool);
+
 
 /* @} */
 
@@ -3447,10 +3614,22 @@ svn_wc__db_base_moved_to(const char **move_dst_abspath,
                          apr_pool_t *scratch_pool);
 
 /* Recover space from the database file for LOCAL_ABSPATH by running
- * the "vacuum" command. */
+ * the "vacuum" command.
+ *
+ * If DB is configured for incremental vacuuming, switch the database to
+ * SQLite's incremental auto-vacuum mode instead, which takes one full
+ * vacuum.  Once it is in that mode, release its free pages in steps of
+ * bounded size, reporting the progress to NOTIFY_FUNC with NOTIFY_BATON
+ * as svn_wc_notify_cleanup_vacuum_progress, if it is not NULL, and
+ * invoking CANCEL_FUNC with CANCEL_BATON between the steps, if it is not
+ * NULL. */
 svn_error_t *
 svn_wc__db_vacuum(svn_wc__db_t *db,
                   const char *local_abspath,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  svn_wc_notify_func2_t notify_func,
+                  void *notify_baton,
                   apr_pool_t *scratch_pool);
 
 /* This raises move-edit tree-conflicts on any moves inside the
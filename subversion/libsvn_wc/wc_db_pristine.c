@@ -25,53 +25,60 @@
 
 #define SVN_WC__I_AM_WC_DB
 
+#include <string.h>
+
+#include <apr_thread_proc.h>
+
 #include "svn_pools.h"
 #include "svn_io.h"
 #include "svn_dirent_uri.h"
+#include "svn_sorts.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
 
 #include "wc.h"
 #include "wc_db.h"
 #include "wc-queries.h"
 #include "wc_db_private.h"
+#include "pristine_chunks.h"
 
 #define PRISTINE_STORAGE_EXT ".svn-base"
 #define PRISTINE_STORAGE_RELPATH "pristine"
 #define PRISTINE_TEMPDIR_RELPATH "tmp"
 
+/* A chunked pristine text has a manifest with this extension instead of
+   its PRISTINE_STORAGE_EXT file.  The chunks are in the PRISTINE_CHUNKS
+   directory of the pristine store.  See pristine_chunks.h. */
+#define PRISTINE_MANIFEST_EXT ".svn-chunks"
+#define PRISTINE_CHUNKS_RELPATH "chunks"
+
 
 
 /* Returns in PRISTINE_ABSPATH a new string allocated from RESULT_POOL,
    holding the local absolute path to the file location that is dedicated
-   to hold CHECKSUM's pristine file, relating to the pristine store
-   configured for the working copy indicated by PDH. The returned path
-   does not necessarily currently exist.
+   to hold CHECKSUM's pristine file in the pristine store directory
+   BASE_DIR_ABSPATH.  The returned path does not necessarily currently
+   exist.
 
    Any other allocations are made in SCRATCH_POOL. */
 static svn_error_t *
-get_pristine_fname(const char **pristine_abspath,
-                   const char *wcroot_abspath,
-                   const svn_checksum_t *sha1_checksum,
-                   apr_pool_t *result_pool,
-                   apr_pool_t *scratch_pool)
+get_pristine_fname_in(const char **pristine_abspath,
+                      const char *base_dir_abspath,
+                      const svn_checksum_t *sha1_checksum,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
 {
-  const char *base_dir_abspath;
   const char *hexdigest = svn_checksum_to_cstring(sha1_checksum, scratch_pool);
   char subdir[3];
 
   /* ### code is in transition. make sure we have the proper data.  */
   SVN_ERR_ASSERT(pristine_abspath != NULL);
-  SVN_ERR_ASSERT(svn_dirent_is_absolute(wcroot_abspath));
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(base_dir_abspath));
   SVN_ERR_ASSERT(sha1_checksum != NULL);
   SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
 
-  base_dir_abspath = svn_dirent_join_many(scratch_pool,
-                                          wcroot_abspath,
-                                          svn_wc_get_adm_dir(scratch_pool),
-                                          PRISTINE_STORAGE_RELPATH,
-                                          SVN_VA_NULL);
-
   /* We should have a valid checksum and (thus) a valid digest. */
   SVN_ERR_ASSERT(hexdigest != NULL);
 
@@ -83,7 +90,7 @@ get_pristine_fname(const char **pristine_abspath,
   hexdigest = apr_pstrcat(scratch_pool, hexdigest, PRISTINE_STORAGE_EXT,
                           SVN_VA_NULL);
 
-  /* The file is located at DIR/.svn/pristine/XX/XXYYZZ...svn-base */
+  /* The file is located at BASE_DIR/XX/XXYYZZ...svn-base */
   *pristine_abspath = svn_dirent_join_many(result_pool,
                                            base_dir_abspath,
                                            subdir,
@@ -92,6 +99,168 @@ get_pristine_fname(const char **pristine_abspath,
   return SVN_NO_ERROR;
 }
 
+/* Like get_pristine_fname_in(), for the pristine store of the working
+   copy at WCROOT_ABSPATH. */
+static svn_error_t *
+get_pristine_fname(const char **pristine_abspath,
+                   const char *wcroot_abspath,
+                   const svn_checksum_t *sha1_checksum,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wcroot_abspath));
+
+  return svn_error_trace(get_pristine_fname_in(
+                           pristine_abspath,
+                           svn_dirent_join_many(
+                             scratch_pool, wcroot_abspath,
+                             svn_wc_get_adm_dir(scratch_pool),
+                             PRISTINE_STORAGE_RELPATH, SVN_VA_NULL),
+                           sha1_checksum, result_pool, scratch_pool));
+}
+
+/* Return the path of the chunk manifest belonging to the pristine file
+   PRISTINE_ABSPATH, as returned by get_pristine_fname(), allocated in
+   RESULT_POOL. */
+static const char *
+get_manifest_fname(const char *pristine_abspath,
+                   apr_pool_t *result_pool)
+{
+  apr_size_t len = strlen(pristine_abspath) - strlen(PRISTINE_STORAGE_EXT);
+
+  return apr_pstrcat(result_pool,
+                     apr_pstrmemdup(result_pool, pristine_abspath, len),
+                     PRISTINE_MANIFEST_EXT, SVN_VA_NULL);
+}
+
+/* Return the directory holding the chunks of the chunked pristine texts
+   of the working copy at WCROOT_ABSPATH, allocated in RESULT_POOL. */
+static const char *
+get_chunks_dir(const char *wcroot_abspath,
+               apr_pool_t *result_pool)
+{
+  return svn_dirent_join_many(result_pool, wcroot_abspath,
+                              svn_wc_get_adm_dir(result_pool),
+                              PRISTINE_STORAGE_RELPATH,
+                              PRISTINE_CHUNKS_RELPATH, SVN_VA_NULL);
+}
+
+/* Set *MATCHES to whether the file at LOCAL_ABSPATH has SIZE bytes and
+   the SHA-1 checksum SHA1_CHECKSUM. */
+static svn_error_t *
+file_has_text(svn_boolean_t *matches,
+              const char *local_abspath,
+              apr_off_t size,
+              const svn_checksum_t *sha1_checksum,
+              apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+  svn_checksum_t *actual_checksum;
+
+  SVN_ERR(svn_io_stat(&finfo, local_abspath, APR_FINFO_SIZE, scratch_pool));
+  if (finfo.size != size)
+    {
+      *matches = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_io_file_checksum2(&actual_checksum, local_abspath,
+                                svn_checksum_sha1, scratch_pool));
+  *matches = svn_checksum_match(actual_checksum, sha1_checksum);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CONTENTS to a readable stream of the pristine text whose file in
+   the pristine store of the working copy at WCROOT_ABSPATH is
+   PRISTINE_ABSPATH, reassembling it from its chunks if it has none.  If
+   neither exists, return the ENOENT error for PRISTINE_ABSPATH.
+
+   Allocate the stream in RESULT_POOL. */
+static svn_error_t *
+pristine_open(svn_stream_t **contents,
+              const char *wcroot_abspath,
+              const char *pristine_abspath,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_error_t *err;
+  svn_error_t *err2;
+
+  /* We don't enable APR_BUFFERED on this file to maximize throughput
+   * e.g. for fulltext comparison.  As we use SVN__STREAM_CHUNK_SIZE buffers
+   * where needed in streams, there is no point in having another layer of
+   * buffers. */
+  err = svn_io_file_open(&file, pristine_abspath, APR_READ, APR_OS_DEFAULT,
+                         result_pool);
+  if (!err)
+    {
+      *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
+      return SVN_NO_ERROR;
+    }
+  else if (!APR_STATUS_IS_ENOENT(err->apr_err))
+    return svn_error_trace(err);
+
+  err2 = svn_wc__pristine_chunks_open(contents,
+                                      get_manifest_fname(pristine_abspath,
+                                                         scratch_pool),
+                                      get_chunks_dir(wcroot_abspath,
+                                                     scratch_pool),
+                                      result_pool, scratch_pool);
+  if (err2 && APR_STATUS_IS_ENOENT(err2->apr_err))
+    {
+      svn_error_clear(err2);
+      return svn_error_trace(err);
+    }
+
+  svn_error_clear(err);
+  return svn_error_trace(err2);
+}
+
+/* Set *FILE_ABSPATH to a file holding the pristine text of WCROOT_ABSPATH
+   stored at PRISTINE_ABSPATH.  That is PRISTINE_ABSPATH itself unless the
+   text is chunked.  Chunked texts get reassembled into a temporary file
+   that will be removed when RESULT_POOL is cleared, so the pristine store
+   never grows by their full size.  Path based users of the pristine store
+   need that. */
+static svn_error_t *
+pristine_materialize(const char **file_abspath,
+                     const char *wcroot_abspath,
+                     const char *pristine_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  svn_node_kind_t kind;
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+
+  SVN_ERR(svn_io_check_path(pristine_abspath, &kind, scratch_pool));
+  if (kind == svn_node_file)
+    {
+      *file_abspath = pristine_abspath;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_wc__pristine_chunks_open(&src_stream,
+                                       get_manifest_fname(pristine_abspath,
+                                                          scratch_pool),
+                                       get_chunks_dir(wcroot_abspath,
+                                                      scratch_pool),
+                                       scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_open_unique(&dst_stream, file_abspath,
+                                 svn_dirent_join_many(
+                                   scratch_pool, wcroot_abspath,
+                                   svn_wc_get_adm_dir(scratch_pool),
+                                   PRISTINE_TEMPDIR_RELPATH, SVN_VA_NULL),
+                                 svn_io_file_del_on_pool_cleanup,
+                                 result_pool, scratch_pool));
+  SVN_ERR(svn_stream_copy3(src_stream, dst_stream, NULL, NULL,
+                           scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_wc__db_pristine_get_path(const char **pristine_abspath,
@@ -107,7 +276,17 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
 
   SVN_ERR_ASSERT(pristine_abspath != NULL);
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
-  SVN_ERR_ASSERT(sha1_checksum != NULL);
+
+  /* Files added without their text have no checksum.  Callers should
+   * catch this, but don't let one that doesn't crash the client. */
+  if (sha1_checksum == NULL)
+    return svn_error_createf(SVN_ERR_WC_PATH_UNEXPECTED_STATUS, NULL,
+                             _("No pristine text is available in '%s'; "
+                               "run 'svn hydrate' if files were added "
+                               "without their text"),
+                             svn_dirent_local_style(wri_abspath,
+                                                    scratch_pool));
+
   /* ### Transitional: accept MD-5 and look up the SHA-1.  Return an error
    * if the pristine text is not in the store. */
   if (sha1_checksum->kind != svn_checksum_sha1)
@@ -133,6 +312,9 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
   SVN_ERR(get_pristine_fname(pristine_abspath, wcroot->abspath,
                              sha1_checksum,
                              result_pool, scratch_pool));
+  SVN_ERR(pristine_materialize(pristine_abspath, wcroot->abspath,
+                               *pristine_abspath,
+                               result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -150,6 +332,61 @@ svn_wc__db_pristine_get_future_path(const char **pristine_abspath,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__db_pristine_read_future(svn_stream_t **contents,
+                                const char *wcroot_abspath,
+                                const svn_checksum_t *sha1_checksum,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  const char *pristine_abspath;
+
+  SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot_abspath,
+                             sha1_checksum,
+                             scratch_pool, scratch_pool));
+  SVN_ERR(pristine_open(contents, wcroot_abspath, pristine_abspath,
+                        result_pool, scratch_pool));
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_pristine_read_shared(svn_stream_t **contents,
+                                svn_wc__db_t *db,
+                                const svn_checksum_t *sha1_checksum,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  const char *shared_abspath;
+  svn_error_t *err;
+
+  *contents = NULL;
+  if (!db->shared_pristine_abspath
+      || sha1_checksum->kind != svn_checksum_sha1)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_pristine_fname_in(&shared_abspath, db->shared_pristine_abspath,
+                                sha1_checksum,
+                                scratch_pool, scratch_pool));
+
+  err = svn_stream_open_readonly(contents, shared_abspath,
+                                 result_pool, scratch_pool);
+  if (err && (APR_STATUS_IS_ENOENT(err->apr_err)
+              || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+    {
+      svn_error_clear(err);
+      *contents = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+svn_boolean_t
+svn_wc__db_pristine_get_compare_by_checksum(svn_wc__db_t *db)
+{
+  return db->compare_by_checksum;
+}
+
 /* Set *CONTENTS to a readable stream from which the pristine text
  * identified by SHA1_CHECKSUM and PRISTINE_ABSPATH can be read from the
  * pristine store of WCROOT.  If SIZE is not null, set *SIZE to the size
@@ -198,18 +435,11 @@ pristine_read_txn(svn_stream_t **contents,
 
   /* Open the file as a readable stream.  It will remain readable even when
    * deleted from disk; APR guarantees that on Windows as well as Unix.
-   *
-   * We also don't enable APR_BUFFERED on this file to maximize throughput
-   * e.g. for fulltext comparison.  As we use SVN__STREAM_CHUNK_SIZE buffers
-   * where needed in streams, there is no point in having another layer of
-   * buffers. */
+   * The chunks of a chunked text are opened one at a time while reading,
+   * but only svn_wc__db_pristine_cleanup() removes chunks. */
   if (contents)
-    {
-      apr_file_t *file;
-      SVN_ERR(svn_io_file_open(&file, pristine_abspath, APR_READ,
-                               APR_OS_DEFAULT, result_pool));
-      *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
-    }
+    SVN_ERR(pristine_open(contents, wcroot->abspath, pristine_abspath,
+                          result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -287,6 +517,12 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
                      const svn_checksum_t *sha1_checksum,
                      /* The pristine text's MD-5 checksum. */
                      const svn_checksum_t *md5_checksum,
+                     /* Where to store the text in chunks, if large, or
+                        NULL to always store it as a single file. */
+                     const char *chunks_dir_abspath,
+                     /* The path of the text in the shared pristine store,
+                        or NULL if there is none. */
+                     const char *shared_abspath,
                      apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
@@ -305,21 +541,23 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
       /* Consistency checks.  Verify both files exist and match.
        * ### We could check much more. */
       {
-        apr_finfo_t finfo1, finfo2;
+        apr_finfo_t finfo1;
+        const svn_io_dirent2_t *dirent2;
 
         SVN_ERR(svn_stream__install_get_info(&finfo1, install_stream, APR_FINFO_SIZE,
                                              scratch_pool));
 
-        SVN_ERR(svn_io_stat(&finfo2, pristine_abspath, APR_FINFO_SIZE,
-                            scratch_pool));
-        if (finfo1.size != finfo2.size)
+        /* Chunked texts have no file. */
+        SVN_ERR(svn_io_stat_dirent2(&dirent2, pristine_abspath, FALSE, TRUE,
+                                    scratch_pool, scratch_pool));
+        if (dirent2->kind == svn_node_file && finfo1.size != dirent2->filesize)
           {
             return svn_error_createf(
               SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
               _("New pristine text '%s' has different size: %s versus %s"),
               svn_checksum_to_cstring_display(sha1_checksum, scratch_pool),
               apr_off_t_toa(scratch_pool, finfo1.size),
-              apr_off_t_toa(scratch_pool, finfo2.size));
+              apr_off_t_toa(scratch_pool, dirent2->filesize));
           }
       }
 #endif
@@ -333,10 +571,58 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
    * an orphan file and it doesn't matter if we overwrite it.) */
   {
     apr_finfo_t finfo;
+    svn_boolean_t chunked;
+    svn_boolean_t linked = FALSE;
+
     SVN_ERR(svn_stream__install_get_info(&finfo, install_stream,
                                          APR_FINFO_SIZE, scratch_pool));
-    SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
-                                       TRUE, scratch_pool));
+    chunked = (chunks_dir_abspath
+               && finfo.size >= SVN_WC__PRISTINE_CHUNKS_MIN_TEXT_SIZE);
+
+    /* If the shared store has this text, link to it instead of keeping
+     * another copy.  If that fails for whatever reason, e.g. because the
+     * shared store is on another volume, just install our own copy.
+     *
+     * Other users of the shared store may have put anything there, so
+     * check what we linked to.  Checking before linking would leave a
+     * window for replacing the file.  Our copy replaces a bad link. */
+    if (shared_abspath && !chunked)
+      {
+        svn_error_t *err;
+
+        err = svn_io_make_dir_recursively(svn_dirent_dirname(pristine_abspath,
+                                                              scratch_pool),
+                                          scratch_pool);
+        if (!err)
+          err = svn_io__file_link(shared_abspath, pristine_abspath,
+                                  scratch_pool);
+        if (!err)
+          err = file_has_text(&linked, pristine_abspath, finfo.size,
+                              sha1_checksum, scratch_pool);
+
+        if (err)
+          linked = FALSE;
+        svn_error_clear(err);
+      }
+
+    if (linked)
+      SVN_ERR(svn_stream__install_delete(install_stream, scratch_pool));
+    else
+      SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
+                                         TRUE, scratch_pool));
+
+    /* Replace large texts by their chunks before recording them, so the
+     * store never has a row for a text that is neither a file nor chunked.
+     * A crash in between just leaves orphan files. */
+    if (chunked)
+      {
+        /* Older clients can't read chunked texts. */
+        SVN_ERR(svn_wc__db_util_require_features(sdb, scratch_pool));
+        SVN_ERR(svn_wc__pristine_chunks_store(
+                  get_manifest_fname(pristine_abspath, scratch_pool),
+                  chunks_dir_abspath, pristine_abspath, scratch_pool));
+        SVN_ERR(svn_io_remove_file2(pristine_abspath, FALSE, scratch_pool));
+      }
 
     SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_PRISTINE));
     SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
@@ -344,7 +630,26 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
     SVN_ERR(svn_sqlite__bind_int64(stmt, 3, finfo.size));
     SVN_ERR(svn_sqlite__insert(NULL, stmt));
 
-    SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE, scratch_pool));
+    if (!chunked && !linked)
+      {
+        SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE,
+                                          scratch_pool));
+
+        /* Offer our copy to the shared store.  Other processes may be
+         * doing the same, but only one link can be created. */
+        if (shared_abspath)
+          {
+            svn_error_t *err;
+
+            err = svn_io_make_dir_recursively(
+                    svn_dirent_dirname(shared_abspath, scratch_pool),
+                    scratch_pool);
+            if (!err)
+              err = svn_io__file_link(pristine_abspath, shared_abspath,
+                                      scratch_pool);
+            svn_error_clear(err);
+          }
+      }
   }
 
   return SVN_NO_ERROR;
@@ -354,6 +659,12 @@ struct svn_wc__db_install_data_t
 {
   svn_wc__db_wcroot_t *wcroot;
   svn_stream_t *inner_stream;
+
+  /* Store large texts in chunks? */
+  svn_boolean_t chunked;
+
+  /* The shared pristine store or NULL. */
+  const char *shared_store_abspath;
 };
 
 svn_error_t *
@@ -380,6 +691,8 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
 
   *install_data = apr_pcalloc(result_pool, sizeof(**install_data));
   (*install_data)->wcroot = wcroot;
+  (*install_data)->chunked = db->pristine_chunking;
+  (*install_data)->shared_store_abspath = db->shared_pristine_abspath;
 
   SVN_ERR_W(svn_stream__create_for_install(stream,
                                            temp_dir_abspath,
@@ -389,11 +702,12 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
   (*install_data)->inner_stream = *stream;
 
   if (md5_checksum)
-    *stream = svn_stream_checksummed2(*stream, NULL, md5_checksum,
-                                      svn_checksum_md5, FALSE, result_pool);
-  if (sha1_checksum)
-    *stream = svn_stream_checksummed2(*stream, NULL, sha1_checksum,
-                                      svn_checksum_sha1, FALSE, result_pool);
+    *stream = svn_checksum__wrap_write_stream_md5_sha1(md5_checksum,
+                                                       sha1_checksum,
+                                                       *stream, result_pool);
+  else if (sha1_checksum)
+    *stream = svn_checksum__wrap_write_stream(sha1_checksum, *stream,
+                                              svn_checksum_sha1, result_pool);
 
   return SVN_NO_ERROR;
 }
@@ -406,6 +720,7 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
 {
   svn_wc__db_wcroot_t *wcroot = install_data->wcroot;
   const char *pristine_abspath;
+  const char *shared_abspath = NULL;
 
   SVN_ERR_ASSERT(sha1_checksum != NULL);
   SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
@@ -415,15 +730,24 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
   SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
                              sha1_checksum,
                              scratch_pool, scratch_pool));
+  if (install_data->shared_store_abspath)
+    SVN_ERR(get_pristine_fname_in(&shared_abspath,
+                                  install_data->shared_store_abspath,
+                                  sha1_checksum,
+                                  scratch_pool, scratch_pool));
 
   /* Ensure the SQL txn has at least a 'RESERVED' lock before we start looking
    * at the disk, to ensure no concurrent pristine install/delete txn. */
-  SVN_SQLITE__WITH_IMMEDIATE_TXN(
+  SVN_WC__DB_WITH_IMMEDIATE_TXN(
     pristine_install_txn(wcroot->sdb,
                          install_data->inner_stream, pristine_abspath,
                          sha1_checksum, md5_checksum,
+                         install_data->chunked
+                           ? get_chunks_dir(wcroot->abspath, scratch_pool)
+                           : NULL,
+                         shared_abspath,
                          scratch_pool),
-    wcroot->sdb);
+    wcroot);
 
   return SVN_NO_ERROR;
 }
@@ -555,8 +879,8 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
   SVN_ERR(get_pristine_fname(&src_abspath, src_wcroot->abspath, checksum,
                              scratch_pool, scratch_pool));
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, src_abspath,
-                                   scratch_pool, scratch_pool));
+  SVN_ERR(pristine_open(&src_stream, src_wcroot->abspath, src_abspath,
+                        scratch_pool, scratch_pool));
 
   /* ### Should we verify the SHA1 or MD5 here, or is that too expensive? */
   SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
@@ -721,6 +1045,20 @@ pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
 #else
       svn_boolean_t ignore_enoent = TRUE;
 #endif
+      const char *manifest_abspath = get_manifest_fname(pristine_abspath,
+                                                        scratch_pool);
+      svn_node_kind_t kind;
+
+      /* A chunked text has a manifest instead of a file, unless chunking
+       * got interrupted.  Its chunks may be shared and are left to the
+       * next cleanup. */
+      SVN_ERR(svn_io_check_path(manifest_abspath, &kind, scratch_pool));
+      if (kind == svn_node_file)
+        {
+          SVN_ERR(svn_io_remove_file2(manifest_abspath, FALSE,
+                                      scratch_pool));
+          ignore_enoent = TRUE;
+        }
 
       SVN_ERR(svn_io_remove_file2(pristine_abspath, ignore_enoent,
                                   scratch_pool));
@@ -746,10 +1084,10 @@ pristine_remove_if_unreferenced(svn_wc__db_wcroot_t *wcroot,
 
   /* Ensure the SQL txn has at least a 'RESERVED' lock before we start looking
    * at the disk, to ensure no concurrent pristine install/delete txn. */
-  SVN_SQLITE__WITH_IMMEDIATE_TXN(
+  SVN_WC__DB_WITH_IMMEDIATE_TXN(
     pristine_remove_if_unreferenced_txn(
       wcroot->sdb, wcroot, sha1_checksum, pristine_abspath, scratch_pool),
-    wcroot->sdb);
+    wcroot);
 
   return SVN_NO_ERROR;
 }
@@ -798,6 +1136,52 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
 }
 
 
+/* Maximum time to spend removing pristine texts in one transaction.
+ * Keeping the transactions short lets other clients access the working
+ * copy in between, and lets cleanup report progress and be cancelled. */
+#define PRISTINE_CLEANUP_STEP_TIME apr_time_from_msec(200)
+
+/* Remove the pristine texts in WCROOT whose SHA-1 checksums are in
+ * CHECKSUMS, starting at index *NEXT, if they are still unreferenced.
+ * Stop when all are done or PRISTINE_CLEANUP_STEP_TIME has passed and
+ * set *NEXT to the index of the first text not done.
+ *
+ * This function expects to be executed inside a SQLite txn that has already
+ * acquired a 'RESERVED' lock.
+ */
+static svn_error_t *
+pristine_cleanup_step_txn(int *next,
+                          svn_wc__db_wcroot_t *wcroot,
+                          const apr_array_header_t *checksums,
+                          apr_pool_t *scratch_pool)
+{
+  apr_time_t deadline = apr_time_now() + PRISTINE_CLEANUP_STEP_TIME;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  /* Remove at least one text per step. */
+  do
+    {
+      const svn_checksum_t *sha1_checksum
+        = APR_ARRAY_IDX(checksums, *next, const svn_checksum_t *);
+      const char *pristine_abspath;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                                 sha1_checksum, iterpool, iterpool));
+      SVN_ERR(pristine_remove_if_unreferenced_txn(wcroot->sdb, wcroot,
+                                                  sha1_checksum,
+                                                  pristine_abspath,
+                                                  iterpool));
+      ++*next;
+    }
+  while (*next < checksums->nelts && apr_time_now() < deadline);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Remove all unreferenced pristines in the WC DB in WCROOT.
  *
  * Look for pristine texts whose 'refcount' in the DB is zero, and remove
@@ -828,44 +1212,403 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
  *         in the DB, and delete them.
  *
  * TODO: Provide feedback about any errors found and any corrections made.
+ *
+ * The texts are removed in transactions of at most
+ * PRISTINE_CLEANUP_STEP_TIME each, reporting the progress to NOTIFY_FUNC
+ * with NOTIFY_BATON after each one if it is not NULL.  If CANCEL_FUNC is
+ * not NULL, invoke it with CANCEL_BATON before each transaction.
  */
 static svn_error_t *
 pristine_cleanup_wcroot(svn_wc__db_wcroot_t *wcroot,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        svn_wc_notify_func2_t notify_func,
+                        void *notify_baton,
                         apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
-  svn_error_t *err = NULL;
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_boolean_t have_row;
+  apr_array_header_t *checksums;
+  apr_pool_t *iterpool;
+  int next = 0;
 
-  /* Find each unreferenced pristine in the DB and remove it. */
+  /* Find all unreferenced pristines first, so that no statement stays
+   * active across the transactions that remove them. */
+  checksums = apr_array_make(scratch_pool, 0, sizeof(const svn_checksum_t *));
   SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
                                     STMT_SELECT_UNREFERENCED_PRISTINES));
-  while (! err)
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
     {
-      svn_boolean_t have_row;
       const svn_checksum_t *sha1_checksum;
+      svn_error_t *err = svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
+                                                     scratch_pool);
+      if (err)
+        return svn_error_compose_create(err, svn_sqlite__reset(stmt));
 
+      APR_ARRAY_PUSH(checksums, const svn_checksum_t *) = sha1_checksum;
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  iterpool = svn_pool_create(scratch_pool);
+  while (next < checksums->nelts)
+    {
       svn_pool_clear(iterpool);
 
-      SVN_ERR(svn_sqlite__step(&have_row, stmt));
-      if (! have_row)
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_WC__DB_WITH_IMMEDIATE_TXN(
+        pristine_cleanup_step_txn(&next, wcroot, checksums, iterpool),
+        wcroot);
+
+      if (notify_func)
+        {
+          svn_wc_notify_t *notify
+            = svn_wc_create_notify(wcroot->abspath,
+                                   svn_wc_notify_cleanup_pristines_progress,
+                                   iterpool);
+
+          notify->progress = next;
+          notify->progress_total = checksums->nelts;
+          notify_func(notify_baton, notify, iterpool);
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/*** Reading the pristine store directories in parallel ***/
+
+/* Number of threads reading the subdirectories of a pristine store. */
+#define STORE_SCAN_THREADS 4
+
+/* A subdirectory of a pristine store, as read by read_store_dirs(). */
+typedef struct store_dir_t
+{
+  /* The directory. */
+  const char *abspath;
+
+  /* Its entries as returned by svn_io_get_dirents3(), allocated in POOL,
+   * and the error that returned, if any. */
+  apr_hash_t *names;
+  svn_error_t *err;
+
+  /* Not shared with any other directory, so that any thread may read
+   * this one. */
+  apr_pool_t *pool;
+} store_dir_t;
+
+/* The directories being read by the threads of read_store_dirs(). */
+typedef struct store_scan_t
+{
+  /* The store_dir_t * to read. */
+  apr_array_header_t *dirs;
+
+  /* Index of the next directory to read. */
+  volatile svn_atomic_t next;
+} store_scan_t;
+
+/* Read the directories in SCAN until there are none left. */
+static void
+run_store_scan(store_scan_t *scan)
+{
+  while (TRUE)
+    {
+      apr_uint32_t i = svn_atomic_inc(&scan->next);
+      store_dir_t *dir;
+
+      if (i >= (apr_uint32_t)scan->dirs->nelts)
         break;
 
-      SVN_ERR(svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
-                                          iterpool));
-      err = pristine_remove_if_unreferenced(wcroot, sha1_checksum,
-                                            iterpool);
+      dir = APR_ARRAY_IDX(scan->dirs, i, store_dir_t *);
+      dir->err = svn_io_get_dirents3(&dir->names, dir->abspath, TRUE,
+                                     dir->pool, dir->pool);
     }
+}
+
+#if APR_HAS_THREADS
+
+/* Thread function of the additional store readers.  DATA is the
+ * store_scan_t to work on. */
+static void * APR_THREAD_FUNC
+store_scan_worker(apr_thread_t *thread,
+                  void *data)
+{
+  run_store_scan(data);
+  apr_thread_exit(thread, APR_SUCCESS);
+
+  return NULL;
+}
+
+#endif
 
+/* Implements apr_pool_cleanup_t.  Destroy the pool DATA. */
+static apr_status_t
+destroy_store_dir_pool(void *data)
+{
+  svn_pool_destroy(data);
+  return APR_SUCCESS;
+}
+
+/* Set *DIRS to an array of store_dir_t * describing the subdirectories
+ * of the pristine store at STORE_ABSPATH, i.e. those with two character
+ * names, and read all of them using up to STORE_SCAN_THREADS threads.
+ * If any of them could not be read, return the first error.
+ *
+ * Allocate the result in RESULT_POOL.
+ */
+static svn_error_t *
+read_store_dirs(apr_array_header_t **dirs,
+                const char *store_abspath,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  store_scan_t scan;
+  apr_hash_t *subdirs;
+  apr_hash_index_t *hi;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+#if APR_HAS_THREADS
+  apr_pool_t *threads_pool = NULL;
+  apr_array_header_t *threads = NULL;
+#endif
+
+  SVN_ERR(svn_io_get_dirents3(&subdirs, store_abspath, TRUE,
+                              scratch_pool, scratch_pool));
+
+  scan.dirs = apr_array_make(result_pool, apr_hash_count(subdirs),
+                             sizeof(store_dir_t *));
+  scan.next = 0;
+
+  for (hi = apr_hash_first(scratch_pool, subdirs); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+      store_dir_t *dir;
+
+      if (strlen(name) != 2 || dirent->kind != svn_node_dir)
+        continue;
+
+      dir = apr_pcalloc(result_pool, sizeof(*dir));
+      dir->abspath = svn_dirent_join(store_abspath, name, result_pool);
+
+      /* The results live as long as RESULT_POOL. */
+      dir->pool = svn_pool_create(NULL);
+      apr_pool_cleanup_register(result_pool, dir->pool,
+                                destroy_store_dir_pool,
+                                apr_pool_cleanup_null);
+
+      APR_ARRAY_PUSH(scan.dirs, store_dir_t *) = dir;
+    }
+
+#if APR_HAS_THREADS
+  /* The calling thread will be one of the readers. */
+  if (scan.dirs->nelts > 1)
+    {
+      int thread_count = MIN(STORE_SCAN_THREADS, scan.dirs->nelts) - 1;
+
+      /* The threads release their memory to this pool upon exit,
+       * so keep it independent from SCRATCH_POOL. */
+      threads_pool = svn_pool_create(NULL);
+      threads = apr_array_make(scratch_pool, thread_count,
+                               sizeof(apr_thread_t *));
+
+      for (i = 0; i < thread_count; ++i)
+        {
+          apr_thread_t *thread;
+
+          /* If we can't start more threads, we simply read the
+           * remaining directories with the ones we already have. */
+          if (apr_thread_create(&thread, NULL, store_scan_worker, &scan,
+                                threads_pool))
+            break;
+
+          APR_ARRAY_PUSH(threads, apr_thread_t *) = thread;
+        }
+    }
+#endif
+
+  run_store_scan(&scan);
+
+#if APR_HAS_THREADS
+  if (threads)
+    {
+      for (i = 0; i < threads->nelts; ++i)
+        {
+          apr_status_t retval;
+          apr_thread_join(&retval, APR_ARRAY_IDX(threads, i,
+                                                 apr_thread_t *));
+        }
+
+      svn_pool_destroy(threads_pool);
+    }
+#endif
+
+  for (i = 0; i < scan.dirs->nelts; ++i)
+    {
+      store_dir_t *dir = APR_ARRAY_IDX(scan.dirs, i, store_dir_t *);
+
+      if (!err)
+        err = dir->err;
+      else
+        svn_error_clear(dir->err);
+      dir->err = SVN_NO_ERROR;
+    }
+
+  *dirs = scan.dirs;
+
+  return svn_error_trace(err);
+}
+
+/* Remove the chunks that no chunked pristine text in WCROOT uses any
+ * more, and the files of chunked texts left behind by interrupted
+ * chunking.  This must only run under a write lock on all of WCROOT.
+ */
+static svn_error_t *
+pristine_cleanup_chunks(svn_wc__db_wcroot_t *wcroot,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *scratch_pool)
+{
+  const char *chunks_dir_abspath = get_chunks_dir(wcroot->abspath,
+                                                  scratch_pool);
+  const char *base_dir_abspath = svn_dirent_dirname(chunks_dir_abspath,
+                                                    scratch_pool);
+  apr_size_t ext_len = strlen(PRISTINE_MANIFEST_EXT);
+  apr_hash_t *referenced = apr_hash_make(scratch_pool);
+  apr_array_header_t *dirs;
+  apr_pool_t *iterpool;
+  svn_node_kind_t kind;
+  int i;
+
+  /* Nothing to do for working copies that never stored chunks. */
+  SVN_ERR(svn_io_check_path(chunks_dir_abspath, &kind, scratch_pool));
+  if (kind != svn_node_dir)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(read_store_dirs(&dirs, base_dir_abspath, scratch_pool,
+                          scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < dirs->nelts; ++i)
+    {
+      const store_dir_t *dir = APR_ARRAY_IDX(dirs, i, const store_dir_t *);
+      apr_hash_index_t *hi;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      for (hi = apr_hash_first(iterpool, dir->names); hi;
+           hi = apr_hash_next(hi))
+        {
+          const char *name = apr_hash_this_key(hi);
+          apr_size_t len = strlen(name);
+          const char *pristine_name;
+
+          if (len <= ext_len
+              || strcmp(name + len - ext_len, PRISTINE_MANIFEST_EXT))
+            continue;
+
+          SVN_ERR(svn_wc__pristine_chunks_collect(
+                    referenced,
+                    svn_dirent_join(dir->abspath, name, iterpool),
+                    iterpool));
+
+          pristine_name = apr_pstrcat(iterpool,
+                                      apr_pstrmemdup(iterpool, name,
+                                                     len - ext_len),
+                                      PRISTINE_STORAGE_EXT, SVN_VA_NULL);
+          SVN_ERR(svn_io_remove_file2(svn_dirent_join(dir->abspath,
+                                                      pristine_name,
+                                                      iterpool),
+                                      TRUE, iterpool));
+        }
+    }
   svn_pool_destroy(iterpool);
 
-  return svn_error_trace(
-      svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+  SVN_ERR(svn_wc__pristine_chunks_sweep(chunks_dir_abspath, referenced,
+                                        scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the texts that no working copy uses any more from the shared
+ * pristine store at STORE_ABSPATH.  Working copies link to the texts, so
+ * a text is unused if this is its only link.
+ *
+ * Another process may link to a text right before it gets removed here.
+ * That is fine: the working copy keeps the text, only the shared store
+ * no longer has it.
+ */
+static svn_error_t *
+shared_store_vacuum(const char *store_abspath,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *dirs;
+  apr_pool_t *iterpool;
+  svn_error_t *err;
+  int i;
+
+  err = read_store_dirs(&dirs, store_abspath, scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < dirs->nelts; ++i)
+    {
+      const store_dir_t *dir = APR_ARRAY_IDX(dirs, i, const store_dir_t *);
+      apr_hash_index_t *hi;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      for (hi = apr_hash_first(iterpool, dir->names); hi;
+           hi = apr_hash_next(hi))
+        {
+          const char *text_abspath = svn_dirent_join(dir->abspath,
+                                                     apr_hash_this_key(hi),
+                                                     iterpool);
+          apr_finfo_t finfo;
+
+          /* Another cleanup may be vacuuming the store as well. */
+          err = svn_io_stat(&finfo, text_abspath, APR_FINFO_NLINK, iterpool);
+          if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+            {
+              svn_error_clear(err);
+              continue;
+            }
+          SVN_ERR(err);
+
+          if (finfo.nlink == 1)
+            SVN_ERR(svn_io_remove_file2(text_abspath, TRUE, iterpool));
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
 svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                             const char *wri_abspath,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            svn_wc_notify_func2_t notify_func,
+                            void *notify_baton,
                             apr_pool_t *scratch_pool)
 {
   svn_wc__db_wcroot_t *wcroot;
@@ -877,7 +1620,13 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                               wri_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
-  SVN_ERR(pristine_cleanup_wcroot(wcroot, scratch_pool));
+  SVN_ERR(pristine_cleanup_wcroot(wcroot, cancel_func, cancel_baton,
+                                  notify_func, notify_baton, scratch_pool));
+  SVN_ERR(pristine_cleanup_chunks(wcroot, cancel_func, cancel_baton,
+                                  scratch_pool));
+  if (db->shared_pristine_abspath)
+    SVN_ERR(shared_store_vacuum(db->shared_pristine_abspath,
+                                cancel_func, cancel_baton, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -937,8 +1686,15 @@ svn_wc__db_pristine_check(svn_boolean_t *present,
       return svn_error_trace(err);
     else if (kind_on_disk != svn_node_file)
       {
-        *present = FALSE;
-        return SVN_NO_ERROR;
+        /* Maybe it is chunked? */
+        SVN_ERR(svn_io_check_path(get_manifest_fname(pristine_abspath,
+                                                     scratch_pool),
+                                  &kind_on_disk, scratch_pool));
+        if (kind_on_disk != svn_node_file)
+          {
+            *present = FALSE;
+            return SVN_NO_ERROR;
+          }
       }
   }
 
@@ -52,6 +52,30 @@ struct svn_wc__db_t {
   /* Busy timeout in ms., 0 for the libsvn_subr default. */
   apr_int32_t timeout;
 
+  /* Threads to install files with in the work queue, 1 for none. */
+  int install_threads;
+
+  /* Maximum number of nodes per batch transaction, 0 for no batching.
+     See svn_wc__db_batch_begin(). */
+  int batch_size;
+
+  /* Store large pristine texts in chunks?  See pristine_chunks.h. */
+  svn_boolean_t pristine_chunking;
+
+  /* The pristine store shared by the working copies of this user, whose
+     texts are hard-linked into theirs, or NULL. */
+  const char *shared_pristine_abspath;
+
+  /* Detect text modifications by checksum rather than by reading the
+     pristine text?  See svn_wc__internal_file_modified_p(). */
+  svn_boolean_t compare_by_checksum;
+
+  /* Release unused database space in steps?  See svn_wc__db_vacuum(). */
+  svn_boolean_t incremental_vacuum;
+
+  /* Add files without their text?  See svn_wc__db_get_lazy_fetch(). */
+  svn_boolean_t lazy_fetch;
+
   /* Map a given working copy directory to its relevant data.
      const char *local_abspath -> svn_wc__db_wcroot_t *wcroot  */
   apr_hash_t *dir_data;
@@ -107,6 +131,13 @@ typedef struct svn_wc__db_wcroot_t {
      const char *local_abspath -> svn_wc_adm_access_t *adm_access */
   apr_hash_t *access_cache;
 
+  /* Number of svn_wc__db_batch_begin() calls not yet ended. */
+  int batch_depth;
+
+  /* Number of nodes recorded in the open batch transaction, or -1 if
+     there is no open batch transaction. */
+  int batch_nodes;
+
 } svn_wc__db_wcroot_t;
 
 
@@ -152,10 +183,13 @@ svn_wc__db_wcroot_parse_local_abspath(svn_wc__db_wcroot_t **wcroot,
 svn_error_t *
 svn_wc__db_verify_no_work(svn_sqlite__db_t *sdb);
 
-/* Assert that the given WCROOT is usable.
+/* Assert that the given WCROOT is usable, i.e. that it has the current
+   format, with or without the features that older clients don't know.
    NOTE: the expression is multiply-evaluated!!  */
 #define VERIFY_USABLE_WCROOT(wcroot)  SVN_ERR_ASSERT(               \
-    (wcroot) != NULL && (wcroot)->format == SVN_WC__VERSION)
+    (wcroot) != NULL                                                \
+    && ((wcroot)->format == SVN_WC__VERSION                         \
+        || (wcroot)->format == SVN_WC__FEATURES_VERSION))
 
 /* Check if the WCROOT is usable for light db operations such as path
    calculations */
@@ -216,6 +250,14 @@ svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool);
 
+/* Give the working copy database SDB the format SVN_WC__FEATURES_VERSION,
+ * so that older clients refuse it, unless it has that already.  Call this
+ * in the transaction that first makes use of a feature they don't know
+ * about. */
+svn_error_t *
+svn_wc__db_util_require_features(svn_sqlite__db_t *sdb,
+                                 apr_pool_t *scratch_pool);
+
 /* Like svn_wc__db_wq_add() but taking WCROOT */
 svn_error_t *
 svn_wc__db_wq_add_internal(svn_wc__db_wcroot_t *wcroot,
@@ -394,6 +436,21 @@ svn_wc__db_mark_conflict_internal(svn_wc__db_wcroot_t *wcroot,
 #define SVN_WC__DB_WITH_TXN4(expr1, expr2, expr3, expr4, wcroot) \
   SVN_SQLITE__WITH_LOCK4(expr1, expr2, expr3, expr4, (wcroot)->sdb)
 
+/* Like SVN_WC__DB_WITH_TXN(), but take out a 'RESERVED' lock immediately.
+ *
+ * A batch transaction (see svn_wc__db_batch_begin()) already holds that
+ * lock, so within one evaluate EXPR in a savepoint of the batch instead.
+ */
+#define SVN_WC__DB_WITH_IMMEDIATE_TXN(expr, wcroot)                        \
+  do {                                                                    \
+    svn_wc__db_wcroot_t *svn_wc__db_wcroot = (wcroot);                    \
+                                                                          \
+    if (svn_wc__db_wcroot->batch_nodes >= 0)                              \
+      SVN_SQLITE__WITH_LOCK(expr, svn_wc__db_wcroot->sdb);                \
+    else                                                                  \
+      SVN_SQLITE__WITH_IMMEDIATE_TXN(expr, svn_wc__db_wcroot->sdb);       \
+  } while (0)
+
 /* Update the single op-depth layer in the move destination subtree
    rooted at DST_RELPATH to make it match the move source subtree
    rooted at SRC_RELPATH. */
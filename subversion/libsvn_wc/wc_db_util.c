@@ -75,6 +75,20 @@ svn_wc__db_util_fetch_wc_id(apr_int64_t *wc_id,
 }
 
 
+svn_error_t *
+svn_wc__db_util_require_features(svn_sqlite__db_t *sdb,
+                                 apr_pool_t *scratch_pool)
+{
+  int format;
+
+  SVN_ERR(svn_sqlite__read_schema_version(&format, sdb, scratch_pool));
+  if (format < SVN_WC__FEATURES_VERSION)
+    SVN_ERR(svn_sqlite__exec_statements(sdb, STMT_UPGRADE_TO_32));
+
+  return SVN_NO_ERROR;
+}
+
+
 
 
 /* An SQLite application defined function that allows SQL queries to
@@ -43,6 +43,12 @@
 #define UNKNOWN_WC_ID ((apr_int64_t) -1)
 #define FORMAT_FROM_SDB (-1)
 
+/* Upper limit for SVN_CONFIG_OPTION_INSTALL_THREADS. */
+#define MAX_INSTALL_THREADS 64
+
+/* Default for SVN_CONFIG_OPTION_UPDATE_BATCH_SIZE. */
+#define DEFAULT_BATCH_SIZE 256
+
 /* #define VERIFY_ON_CLOSE */
 
 /* Get the format version from a wc-1 directory. If it is not a working copy
@@ -232,6 +238,8 @@ svn_wc__db_open(svn_wc__db_t **db,
   (*db)->verify_format = !open_without_upgrade;
   (*db)->enforce_empty_wq = enforce_empty_wq;
   (*db)->dir_data = apr_hash_make(result_pool);
+  (*db)->install_threads = 1;
+  (*db)->batch_size = DEFAULT_BATCH_SIZE;
 
   (*db)->state_pool = result_pool;
 
@@ -241,6 +249,13 @@ svn_wc__db_open(svn_wc__db_t **db,
       svn_error_t *err;
       svn_boolean_t sqlite_exclusive = FALSE;
       apr_int64_t timeout;
+      apr_int64_t install_threads;
+      apr_int64_t batch_size;
+      svn_boolean_t pristine_chunking;
+      const char *shared_store;
+      svn_boolean_t compare_by_checksum;
+      svn_boolean_t incremental_vacuum;
+      svn_boolean_t lazy_fetch;
 
       err = svn_config_get_bool(config, &sqlite_exclusive,
                                 SVN_CONFIG_SECTION_WORKING_COPY,
@@ -261,6 +276,76 @@ svn_wc__db_open(svn_wc__db_t **db,
         svn_error_clear(err);
       else
         (*db)->timeout = (apr_int32_t)timeout;
+
+      err = svn_config_get_int64(config, &install_threads,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_INSTALL_THREADS,
+                                 1);
+      if (err || install_threads < 1 || install_threads > MAX_INSTALL_THREADS)
+        svn_error_clear(err);
+      else
+        (*db)->install_threads = (int)install_threads;
+
+      err = svn_config_get_int64(config, &batch_size,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_UPDATE_BATCH_SIZE,
+                                 DEFAULT_BATCH_SIZE);
+      if (err || batch_size < 0 || batch_size > APR_INT32_MAX)
+        svn_error_clear(err);
+      else
+        (*db)->batch_size = (int)batch_size;
+
+      err = svn_config_get_bool(config, &pristine_chunking,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_PRISTINE_CHUNKING,
+                                FALSE);
+      if (err)
+        svn_error_clear(err);
+      else
+        (*db)->pristine_chunking = pristine_chunking;
+
+      svn_config_get(config, &shared_store,
+                     SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE, NULL);
+      if (shared_store && *shared_store)
+        {
+          err = svn_dirent_get_absolute(&(*db)->shared_pristine_abspath,
+                                        svn_dirent_internal_style(
+                                          shared_store, scratch_pool),
+                                        result_pool);
+          if (err)
+            {
+              svn_error_clear(err);
+              (*db)->shared_pristine_abspath = NULL;
+            }
+        }
+
+      err = svn_config_get_bool(config, &compare_by_checksum,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_COMPARE_BY_CHECKSUM,
+                                FALSE);
+      if (err)
+        svn_error_clear(err);
+      else
+        (*db)->compare_by_checksum = compare_by_checksum;
+
+      err = svn_config_get_bool(config, &incremental_vacuum,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_INCREMENTAL_VACUUM,
+                                FALSE);
+      if (err)
+        svn_error_clear(err);
+      else
+        (*db)->incremental_vacuum = incremental_vacuum;
+
+      err = svn_config_get_bool(config, &lazy_fetch,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_LAZY_FETCH,
+                                FALSE);
+      if (err)
+        svn_error_clear(err);
+      else
+        (*db)->lazy_fetch = lazy_fetch;
     }
 
   return SVN_NO_ERROR;
@@ -321,7 +406,7 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
     }
 
   /* If this working copy is from a future version, then bail out.  */
-  if (format > SVN_WC__VERSION)
+  if (format > SVN_WC__VERSION && format != SVN_WC__FEATURES_VERSION)
     {
       return svn_error_createf(
         SVN_ERR_WC_UNSUPPORTED_FORMAT, NULL,
@@ -377,6 +462,8 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
   (*wcroot)->owned_locks = apr_array_make(result_pool, 8,
                                           sizeof(svn_wc__db_wclock_t));
   (*wcroot)->access_cache = apr_hash_make(result_pool);
+  (*wcroot)->batch_depth = 0;
+  (*wcroot)->batch_nodes = -1;
 
   /* SDB will be NULL for pre-NG working copies. We only need to run a
      cleanup when the SDB is present.  */
@@ -22,6 +22,7 @@
  */
 
 #include <apr_pools.h>
+#include <apr_thread_proc.h>
 
 #include "svn_private_config.h"
 #include "svn_types.h"
@@ -40,6 +41,8 @@
 
 #include "private/svn_io_private.h"
 #include "private/svn_skel.h"
+#include "private/svn_mutex.h"
+#include "private/svn_thread_cond.h"
 
 
 /* Workqueue operation names.  */
@@ -84,6 +87,11 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
                         svn_boolean_t ignore_enoent,
                         apr_pool_t *scratch_pool);
 
+static void
+record_fileinfo(work_item_baton_t *wqb,
+                const char *local_abspath,
+                const svn_io_dirent2_t *dirent);
+
 /* ------------------------------------------------------------------------ */
 /* OP_REMOVE_BASE  */
 
@@ -445,46 +453,69 @@ svn_wc__wq_build_postupgrade(svn_skel_t **work_item,
 
 /* OP_FILE_INSTALL */
 
-/* Process the OP_FILE_INSTALL work item WORK_ITEM.
- * See svn_wc__wq_build_file_install() which generates this work item.
- * Implements (struct work_item_dispatch).func. */
+/* Everything needed to install a file, as read from the working copy
+   database by prepare_file_install().  install_file() then only works on
+   the filesystem, so it can run in a worker thread. */
+typedef struct file_install_t
+{
+  /* The file to install and the file to install it from, or if that is
+     NULL, the pristine text in the working copy WCROOT_ABSPATH. */
+  const char *local_abspath;
+  const char *source_abspath;
+  const char *wcroot_abspath;
+  const svn_checksum_t *checksum;
+
+  /* Translation of the source.  Install a special file if SPECIAL. */
+  svn_subst_eol_style_t style;
+  const char *eol;
+  apr_hash_t *keywords;
+  svn_boolean_t special;
+
+  /* Where to create the temporary file. */
+  const char *temp_dir_abspath;
+
+  /* Tweaks of the installed file.  Don't set its time if SET_TIME is 0. */
+  svn_boolean_t executable;
+  svn_boolean_t read_only;
+  apr_time_t set_time;
+
+  /* Stat the installed file into DIRENT for recording its size and
+     timestamp. */
+  svn_boolean_t record_fileinfo;
+  const svn_io_dirent2_t *dirent;
+} file_install_t;
+
+/* Set *INSTALL for the OP_FILE_INSTALL work item WORK_ITEM, reading all
+ * information from DB.  Allocate *INSTALL in RESULT_POOL. */
 static svn_error_t *
-run_file_install(work_item_baton_t *wqb,
-                 svn_wc__db_t *db,
-                 const svn_skel_t *work_item,
-                 const char *wri_abspath,
-                 svn_cancel_func_t cancel_func,
-                 void *cancel_baton,
-                 apr_pool_t *scratch_pool)
+prepare_file_install(file_install_t **install,
+                     svn_wc__db_t *db,
+                     const svn_skel_t *work_item,
+                     const char *wri_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
 {
   const svn_skel_t *arg1 = work_item->children->next;
   const svn_skel_t *arg4 = arg1->next->next->next;
+  file_install_t *result = apr_pcalloc(result_pool, sizeof(*result));
   const char *local_relpath;
   const char *local_abspath;
   svn_boolean_t use_commit_times;
-  svn_boolean_t record_fileinfo;
-  svn_boolean_t special;
-  svn_stream_t *src_stream;
-  svn_subst_eol_style_t style;
-  const char *eol;
-  apr_hash_t *keywords;
-  const char *temp_dir_abspath;
-  svn_stream_t *dst_stream;
   apr_int64_t val;
   const char *wcroot_abspath;
-  const char *source_abspath;
   const svn_checksum_t *checksum;
   apr_hash_t *props;
   apr_time_t changed_date;
 
   local_relpath = apr_pstrmemdup(scratch_pool, arg1->data, arg1->len);
   SVN_ERR(svn_wc__db_from_relpath(&local_abspath, db, wri_abspath,
-                                  local_relpath, scratch_pool, scratch_pool));
+                                  local_relpath, result_pool, scratch_pool));
+  result->local_abspath = local_abspath;
 
   SVN_ERR(svn_skel__parse_int(&val, arg1->next, scratch_pool));
   use_commit_times = (val != 0);
   SVN_ERR(svn_skel__parse_int(&val, arg1->next->next, scratch_pool));
-  record_fileinfo = (val != 0);
+  result->record_fileinfo = (val != 0);
 
   SVN_ERR(svn_wc__db_read_node_install_info(&wcroot_abspath,
                                             &checksum, &props,
@@ -496,9 +527,9 @@ run_file_install(work_item_baton_t *wqb,
     {
       /* Use the provided path for the source.  */
       local_relpath = apr_pstrmemdup(scratch_pool, arg4->data, arg4->len);
-      SVN_ERR(svn_wc__db_from_relpath(&source_abspath, db, wri_abspath,
-                                      local_relpath,
-                                      scratch_pool, scratch_pool));
+      SVN_ERR(svn_wc__db_from_relpath(&result->source_abspath, db,
+                                      wri_abspath, local_relpath,
+                                      result_pool, scratch_pool));
     }
   else if (! checksum)
     {
@@ -518,22 +549,83 @@ run_file_install(work_item_baton_t *wqb,
     }
   else
     {
-      SVN_ERR(svn_wc__db_pristine_get_future_path(&source_abspath,
-                                                  wcroot_abspath,
-                                                  checksum,
-                                                  scratch_pool, scratch_pool));
+      result->wcroot_abspath = apr_pstrdup(result_pool, wcroot_abspath);
+      result->checksum = svn_checksum_dup(checksum, result_pool);
     }
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
-                                   scratch_pool, scratch_pool));
-
   /* Fetch all the translation bits.  */
-  SVN_ERR(svn_wc__get_translate_info(&style, &eol,
-                                     &keywords,
-                                     &special, db, local_abspath,
+  SVN_ERR(svn_wc__get_translate_info(&result->style, &result->eol,
+                                     &result->keywords,
+                                     &result->special, db, local_abspath,
                                      props, FALSE,
+                                     result_pool, scratch_pool));
+  if (result->special)
+    {
+      /* No need to set exec or read-only flags on special files.  */
+
+      /* ### Shouldn't this record a timestamp and size, etc.? */
+      result->record_fileinfo = FALSE;
+      *install = result;
+      return SVN_NO_ERROR;
+    }
+
+  /* Where is the Right Place to put a temp file in this working copy?  */
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&result->temp_dir_abspath,
+                                         db, wcroot_abspath,
+                                         result_pool, scratch_pool));
+
+#ifndef WIN32
+  result->executable = (props
+                        && svn_hash_gets(props, SVN_PROP_EXECUTABLE));
+#endif
+
+  /* Note that this explicitly checks the pristine properties, to make sure
+     that when the lock is locally set (=modification) it is not read only */
+  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
+    {
+      svn_wc__db_status_t status;
+      svn_wc__db_lock_t *lock;
+      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                   db, local_abspath,
+                                   scratch_pool, scratch_pool));
+
+      result->read_only = (!lock && status != svn_wc__db_status_added);
+    }
+
+  if (use_commit_times)
+    result->set_time = changed_date;
+
+  *install = result;
+  return SVN_NO_ERROR;
+}
+
+/* Install the file described by INSTALL.  This does not access the working
+ * copy database.  If INSTALL->RECORD_FILEINFO, set INSTALL->DIRENT to the
+ * installed file's dirent, allocated in RESULT_POOL. */
+static svn_error_t *
+install_file(file_install_t *install,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  const char *local_abspath = install->local_abspath;
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+
+  if (install->source_abspath)
+    SVN_ERR(svn_stream_open_readonly(&src_stream, install->source_abspath,
                                      scratch_pool, scratch_pool));
-  if (special)
+  else
+    SVN_ERR(svn_wc__db_pristine_read_future(&src_stream,
+                                            install->wcroot_abspath,
+                                            install->checksum,
+                                            scratch_pool, scratch_pool));
+
+  if (install->special)
     {
       /* When this stream is closed, the resulting special file will
          atomically be created/moved into place at LOCAL_ABSPATH.  */
@@ -546,33 +638,27 @@ run_file_install(work_item_baton_t *wqb,
                                cancel_func, cancel_baton,
                                scratch_pool));
 
-      /* No need to set exec or read-only flags on special files.  */
-
-      /* ### Shouldn't this record a timestamp and size, etc.? */
       return SVN_NO_ERROR;
     }
 
-  if (svn_subst_translation_required(style, eol, keywords,
+  if (svn_subst_translation_required(install->style, install->eol,
+                                     install->keywords,
                                      FALSE /* special */,
                                      TRUE /* force_eol_check */))
     {
       /* Wrap it in a translating (expanding) stream.  */
-      src_stream = svn_subst_stream_translated(src_stream, eol,
+      src_stream = svn_subst_stream_translated(src_stream, install->eol,
                                                TRUE /* repair */,
-                                               keywords,
+                                               install->keywords,
                                                TRUE /* expand */,
                                                scratch_pool);
     }
 
-  /* Where is the Right Place to put a temp file in this working copy?  */
-  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath,
-                                         db, wcroot_abspath,
-                                         scratch_pool, scratch_pool));
-
   /* Translate to a temporary file. We don't want the user seeing a partial
      file, nor let them muck with it while we translate. We may also need to
      get its TRANSLATED_SIZE before the user can monkey it.  */
-  SVN_ERR(svn_stream__create_for_install(&dst_stream, temp_dir_abspath,
+  SVN_ERR(svn_stream__create_for_install(&dst_stream,
+                                         install->temp_dir_abspath,
                                          scratch_pool, scratch_pool));
 
   /* Copy from the source to the dest, translating as we go. This will also
@@ -589,48 +675,57 @@ run_file_install(work_item_baton_t *wqb,
                                      TRUE /* make_parents*/, scratch_pool));
 
   /* Tweak the on-disk file according to its properties.  */
-#ifndef WIN32
-  if (props && svn_hash_gets(props, SVN_PROP_EXECUTABLE))
+  if (install->executable)
     SVN_ERR(svn_io_set_file_executable(local_abspath, TRUE, FALSE,
                                        scratch_pool));
-#endif
-
-  /* Note that this explicitly checks the pristine properties, to make sure
-     that when the lock is locally set (=modification) it is not read only */
-  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
-    {
-      svn_wc__db_status_t status;
-      svn_wc__db_lock_t *lock;
-      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL,
-                                   db, local_abspath,
-                                   scratch_pool, scratch_pool));
 
-      if (!lock && status != svn_wc__db_status_added)
-        SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
-    }
+  if (install->read_only)
+    SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
 
-  if (use_commit_times)
-    {
-      if (changed_date)
-        SVN_ERR(svn_io_set_file_affected_time(changed_date,
-                                              local_abspath,
-                                              scratch_pool));
-    }
+  if (install->set_time)
+    SVN_ERR(svn_io_set_file_affected_time(install->set_time,
+                                          local_abspath,
+                                          scratch_pool));
 
   /* ### this should happen before we rename the file into place.  */
-  if (record_fileinfo)
+  if (install->record_fileinfo)
     {
-      SVN_ERR(get_and_record_fileinfo(wqb, local_abspath,
-                                      FALSE /* ignore_enoent */,
-                                      scratch_pool));
+      const svn_io_dirent2_t *dirent;
+
+      SVN_ERR(svn_io_stat_dirent2(&dirent, local_abspath, FALSE, FALSE,
+                                  result_pool, scratch_pool));
+      if (dirent->kind == svn_node_file)
+        install->dirent = dirent;
     }
 
   return SVN_NO_ERROR;
 }
 
+/* Process the OP_FILE_INSTALL work item WORK_ITEM.
+ * See svn_wc__wq_build_file_install() which generates this work item.
+ * Implements (struct work_item_dispatch).func. */
+static svn_error_t *
+run_file_install(work_item_baton_t *wqb,
+                 svn_wc__db_t *db,
+                 const svn_skel_t *work_item,
+                 const char *wri_abspath,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  file_install_t *install;
+
+  SVN_ERR(prepare_file_install(&install, db, work_item, wri_abspath,
+                               scratch_pool, scratch_pool));
+  SVN_ERR(install_file(install, cancel_func, cancel_baton,
+                       scratch_pool, scratch_pool));
+
+  if (install->dirent)
+    record_fileinfo(wqb, install->local_abspath, install->dirent);
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_wc__wq_build_file_install(svn_skel_t **work_item,
@@ -1474,6 +1569,473 @@ dispatch_work_item(work_item_baton_t *wqb,
 }
 
 
+/* Return ERR, which running the work item ID, WORK_ITEM in the work queue
+   of WRI_ABSPATH produced, wrapped in a generic work queue error.
+   Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+wrap_work_item_error(svn_error_t *err,
+                     const char *wri_abspath,
+                     apr_uint64_t id,
+                     const svn_skel_t *work_item,
+                     apr_pool_t *scratch_pool)
+{
+  const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
+
+  return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
+                           _("Failed to run the WC DB work queue "
+                             "associated with '%s', work item %d %s"),
+                           svn_dirent_local_style(wri_abspath,
+                                                  scratch_pool),
+                           (int)id, skel);
+}
+
+/*** Installing files in worker threads ***/
+
+#if APR_HAS_THREADS
+
+/* Number of work items fetched from the database at once when installing
+   files in parallel.  All installs of a batch run concurrently. */
+#define INSTALL_BATCH_SIZE 128
+
+/* A file install work item, handed to the installer threads. */
+typedef struct install_job_t
+{
+  /* The work item. */
+  apr_uint64_t id;
+  const svn_skel_t *work_item;
+
+  /* What to do, as read from the database by the main thread. */
+  file_install_t *install;
+
+  /* All following fields are protected by the installer mutex. */
+
+  /* Next job in the queue. */
+  struct install_job_t *next;
+
+  /* Result of install_file(), valid once the job is no longer pending. */
+  svn_error_t *err;
+
+  /* Owns the job and its results. */
+  apr_pool_t *pool;
+} install_job_t;
+
+/* The workers installing files and their queue. */
+typedef struct installer_t
+{
+  /* Synchronization.  COND gets signalled upon any state change. */
+  svn_mutex__t *mutex;
+  svn_thread_cond__t *cond;
+
+  /* Jobs not yet started, in the order they were queued.
+     Protected by MUTEX. */
+  install_job_t *first;
+  install_job_t *last;
+
+  /* Number of jobs queued or running.  Protected by MUTEX. */
+  int pending;
+
+  /* Set when the workers shall terminate.  Protected by MUTEX. */
+  svn_boolean_t shutdown;
+
+  /* install_job_t * of the current batch, in work queue order, and the
+     files they install.  Used by the main thread only. */
+  apr_array_header_t *batch;
+  apr_hash_t *batch_paths;
+
+  /* apr_thread_t * of the workers. */
+  apr_array_header_t *threads;
+
+  /* Owns the synchronization objects and threads. */
+  apr_pool_t *pool;
+} installer_t;
+
+/* Run the jobs queued in INSTALLER until shutdown is requested.
+   Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+run_install_jobs(installer_t *installer,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (TRUE)
+    {
+      install_job_t *job = NULL;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_pool_clear(iterpool);
+
+      /* Wait for the next job. */
+      SVN_ERR(svn_mutex__lock(installer->mutex));
+
+      while (!err && !installer->shutdown && !installer->first)
+        err = svn_thread_cond__wait(installer->cond, installer->mutex);
+
+      if (!err && !installer->shutdown)
+        {
+          job = installer->first;
+          installer->first = job->next;
+          if (!installer->first)
+            installer->last = NULL;
+        }
+
+      SVN_ERR(svn_mutex__unlock(installer->mutex, err));
+
+      if (!job)
+        break;
+
+      /* Do the actual work outside the lock.  The cancellation callback
+         is not meant to be called from other threads; the main thread
+         checks it before queueing each job. */
+      err = install_file(job->install, NULL, NULL, job->pool, iterpool);
+
+      /* Hand the results to the main thread. */
+      SVN_ERR(svn_mutex__lock(installer->mutex));
+
+      job->err = err;
+      installer->pending--;
+
+      SVN_ERR(svn_mutex__unlock(installer->mutex,
+                                svn_thread_cond__broadcast(installer->cond)));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function of the installer workers.  DATA is the installer_t. */
+static void * APR_THREAD_FUNC
+install_worker(apr_thread_t *thread,
+               void *data)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  /* Errors here are synchronization failures.  There is no good way to
+     report them to the main thread, which will probably get stuck on
+     the same mutex anyway. */
+  svn_error_clear(run_install_jobs(data, pool));
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(thread, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Start THREAD_COUNT workers installing files and return them in
+   *INSTALLER.  Allocate the result in RESULT_POOL. */
+static svn_error_t *
+start_installer(installer_t **installer_p,
+                int thread_count,
+                apr_pool_t *result_pool)
+{
+  installer_t *installer = apr_pcalloc(result_pool, sizeof(*installer));
+  int i;
+
+  /* The threads are created from and release their memory to this pool,
+     so make it independent from any pool used by the main thread. */
+  installer->pool = svn_pool_create(NULL);
+  installer->batch = apr_array_make(result_pool, INSTALL_BATCH_SIZE,
+                                    sizeof(install_job_t *));
+  installer->batch_paths = apr_hash_make(result_pool);
+  installer->threads = apr_array_make(result_pool, thread_count,
+                                      sizeof(apr_thread_t *));
+
+  SVN_ERR(svn_mutex__init(&installer->mutex, TRUE, installer->pool));
+  SVN_ERR(svn_thread_cond__create(&installer->cond, installer->pool));
+
+  /* Set *INSTALLER_P now such that the workers get stopped even if we
+     fail to create some of them. */
+  *installer_p = installer;
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_thread_t *thread;
+      apr_status_t status = apr_thread_create(&thread, NULL, install_worker,
+                                              installer, installer->pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create install worker"));
+
+      APR_ARRAY_PUSH(installer->threads, apr_thread_t *) = thread;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop the workers of INSTALLER and release all its resources.  The
+   current batch must have been finished by finish_install_batch(). */
+static svn_error_t *
+stop_installer(installer_t *installer)
+{
+  int i;
+
+  SVN_ERR(svn_mutex__lock(installer->mutex));
+  installer->shutdown = TRUE;
+  SVN_ERR(svn_mutex__unlock(installer->mutex,
+                            svn_thread_cond__broadcast(installer->cond)));
+
+  for (i = 0; i < installer->threads->nelts; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, APR_ARRAY_IDX(installer->threads, i,
+                                             apr_thread_t *));
+    }
+
+  svn_pool_destroy(installer->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for all jobs of the current batch in INSTALLER to finish.  Then,
+   in work queue order, add the IDs of the successful jobs up to the first
+   failed one to COMPLETED_IDS and record the installed files in WIB.
+   Return the error of the first failed job, if any, wrapped as by
+   wrap_work_item_error() with WRI_ABSPATH.  Use SCRATCH_POOL for
+   temporaries. */
+static svn_error_t *
+finish_install_batch(installer_t *installer,
+                     work_item_baton_t *wib,
+                     apr_array_header_t *completed_ids,
+                     const char *wri_abspath,
+                     apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  if (installer->batch->nelts == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(installer->mutex));
+
+  while (!err && installer->pending > 0)
+    err = svn_thread_cond__wait(installer->cond, installer->mutex);
+
+  SVN_ERR(svn_mutex__unlock(installer->mutex, err));
+
+  /* All workers are idle now. */
+  for (i = 0; i < installer->batch->nelts; ++i)
+    {
+      install_job_t *job = APR_ARRAY_IDX(installer->batch, i,
+                                         install_job_t *);
+
+      if (err)
+        {
+          /* Files installed after a failed one will simply be installed
+             again by the next run of the work queue. */
+          svn_error_clear(job->err);
+        }
+      else if (job->err)
+        {
+          err = wrap_work_item_error(job->err, wri_abspath, job->id,
+                                     job->work_item, scratch_pool);
+        }
+      else
+        {
+          APR_ARRAY_PUSH(completed_ids, apr_uint64_t) = job->id;
+          if (job->install->dirent)
+            record_fileinfo(wib, job->install->local_abspath,
+                            job->install->dirent);
+        }
+
+      svn_pool_destroy(job->pool);
+    }
+
+  apr_array_clear(installer->batch);
+  apr_hash_clear(installer->batch_paths);
+
+  return svn_error_trace(err);
+}
+
+/* Read the OP_FILE_INSTALL work item ID, WORK_ITEM from DB and queue it
+   in INSTALLER.  If the current batch already installs the same file,
+   finish that batch first, as if by finish_install_batch() with WIB,
+   WRI_ABSPATH and COMPLETED_IDS. */
+static svn_error_t *
+queue_file_install(installer_t *installer,
+                   work_item_baton_t *wib,
+                   apr_array_header_t *completed_ids,
+                   svn_wc__db_t *db,
+                   const char *wri_abspath,
+                   apr_uint64_t id,
+                   const svn_skel_t *work_item,
+                   apr_pool_t *scratch_pool)
+{
+  apr_pool_t *job_pool = svn_pool_create(NULL);
+  install_job_t *job = apr_pcalloc(job_pool, sizeof(*job));
+  svn_error_t *err;
+
+  job->id = id;
+  job->work_item = work_item;
+  job->pool = job_pool;
+
+  err = prepare_file_install(&job->install, db, work_item, wri_abspath,
+                             job_pool, scratch_pool);
+  if (err)
+    {
+      svn_pool_destroy(job_pool);
+      return svn_error_trace(wrap_work_item_error(err, wri_abspath, id,
+                                                  work_item, scratch_pool));
+    }
+
+  /* Installs of the same file must not overtake each other. */
+  if (svn_hash_gets(installer->batch_paths, job->install->local_abspath))
+    {
+      err = finish_install_batch(installer, wib, completed_ids, wri_abspath,
+                                 scratch_pool);
+      if (err)
+        {
+          svn_pool_destroy(job_pool);
+          return svn_error_trace(err);
+        }
+    }
+
+  svn_hash_sets(installer->batch_paths, job->install->local_abspath, job);
+  APR_ARRAY_PUSH(installer->batch, install_job_t *) = job;
+
+  SVN_ERR(svn_mutex__lock(installer->mutex));
+
+  if (installer->last)
+    installer->last->next = job;
+  else
+    installer->first = job;
+  installer->last = job;
+  installer->pending++;
+
+  SVN_ERR(svn_mutex__unlock(installer->mutex,
+                            svn_thread_cond__broadcast(installer->cond)));
+
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_wc__wq_run() but install files using THREAD_COUNT worker
+   threads.
+
+   The working copy database is only accessed by the calling thread.  It
+   fetches the work items in batches, reads everything needed to install
+   the files and queues the installs.  Any other work item waits for all
+   installs queued before it and runs in the calling thread.  Work items
+   are marked completed in the order they were queued, so an interrupted
+   run leaves the work queue in a state that a later run can continue
+   from. */
+static svn_error_t *
+run_work_queue_parallel(svn_wc__db_t *db,
+                        const char *wri_abspath,
+                        int thread_count,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *batch_pool = svn_pool_create(scratch_pool);
+  apr_array_header_t *completed_ids;
+  installer_t *installer = NULL;
+  work_item_baton_t wib = { 0 };
+  svn_error_t *err;
+
+  wib.result_pool = svn_pool_create(scratch_pool);
+  completed_ids = apr_array_make(scratch_pool, INSTALL_BATCH_SIZE,
+                                 sizeof(apr_uint64_t));
+
+  err = start_installer(&installer, thread_count, scratch_pool);
+
+  while (!err)
+    {
+      apr_array_header_t *ids;
+      apr_array_header_t *work_items;
+      int i;
+
+      /* Mark everything completed that finished in the previous batch,
+         *before* we start worrying about anything else.  */
+      svn_pool_clear(batch_pool);
+      err = svn_wc__db_wq_record_and_fetch_batch(&ids, &work_items,
+                                                 db, wri_abspath,
+                                                 completed_ids,
+                                                 wib.record_map,
+                                                 INSTALL_BATCH_SIZE,
+                                                 batch_pool, iterpool);
+      if (err)
+        break;
+
+      apr_array_clear(completed_ids);
+      svn_pool_clear(wib.result_pool);
+      wib.record_map = NULL;
+      wib.used = FALSE;
+
+      if (work_items->nelts == 0)
+        break;
+
+      for (i = 0; !err && i < work_items->nelts; ++i)
+        {
+          apr_uint64_t id = APR_ARRAY_IDX(ids, i, apr_uint64_t);
+          const svn_skel_t *work_item = APR_ARRAY_IDX(work_items, i,
+                                                      svn_skel_t *);
+
+          svn_pool_clear(iterpool);
+
+          /* Stop work queue processing, if requested. A future 'svn
+             cleanup' should be able to continue the processing. */
+          if (cancel_func)
+            {
+              err = cancel_func(cancel_baton);
+              if (err)
+                break;
+            }
+
+          if (svn_skel__matches_atom(work_item->children, OP_FILE_INSTALL))
+            {
+              err = queue_file_install(installer, &wib, completed_ids,
+                                       db, wri_abspath, id, work_item,
+                                       iterpool);
+              continue;
+            }
+
+          /* Everything else runs in work queue order, after the installs
+             queued so far. */
+          err = finish_install_batch(installer, &wib, completed_ids,
+                                     wri_abspath, iterpool);
+          if (err)
+            break;
+
+          err = dispatch_work_item(&wib, db, wri_abspath, work_item,
+                                   cancel_func, cancel_baton, iterpool);
+          if (err)
+            err = wrap_work_item_error(err, wri_abspath, id, work_item,
+                                       scratch_pool);
+          else
+            APR_ARRAY_PUSH(completed_ids, apr_uint64_t) = id;
+        }
+
+      err = svn_error_compose_create(
+              err,
+              finish_install_batch(installer, &wib, completed_ids,
+                                   wri_abspath, scratch_pool));
+    }
+
+  /* Mark what was done before the failure as completed, such that the
+     next run does not start all over. */
+  if (err && installer && completed_ids->nelts)
+    {
+      apr_array_header_t *ids;
+      apr_array_header_t *work_items;
+
+      err = svn_error_compose_create(
+              err,
+              svn_wc__db_wq_record_and_fetch_batch(&ids, &work_items,
+                                                   db, wri_abspath,
+                                                   completed_ids,
+                                                   wib.record_map, 0,
+                                                   iterpool, iterpool));
+    }
+
+  if (installer)
+    err = svn_error_compose_create(err, stop_installer(installer));
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(batch_pool);
+
+  return svn_error_trace(err);
+}
+
+#endif
+
 svn_error_t *
 svn_wc__wq_run(svn_wc__db_t *db,
                const char *wri_abspath,
@@ -1486,6 +2048,9 @@ svn_wc__wq_run(svn_wc__db_t *db,
   work_item_baton_t wib = { 0 };
   wib.result_pool = svn_pool_create(scratch_pool);
 
+  /* Don't change the disk for changes that are not committed yet.  */
+  SVN_ERR(svn_wc__db_batch_commit(db, wri_abspath, iterpool));
+
 #ifdef SVN_DEBUG_WORK_QUEUE
   SVN_DBG(("wq_run: wri='%s'\n", wri_abspath));
   {
@@ -1500,6 +2065,17 @@ svn_wc__wq_run(svn_wc__db_t *db,
   }
 #endif
 
+#if APR_HAS_THREADS
+  if (svn_wc__db_wq_get_install_threads(db) > 1)
+    {
+      svn_pool_destroy(iterpool);
+      return svn_error_trace(run_work_queue_parallel(
+                               db, wri_abspath,
+                               svn_wc__db_wq_get_install_threads(db),
+                               cancel_func, cancel_baton, scratch_pool));
+    }
+#endif
+
   while (TRUE)
     {
       apr_uint64_t id;
@@ -1546,16 +2122,8 @@ svn_wc__wq_run(svn_wc__db_t *db,
       err = dispatch_work_item(&wib, db, wri_abspath, work_item,
                                cancel_func, cancel_baton, iterpool);
       if (err)
-        {
-          const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
-
-          return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
-                                   _("Failed to run the WC DB work queue "
-                                     "associated with '%s', work item %d %s"),
-                                   svn_dirent_local_style(wri_abspath,
-                                                          scratch_pool),
-                                   (int)id, skel);
-        }
+        return svn_error_trace(wrap_work_item_error(err, wri_abspath, id,
+                                                    work_item, scratch_pool));
 
       /* The work item finished without error. Mark it completed
          in the next loop.  */
@@ -1629,13 +2197,23 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
   if (dirent->kind != svn_node_file)
     return SVN_NO_ERROR;
 
+  record_fileinfo(wqb, local_abspath, dirent);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remember to record the size and timestamp of the file LOCAL_ABSPATH,
+   as given by DIRENT, when the current work item is marked completed. */
+static void
+record_fileinfo(work_item_baton_t *wqb,
+                const char *local_abspath,
+                const svn_io_dirent2_t *dirent)
+{
   wqb->used = TRUE;
 
   if (! wqb->record_map)
     wqb->record_map = apr_hash_make(wqb->result_pool);
 
   svn_hash_sets(wqb->record_map, apr_pstrdup(wqb->result_pool, local_abspath),
-                dirent);
-
-  return SVN_NO_ERROR;
+                svn_io_dirent2_dup(dirent, wqb->result_pool));
 }
@@ -290,6 +290,7 @@ svn_opt_subcommand_t
   svn_cl__diff,
   svn_cl__export,
   svn_cl__help,
+  svn_cl__hydrate,
   svn_cl__import,
   svn_cl__info,
   svn_cl__lock,
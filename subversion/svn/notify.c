@@ -1197,6 +1197,32 @@ notify_body(struct notify_baton *nb,
       SVN_ERR(svn_cmdline_printf(pool, _("Committing transaction...\n")));
       break;
 
+    case svn_wc_notify_cleanup_pristines_progress:
+    case svn_wc_notify_cleanup_vacuum_progress:
+      if (n->progress_total > 0)
+        {
+          /* Overwrite the previous progress line; the percentage always
+             takes the same width. */
+          int percent = (int)(n->progress * 100 / n->progress_total);
+
+          if (n->action == svn_wc_notify_cleanup_pristines_progress)
+            SVN_ERR(svn_cmdline_printf(pool,
+                                       _("\rRemoving unused pristine "
+                                         "texts... %3d%%"), percent));
+          else
+            SVN_ERR(svn_cmdline_printf(pool,
+                                       _("\rCompacting working copy "
+                                         "database... %3d%%"), percent));
+
+          if (n->progress >= n->progress_total)
+            SVN_ERR(svn_cmdline_printf(pool, "\n"));
+        }
+      break;
+
+    case svn_wc_notify_text_fetched:
+      SVN_ERR(svn_cmdline_printf(pool, _("Fetched '%s'\n"), path_local));
+      break;
+
     default:
       break;
     }
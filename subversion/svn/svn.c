@@ -823,6 +823,18 @@ const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
     {0} },
   /* This command is also invoked if we see option "--help", "-h" or "-?". */
 
+  { "hydrate", svn_cl__hydrate, {0}, {N_(
+     "Fetch the text of files that were checked out without it.\n"
+     "usage: hydrate [PATH...]\n"
+     "\n"), N_(
+     "  When the 'lazy-fetch' option in the [working-copy] section of the\n"
+     "  config file is set, checkout and update add files without fetching\n"
+     "  their text.  Fetch the text of such files at or within PATH and\n"
+     "  create their working files.  'svn cat' does this for single files.\n"
+     "  If PATH is omitted '.' is assumed.\n"
+    )},
+    {opt_depth, 'q'} },
+
   { "import", svn_cl__import, {0}, {N_(
      "Commit an unversioned file or tree into the repository.\n"
      "usage: import [PATH] URL\n"
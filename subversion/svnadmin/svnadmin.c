@@ -45,6 +45,7 @@
 
 #include "private/svn_cmdline_private.h"
 #include "private/svn_opt_private.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_cmdline_private.h"
@@ -95,6 +96,7 @@ check_lib_versions(void)
 /** Subcommands. **/
 
 static svn_opt_subcommand_t
+  subcommand_build_log_index,
   subcommand_crashtest,
   subcommand_create,
   subcommand_delrevprop,
@@ -155,7 +157,8 @@ enum svnadmin__cmdline_options_t
     svnadmin__normalize_props,
     svnadmin__exclude,
     svnadmin__include,
-    svnadmin__glob
+    svnadmin__glob,
+    svnadmin__jobs
   };
 
 /* Option codes and descriptions.
@@ -294,6 +297,12 @@ static const apr_getopt_option_t options_table[] =
         "                             Character '/' is not treated specially, so\n"
         "                             pattern /*/foo matches paths /a/foo and /a/b/foo.") },
 
+    {"jobs", svnadmin__jobs, 1,
+     N_("use up to ARG threads: 'dump' writes revisions\n"
+        "                             dumped ahead by worker threads; 'load'\n"
+        "                             parses and decodes the dumpstream ahead\n"
+        "                             of the commits, which stay in order")},
+
     {NULL}
   };
 
@@ -303,6 +312,15 @@ static const apr_getopt_option_t options_table[] =
  */
 static const svn_opt_subcommand_desc3_t cmd_table[] =
 {
+  {"build-log-index", subcommand_build_log_index, {0}, {N_(
+    "usage: svnadmin build-log-index REPOS_PATH\n"
+    "\n"), N_(
+    "Create or rebuild the changed-paths index of the repository.\n"
+    "Once the index exists, commits keep it up to date and it speeds up\n"
+    "'svn log' on paths.  Rebuild it after loading or replacing revisions.\n"
+   )},
+   {0} },
+
   {"crashtest", subcommand_crashtest, {0}, {N_(
     "usage: svnadmin crashtest REPOS_PATH\n"
     "\n"), N_(
@@ -369,7 +387,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "excluded, the copy is transformed into an add (unlike in 'svndumpfilter').\n"
    )},
   {'r', svnadmin__incremental, svnadmin__deltas, 'q', 'M', 'F',
-   svnadmin__exclude, svnadmin__include, svnadmin__glob },
+   svnadmin__exclude, svnadmin__include, svnadmin__glob, svnadmin__jobs },
   {{'F', N_("write to file ARG instead of stdout")}} },
 
   {"dump-revprops", subcommand_dump_revprops, {0}, {N_(
@@ -456,7 +474,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     svnadmin__use_pre_commit_hook, svnadmin__use_post_commit_hook,
     svnadmin__parent_dir, svnadmin__normalize_props,
     svnadmin__bypass_prop_validation, 'M',
-    svnadmin__no_flush_to_disk, 'F'},
+    svnadmin__no_flush_to_disk, 'F', svnadmin__jobs},
    {{'F', N_("read from file ARG instead of stdin")}} },
 
   {"load-revprops", subcommand_load_revprops, {0}, {N_(
@@ -648,18 +666,16 @@ struct svnadmin_opt_state
   apr_array_header_t *exclude;                      /* --exclude */
   apr_array_header_t *include;                      /* --include */
   svn_boolean_t glob;                               /* --pattern */
+  int jobs;                                         /* --jobs */
 
   const char *config_dir;    /* Overriding Configuration Directory */
 };
 
 
-/* Helper to open a repository and set a warning func (so we don't
- * SEGFAULT when libsvn_fs's default handler gets run).  */
-static svn_error_t *
-open_repos(svn_repos_t **repos,
-           const char *path,
-           struct svnadmin_opt_state *opt_state,
-           apr_pool_t *pool)
+/* Return the FS configuration for OPT_STATE, allocated in POOL. */
+static apr_hash_t *
+get_fs_config(struct svnadmin_opt_state *opt_state,
+              apr_pool_t *pool)
 {
   /* Enable the "block-read" feature (where it applies)? */
   svn_boolean_t use_block_read
@@ -678,8 +694,20 @@ open_repos(svn_repos_t **repos,
   svn_hash_sets(fs_config, SVN_FS_CONFIG_NO_FLUSH_TO_DISK,
                            opt_state->no_flush_to_disk ? "1" : "0");
 
+  return fs_config;
+}
+
+/* Helper to open a repository and set a warning func (so we don't
+ * SEGFAULT when libsvn_fs's default handler gets run).  */
+static svn_error_t *
+open_repos(svn_repos_t **repos,
+           const char *path,
+           struct svnadmin_opt_state *opt_state,
+           apr_pool_t *pool)
+{
   /* now, open the requested repository */
-  SVN_ERR(svn_repos_open3(repos, path, fs_config, pool, pool));
+  SVN_ERR(svn_repos_open3(repos, path, get_fs_config(opt_state, pool),
+                          pool, pool));
   svn_fs_set_warning_func(svn_repos_fs(*repos), warning_func, NULL);
   return SVN_NO_ERROR;
 }
@@ -796,6 +824,22 @@ crashtest_malfunction_handler(svn_boolean_t can_return,
   return SVN_NO_ERROR; /* Not reached. */
 }
 
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_build_log_index(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnadmin_opt_state *opt_state = baton;
+  svn_repos_t *repos;
+
+  /* Expect no more arguments. */
+  SVN_ERR(parse_args(NULL, os, 0, 0, pool));
+
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+
+  return svn_error_trace(svn_repos__log_index_build(repos, check_cancel,
+                                                    NULL, pool));
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_crashtest(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -1451,13 +1495,15 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
                                  "cannot be used simultaneously"));
     }
 
-  SVN_ERR(svn_repos_dump_fs4(repos, out_stream, lower, upper,
+  SVN_ERR(svn_repos__dump_fs(repos, out_stream, lower, upper,
                              opt_state->incremental, opt_state->use_deltas,
                              TRUE, TRUE,
                              !opt_state->quiet ? repos_notify_handler : NULL,
                              feedback_stream,
                              filter_baton.prefixes ? dump_filter_func : NULL,
                              &filter_baton,
+                             opt_state->jobs,
+                             get_fs_config(opt_state, pool),
                              check_cancel, NULL, pool));
 
   return SVN_NO_ERROR;
@@ -1686,6 +1732,9 @@ subcommand_load(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_revnum_t lower, upper;
   svn_stream_t *in_stream;
   svn_stream_t *feedback_stream = NULL;
+  const svn_repos_parse_fns3_t *parser = NULL;
+  void *parse_baton = NULL;
+  apr_pool_t *in_pool = pool;
 
   /* Expect no more arguments. */
   SVN_ERR(parse_args(NULL, os, 0, 0, pool));
@@ -1696,26 +1745,66 @@ subcommand_load(apr_getopt_t *os, void *baton, apr_pool_t *pool)
 
   SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
 
+  /* Progress feedback goes to STDOUT, unless they asked to suppress it. */
+  if (! opt_state->quiet)
+    feedback_stream = recode_stream_create(stdout, pool);
+
+  if (opt_state->jobs > 1)
+    {
+      SVN_ERR(svn_repos_get_fs_build_parser6(&parser, &parse_baton,
+                                             repos, lower, upper,
+                                             TRUE, /* look for copyfrom revs */
+                                             !opt_state->bypass_prop_validation,
+                                             opt_state->uuid_action,
+                                             opt_state->parent_dir,
+                                             opt_state->use_pre_commit_hook,
+                                             opt_state->use_post_commit_hook,
+                                             opt_state->ignore_dates,
+                                             opt_state->normalize_props,
+                                             opt_state->quiet
+                                               ? NULL : repos_notify_handler,
+                                             feedback_stream, pool));
+
+      /* The input gets read by a separate thread.  Our POOL's allocator
+         is not thread-safe, so give the input its own.  From here on,
+         every exit must destroy IN_POOL. */
+      in_pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+    }
+
   /* Open the file or STDIN, depending on whether -F was specified. */
   if (opt_state->file)
-    SVN_ERR(svn_stream_open_readonly(&in_stream, opt_state->file,
-                                     pool, pool));
+    err = svn_stream_open_readonly(&in_stream, opt_state->file,
+                                   in_pool, in_pool);
   else
-    SVN_ERR(svn_stream_for_stdin2(&in_stream, TRUE, pool));
+    err = svn_stream_for_stdin2(&in_stream, TRUE, in_pool);
 
-  /* Progress feedback goes to STDOUT, unless they asked to suppress it. */
-  if (! opt_state->quiet)
-    feedback_stream = recode_stream_create(stdout, pool);
+  if (err)
+    {
+      if (in_pool != pool)
+        svn_pool_destroy(in_pool);
+      return svn_error_trace(err);
+    }
 
-  err = svn_repos_load_fs6(repos, in_stream, lower, upper,
-                           opt_state->uuid_action, opt_state->parent_dir,
-                           opt_state->use_pre_commit_hook,
-                           opt_state->use_post_commit_hook,
-                           !opt_state->bypass_prop_validation,
-                           opt_state->ignore_dates,
-                           opt_state->normalize_props,
-                           opt_state->quiet ? NULL : repos_notify_handler,
-                           feedback_stream, check_cancel, NULL, pool);
+  if (opt_state->jobs > 1)
+    {
+      err = svn_repos__parse_dumpstream_pipelined(in_stream, parser,
+                                                  parse_baton,
+                                                  opt_state->jobs,
+                                                  check_cancel, NULL, pool);
+      svn_pool_destroy(in_pool);
+    }
+  else
+    {
+      err = svn_repos_load_fs6(repos, in_stream, lower, upper,
+                               opt_state->uuid_action, opt_state->parent_dir,
+                               opt_state->use_pre_commit_hook,
+                               opt_state->use_post_commit_hook,
+                               !opt_state->bypass_prop_validation,
+                               opt_state->ignore_dates,
+                               opt_state->normalize_props,
+                               opt_state->quiet ? NULL : repos_notify_handler,
+                               feedback_stream, check_cancel, NULL, pool);
+    }
 
   if (svn_error_find_cause(err, SVN_ERR_BAD_PROPERTY_VALUE_EOL))
     {
@@ -3102,6 +3191,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__glob:
         opt_state.glob = TRUE;
         break;
+      case svnadmin__jobs:
+        SVN_ERR(svn_cstring_atoi(&opt_state.jobs, opt_arg));
+        if (opt_state.jobs < 1)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("Invalid number of jobs '%s'"),
+                                   opt_arg);
+        break;
       default:
         {
           SVN_ERR(subcommand_help(NULL, NULL, pool));
@@ -3229,7 +3325,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     svn_cache_config_t settings = *svn_cache_config_get();
 
     settings.cache_size = opt_state.memory_cache_size;
-    settings.single_threaded = TRUE;
+
+    /* Parallel dumps access the caches from several threads. */
+    settings.single_threaded = (opt_state.jobs <= 1);
 
     svn_cache_config_set(&settings);
   }
@@ -29,6 +29,7 @@
 
 #include "svn_client.h"
 #include "svn_cmdline.h"
+#include "svn_diff.h"
 #include "svn_error.h"
 #include "svn_dirent_uri.h"
 #include "svn_path.h"
@@ -82,6 +83,53 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_client_blame_receiver3_t */
+static svn_error_t *
+blame_receiver(void *baton,
+               svn_revnum_t start_revnum,
+               svn_revnum_t end_revnum,
+               apr_int64_t line_no,
+               svn_revnum_t revision,
+               apr_hash_t *rev_props,
+               svn_revnum_t merged_revision,
+               apr_hash_t *merged_rev_props,
+               const char *merged_path,
+               const char *line,
+               svn_boolean_t local_change,
+               apr_pool_t *pool)
+{
+  apr_int64_t *line_count = baton;
+  (*line_count)++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Run the client's full blame engine on TARGET, discarding the result. */
+static svn_error_t *
+bench_full_blame(const char *target,
+                 const svn_opt_revision_t *peg_revision,
+                 const svn_opt_revision_t *start,
+                 const svn_opt_revision_t *end,
+                 svn_boolean_t include_merged_revisions,
+                 svn_boolean_t quiet,
+                 svn_client_ctx_t *ctx,
+                 apr_pool_t *pool)
+{
+  apr_int64_t line_count = 0;
+
+  SVN_ERR(svn_client_blame5(target, peg_revision, start, end,
+                            svn_diff_file_options_create(pool),
+                            FALSE, include_merged_revisions,
+                            blame_receiver, &line_count, ctx, pool));
+
+  if (!quiet)
+    SVN_ERR(svn_cmdline_printf(pool,
+                               _("%15s lines annotated\n"),
+                               svn__ui64toa_sep(line_count, ',', pool)));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 bench_null_blame(const char *target,
                  const svn_opt_revision_t *peg_revision,
@@ -237,14 +285,24 @@ svn_cl__null_blame(apr_getopt_t *os,
             opt_state->end_revision.kind = svn_opt_revision_working;
         }
 
-      err = bench_null_blame(parsed_path,
-                             &peg_revision,
-                             &opt_state->start_revision,
-                             &opt_state->end_revision,
-                             opt_state->use_merge_history,
-                             opt_state->quiet,
-                             ctx,
-                             iterpool);
+      if (opt_state->verbose)
+        err = bench_full_blame(parsed_path,
+                               &peg_revision,
+                               &opt_state->start_revision,
+                               &opt_state->end_revision,
+                               opt_state->use_merge_history,
+                               opt_state->quiet,
+                               ctx,
+                               iterpool);
+      else
+        err = bench_null_blame(parsed_path,
+                               &peg_revision,
+                               &opt_state->start_revision,
+                               &opt_state->end_revision,
+                               opt_state->use_merge_history,
+                               opt_state->quiet,
+                               ctx,
+                               iterpool);
 
       if (err)
         {
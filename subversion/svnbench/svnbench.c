@@ -232,9 +232,12 @@ const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
      "  If specified, REV determines in which revision the target is first\n"
      "  looked up.\n"
      "\n"), N_(
+     "  With --verbose, also calculate the blame information for each line\n"
+     "  and report the number of lines instead of the data transferred.\n"
+     "\n"), N_(
      "  Write the annotated result to standard output.\n"
     )},
-    {'r', 'g'} },
+    {'r', 'g', 'v'} },
 
   { "null-export", svn_cl__null_export, {0}, {N_(
      "Create an unversioned copy of a tree.\n"
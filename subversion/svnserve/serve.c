@@ -988,6 +988,10 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
                                       authz_check_access_cb_func(b),
                                       &ab, svn_ra_svn_zero_copy_limit(conn),
                                       pool));
+  SVN_CMD_ERR(svn_repos__report_set_delta_threads(report_baton,
+                                                  b->repository->delta_threads,
+                                                  0,
+                                                  b->repository->fs_config));
 
   rb.sb = b;
   rb.repos_url = svn_path_uri_decode(b->repository->repos_url, pool);
@@ -3686,6 +3690,121 @@ list(svn_ra_svn_conn_t *conn,
   return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
 }
 
+/* Baton type to be used with blame_receiver. */
+typedef struct blame_receiver_baton_t
+{
+  /* Send the data through this connection. */
+  svn_ra_svn_conn_t *conn;
+
+  /* Revisions for which we already sent the revprops, mapping
+     svn_revnum_t to non-NULL.  Allocated in POOL. */
+  apr_hash_t *sent_revisions;
+  apr_pool_t *pool;
+} blame_receiver_baton_t;
+
+/* Implements svn_repos__blame_receiver_t, sending a chunk of blame info
+ * to the client.  BATON must be a blame_receiver_baton_t. */
+static svn_error_t *
+blame_receiver(void *baton,
+               apr_int64_t start_line,
+               apr_int64_t line_count,
+               svn_revnum_t revision,
+               apr_hash_t *rev_props,
+               apr_pool_t *scratch_pool)
+{
+  blame_receiver_baton_t *b = baton;
+  apr_hash_t *props = apr_hash_make(scratch_pool);
+
+  /* Most revisions will be responsible for many chunks.  Send their
+     revprops only with the first of them. */
+  if (rev_props && !apr_hash_get(b->sent_revisions, &revision,
+                                 sizeof(revision)))
+    {
+      svn_string_t *value;
+      svn_revnum_t *key = apr_palloc(b->pool, sizeof(*key));
+
+      *key = revision;
+      apr_hash_set(b->sent_revisions, key, sizeof(*key), key);
+
+      value = svn_hash_gets(rev_props, SVN_PROP_REVISION_AUTHOR);
+      if (value)
+        svn_hash_sets(props, SVN_PROP_REVISION_AUTHOR, value);
+      value = svn_hash_gets(rev_props, SVN_PROP_REVISION_DATE);
+      if (value)
+        svn_hash_sets(props, SVN_PROP_REVISION_DATE, value);
+    }
+
+  SVN_ERR(svn_ra_svn__write_tuple(b->conn, scratch_pool, "nn(?r)(!",
+                                  (apr_uint64_t)start_line,
+                                  (apr_uint64_t)line_count, revision));
+  SVN_ERR(svn_ra_svn__write_proplist(b->conn, scratch_pool, props));
+  return svn_error_trace(svn_ra_svn__write_tuple(b->conn, scratch_pool,
+                                                 "!)"));
+}
+
+static svn_error_t *
+get_blame(svn_ra_svn_conn_t *conn,
+          apr_pool_t *pool,
+          svn_ra_svn__list_t *params,
+          void *baton)
+{
+  server_baton_t *b = baton;
+  const char *path, *full_path;
+  svn_revnum_t start_rev, end_rev;
+  const char *ignore_space;
+  svn_boolean_t ignore_eol_style;
+  svn_diff_file_options_t diff_options = { 0 };
+  blame_receiver_baton_t rb;
+  svn_error_t *err, *write_err;
+
+  authz_baton_t ab;
+  ab.server = b;
+  ab.conn = conn;
+
+  /* Read the command parameters. */
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "crrwb", &path, &start_rev,
+                                  &end_rev, &ignore_space,
+                                  &ignore_eol_style));
+
+  if (strcmp(ignore_space, "change") == 0)
+    diff_options.ignore_space = svn_diff_file_ignore_space_change;
+  else if (strcmp(ignore_space, "all") == 0)
+    diff_options.ignore_space = svn_diff_file_ignore_space_all;
+  else
+    diff_options.ignore_space = svn_diff_file_ignore_space_none;
+  diff_options.ignore_eol_style = ignore_eol_style;
+
+  full_path = svn_fspath__join(b->repository->fs_path->data,
+                               svn_relpath_canonicalize(path, pool), pool);
+
+  /* Check authorizations */
+  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read,
+                           full_path, FALSE));
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__get_blame(full_path, start_rev, end_rev,
+                                         pool)));
+
+  rb.conn = conn;
+  rb.sent_revisions = apr_hash_make(pool);
+  rb.pool = pool;
+  err = svn_repos__get_blame(b->repository->repos, full_path, start_rev,
+                             end_rev, &diff_options,
+                             authz_check_access_cb_func(b), &ab,
+                             blame_receiver, &rb, NULL, NULL, pool);
+
+  /* Finish response. */
+  write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+
+  return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
+}
+
 static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "reparent",        reparent },
   { "get-latest-rev",  get_latest_rev },
@@ -3719,6 +3838,7 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "get-deleted-rev", get_deleted_rev },
   { "get-iprops",      get_inherited_props },
   { "list",            list },
+  { "get-blame",       get_blame },
   { NULL }
 };
 
@@ -4117,6 +4237,8 @@ construct_server_baton(server_baton_t **baton,
   b->repository->authzdb = NULL;
   b->repository->realm = NULL;
   b->repository->use_sasl = FALSE;
+  b->repository->delta_threads = params->delta_threads;
+  b->repository->fs_config = params->fs_config;
 
   b->read_only = params->read_only;
   b->pool = conn_pool;
@@ -4129,7 +4251,7 @@ construct_server_baton(server_baton_t **baton,
    * send an empty mechlist. */
   if (params->compression_level > 0)
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
@@ -4143,11 +4265,12 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_BLAME
                                            ));
   else
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
@@ -4159,7 +4282,8 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_BLAME
                                            ));
 
   /* Read client response, which we assume to be in version 2 format:
@@ -73,6 +73,9 @@ typedef struct repository_t {
   enum access_type auth_access; /* access granted to authenticated users */
   enum access_type anon_access; /* access granted to annonymous users */
 
+  int delta_threads;       /* Text delta threads per report */
+  apr_hash_t *fs_config;   /* FS config for the delta threads */
+
 } repository_t;
 
 typedef struct client_info_t {
@@ -159,6 +162,10 @@ typedef struct serve_params_t {
 
   /* Use virtual-host-based path to repo. */
   svn_boolean_t vhost;
+
+  /* Number of extra threads computing text deltas for each update-style
+     report.  0 disables them. */
+  int delta_threads;
 } serve_params_t;
 
 /* This structure contains all data that describes a client / server
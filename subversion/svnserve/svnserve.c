@@ -54,6 +54,7 @@
 
 #include "private/svn_dep_compat.h"
 #include "private/svn_cmdline_private.h"
+#include "private/svn_debug.h"
 #include "private/svn_atomic.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
@@ -222,6 +223,7 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_DELTA_THREADS   277
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -362,6 +364,12 @@ static const apr_getopt_option_t svnserve__options[] =
         "                             "
         "Default is " APR_STRINGIFY(THREADPOOL_MAX_SIZE) "."
         ONLY_AVAILABLE_WITH_THEADS)},
+    {"delta-threads",    SVNSERVE_OPT_DELTA_THREADS, 1,
+     N_("Number of threads per update / checkout request\n"
+        "                             "
+        "computing text deltas ahead of sending them.\n"
+        "                             "
+        "Default is 0, i.e. no extra threads.")},
 #endif
     {"max-request-size", SVNSERVE_OPT_MAX_REQUEST, 1,
      N_("Maximum acceptable size of a client request in MB.\n"
@@ -624,6 +632,30 @@ is_busy(connection_t *connection)
        > apr_thread_pool_thread_max_get(threads);
 }
 
+#ifdef SVN_DEBUG_CACHE_DUMP_STATS
+/* Print the statistics of CONNECTION_POOLS.  Use SCRATCH_POOL for
+   temporary allocations. */
+static void
+dump_root_pool_statistics(apr_pool_t *scratch_pool)
+{
+  svn_root_pools__info_t *info
+    = svn_root_pools__get_info(connection_pools, scratch_pool);
+  svn_string_t *text_stats = svn_root_pools__format_info(info,
+                                                         scratch_pool);
+  apr_array_header_t *lines = svn_cstring_split(text_stats->data, "\n",
+                                                FALSE, scratch_pool);
+
+  int i;
+  for (i = 0; i < lines->nelts; ++i)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+#ifdef SVN_DEBUG
+      SVN_DBG(("%s\n", line));
+#endif
+    }
+}
+#endif
+
 /* Serve the connection given by DATA.  Under high load, serve only
    the current command (if any) and then put the connection back into
    THREAD's task pool. */
@@ -645,6 +677,14 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
       svn_error_clear(err);
       done = TRUE;
     }
+
+#ifdef SVN_DEBUG_CACHE_DUMP_STATS
+  /* Print the root pool statistics alongside the cache statistics
+   * whenever a connection ends. */
+  if (done)
+    dump_root_pool_statistics(pool);
+#endif
+
   svn_root_pools__release_pool(pool, connection_pools);
 
   /* Close or re-schedule connection. */
@@ -774,6 +814,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.error_check_interval = 4096;
   params.max_request_size = MAX_REQUEST_SIZE * 0x100000;
   params.max_response_size = 0;
+  params.delta_threads = 0;
 
   while (1)
     {
@@ -962,6 +1003,12 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           max_thread_count = (apr_size_t)apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_DELTA_THREADS:
+          params.delta_threads = atoi(arg);
+          if (params.delta_threads < 0)
+            params.delta_threads = 0;
+          break;
+
 #ifdef WIN32
         case SVNSERVE_OPT_SERVICE:
           if (run_mode != run_mode_service)
@@ -1279,8 +1326,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     if (params.memory_cache_size != -1)
       settings.cache_size = params.memory_cache_size;
 
+    /* The --delta-threads workers share the caches with the request
+     * thread, i.e. we need synchronization even when forking. */
     settings.single_threaded = TRUE;
-    if (handling_mode == connection_mode_thread)
+    if (handling_mode == connection_mode_thread || params.delta_threads > 0)
       {
 #if APR_HAS_THREADS
         settings.single_threaded = FALSE;
@@ -1298,16 +1347,19 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   }
 
 #if APR_HAS_THREADS
-  SVN_ERR(svn_root_pools__create(&connection_pools));
+  /* create the thread pool with a valid range of threads */
+  if (max_thread_count < 1)
+    max_thread_count = 1;
+  if (min_thread_count > max_thread_count)
+    min_thread_count = max_thread_count;
+
+  /* Threads beyond MIN_THREAD_COUNT terminate when idle and release
+     their root pools.  Don't let those pile up in the unused list. */
+  SVN_ERR(svn_root_pools__create2(&connection_pools,
+                                  (int)min_thread_count, 0));
 
   if (handling_mode == connection_mode_thread)
     {
-      /* create the thread pool with a valid range of threads */
-      if (max_thread_count < 1)
-        max_thread_count = 1;
-      if (min_thread_count > max_thread_count)
-        min_thread_count = max_thread_count;
-
       status = apr_thread_pool_create(&threads,
                                       min_thread_count,
                                       max_thread_count,
@@ -31,6 +31,7 @@
 #include "../../libsvn_client/client.h"
 #include "svn_pools.h"
 #include "svn_client.h"
+#include "svn_config.h"
 #include "private/svn_client_mtcc.h"
 #include "svn_repos.h"
 #include "svn_subst.h"
@@ -1408,6 +1409,423 @@ test_copy_pin_externals_select_subtree(const svn_test_opts_t *opts, apr_pool_t *
   return SVN_NO_ERROR;
 }
 
+/* Check out REPOS_URL at REVNUM into a new working copy named NAME with
+   the lazy-fetch option set.  Set *WC_PATH to its absolute path and *CTX
+   to a client context using that option. */
+static svn_error_t *
+checkout_lazy(const char **wc_path,
+              svn_client_ctx_t **ctx,
+              const char *repos_url,
+              svn_revnum_t revnum,
+              const char *name,
+              apr_pool_t *pool)
+{
+  svn_opt_revision_t rev;
+  svn_opt_revision_t peg_rev;
+  svn_config_t *cfg;
+  apr_hash_t *cfg_hash;
+
+  *wc_path = svn_test_data_path(name, pool);
+  SVN_ERR(svn_io_remove_dir2(*wc_path, TRUE, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(*wc_path);
+  SVN_ERR(svn_dirent_get_absolute(wc_path, *wc_path, pool));
+
+  SVN_ERR(svn_config_create2(&cfg, FALSE, FALSE, pool));
+  svn_config_set_bool(cfg, SVN_CONFIG_SECTION_WORKING_COPY,
+                      SVN_CONFIG_OPTION_LAZY_FETCH, TRUE);
+  cfg_hash = apr_hash_make(pool);
+  svn_hash_sets(cfg_hash, SVN_CONFIG_CATEGORY_CONFIG, cfg);
+  SVN_ERR(svn_client_create_context2(ctx, cfg_hash, pool));
+
+  if (SVN_IS_VALID_REVNUM(revnum))
+    {
+      rev.kind = svn_opt_revision_number;
+      rev.value.number = revnum;
+    }
+  else
+    rev.kind = svn_opt_revision_head;
+  peg_rev.kind = svn_opt_revision_unspecified;
+  SVN_ERR(svn_client_checkout3(NULL, repos_url, *wc_path,
+                               &peg_rev, &rev, svn_depth_infinity,
+                               TRUE, FALSE, *ctx, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_lazy_fetch(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_client_ctx_t *ctx;
+  const char *repos_url;
+  const char *wc_path;
+  const char *iota_path;
+  const char *alpha_path;
+  apr_array_header_t *paths;
+  svn_wc_status3_t *status;
+  svn_node_kind_t kind;
+  svn_stringbuf_t *contents;
+  svn_wc_context_t *wc_ctx;
+  svn_opt_revision_t rev;
+  int format;
+
+  /* Create a filesytem and repository containing the Greek tree. */
+  SVN_ERR(create_greek_repos(&repos_url, "test-lazy-fetch", opts, pool));
+  SVN_ERR(checkout_lazy(&wc_path, &ctx, repos_url, SVN_INVALID_REVNUM,
+                        "test-lazy-fetch-wc", pool));
+
+  /* The files are versioned, but not on disk */
+  iota_path = svn_dirent_join(wc_path, "iota", pool);
+  alpha_path = svn_dirent_join(wc_path, "A/B/E/alpha", pool);
+
+  SVN_ERR(svn_io_check_path(iota_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_wc_status3(&status, ctx->wc_ctx, iota_path, pool, pool));
+  SVN_TEST_ASSERT(status->node_status == svn_wc_status_normal);
+  SVN_TEST_ASSERT(status->text_status == svn_wc_status_normal);
+
+  /* The working copy has the format that keeps older clients away */
+  SVN_ERR(svn_wc_context_create(&wc_ctx, NULL, pool, pool));
+  SVN_ERR(svn_wc_check_wc2(&format, wc_ctx, wc_path, pool));
+  SVN_TEST_INT_ASSERT(format, 32);
+  SVN_ERR(svn_wc_context_destroy(wc_ctx));
+
+  /* But a fresh context can still work with it */
+  SVN_ERR(svn_client_create_context2(&ctx, ctx->config, pool));
+  SVN_ERR(svn_wc_status3(&status, ctx->wc_ctx, iota_path, pool, pool));
+  SVN_TEST_ASSERT(status->node_status == svn_wc_status_normal);
+
+  paths = apr_array_make(pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = wc_path;
+  rev.kind = svn_opt_revision_head;
+  SVN_ERR(svn_client_update4(NULL, paths, &rev, svn_depth_infinity,
+                             FALSE, FALSE, FALSE, FALSE, FALSE, ctx, pool));
+
+  /* Fetch the text of one subtree only */
+  apr_array_clear(paths);
+  APR_ARRAY_PUSH(paths, const char *) = svn_dirent_join(wc_path, "A/B",
+                                                        pool);
+  SVN_ERR(svn_client_hydrate(paths, svn_depth_infinity, ctx, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, alpha_path, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'alpha'.\n");
+  SVN_ERR(svn_io_check_path(iota_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* And then everything */
+  apr_array_clear(paths);
+  APR_ARRAY_PUSH(paths, const char *) = wc_path;
+  SVN_ERR(svn_client_hydrate(paths, svn_depth_infinity, ctx, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, iota_path, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'iota'.\n");
+  SVN_ERR(svn_wc_status3(&status, ctx->wc_ctx, iota_path, pool, pool));
+  SVN_TEST_ASSERT(status->node_status == svn_wc_status_normal);
+  SVN_TEST_ASSERT(status->text_status == svn_wc_status_normal);
+
+  return SVN_NO_ERROR;
+}
+
+/* Diff PATH at REVISION1 against PATH at REVISION2, discarding the
+   output. */
+static svn_error_t *
+diff_path(const char *path,
+          const svn_opt_revision_t *revision1,
+          const svn_opt_revision_t *revision2,
+          svn_client_ctx_t *ctx,
+          apr_pool_t *pool)
+{
+  return svn_error_trace(
+           svn_client_diff7(apr_array_make(pool, 0, sizeof(const char *)),
+                            path, revision1, path, revision2,
+                            NULL, svn_depth_infinity,
+                            FALSE, FALSE, FALSE, FALSE, FALSE, FALSE,
+                            FALSE, FALSE, FALSE, "UTF-8",
+                            svn_stream_empty(pool), svn_stream_empty(pool),
+                            NULL, ctx, pool));
+}
+
+/* Test that reading files added without their text either fetches it
+   or fails cleanly. */
+static svn_error_t *
+test_lazy_fetch_readers(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t committed_rev;
+  svn_client_ctx_t *ctx;
+  const char *repos_url;
+  const char *wc_path;
+  const char *export_path;
+  apr_array_header_t *targets;
+  apr_array_header_t *ranges;
+  svn_opt_revision_range_t range;
+  svn_opt_revision_t rev, peg_rev, working_rev, base_rev;
+  svn_stringbuf_t *contents;
+
+  SVN_ERR(create_greek_repos(&repos_url, "test-lazy-fetch-readers", opts,
+                             pool));
+
+  /* r2: change A/mu */
+  SVN_ERR(svn_repos_open3(&repos,
+                          svn_test_data_path("test-lazy-fetch-readers", pool),
+                          NULL, pool, pool));
+  SVN_ERR(svn_fs_begin_txn2(&txn, svn_repos_fs(repos), 1, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu",
+                                      "This is the file 'mu'.\n"
+                                      "Merged.\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &committed_rev, txn, pool));
+  SVN_TEST_ASSERT(committed_rev == 2);
+
+  SVN_ERR(checkout_lazy(&wc_path, &ctx, repos_url, 1,
+                        "test-lazy-fetch-readers-wc", pool));
+
+  base_rev.kind = svn_opt_revision_base;
+  working_rev.kind = svn_opt_revision_working;
+
+  /* A local diff has no text to compare a property change against */
+  targets = apr_array_make(pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(targets, const char *) = svn_dirent_join(wc_path, "iota",
+                                                          pool);
+  SVN_ERR(svn_client_propset_local("prop", svn_string_create("val", pool),
+                                   targets, svn_depth_empty, FALSE, NULL,
+                                   ctx, pool));
+  SVN_TEST_ASSERT_ERROR(diff_path(APR_ARRAY_IDX(targets, 0, const char *),
+                                  &base_rev, &working_rev, ctx, pool),
+                        SVN_ERR_WC_PATH_UNEXPECTED_STATUS);
+
+  /* Nor does a diff against another revision */
+  rev.kind = svn_opt_revision_number;
+  rev.value.number = 2;
+  SVN_TEST_ASSERT_ERROR(diff_path(svn_dirent_join(wc_path, "A/mu", pool),
+                                  &rev, &working_rev, ctx, pool),
+                        SVN_ERR_WC_PATH_UNEXPECTED_STATUS);
+
+  /* A merge fetches the text of the files it changes */
+  range.start.kind = svn_opt_revision_number;
+  range.start.value.number = 1;
+  range.end.kind = svn_opt_revision_number;
+  range.end.value.number = 2;
+  ranges = apr_array_make(pool, 1, sizeof(svn_opt_revision_range_t *));
+  APR_ARRAY_PUSH(ranges, svn_opt_revision_range_t *) = &range;
+  peg_rev.kind = svn_opt_revision_head;
+  SVN_ERR(svn_client_merge_peg5(svn_path_url_add_component2(repos_url,
+                                                            "A/mu", pool),
+                                ranges, &peg_rev,
+                                svn_dirent_join(wc_path, "A/mu", pool),
+                                svn_depth_infinity,
+                                TRUE, FALSE, FALSE, FALSE, FALSE, TRUE,
+                                NULL, ctx, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&contents,
+                                   svn_dirent_join(wc_path, "A/mu", pool),
+                                   pool));
+  SVN_TEST_STRING_ASSERT(contents->data,
+                         "This is the file 'mu'.\nMerged.\n");
+
+  /* An export fetches the text of all files it exports */
+  export_path = svn_test_data_path("test-lazy-fetch-readers-export", pool);
+  SVN_ERR(svn_io_remove_dir2(export_path, TRUE, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(export_path);
+  peg_rev.kind = svn_opt_revision_unspecified;
+  SVN_ERR(svn_client_export5(NULL, svn_dirent_join(wc_path, "A/B", pool),
+                             export_path, &peg_rev, &working_rev,
+                             FALSE, FALSE, FALSE, svn_depth_infinity, NULL,
+                             ctx, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&contents,
+                                   svn_dirent_join(export_path, "E/alpha",
+                                                   pool),
+                                   pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'alpha'.\n");
+  SVN_ERR(svn_stringbuf_from_file2(&contents,
+                                   svn_dirent_join(export_path, "lambda",
+                                                   pool),
+                                   pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'lambda'.\n");
+
+  /* Once fetched, the diff works */
+  SVN_ERR(svn_client_hydrate(targets, svn_depth_empty, ctx, pool));
+  SVN_ERR(diff_path(APR_ARRAY_IDX(targets, 0, const char *),
+                    &base_rev, &working_rev, ctx, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* A line of the file annotated by test_blame_edits(). */
+typedef struct blame_test_line_t
+{
+  svn_revnum_t revision;
+  int id;
+} blame_test_line_t;
+
+/* Baton for blame_test_receiver(). */
+typedef struct blame_test_baton_t
+{
+  /* The expected lines, as blame_test_line_t. */
+  apr_array_header_t *lines;
+
+  /* Number of lines received so far. */
+  int received;
+} blame_test_baton_t;
+
+/* Implements svn_client_blame_receiver3_t, comparing each line with the
+   expected one in the blame_test_baton_t BATON. */
+static svn_error_t *
+blame_test_receiver(void *baton,
+                    svn_revnum_t start_revnum,
+                    svn_revnum_t end_revnum,
+                    apr_int64_t line_no,
+                    svn_revnum_t revision,
+                    apr_hash_t *rev_props,
+                    svn_revnum_t merged_revision,
+                    apr_hash_t *merged_rev_props,
+                    const char *merged_path,
+                    const char *line,
+                    svn_boolean_t local_change,
+                    apr_pool_t *pool)
+{
+  blame_test_baton_t *b = baton;
+  const blame_test_line_t *expected;
+
+  SVN_TEST_ASSERT(line_no == b->received);
+  SVN_TEST_ASSERT(line_no < b->lines->nelts);
+
+  expected = &APR_ARRAY_IDX(b->lines, line_no, blame_test_line_t);
+  SVN_TEST_ASSERT(revision == expected->revision);
+  SVN_TEST_STRING_ASSERT(line, apr_psprintf(pool, "%ld.%d",
+                                            expected->revision,
+                                            expected->id));
+  b->received++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Insert COUNT new lines of REVISION into LINES before index POS,
+   numbering them from *NEXT_ID onwards. */
+static void
+blame_test_insert(apr_array_header_t *lines,
+                  int pos,
+                  int count,
+                  svn_revnum_t revision,
+                  int *next_id)
+{
+  int i;
+
+  for (i = 0; i < count; ++i)
+    {
+      blame_test_line_t line;
+
+      line.revision = revision;
+      line.id = (*next_id)++;
+      svn_sort__array_insert(lines, &line, pos + i);
+    }
+}
+
+/* Exercise the client-side blame chunk bookkeeping with many random line
+   insertions and deletions at random positions.  Each line is unique, so
+   its expected revision is known exactly. */
+static svn_error_t *
+test_blame_edits(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_client_ctx_t *ctx;
+  const char *repos_url;
+  svn_opt_revision_t peg_rev, start_rev, end_rev;
+  blame_test_baton_t b;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_uint32_t seed = 4711;
+  int next_id = 0;
+  svn_revnum_t rev;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(
+              &repos, svn_test_data_path("test-blame-edits", pool),
+              opts, pool));
+  SVN_ERR(svn_uri_get_file_url_from_dirent(
+              &repos_url, svn_test_data_path("test-blame-edits", pool),
+              pool));
+
+  b.lines = apr_array_make(pool, 0, sizeof(blame_test_line_t));
+  b.received = 0;
+  blame_test_insert(b.lines, 0, 20, 1, &next_id);
+
+  for (rev = 1; rev <= 100; ++rev)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *txn_root;
+      svn_stringbuf_t *contents;
+      svn_revnum_t committed_rev;
+
+      svn_pool_clear(iterpool);
+
+      /* Every revision after the first deletes and inserts a few
+         ranges of lines. */
+      for (i = 0; rev > 1 && i < 4; ++i)
+        {
+          int pos, count;
+
+          seed = seed * 1103515245 + 12345;
+          if ((seed >> 16) % 2 && b.lines->nelts > 1)
+            {
+              pos = (int)((seed >> 8) % b.lines->nelts);
+              count = 1 + (int)((seed >> 20) % 5);
+              if (count > b.lines->nelts - pos)
+                count = b.lines->nelts - pos;
+              svn_sort__array_delete(b.lines, pos, count);
+            }
+          else
+            {
+              pos = (int)((seed >> 8) % (b.lines->nelts + 1));
+              count = 1 + (int)((seed >> 20) % 4);
+              blame_test_insert(b.lines, pos, count, rev, &next_id);
+            }
+        }
+
+      contents = svn_stringbuf_create_empty(iterpool);
+      for (i = 0; i < b.lines->nelts; ++i)
+        {
+          const blame_test_line_t *line
+            = &APR_ARRAY_IDX(b.lines, i, blame_test_line_t);
+          svn_stringbuf_appendcstr(contents,
+                                   apr_psprintf(iterpool, "%ld.%d\n",
+                                                line->revision, line->id));
+        }
+
+      SVN_ERR(svn_fs_begin_txn2(&txn, svn_repos_fs(repos), rev - 1, 0,
+                                iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      if (rev == 1)
+        SVN_ERR(svn_fs_make_file(txn_root, "file", iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "file", contents->data,
+                                          iterpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &committed_rev, txn,
+                                      iterpool));
+      SVN_TEST_ASSERT(committed_rev == rev);
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_client_create_context2(&ctx, NULL, pool));
+
+  /* Servers may compute the blame themselves, but not with merge
+     information.  Request that to run the client-side engine. */
+  peg_rev.kind = svn_opt_revision_unspecified;
+  start_rev.kind = svn_opt_revision_number;
+  start_rev.value.number = 1;
+  end_rev.kind = svn_opt_revision_head;
+  SVN_ERR(svn_client_blame5(apr_pstrcat(pool, repos_url, "/file",
+                                        SVN_VA_NULL),
+                            &peg_rev, &start_rev, &end_rev,
+                            svn_diff_file_options_create(pool),
+                            FALSE, TRUE,
+                            blame_test_receiver, &b, ctx, pool));
+  SVN_TEST_ASSERT(b.received == b.lines->nelts);
+
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -1436,6 +1854,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_client_copy7 with externals_to_pin"),
     SVN_TEST_OPTS_PASS(test_copy_pin_externals_select_subtree,
                        "pin externals on selected subtrees only"),
+    SVN_TEST_OPTS_PASS(test_lazy_fetch,
+                       "test checkout with lazy-fetch and hydrate"),
+    SVN_TEST_OPTS_PASS(test_lazy_fetch_readers,
+                       "test reading files added without their text"),
+    SVN_TEST_OPTS_PASS(test_blame_edits,
+                       "test blame of many line insertions and deletions"),
     SVN_TEST_NULL
   };
 
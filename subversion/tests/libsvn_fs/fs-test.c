@@ -7369,6 +7369,60 @@ closest_copy_test_svn_4677(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_dir_prefetch(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t rev;
+  apr_hash_t *unordered;
+  apr_array_header_t *ordered;
+
+  /* Create a new repo with the greek tree in rev 1 and a few changes
+   * in rev 2, such that directory entries span multiple revisions. */
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-dir-prefetch", opts, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(test_commit_txn(&rev, txn, NULL, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "changed\n", pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A/Z", pool));
+  SVN_ERR(test_commit_txn(&rev, txn, NULL, pool));
+
+  /* Prefetch the entries of the root and of A. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+
+  SVN_ERR(svn_fs_dir_entries(&unordered, root, "", pool));
+  SVN_ERR(svn_fs_dir_optimal_order(&ordered, root, unordered, pool, pool));
+  SVN_ERR(svn_fs_dir_prefetch(root, ordered, pool));
+
+  SVN_ERR(svn_fs_dir_entries(&unordered, root, "A", pool));
+  SVN_ERR(svn_fs_dir_optimal_order(&ordered, root, unordered, pool, pool));
+  SVN_ERR(svn_fs_dir_prefetch(root, ordered, pool));
+
+  /* Uncommitted entries must be accepted as well. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A/Y", pool));
+  SVN_ERR(svn_fs_dir_entries(&unordered, txn_root, "A", pool));
+  SVN_ERR(svn_fs_dir_optimal_order(&ordered, txn_root, unordered,
+                                   pool, pool));
+  SVN_ERR(svn_fs_dir_prefetch(txn_root, ordered, pool));
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  /* The tree must still read back correctly. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, 1, pool));
+  SVN_ERR(svn_test__check_greek_tree(root, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -7513,6 +7567,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test rep-sharing on content rather than SHA1"),
     SVN_TEST_OPTS_PASS(closest_copy_test_svn_4677,
                        "test issue SVN-4677 regression"),
+    SVN_TEST_OPTS_PASS(test_dir_prefetch,
+                       "test svn_fs_dir_prefetch"),
     SVN_TEST_NULL
   };
 
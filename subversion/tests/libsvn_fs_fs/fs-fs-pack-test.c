@@ -1889,6 +1889,71 @@ large_delta_against_plain(const svn_test_opts_t *opts,
 
 
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-dir-prefetch-physical"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+static svn_error_t *
+dir_prefetch_physical_addressing(const svn_test_opts_t *opts,
+                                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_test_opts_t temp_opts;
+  apr_hash_t *fs_config;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t rev;
+
+  /* Packed and non-packed revisions in a repository using physical
+   * addressing, i.e. without an index to translate item numbers. */
+  temp_opts = *opts;
+  temp_opts.server_minor_version = 8;
+  SVN_ERR(create_packed_filesystem(REPO_NAME, &temp_opts, MAX_REV,
+                                   SHARD_SIZE, pool));
+
+  /* Make sure we actually read from disk. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  for (rev = 1; rev <= MAX_REV; ++rev)
+    {
+      static const char * const dirs[] = { "", "A", "A/D" };
+      svn_fs_root_t *root;
+      apr_size_t i;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+
+      for (i = 0; i < sizeof(dirs) / sizeof(dirs[0]); ++i)
+        {
+          apr_hash_t *unordered;
+          apr_array_header_t *ordered;
+
+          SVN_ERR(svn_fs_dir_entries(&unordered, root, dirs[i], iterpool));
+          SVN_ERR(svn_fs_dir_optimal_order(&ordered, root, unordered,
+                                           iterpool, iterpool));
+          SVN_ERR(svn_fs_dir_prefetch(root, ordered, iterpool));
+        }
+    }
+
+  /* The tree must still read back correctly. */
+  {
+    svn_fs_root_t *root;
+    SVN_ERR(svn_fs_revision_root(&root, fs, 1, pool));
+    SVN_ERR(svn_test__check_greek_tree(root, pool));
+  }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -1942,6 +2007,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack with limited memory for metadata"),
     SVN_TEST_OPTS_PASS(large_delta_against_plain,
                        "large deltas against PLAIN, issue #4658"),
+    SVN_TEST_OPTS_PASS(dir_prefetch_physical_addressing,
+                       "prefetch directories with physical addressing"),
     SVN_TEST_NULL
   };
 
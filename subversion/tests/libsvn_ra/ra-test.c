@@ -34,6 +34,7 @@
 #include "svn_time.h"
 #include "svn_pools.h"
 #include "svn_cmdline.h"
+#include "svn_config.h"
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
 
@@ -1784,6 +1785,164 @@ commit_locked_file(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Add (if ADD is set) or modify the files "f0" to "f<COUNT-1>" in the
+   root directory through EDITOR / EDIT_BATON, giving each the contents
+   "<PREFIX> <number>\n".  Claim a wrong result checksum for file
+   BAD_FILE, unless that is negative.  Don't close the edit. */
+static svn_error_t *
+put_many_files(const svn_delta_editor_t *editor,
+               void *edit_baton,
+               int count,
+               svn_boolean_t add,
+               const char *prefix,
+               int bad_file,
+               apr_pool_t *pool)
+{
+  void *root_baton;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(editor->open_root(edit_baton, add ? 0 : 1, pool, &root_baton));
+  for (i = 0; i < count; i++)
+    {
+      const char *name;
+      svn_stringbuf_t *contents;
+      svn_checksum_t *checksum;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      void *file_baton;
+
+      svn_pool_clear(iterpool);
+      name = apr_psprintf(iterpool, "f%d", i);
+      contents = svn_stringbuf_createf(iterpool, "%s %d\n", prefix, i);
+
+      if (add)
+        SVN_ERR(editor->add_file(name, root_baton, NULL, SVN_INVALID_REVNUM,
+                                 iterpool, &file_baton));
+      else
+        SVN_ERR(editor->open_file(name, root_baton, 1, iterpool,
+                                  &file_baton));
+
+      SVN_ERR(editor->apply_textdelta(file_baton, NULL, iterpool,
+                                      &handler, &handler_baton));
+      SVN_ERR(svn_txdelta_send_contents((const unsigned char *)contents->data,
+                                        contents->len, handler,
+                                        handler_baton, iterpool));
+
+      if (i == bad_file)
+        svn_stringbuf_appendcstr(contents, "wrong");
+      SVN_ERR(svn_checksum(&checksum, svn_checksum_md5,
+                           contents->data, contents->len, iterpool));
+      SVN_ERR(editor->close_file(file_baton,
+                                 svn_checksum_to_cstring(checksum, iterpool),
+                                 iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(editor->close_directory(root_baton, pool));
+}
+
+/* Verify that the files written by put_many_files() for COUNT and PREFIX
+   are in HEAD of SESSION. */
+static svn_error_t *
+check_many_files(svn_ra_session_t *session,
+                 int count,
+                 const char *prefix,
+                 apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; i < count; i++)
+    {
+      svn_stringbuf_t *contents;
+
+      svn_pool_clear(iterpool);
+      contents = svn_stringbuf_create_empty(iterpool);
+      SVN_ERR(svn_ra_get_file(session, apr_psprintf(iterpool, "f%d", i),
+                              SVN_INVALID_REVNUM,
+                              svn_stream_from_stringbuf(contents, iterpool),
+                              NULL, NULL, iterpool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             apr_psprintf(iterpool, "%s %d\n", prefix, i));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Commit many files in one go with http-pipelined-commits enabled.  Over
+   ra_serf, that queues many PUT requests on one connection, of which one
+   fails in the second commit. */
+static svn_error_t *
+commit_many_files_pipelined(const svn_test_opts_t *opts,
+                            apr_pool_t *pool)
+{
+  const int count = 200;
+  svn_ra_session_t *session;
+  svn_ra_callbacks2_t *cbtable;
+  const char *url;
+  apr_hash_t *config;
+  svn_config_t *servers;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  svn_revnum_t youngest;
+  svn_error_t *err;
+
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  SVN_ERR(svn_test__init_auth_baton(&cbtable->auth_baton, pool));
+
+  SVN_ERR(svn_test__create_repos2(NULL, &url, NULL,
+                                  "test-repo-commit-many-pipelined",
+                                  opts, pool, pool));
+  SVN_ERR(svn_ra_initialize(pool));
+
+  SVN_ERR(svn_config_create2(&servers, FALSE, FALSE, pool));
+  svn_config_set_bool(servers, SVN_CONFIG_SECTION_GLOBAL,
+                      SVN_CONFIG_OPTION_HTTP_PIPELINED_COMMITS, TRUE);
+  config = apr_hash_make(pool);
+  svn_hash_sets(config, SVN_CONFIG_CATEGORY_SERVERS, servers);
+
+  SVN_ERR(svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, config,
+                       pool));
+
+  /* r1: add all the files. */
+  SVN_ERR(svn_ra_get_commit_editor3(session, &editor, &edit_baton,
+                                    apr_hash_make(pool), NULL, NULL,
+                                    NULL, TRUE, pool));
+  SVN_ERR(put_many_files(editor, edit_baton, count, TRUE, "first", -1,
+                         pool));
+  SVN_ERR(editor->close_edit(edit_baton, pool));
+  SVN_ERR(check_many_files(session, count, "first", pool));
+
+  /* A commit with one failing PUT among many must fail as a whole. */
+  SVN_ERR(svn_ra_get_commit_editor3(session, &editor, &edit_baton,
+                                    apr_hash_make(pool), NULL, NULL,
+                                    NULL, TRUE, pool));
+  err = put_many_files(editor, edit_baton, count, FALSE, "bad", count / 2,
+                       pool);
+  if (!err)
+    err = editor->close_edit(edit_baton, pool);
+
+  SVN_TEST_ASSERT(err != SVN_NO_ERROR);
+  svn_error_clear(err);
+  svn_error_clear(editor->abort_edit(edit_baton, pool));
+
+  SVN_ERR(svn_ra_get_latest_revnum(session, &youngest, pool));
+  SVN_TEST_INT_ASSERT((int) youngest, 1);
+  SVN_ERR(check_many_files(session, count, "first", pool));
+
+  /* The session must still be usable for another commit. */
+  SVN_ERR(svn_ra_get_commit_editor3(session, &editor, &edit_baton,
+                                    apr_hash_make(pool), NULL, NULL,
+                                    NULL, TRUE, pool));
+  SVN_ERR(put_many_files(editor, edit_baton, count, FALSE, "second", -1,
+                         pool));
+  SVN_ERR(editor->close_edit(edit_baton, pool));
+  SVN_ERR(check_many_files(session, count, "second", pool));
+
+  return SVN_NO_ERROR;
+}
 
 /* The test table.  */
 
@@ -1820,6 +1979,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "check how last change applies to empty commit"),
     SVN_TEST_OPTS_PASS(commit_locked_file,
                        "check commit editor for a locked file"),
+    SVN_TEST_OPTS_PASS(commit_many_files_pipelined,
+                       "commit many files with pipelined PUTs"),
     SVN_TEST_NULL
   };
 
@@ -28,6 +28,7 @@
 #include "svn_error.h"
 #include "svn_fs.h"
 #include "svn_repos.h"
+#include "svn_cache_config.h"
 #include "private/svn_repos_private.h"
 
 #include "../svn_test.h"
@@ -273,6 +274,181 @@ test_load_r0_mergeinfo(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Dump REPOS with text deltas and return the dump data in *DUMP_DATA_P.
+ */
+static svn_error_t *
+dump_with_deltas(svn_stringbuf_t **dump_data_p,
+                 svn_repos_t *repos,
+                 apr_pool_t *pool)
+{
+  svn_stringbuf_t *dump_data = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(dump_data, pool);
+
+  SVN_ERR(svn_repos_dump_fs4(repos, stream, 0, SVN_INVALID_REVNUM,
+                             FALSE, TRUE, TRUE, TRUE,
+                             NULL, NULL, NULL, NULL, NULL, NULL,
+                             pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  *dump_data_p = dump_data;
+  return SVN_NO_ERROR;
+}
+
+/* Commit a few revisions with adds, modifications, copies and deletions
+ * of small and large files to the empty repository REPOS.
+ */
+static svn_error_t *
+populate_repos(svn_repos_t *repos,
+               apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_fs_root_t *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *big = svn_stringbuf_create_empty(pool);
+  int i;
+
+  /* Large enough to span several svndiff windows. */
+  for (i = 0; i < 20000; ++i)
+    svn_stringbuf_appendcstr(big, apr_psprintf(pool, "line %d\n", i));
+
+  /* r1: add a directory with files. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "/A", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/A/small", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "/A/small", "small\n", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/A/big", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "/A/big", big->data, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2: modify a file and set a property. */
+  svn_stringbuf_appendcstr(big, "one more line\n");
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "/A/big", big->data, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "/A/small", "p",
+                                  svn_string_create("v", pool), pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r3: copy and delete. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "/A", txn_root, "/B", pool));
+  SVN_ERR(svn_fs_delete(txn_root, "/A/small", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_load_pipelined(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_stringbuf_t *dump_data;
+  svn_stringbuf_t *reloaded_data;
+  const svn_repos_parse_fns3_t *parser;
+  void *parse_baton;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-pipelined",
+                                 opts, pool));
+  SVN_ERR(populate_repos(repos, pool));
+  SVN_ERR(dump_with_deltas(&dump_data, repos, pool));
+
+  /* Load through the pipeline, with and without decoder threads, and
+   * expect the result to dump the same. */
+  for (i = 2; i <= 3; ++i)
+    {
+      svn_stream_t *stream = svn_stream_from_stringbuf(dump_data, pool);
+      svn_repos_t *loaded;
+      const char *name = apr_psprintf(pool, "test-repo-load-pipelined-%d", i);
+
+      SVN_ERR(svn_test__create_repos(&loaded, name, opts, pool));
+      SVN_ERR(svn_repos_get_fs_build_parser6(&parser, &parse_baton, loaded,
+                                             SVN_INVALID_REVNUM,
+                                             SVN_INVALID_REVNUM,
+                                             TRUE, TRUE,
+                                             svn_repos_load_uuid_default,
+                                             NULL, FALSE, FALSE, FALSE, FALSE,
+                                             NULL, NULL, pool));
+      SVN_ERR(svn_repos__parse_dumpstream_pipelined(stream, parser,
+                                                    parse_baton, i,
+                                                    NULL, NULL, pool));
+
+      SVN_ERR(dump_with_deltas(&reloaded_data, loaded, pool));
+      SVN_TEST_ASSERT(svn_stringbuf_compare(dump_data, reloaded_data));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_dump_parallel(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_boolean_t incremental;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-dump-parallel",
+                                 opts, pool));
+  SVN_ERR(populate_repos(repos, pool));
+
+  /* Full and incremental dumps of all and of partial revision ranges
+   * must not depend on the number of threads. */
+  for (incremental = FALSE; incremental <= TRUE; ++incremental)
+    {
+      svn_revnum_t start_rev;
+
+      for (start_rev = 0; start_rev <= 2; ++start_rev)
+        {
+          svn_stringbuf_t *expected = svn_stringbuf_create_empty(pool);
+          svn_stringbuf_t *actual = svn_stringbuf_create_empty(pool);
+          svn_stream_t *stream;
+
+          stream = svn_stream_from_stringbuf(expected, pool);
+          SVN_ERR(svn_repos_dump_fs4(repos, stream, start_rev,
+                                     SVN_INVALID_REVNUM, incremental, TRUE,
+                                     TRUE, TRUE, NULL, NULL, NULL, NULL,
+                                     NULL, NULL, pool));
+          SVN_ERR(svn_stream_close(stream));
+
+          stream = svn_stream_from_stringbuf(actual, pool);
+          SVN_ERR(svn_repos__dump_fs(repos, stream, start_rev,
+                                     SVN_INVALID_REVNUM, incremental, TRUE,
+                                     TRUE, TRUE, NULL, NULL, NULL, NULL,
+                                     3, NULL, NULL, NULL, pool));
+          SVN_ERR(svn_stream_close(stream));
+
+          SVN_TEST_ASSERT(svn_stringbuf_compare(expected, actual));
+        }
+    }
+
+#if APR_HAS_THREADS
+  /* Workers must not share caches that are not thread-safe. */
+  {
+    svn_cache_config_t settings = *svn_cache_config_get();
+    svn_cache_config_t single_threaded = settings;
+    svn_error_t *err;
+
+    single_threaded.single_threaded = TRUE;
+    svn_cache_config_set(&single_threaded);
+    err = svn_repos__dump_fs(repos, svn_stream_empty(pool), 0,
+                             SVN_INVALID_REVNUM, FALSE, TRUE, TRUE, TRUE,
+                             NULL, NULL, NULL, NULL, 3, NULL, NULL, NULL,
+                             pool);
+    svn_cache_config_set(&settings);
+
+    SVN_TEST_ASSERT_ERROR(err, SVN_ERR_REPOS_BAD_ARGS);
+  }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -284,6 +460,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test dumping with r0 mergeinfo"),
     SVN_TEST_OPTS_PASS(test_load_r0_mergeinfo,
                        "test loading with r0 mergeinfo"),
+    SVN_TEST_OPTS_PASS(test_load_pipelined,
+                       "test pipelined loading"),
+    SVN_TEST_OPTS_PASS(test_dump_parallel,
+                       "test dumping with several threads"),
     SVN_TEST_NULL
   };
 
@@ -4466,6 +4466,560 @@ test_list(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+reporter_delta_threads(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+
+  /* Create the greek tree in r1. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-reporter-delta-threads",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* "Check out" r1 into a txn based on r0, with the text deltas being
+     computed by worker threads. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                               txn_root, "", pool));
+
+  SVN_ERR(svn_repos_begin_report3(&report_baton, youngest_rev, repos,
+                                  "/", "", NULL, TRUE, svn_depth_infinity,
+                                  FALSE, FALSE, editor, edit_baton,
+                                  NULL, NULL, 0, pool));
+  SVN_ERR(svn_repos__report_set_delta_threads(report_baton, 2, 0, NULL));
+  SVN_ERR(svn_repos_set_path3(report_baton, "", 0, svn_depth_infinity,
+                              TRUE, NULL, pool));
+  SVN_ERR(svn_repos_finish_report(report_baton, pool));
+
+  /* We must have received the full tree. */
+  SVN_ERR(svn_test__check_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cancel_func_t.  Slow down the editor drive such that
+   the delta workers get ahead of it. */
+static svn_error_t *
+slow_editor_cancel(void *baton)
+{
+  apr_sleep(1000);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+reporter_delta_threads_many_files(const svn_test_opts_t *opts,
+                                  apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  enum { FILE_COUNT = 200 };
+  int i;
+
+  /* Create many files with contents that differ from file to file and
+     get deltified in r1, so that the workers have some work to do. */
+  SVN_ERR(svn_test__create_repos(&repos,
+                                 "test-repo-reporter-delta-threads-many",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "/big", pool));
+  for (i = 0; i < FILE_COUNT; ++i)
+    {
+      svn_stringbuf_t *contents;
+      int k;
+
+      svn_pool_clear(iterpool);
+      contents = svn_stringbuf_create_empty(iterpool);
+      for (k = 0; k < 200; ++k)
+        svn_stringbuf_appendcstr(contents,
+                                 apr_psprintf(iterpool,
+                                              "file %d, line %d\n", i, k));
+
+      SVN_ERR(svn_fs_make_file(txn_root,
+                               apr_psprintf(iterpool, "/big/f%03d", i),
+                               iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root,
+                                          apr_psprintf(iterpool,
+                                                       "/big/f%03d", i),
+                                          contents->data, iterpool));
+    }
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* "Check out" r1 through an editor drive slow enough for the workers to
+     precompute most of the deltas. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                               txn_root, "", pool));
+  SVN_ERR(svn_delta_get_cancellation_editor(slow_editor_cancel, NULL,
+                                            editor, edit_baton,
+                                            &editor, &edit_baton, pool));
+
+  SVN_ERR(svn_repos_begin_report3(&report_baton, youngest_rev, repos,
+                                  "/", "", NULL, TRUE, svn_depth_infinity,
+                                  FALSE, FALSE, editor, edit_baton,
+                                  NULL, NULL, 0, pool));
+  SVN_ERR(svn_repos__report_set_delta_threads(report_baton, 4, 0, NULL));
+  SVN_ERR(svn_repos_set_path3(report_baton, "", 0, svn_depth_infinity,
+                              TRUE, NULL, pool));
+  SVN_ERR(svn_repos_finish_report(report_baton, pool));
+
+  /* Every file must have arrived intact. */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  for (i = 0; i < FILE_COUNT; ++i)
+    {
+      const char *path;
+      svn_stringbuf_t *expected, *actual;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "/big/f%03d", i);
+      SVN_ERR(svn_test__get_file_contents(rev_root, path, &expected,
+                                          iterpool));
+      SVN_ERR(svn_test__get_file_contents(txn_root, path, &actual,
+                                          iterpool));
+      SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+    }
+
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* svn_repos_log_entry_receiver_t appending the revision to the
+   svn_stringbuf_t BATON.  Revisions with merged children get a "+". */
+static svn_error_t *
+log_index_receiver(void *baton,
+                   svn_repos_log_entry_t *log_entry,
+                   apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *result = baton;
+  svn_stringbuf_appendcstr(result,
+                           apr_psprintf(scratch_pool, " %ld%s",
+                                        log_entry->revision,
+                                        log_entry->has_children ? "+" : ""));
+  return SVN_NO_ERROR;
+}
+
+/* Return the log of PATH in REPOS as a string of space-separated
+   revisions, allocated in POOL.  The other parameters are as for
+   svn_repos_get_logs5(). */
+static svn_error_t *
+log_index_get_log(const char **log,
+                  svn_repos_t *repos,
+                  const char *path,
+                  svn_revnum_t start,
+                  svn_revnum_t end,
+                  int limit,
+                  svn_boolean_t strict_node_history,
+                  svn_boolean_t include_merged_revisions,
+                  apr_pool_t *pool)
+{
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(const char *));
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+
+  APR_ARRAY_PUSH(paths, const char *) = path;
+  SVN_ERR(svn_repos_get_logs5(repos, paths, start, end, limit,
+                              strict_node_history, include_merged_revisions,
+                              NULL, NULL, NULL, NULL, NULL,
+                              log_index_receiver, result, pool));
+
+  *log = result->data;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+log_index(const svn_test_opts_t *opts,
+          apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  apr_hash_t *expected = apr_hash_make(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i, k;
+  const char *paths[] = { "A/mu", "A2/B/E/alpha", "A2", "A/B", "/", "iota",
+                          "A2/D/G" };
+  const struct {
+    svn_revnum_t start, end;
+    int limit;
+    svn_boolean_t strict;
+  } ranges[] = { { 6, 0, 0, FALSE }, { 0, 6, 0, FALSE }, { 6, 0, 2, FALSE },
+                 { 0, 6, 2, FALSE }, { 6, 0, 0, TRUE }, { 5, 3, 0, FALSE },
+                 { 3, 5, 1, TRUE } };
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-log-index", opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: The greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2: Modify A/mu and A/B/E/alpha. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "r2", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/E/alpha", "r2", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r3: Copy A to A2. */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A", txn_root, "A2", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r4: Modify A2/B/E/alpha and delete A/B/lambda. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A2/B/E/alpha", "r4", pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/B/lambda", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r5: Change a property on A2/D/G. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A2/D/G", "prop",
+                                  svn_string_create("r5", pool), pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r6: Modify iota. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "r6", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* Record the logs without index. */
+  for (i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+    for (k = 0; k < sizeof(ranges) / sizeof(ranges[0]); k++)
+      {
+        const char *log;
+        SVN_ERR(log_index_get_log(&log, repos, paths[i], ranges[k].start,
+                                  ranges[k].end, ranges[k].limit,
+                                  ranges[k].strict, FALSE, pool));
+        svn_hash_sets(expected, apr_psprintf(pool, "%d %d", i, k), log);
+      }
+
+  /* The same logs must be reported by the index, right after building it
+     as well as after it has been updated by a commit. */
+  SVN_ERR(svn_repos__log_index_build(repos, NULL, NULL, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/gamma", "r7", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  for (i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+    for (k = 0; k < sizeof(ranges) / sizeof(ranges[0]); k++)
+      {
+        const char *log;
+
+        svn_pool_clear(iterpool);
+        SVN_ERR(log_index_get_log(&log, repos, paths[i], ranges[k].start,
+                                  ranges[k].end, ranges[k].limit,
+                                  ranges[k].strict, FALSE, iterpool));
+        SVN_TEST_STRING_ASSERT(log,
+                               svn_hash_gets(expected,
+                                             apr_psprintf(iterpool, "%d %d",
+                                                          i, k)));
+      }
+
+  /* r7 must have been indexed as well. */
+  {
+    const char *log;
+    SVN_ERR(log_index_get_log(&log, repos, "A/D", youngest_rev, 0, 1,
+                              FALSE, FALSE, iterpool));
+    SVN_TEST_STRING_ASSERT(log, " 7");
+  }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+log_index_merged(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  const char *paths[] = { "A2", "A2/mu", "A", "/" };
+  const char *expected[sizeof(paths) / sizeof(paths[0])];
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-log-index-merged",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: The greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2: Branch A to A2. */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A", txn_root, "A2", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r3: Modify A/mu. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "r3", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r4: "Merge" r3 into A2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A2/mu", "r3", pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A2", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/A:3", pool), pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* Record the merge-aware logs without index. */
+  for (i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+    SVN_ERR(log_index_get_log(&expected[i], repos, paths[i], youngest_rev,
+                              0, 0, FALSE, TRUE, pool));
+  SVN_TEST_ASSERT(strstr(expected[0], " 4+ 3 ") == expected[0]);
+
+  /* The index must report the same mergeinfo changes. */
+  SVN_ERR(svn_repos__log_index_build(repos, NULL, NULL, pool));
+  for (i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+    {
+      const char *log;
+      SVN_ERR(log_index_get_log(&log, repos, paths[i], youngest_rev,
+                                0, 0, FALSE, TRUE, pool));
+      SVN_TEST_STRING_ASSERT(log, expected[i]);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos__blame_receiver_t, appending " START+COUNT:REV"
+   to the svn_stringbuf_t BATON. */
+static svn_error_t *
+server_blame_receiver(void *baton,
+                      apr_int64_t start_line,
+                      apr_int64_t line_count,
+                      svn_revnum_t revision,
+                      apr_hash_t *rev_props,
+                      apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *result = baton;
+
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(revision) == (rev_props != NULL));
+  svn_stringbuf_appendcstr(result,
+                           apr_psprintf(scratch_pool,
+                                        " %" APR_INT64_T_FMT
+                                        "+%" APR_INT64_T_FMT ":%ld",
+                                        start_line, line_count, revision));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+server_blame(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_diff_file_options_t diff_options = { 0 };
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream;
+  char block[SVN__STREAM_CHUNK_SIZE];
+  int i;
+  const char *contents[] = { "a\nb\nc\n", "a\nB\nc\n", "a\nB\nc\nd\n",
+                             "x\na\nB\nc\nd\n", "x\na \nB\nc\nd\n" };
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-server-blame",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1 to r5: Modify the file line by line. */
+  for (i = 0; i < sizeof(contents) / sizeof(contents[0]); i++)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      if (i == 0)
+        SVN_ERR(svn_fs_make_file(txn_root, "f", pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "f", contents[i], pool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      pool));
+    }
+
+  SVN_ERR(svn_repos__get_blame(repos, "/f", 0, 4, &diff_options, NULL, NULL,
+                               server_blame_receiver, result, NULL, NULL,
+                               pool));
+  SVN_TEST_STRING_ASSERT(result->data, " 0+1:4 1+1:1 2+1:2 3+1:1 4+1:3");
+
+  /* Lines changed before the start revision have no revision. */
+  svn_stringbuf_setempty(result);
+  SVN_ERR(svn_repos__get_blame(repos, "/f", 3, 4, &diff_options, NULL, NULL,
+                               server_blame_receiver, result, NULL, NULL,
+                               pool));
+  SVN_TEST_STRING_ASSERT(result->data, " 0+1:4 1+3:-1 4+1:3");
+
+  svn_stringbuf_setempty(result);
+  SVN_ERR(svn_repos__get_blame(repos, "/f", 1, 5, &diff_options, NULL, NULL,
+                               server_blame_receiver, result, NULL, NULL,
+                               pool));
+  SVN_TEST_STRING_ASSERT(result->data,
+                         " 0+1:4 1+1:5 2+1:2 3+1:1 4+1:3");
+
+  /* Whitespace changes may be ignored. */
+  diff_options.ignore_space = svn_diff_file_ignore_space_all;
+  svn_stringbuf_setempty(result);
+  SVN_ERR(svn_repos__get_blame(repos, "/f", 1, 5, &diff_options, NULL, NULL,
+                               server_blame_receiver, result, NULL, NULL,
+                               pool));
+  SVN_TEST_STRING_ASSERT(result->data,
+                         " 0+1:4 1+1:1 2+1:2 3+1:1 4+1:3");
+
+  /* r6: Files too large to diff in memory are left to the client. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_apply_text(&stream, txn_root, "f", NULL, pool));
+  memset(block, 'x', sizeof(block));
+  for (i = 0; i <= SVN_REPOS__BLAME_MAX_TEXT_SIZE / sizeof(block); i++)
+    {
+      apr_size_t len = sizeof(block);
+
+      SVN_ERR(svn_stream_write(stream, block, &len));
+    }
+  SVN_ERR(svn_stream_close(stream));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  svn_stringbuf_setempty(result);
+  SVN_TEST_ASSERT_ERROR(svn_repos__get_blame(repos, "/f", 1, 6,
+                                             &diff_options, NULL, NULL,
+                                             server_blame_receiver, result,
+                                             NULL, NULL, pool),
+                        SVN_ERR_UNSUPPORTED_FEATURE);
+  SVN_TEST_STRING_ASSERT(result->data, "");
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+server_blame_cache(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_diff_file_options_t diff_options = { 0 };
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  svn_node_kind_t kind;
+  int i;
+  const char *contents[] = { "a\nb\nc\n", "a\nB\nc\n", "a\nB\nc\nd\n",
+                             "x\na\nB\nc\nd\n" };
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-server-blame-cache",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1 to r3: Modify the file line by line. */
+  for (i = 0; i < 3; i++)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      if (i == 0)
+        SVN_ERR(svn_fs_make_file(txn_root, "f", pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "f", contents[i], pool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      pool));
+    }
+
+  /* The first call fills the cache, the second one reads it. */
+  SVN_ERR(svn_repos__get_blame(repos, "/f", 1, 3, &diff_options, NULL, NULL,
+                               server_blame_receiver, result, NULL, NULL,
+                               pool));
+  SVN_TEST_STRING_ASSERT(result->data, " 0+1:1 1+1:2 2+1:1 3+1:3");
+  SVN_ERR(svn_io_check_path(svn_dirent_join(svn_repos_path(repos, pool),
+                                            "blame-cache.db", pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  svn_stringbuf_setempty(result);
+  SVN_ERR(svn_repos__get_blame(repos, "/f", 1, 3, &diff_options, NULL, NULL,
+                               server_blame_receiver, result, NULL, NULL,
+                               pool));
+  SVN_TEST_STRING_ASSERT(result->data, " 0+1:1 1+1:2 2+1:1 3+1:3");
+
+  /* r4: Continue from the cached r3 result. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "f", contents[3], pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  svn_stringbuf_setempty(result);
+  SVN_ERR(svn_repos__get_blame(repos, "/f", 1, 4, &diff_options, NULL, NULL,
+                               server_blame_receiver, result, NULL, NULL,
+                               pool));
+  SVN_TEST_STRING_ASSERT(result->data, " 0+1:4 1+1:1 2+1:2 3+1:1 4+1:3");
+
+  /* Older revisions still work after their entry got replaced. */
+  svn_stringbuf_setempty(result);
+  SVN_ERR(svn_repos__get_blame(repos, "/f", 1, 3, &diff_options, NULL, NULL,
+                               server_blame_receiver, result, NULL, NULL,
+                               pool));
+  SVN_TEST_STRING_ASSERT(result->data, " 0+1:1 1+1:2 2+1:1 3+1:3");
+
+  /* r5: Replace the file.  The cache entry for the old node must not be
+     used for the new one. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "f", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "f", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "f", contents[3], pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  svn_stringbuf_setempty(result);
+  SVN_ERR(svn_repos__get_blame(repos, "/f", 1, 5, &diff_options, NULL, NULL,
+                               server_blame_receiver, result, NULL, NULL,
+                               pool));
+  SVN_TEST_STRING_ASSERT(result->data, " 0+5:5");
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -4537,6 +5091,18 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "optional authz wildcard performance test"),
     SVN_TEST_OPTS_PASS(test_list,
                        "test svn_repos_list"),
+    SVN_TEST_OPTS_PASS(reporter_delta_threads,
+                       "test reporter with text delta threads"),
+    SVN_TEST_OPTS_PASS(reporter_delta_threads_many_files,
+                       "test reporter delta threads with many files"),
+    SVN_TEST_OPTS_PASS(log_index,
+                       "test the changed-paths index for svn log"),
+    SVN_TEST_OPTS_PASS(log_index_merged,
+                       "test the mergeinfo changes in the log index"),
+    SVN_TEST_OPTS_PASS(server_blame,
+                       "test svn_repos__get_blame"),
+    SVN_TEST_OPTS_PASS(server_blame_cache,
+                       "test the server-side blame cache"),
     SVN_TEST_NULL
   };
 
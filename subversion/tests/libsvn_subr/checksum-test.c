@@ -25,8 +25,12 @@
 
 #include <zlib.h>
 
+#include "svn_dirent_uri.h"
 #include "svn_error.h"
 #include "svn_io.h"
+#include "svn_sorts.h"
+
+#include "private/svn_subr_private.h"
 
 #include "../svn_test.h"
 
@@ -364,6 +368,228 @@ test_checksummed_stream_reset(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Verify that the MD5 and SHA1 checksums of DATA match the hex digests
+ * EXPECTED_MD5 and EXPECTED_SHA1, feeding the data in chunks of CHUNK_SIZE
+ * bytes into all our checksumming APIs. */
+static svn_error_t *
+verify_md5_sha1(const svn_string_t *data,
+                apr_size_t chunk_size,
+                const char *expected_md5,
+                const char *expected_sha1,
+                apr_pool_t *pool)
+{
+  svn_checksum_t *md5_checksum;
+  svn_checksum_t *sha1_checksum;
+  svn_checksum_ctx_t *md5_ctx = svn_checksum_ctx_create(svn_checksum_md5,
+                                                        pool);
+  svn_checksum_ctx_t *sha1_ctx = svn_checksum_ctx_create(svn_checksum_sha1,
+                                                         pool);
+  svn_checksum__md5_sha1_ctx_t *ctx
+    = svn_checksum__md5_sha1_ctx_create(TRUE, pool);
+  apr_size_t i;
+
+  for (i = 0; i < data->len; i += chunk_size)
+    {
+      apr_size_t len = MIN(chunk_size, data->len - i);
+
+      SVN_ERR(svn_checksum_update(md5_ctx, data->data + i, len));
+      SVN_ERR(svn_checksum_update(sha1_ctx, data->data + i, len));
+      svn_checksum__md5_sha1_update(ctx, data->data + i, len);
+    }
+
+  SVN_ERR(svn_checksum_final(&md5_checksum, md5_ctx, pool));
+  SVN_TEST_STRING_ASSERT(svn_checksum_to_cstring_display(md5_checksum, pool),
+                         expected_md5);
+  SVN_ERR(svn_checksum_final(&sha1_checksum, sha1_ctx, pool));
+  SVN_TEST_STRING_ASSERT(svn_checksum_to_cstring_display(sha1_checksum, pool),
+                         expected_sha1);
+
+  svn_checksum__md5_sha1_final(&md5_checksum, &sha1_checksum, ctx, pool);
+  SVN_TEST_STRING_ASSERT(svn_checksum_to_cstring_display(md5_checksum, pool),
+                         expected_md5);
+  SVN_TEST_STRING_ASSERT(svn_checksum_to_cstring_display(sha1_checksum, pool),
+                         expected_sha1);
+
+  SVN_ERR(svn_checksum(&md5_checksum, svn_checksum_md5, data->data,
+                       data->len, pool));
+  SVN_TEST_STRING_ASSERT(svn_checksum_to_cstring_display(md5_checksum, pool),
+                         expected_md5);
+  SVN_ERR(svn_checksum(&sha1_checksum, svn_checksum_sha1, data->data,
+                       data->len, pool));
+  SVN_TEST_STRING_ASSERT(svn_checksum_to_cstring_display(sha1_checksum, pool),
+                         expected_sha1);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_md5_sha1_vectors(apr_pool_t *pool)
+{
+  svn_stringbuf_t *buffer = svn_stringbuf_create_empty(pool);
+  const svn_string_t *million_a;
+  apr_size_t chunk_sizes[] = { 1, 3, 63, 64, 65, 4096, 1000000 };
+  int i;
+
+  SVN_ERR(verify_md5_sha1(svn_string_create("abc", pool), 1,
+                          "900150983cd24fb0d6963f7d28e17f72",
+                          "a9993e364706816aba3e25717850c26c9cd0d89d",
+                          pool));
+  SVN_ERR(verify_md5_sha1(svn_string_create("abcdbcdecdefdefgefghfghighijhi"
+                                            "jkijkljklmklmnlmnomnopnopq",
+                                            pool), 7,
+                          "8215ef0796a20bcaaae116d3876c664a",
+                          "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+                          pool));
+
+  /* Exercise all combinations of partial and complete blocks. */
+  svn_stringbuf_appendfill(buffer, 'a', 1000000);
+  million_a = svn_string_create_from_buf(buffer, pool);
+  for (i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); ++i)
+    SVN_ERR(verify_md5_sha1(million_a, chunk_sizes[i],
+                            "7707d6ae4e027c70eea2a935c2296f21",
+                            "34aa973cd4c4daa4f61eeb2bdbad27316534016f",
+                            pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_md5_sha1_stream(apr_pool_t *pool)
+{
+  const svn_string_t *str = svn_string_create("abcde", pool);
+  svn_checksum_t *expected_md5, *expected_sha1;
+  svn_checksum_t *md5_checksum, *sha1_checksum;
+  svn_stringbuf_t *target = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream;
+
+  SVN_ERR(svn_checksum(&expected_md5, svn_checksum_md5, str->data, str->len,
+                       pool));
+  SVN_ERR(svn_checksum(&expected_sha1, svn_checksum_sha1, str->data,
+                       str->len, pool));
+
+  stream = svn_checksum__wrap_write_stream_md5_sha1(
+             &md5_checksum, &sha1_checksum,
+             svn_stream_from_stringbuf(target, pool), pool);
+  SVN_ERR(svn_stream_puts(stream, str->data));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_TEST_STRING_ASSERT(target->data, str->data);
+  SVN_TEST_ASSERT(svn_checksum_match(expected_md5, md5_checksum));
+  SVN_TEST_ASSERT(svn_checksum_match(expected_sha1, sha1_checksum));
+
+  /* SHA1 is optional. */
+  stream = svn_checksum__wrap_write_stream_md5_sha1(
+             &md5_checksum, NULL, svn_stream_empty(pool), pool);
+  SVN_ERR(svn_stream_puts(stream, str->data));
+  SVN_ERR(svn_stream_close(stream));
+  SVN_TEST_ASSERT(svn_checksum_match(expected_md5, md5_checksum));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_checksum_batch(apr_pool_t *pool)
+{
+  enum { FILE_COUNT = 8 };
+  const char *dir;
+  const char *paths[FILE_COUNT];
+  svn_stringbuf_t *contents[FILE_COUNT];
+  int threads;
+  int i;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&dir, "checksum_batch", pool));
+
+  /* Files of different sizes, some of them larger than a read buffer. */
+  for (i = 0; i < FILE_COUNT; ++i)
+    {
+      apr_size_t k;
+
+      contents[i] = svn_stringbuf_create_empty(pool);
+      for (k = 0; k < (apr_size_t)i * i * 5000; ++k)
+        svn_stringbuf_appendbyte(contents[i], (char)(k * 7 + i));
+
+      paths[i] = svn_dirent_join(dir, apr_psprintf(pool, "file%d", i),
+                                 pool);
+      SVN_ERR(svn_io_file_create_bytes(paths[i], contents[i]->data,
+                                       contents[i]->len, pool));
+    }
+
+  for (threads = 1; threads <= 4; threads += 3)
+    {
+      apr_array_header_t *jobs = apr_array_make(pool, 0,
+                                                sizeof(svn_checksum__job_t *));
+      svn_checksum__job_t *job;
+
+      /* Whole files with MD5 and SHA1 and parts of them with FNV-1a. */
+      for (i = 0; i < FILE_COUNT; ++i)
+        {
+          job = apr_pcalloc(pool, sizeof(*job));
+          job->abspath = paths[i];
+          job->length = -1;
+          job->kind = svn_checksum_sha1;
+          job->with_md5 = TRUE;
+          APR_ARRAY_PUSH(jobs, svn_checksum__job_t *) = job;
+
+          job = apr_pcalloc(pool, sizeof(*job));
+          job->abspath = paths[i];
+          job->offset = contents[i]->len / 3;
+          job->length = contents[i]->len / 2;
+          job->kind = svn_checksum_fnv1a_32x4;
+          APR_ARRAY_PUSH(jobs, svn_checksum__job_t *) = job;
+        }
+
+      /* Errors are reported per job. */
+      job = apr_pcalloc(pool, sizeof(*job));
+      job->abspath = svn_dirent_join(dir, "missing", pool);
+      job->length = -1;
+      job->kind = svn_checksum_md5;
+      APR_ARRAY_PUSH(jobs, svn_checksum__job_t *) = job;
+
+      job = apr_pcalloc(pool, sizeof(*job));
+      job->abspath = paths[1];
+      job->length = contents[1]->len + 1;
+      job->kind = svn_checksum_md5;
+      APR_ARRAY_PUSH(jobs, svn_checksum__job_t *) = job;
+
+      SVN_ERR(svn_checksum__compute_batch(jobs, threads, NULL, NULL,
+                                          pool, pool));
+
+      for (i = 0; i < FILE_COUNT; ++i)
+        {
+          svn_checksum_t *expected;
+          const char *data = contents[i]->data;
+          apr_size_t len = contents[i]->len;
+
+          job = APR_ARRAY_IDX(jobs, 2 * i, svn_checksum__job_t *);
+          SVN_TEST_ASSERT(job->err == SVN_NO_ERROR);
+          SVN_TEST_ASSERT(job->size == (apr_off_t)len);
+          SVN_ERR(svn_checksum(&expected, svn_checksum_sha1, data, len,
+                               pool));
+          SVN_TEST_ASSERT(svn_checksum_match(expected, job->checksum));
+          SVN_ERR(svn_checksum(&expected, svn_checksum_md5, data, len,
+                               pool));
+          SVN_TEST_ASSERT(svn_checksum_match(expected, job->md5_checksum));
+
+          job = APR_ARRAY_IDX(jobs, 2 * i + 1, svn_checksum__job_t *);
+          SVN_TEST_ASSERT(job->err == SVN_NO_ERROR);
+          SVN_TEST_ASSERT(job->size == (apr_off_t)(len / 2));
+          SVN_ERR(svn_checksum(&expected, svn_checksum_fnv1a_32x4,
+                               data + len / 3, len / 2, pool));
+          SVN_TEST_ASSERT(svn_checksum_match(expected, job->checksum));
+        }
+
+      job = APR_ARRAY_IDX(jobs, 2 * FILE_COUNT, svn_checksum__job_t *);
+      SVN_TEST_ASSERT(job->err && APR_STATUS_IS_ENOENT(job->err->apr_err));
+      svn_error_clear(job->err);
+
+      job = APR_ARRAY_IDX(jobs, 2 * FILE_COUNT + 1, svn_checksum__job_t *);
+      SVN_TEST_ASSERT(job->err && APR_STATUS_IS_EOF(job->err->apr_err));
+      svn_error_clear(job->err);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -389,6 +615,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "read from checksummed stream"),
     SVN_TEST_PASS2(test_checksummed_stream_reset,
                    "reset checksummed stream"),
+    SVN_TEST_PASS2(test_md5_sha1_vectors,
+                   "MD5 and SHA1 test vectors"),
+    SVN_TEST_PASS2(test_md5_sha1_stream,
+                   "write to MD5 and SHA1 checksumming stream"),
+    SVN_TEST_PASS2(test_checksum_batch,
+                   "checksum batches of files concurrently"),
     SVN_TEST_NULL
   };
 
@@ -25,6 +25,8 @@
 #include <apr_thread_proc.h>
 #include <apr_thread_cond.h>
 
+#include "svn_pools.h"
+
 #include "private/svn_atomic.h"
 #include "private/svn_subr_private.h"
 
@@ -78,6 +80,59 @@ test_root_pool(apr_pool_t *pool)
   svn_root_pools__t *pools;
   SVN_ERR(svn_root_pools__create(&pools));
   use_root_pool(pools);
+  svn_root_pools__destroy(pools);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_root_pool_limits(apr_pool_t *pool)
+{
+  svn_root_pools__t *pools;
+  svn_root_pools__info_t *info;
+  apr_pool_t *pool1, *pool2, *pool3;
+
+  /* At most one pool in the shared list. */
+  SVN_ERR(svn_root_pools__create2(&pools, 1, 0));
+
+  pool1 = svn_root_pools__acquire_pool(pools);
+  pool2 = svn_root_pools__acquire_pool(pools);
+  pool3 = svn_root_pools__acquire_pool(pools);
+  do_some_allocations(pool1);
+
+  info = svn_root_pools__get_info(pools, pool);
+  SVN_TEST_ASSERT(info->created == 3);
+  SVN_TEST_ASSERT(info->in_use == 3);
+
+  /* The first one gets cached by this thread, the second one goes into
+     the shared list and the third one exceeds the limit. */
+  svn_root_pools__release_pool(pool1, pools);
+  svn_root_pools__release_pool(pool2, pools);
+  svn_root_pools__release_pool(pool3, pools);
+
+  info = svn_root_pools__get_info(pools, pool);
+  SVN_TEST_ASSERT(info->in_use == 0);
+  SVN_TEST_ASSERT(info->unused == 1);
+#if APR_HAS_THREADS
+  SVN_TEST_ASSERT(info->thread_cached == 1);
+#endif
+  SVN_TEST_ASSERT(info->reclaimed == info->created - 1 - info->thread_cached);
+  SVN_TEST_ASSERT(info->max_retained
+                  == (info->unused + info->thread_cached)
+                     * SVN_ALLOCATOR_RECOMMENDED_MAX_FREE);
+
+  /* Re-use what we cached. */
+  pool2 = svn_root_pools__acquire_pool(pools);
+  SVN_TEST_ASSERT(pool2 == pool1);
+  svn_root_pools__release_pool(pool2, pools);
+
+  info = svn_root_pools__get_info(pools, pool);
+  SVN_TEST_ASSERT(info->acquired == 4);
+  SVN_TEST_ASSERT(info->created == 3);
+  SVN_TEST_ASSERT(svn_root_pools__format_info(info, pool)->len > 0);
+
+  /* Releases the pool cached by this thread and the unused one. */
+  svn_root_pools__destroy(pools);
 
   return SVN_NO_ERROR;
 }
@@ -113,11 +168,62 @@ test_root_pool_concurrency(apr_pool_t *pool)
       APR_ERR(apr_thread_join(&retval, threads[i]));
       APR_ERR(retval);
     }
+
+  svn_root_pools__destroy(pools);
 #endif
 
   return SVN_NO_ERROR;
 }
 
+/* Pool cleanup function incrementing the int in DATA. */
+static apr_status_t
+count_cleanup(void *data)
+{
+  int *count = data;
+  ++*count;
+
+  return APR_SUCCESS;
+}
+
+static svn_error_t *
+test_arena_parent_cleared(apr_pool_t *pool)
+{
+  apr_pool_t *parent = svn_pool_create(pool);
+  apr_pool_t *arena, *nested;
+  int cleaned_up = 0;
+
+  /* Clearing the parent takes the arena and the arenas within it along. */
+  arena = svn_pool__create_arena(parent);
+  nested = svn_pool__create_arena(arena);
+  apr_pool_cleanup_register(arena, &cleaned_up, count_cleanup,
+                            apr_pool_cleanup_null);
+  apr_pool_cleanup_register(nested, &cleaned_up, count_cleanup,
+                            apr_pool_cleanup_null);
+  do_some_allocations(arena);
+  do_some_allocations(nested);
+
+  svn_pool_clear(parent);
+  SVN_TEST_INT_ASSERT(cleaned_up, 2);
+
+  /* The parent and the thread's allocator are still fine to use. */
+  do_some_allocations(parent);
+  arena = svn_pool__create_arena(parent);
+  do_some_allocations(arena);
+  svn_pool_clear(arena);
+  do_some_allocations(arena);
+
+  /* Explicit destruction does not run the cleanups again. */
+  apr_pool_cleanup_register(arena, &cleaned_up, count_cleanup,
+                            apr_pool_cleanup_null);
+  svn_pool__destroy_arena(arena);
+  SVN_TEST_INT_ASSERT(cleaned_up, 3);
+
+  svn_pool_destroy(parent);
+  SVN_TEST_INT_ASSERT(cleaned_up, 3);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -128,9 +234,13 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_PASS2(test_root_pool,
                    "test root pool recycling"),
+    SVN_TEST_PASS2(test_root_pool_limits,
+                   "test root pool retention limits"),
     SVN_TEST_SKIP2(test_root_pool_concurrency,
                    ! APR_HAS_THREADS,
                    "test concurrent root pool recycling"),
+    SVN_TEST_PASS2(test_arena_parent_cleared,
+                   "test arenas whose parent gets cleared"),
     SVN_TEST_NULL
   };
 
@@ -170,6 +170,72 @@ test_sqlite_txn_commit_busy(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_sqlite_profile(apr_pool_t *pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  svn_stringbuf_t *table = svn_stringbuf_create_empty(pool);
+  const char *line;
+  apr_int64_t calls, rows;
+  int i;
+
+  static const char *const statements[] = {
+    "CREATE TABLE profile (one INTEGER NOT NULL PRIMARY KEY)",
+
+    "INSERT INTO profile(one) VALUES (?1)",
+
+    "SELECT one FROM profile "
+    "ORDER BY one",
+
+    NULL
+  };
+
+  SVN_ERR(open_db(&sdb, NULL, "profile", statements, 0, pool));
+  svn_sqlite__profile_enable(sdb);
+  SVN_ERR(svn_sqlite__exec_statements(sdb, 0));
+
+  for (i = 0; i < 3; i++)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 1));
+      SVN_ERR(svn_sqlite__bindf(stmt, "d", i));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+
+  /* Read the rows twice, once only partially. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 2));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 2));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  SVN_ERR(svn_sqlite__profile_write(svn_stream_from_stringbuf(table, pool),
+                                    sdb, pool));
+
+  /* Whitespace in the statement text is collapsed. */
+  line = strstr(table->data, "INSERT INTO profile(one) VALUES (?1)");
+  SVN_TEST_ASSERT(line);
+  line = strstr(table->data, "SELECT one FROM profile ORDER BY one");
+  SVN_TEST_ASSERT(line);
+
+  /* Parse the counters at the start of the SELECT line. */
+  while (line > table->data && line[-1] != '\n')
+    line--;
+  SVN_TEST_ASSERT(sscanf(line, "%*s %" APR_INT64_T_FMT " %" APR_INT64_T_FMT,
+                         &calls, &rows) == 2);
+  SVN_TEST_ASSERT(calls == 2);
+  SVN_TEST_ASSERT(rows == 4);
+
+  SVN_ERR(svn_sqlite__close(sdb));
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = 1;
 
@@ -180,6 +246,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "sqlite reset"),
     SVN_TEST_PASS2(test_sqlite_txn_commit_busy,
                    "sqlite busy on transaction commit"),
+    SVN_TEST_PASS2(test_sqlite_profile,
+                   "sqlite statement profile"),
     SVN_TEST_NULL
   };
 
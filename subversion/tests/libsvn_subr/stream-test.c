@@ -1000,6 +1000,134 @@ test_stream_readline_file_crlf(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Return the content of line number I for test_stream_readline_bulk(),
+   allocated in POOL.  Lines vary in length between 2 and a few hundred
+   bytes, so they cross the internal buffer boundaries at various offsets. */
+static const char *
+make_bulk_line(int i, apr_pool_t *pool)
+{
+  int len = (i * 37) % 301;
+  char *filler = apr_palloc(pool, len + 1);
+
+  memset(filler, 'a' + i % 26, len);
+  filler[len] = '\0';
+
+  return apr_psprintf(pool, "%d:%s", i, filler);
+}
+
+/* Read the LINE_COUNT lines generated by make_bulk_line() and terminated
+   by EOL from STREAM and verify them.  Print the throughput for a total
+   of SIZE bytes, labelled NAME, if VERBOSE is set. */
+static svn_error_t *
+verify_bulk_lines(svn_stream_t *stream,
+                  const char *eol,
+                  int line_count,
+                  apr_size_t size,
+                  const char *name,
+                  svn_boolean_t verbose,
+                  apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start = apr_time_now();
+  svn_stringbuf_t *line;
+  svn_boolean_t eof;
+  int i;
+
+  for (i = 0; i < line_count; ++i)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_stream_readline(stream, &line, eol, &eof, iterpool));
+      SVN_TEST_ASSERT(!eof);
+      SVN_TEST_STRING_ASSERT(line->data, make_bulk_line(i, iterpool));
+    }
+
+  SVN_ERR(svn_stream_readline(stream, &line, eol, &eof, iterpool));
+  SVN_TEST_ASSERT(eof);
+  SVN_TEST_ASSERT(line->len == 0);
+
+  if (verbose)
+    {
+      apr_time_t elapsed = apr_time_now() - start;
+      printf("%-24s %8.1f MB/s\n", name,
+             (double)size / (elapsed ? (double)elapsed : 1.0));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_stream_readline_bulk(const svn_test_opts_t *opts,
+                          apr_pool_t *pool)
+{
+  enum { LINE_COUNT = 20000 };
+  static const char *eols[] = { "\n", "\r\n" };
+  const char *tmp_dir;
+  svn_stream_t *stream;
+  svn_stringbuf_t *line;
+  svn_boolean_t eof;
+  apr_size_t k;
+  int i;
+
+  SVN_ERR(svn_dirent_get_absolute(&tmp_dir, "test_stream_readline_bulk",
+                                  pool));
+  SVN_ERR(svn_io_remove_dir2(tmp_dir, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_io_make_dir_recursively(tmp_dir, pool));
+  svn_test_add_dir_cleanup(tmp_dir);
+
+  for (k = 0; k < sizeof(eols) / sizeof(eols[0]); ++k)
+    {
+      const char *eol = eols[k];
+      const char *eol_name = eol[0] == '\n' ? "LF" : "CRLF";
+      svn_stringbuf_t *content = svn_stringbuf_create_empty(pool);
+      const char *tmp_file = svn_dirent_join(tmp_dir, eol_name, pool);
+
+      for (i = 0; i < LINE_COUNT; ++i)
+        {
+          svn_stringbuf_appendcstr(content, make_bulk_line(i, pool));
+          svn_stringbuf_appendcstr(content, eol);
+        }
+
+      SVN_ERR(verify_bulk_lines(svn_stream_from_stringbuf(content, pool),
+                                eol, LINE_COUNT, content->len,
+                                apr_pstrcat(pool, "stringbuf, ", eol_name,
+                                            SVN_VA_NULL),
+                                opts->verbose, pool));
+      SVN_ERR(verify_bulk_lines(svn_stream_from_string(
+                                  svn_string_ncreate(content->data,
+                                                     content->len, pool),
+                                  pool),
+                                eol, LINE_COUNT, content->len,
+                                apr_pstrcat(pool, "string, ", eol_name,
+                                            SVN_VA_NULL),
+                                opts->verbose, pool));
+
+      SVN_ERR(svn_io_file_create_bytes(tmp_file, content->data,
+                                       content->len, pool));
+      SVN_ERR(svn_stream_open_readonly(&stream, tmp_file, pool, pool));
+      SVN_ERR(verify_bulk_lines(stream, eol, LINE_COUNT, content->len,
+                                apr_pstrcat(pool, "file, ", eol_name,
+                                            SVN_VA_NULL),
+                                opts->verbose, pool));
+      SVN_ERR(svn_stream_close(stream));
+    }
+
+  /* In-memory streams must not stop at embedded NULs. */
+  stream = svn_stream_from_stringbuf(svn_stringbuf_ncreate("a\0b\r\nc", 6,
+                                                           pool),
+                                     pool);
+  SVN_ERR(svn_stream_readline(stream, &line, "\r\n", &eof, pool));
+  SVN_TEST_ASSERT(!eof);
+  SVN_TEST_ASSERT(line->len == 3 && memcmp(line->data, "a\0b", 3) == 0);
+  SVN_ERR(svn_stream_readline(stream, &line, "\r\n", &eof, pool));
+  SVN_TEST_ASSERT(eof);
+  SVN_TEST_STRING_ASSERT(line->data, "c");
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -1037,6 +1165,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test reading LF-terminated lines from file"),
     SVN_TEST_PASS2(test_stream_readline_file_crlf,
                    "test reading CRLF-terminated lines from file"),
+    SVN_TEST_OPTS_PASS(test_stream_readline_bulk,
+                       "test reading many lines from various streams"),
     SVN_TEST_NULL
   };
 
@@ -633,7 +633,7 @@ test_inserting_nodes(apr_pool_t *pool)
             "N/N-a", ROOT_ONE, UUID_ONE, 3,
             props,
             1, TIME_1a, AUTHOR_1,
-            checksum,
+            checksum, FALSE,
             NULL, FALSE, FALSE, NULL, NULL, FALSE, FALSE,
             NULL, NULL,
             pool));
@@ -23,6 +23,7 @@
 
 #include <apr_pools.h>
 #include <apr_general.h>
+#include <apr_strings.h>
 
 #include "svn_types.h"
 
@@ -46,6 +47,8 @@
 #include "../../libsvn_wc/wc_db.h"
 #include "../../libsvn_wc/wc-queries.h"
 #include "../../libsvn_wc/workqueue.h"
+#define SVN_WC__I_AM_WC_DB
+#include "../../libsvn_wc/wc_db_private.h"
 
 #include "private/svn_wc_private.h"
 
@@ -306,6 +309,372 @@ reject_mismatching_text(const svn_test_opts_t *opts,
 #endif
 }
 
+/* Install a pristine text with contents DATA in the WC at WC_ABSPATH in DB
+ * and set *SHA1 to its SHA-1 checksum. */
+static svn_error_t *
+install_text(svn_checksum_t **sha1,
+             svn_wc__db_t *db,
+             const char *wc_abspath,
+             const char *data,
+             apr_pool_t *pool)
+{
+  svn_wc__db_install_data_t *install_data;
+  svn_stream_t *pristine_stream;
+  svn_checksum_t *md5;
+  apr_size_t sz = strlen(data);
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                              &install_data,
+                                              sha1, &md5,
+                                              db, wc_abspath,
+                                              pool, pool));
+  SVN_ERR(svn_stream_write(pristine_stream, data, &sz));
+  SVN_ERR(svn_stream_close(pristine_stream));
+
+  SVN_ERR(svn_wc__db_pristine_install(install_data, *sha1, md5, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Install the LEN bytes in DATA as a pristine text in the WC at WC_ABSPATH
+ * in DB, check that it reads back the same and set *SHA1 to its SHA-1
+ * checksum. */
+static svn_error_t *
+install_and_read_text(svn_checksum_t **sha1,
+                      svn_wc__db_t *db,
+                      const char *wc_abspath,
+                      const char *data,
+                      apr_size_t len,
+                      apr_pool_t *pool)
+{
+  svn_wc__db_install_data_t *install_data;
+  svn_stream_t *pristine_stream;
+  svn_checksum_t *md5;
+  svn_stringbuf_t *contents;
+  apr_size_t sz = len;
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                              &install_data,
+                                              sha1, &md5,
+                                              db, wc_abspath,
+                                              pool, pool));
+  SVN_ERR(svn_stream_write(pristine_stream, data, &sz));
+  SVN_ERR(svn_stream_close(pristine_stream));
+  SVN_ERR(svn_wc__db_pristine_install(install_data, *sha1, md5, pool));
+
+  SVN_ERR(svn_wc__db_pristine_read(&pristine_stream, NULL, db, wc_abspath,
+                                   *sha1, pool, pool));
+  SVN_ERR(svn_stringbuf_from_stream(&contents, pristine_stream, len, pool));
+  SVN_TEST_ASSERT(contents->len == len);
+  SVN_TEST_ASSERT(memcmp(contents->data, data, len) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SIZE to the total size of the chunks in the WC at WC_ABSPATH. */
+static svn_error_t *
+get_chunks_size(apr_int64_t *size,
+                const char *wc_abspath,
+                apr_pool_t *pool)
+{
+  const char *chunks_abspath;
+  apr_hash_t *dirs;
+  apr_hash_index_t *hi;
+
+  chunks_abspath = svn_dirent_join_many(pool, wc_abspath,
+                                        svn_wc_get_adm_dir(pool),
+                                        "pristine", "chunks", SVN_VA_NULL);
+  SVN_ERR(svn_io_get_dirents3(&dirs, chunks_abspath, TRUE, pool, pool));
+
+  *size = 0;
+  for (hi = apr_hash_first(pool, dirs); hi; hi = apr_hash_next(hi))
+    {
+      apr_hash_t *files;
+      apr_hash_index_t *hi2;
+
+      SVN_ERR(svn_io_get_dirents3(&files,
+                                  svn_dirent_join(chunks_abspath,
+                                                  apr_hash_this_key(hi),
+                                                  pool),
+                                  FALSE, pool, pool));
+      for (hi2 = apr_hash_first(pool, files); hi2; hi2 = apr_hash_next(hi2))
+        {
+          const svn_io_dirent2_t *dirent = apr_hash_this_val(hi2);
+          *size += dirent->filesize;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *FORMAT to the format recorded in the wc.db of the WC at
+ * WC_ABSPATH in DB. */
+static svn_error_t *
+read_db_format(int *format,
+               svn_wc__db_t *db,
+               const char *wc_abspath,
+               apr_pool_t *pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                                                wc_abspath, pool, pool));
+  SVN_ERR(svn_sqlite__read_schema_version(format, wcroot->sdb, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Store two large, similar texts in chunks and check that they can be
+ * read, share most of their chunks and get cleaned up. */
+static svn_error_t *
+pristine_chunked(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *wc_abspath;
+  const char *path;
+  svn_checksum_t *sha1, *sha1_2;
+  apr_size_t len = 3 * 1024 * 1024;
+  char *data = apr_palloc(pool, len);
+  char *data2 = apr_palloc(pool, len + 10);
+  apr_uint32_t seed = 1;
+  apr_int64_t stored;
+  svn_stringbuf_t *contents;
+  svn_stream_t *stream;
+  svn_wc__db_status_t status;
+  svn_node_kind_t kind;
+  svn_boolean_t present;
+  apr_pool_t *subpool;
+  int format;
+  apr_size_t i;
+
+  SVN_ERR(create_repos_and_wc(&wc_abspath, &db,
+                              "pristine_chunked", opts, pool));
+  db->pristine_chunking = TRUE;
+
+  /* Small texts don't get chunked, so older clients can still use the
+     working copy. */
+  SVN_ERR(install_text(&sha1, db, wc_abspath, "Small", pool));
+  SVN_ERR(read_db_format(&format, db, wc_abspath, pool));
+  SVN_TEST_INT_ASSERT(format, SVN_WC__VERSION);
+
+  /* The second text has a few bytes inserted in the middle. */
+  for (i = 0; i < len; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      data[i] = 'a' + (seed >> 16) % 26;
+    }
+  memcpy(data2, data, len / 2);
+  memcpy(data2 + len / 2, "0123456789", 10);
+  memcpy(data2 + len / 2 + 10, data + len / 2, len - len / 2);
+
+  SVN_ERR(install_and_read_text(&sha1, db, wc_abspath, data, len, pool));
+  SVN_ERR(install_and_read_text(&sha1_2, db, wc_abspath, data2, len + 10,
+                                pool));
+
+  /* Older clients must refuse the working copy now. */
+  SVN_ERR(read_db_format(&format, db, wc_abspath, pool));
+  SVN_TEST_INT_ASSERT(format, SVN_WC__FEATURES_VERSION);
+
+  /* But we can still open and use it. */
+  SVN_ERR(svn_wc__db_close(db));
+  SVN_ERR(svn_wc__db_open(&db, NULL, FALSE, TRUE, pool, pool));
+  db->pristine_chunking = TRUE;
+  SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL,
+                               db, wc_abspath, pool, pool));
+  SVN_TEST_ASSERT(status == svn_wc__db_status_normal);
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+  SVN_ERR(svn_wc__db_pristine_read(&stream, NULL, db, wc_abspath, sha1,
+                                   pool, pool));
+  SVN_ERR(svn_stringbuf_from_stream(&contents, stream, len, pool));
+  SVN_TEST_ASSERT(contents->len == len);
+  SVN_TEST_ASSERT(memcmp(contents->data, data, len) == 0);
+
+  /* There are no pristine files, but the texts are present. */
+  SVN_ERR(svn_wc__db_pristine_get_future_path(&path, wc_abspath, sha1,
+                                              pool, pool));
+  SVN_ERR(svn_io_check_path(path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_wc__db_pristine_check(&present, db, wc_abspath, sha1, pool));
+  SVN_TEST_ASSERT(present);
+
+  /* Both texts together take little more space than one. */
+  SVN_ERR(get_chunks_size(&stored, wc_abspath, pool));
+  SVN_TEST_ASSERT(stored < len + len / 2);
+
+  /* Removing one text keeps the chunks it shares with the other. */
+  SVN_ERR(svn_wc__db_pristine_remove(db, wc_abspath, sha1_2, pool));
+  SVN_ERR(svn_wc__db_pristine_check(&present, db, wc_abspath, sha1_2, pool));
+  SVN_TEST_ASSERT(!present);
+  SVN_ERR(svn_wc__db_pristine_read(&stream, NULL, db, wc_abspath, sha1,
+                                   pool, pool));
+  SVN_ERR(svn_stringbuf_from_stream(&contents, stream, len, pool));
+  SVN_TEST_ASSERT(contents->len == len);
+  SVN_TEST_ASSERT(memcmp(contents->data, data, len) == 0);
+
+  /* Asking for the path gives a complete temporary file outside of the
+     pristine store. */
+  subpool = svn_pool_create(pool);
+  SVN_ERR(svn_wc__db_pristine_get_path(&path, db, wc_abspath, sha1,
+                                       subpool, pool));
+  path = apr_pstrdup(pool, path);
+  SVN_TEST_ASSERT(svn_dirent_is_ancestor(
+                    svn_dirent_join_many(pool, wc_abspath,
+                                         svn_wc_get_adm_dir(pool), "tmp",
+                                         SVN_VA_NULL),
+                    path));
+  SVN_ERR(svn_stringbuf_from_file2(&contents, path, pool));
+  SVN_TEST_ASSERT(contents->len == len);
+  SVN_TEST_ASSERT(memcmp(contents->data, data, len) == 0);
+
+  svn_pool_destroy(subpool);
+  SVN_ERR(svn_io_check_path(path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* The text is unreferenced, so cleanup removes it and all chunks. */
+  SVN_ERR(svn_wc__db_pristine_cleanup(db, wc_abspath, NULL, NULL,
+                                      NULL, NULL, pool));
+  SVN_ERR(get_chunks_size(&stored, wc_abspath, pool));
+  SVN_TEST_ASSERT(stored == 0);
+
+  return svn_error_trace(svn_wc__db_close(db));
+}
+
+/* Share a text between two working copies and vacuum it again. */
+static svn_error_t *
+pristine_shared(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_wc__db_t *db, *db2;
+  const char *wc_abspath, *wc2_abspath;
+  const char *store_abspath;
+  const char *path, *path2;
+  const char *shared_path;
+  const char *hexdigest;
+  svn_checksum_t *sha1, *sha1_2, *sha1_3;
+  svn_stringbuf_t *contents;
+  svn_stream_t *stream;
+  apr_finfo_t finfo;
+
+  SVN_ERR(create_repos_and_wc(&wc_abspath, &db,
+                              "pristine_shared", opts, pool));
+  SVN_ERR(create_repos_and_wc(&wc2_abspath, &db2,
+                              "pristine_shared_2", opts, pool));
+  SVN_ERR(svn_test_make_sandbox_dir(&store_abspath, "pristine_shared_store",
+                                    pool));
+  db->shared_pristine_abspath = store_abspath;
+  db2->shared_pristine_abspath = store_abspath;
+
+  /* Installing a text offers it to the shared store. */
+  SVN_ERR(install_text(&sha1, db, wc_abspath, "Shared", pool));
+  SVN_ERR(svn_wc__db_pristine_get_future_path(&path, wc_abspath, sha1,
+                                              pool, pool));
+  SVN_ERR(svn_io_stat(&finfo, path, APR_FINFO_NLINK, pool));
+  if (finfo.nlink != 2)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "Hard links are not supported here");
+
+  /* The other working copy finds it there. */
+  SVN_ERR(svn_wc__db_pristine_read_shared(&stream, db2, sha1, pool, pool));
+  SVN_TEST_ASSERT(stream != NULL);
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_ERR(install_text(&sha1_2, db2, wc2_abspath, "Shared", pool));
+  SVN_TEST_ASSERT(svn_checksum_match(sha1, sha1_2));
+  SVN_ERR(svn_io_stat(&finfo, path, APR_FINFO_NLINK, pool));
+  SVN_TEST_INT_ASSERT(finfo.nlink, 3);
+
+  /* A damaged text in the shared store doesn't get linked. */
+  SVN_ERR(install_text(&sha1_3, db, wc_abspath, "Damaged", pool));
+  hexdigest = svn_checksum_to_cstring(sha1_3, pool);
+  shared_path = svn_dirent_join_many(pool, store_abspath,
+                                     apr_pstrndup(pool, hexdigest, 2),
+                                     apr_pstrcat(pool, hexdigest,
+                                                 ".svn-base", SVN_VA_NULL),
+                                     SVN_VA_NULL);
+  SVN_ERR(svn_io_remove_file2(shared_path, FALSE, pool));
+  SVN_ERR(svn_io_file_create(shared_path, "damaged", pool));
+
+  SVN_ERR(install_text(&sha1_3, db2, wc2_abspath, "Damaged", pool));
+  SVN_ERR(svn_wc__db_pristine_get_future_path(&path2, wc2_abspath, sha1_3,
+                                              pool, pool));
+  SVN_ERR(svn_io_stat(&finfo, path2, APR_FINFO_NLINK, pool));
+  SVN_TEST_INT_ASSERT(finfo.nlink, 1);
+  SVN_ERR(svn_stringbuf_from_file2(&contents, path2, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "Damaged");
+
+  /* It stays shared as long as any working copy uses it. */
+  SVN_ERR(svn_wc__db_pristine_remove(db, wc_abspath, sha1, pool));
+  SVN_ERR(svn_wc__db_pristine_cleanup(db, wc_abspath, NULL, NULL,
+                                      NULL, NULL, pool));
+  SVN_ERR(svn_wc__db_pristine_read_shared(&stream, db, sha1, pool, pool));
+  SVN_TEST_ASSERT(stream != NULL);
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_ERR(svn_wc__db_pristine_remove(db2, wc2_abspath, sha1, pool));
+  SVN_ERR(svn_wc__db_pristine_cleanup(db2, wc2_abspath, NULL, NULL,
+                                      NULL, NULL, pool));
+  SVN_ERR(svn_wc__db_pristine_read_shared(&stream, db, sha1, pool, pool));
+  SVN_TEST_ASSERT(stream == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_wc_notify_func2_t.  Record the last cleanup progress
+ * notification in the svn_wc_notify_t * BATON. */
+static void
+record_cleanup_progress(void *baton,
+                        const svn_wc_notify_t *notify,
+                        apr_pool_t *pool)
+{
+  svn_wc_notify_t *last = baton;
+
+  if (notify->action == svn_wc_notify_cleanup_pristines_progress)
+    {
+      last->progress = notify->progress;
+      last->progress_total = notify->progress_total;
+    }
+}
+
+/* Verify that pristine cleanup reports its progress. */
+static svn_error_t *
+pristine_cleanup_progress(const svn_test_opts_t *opts,
+                          apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *wc_abspath;
+  svn_checksum_t *sha1[10];
+  svn_wc_notify_t last = { 0 };
+  svn_boolean_t present;
+  int i;
+
+  SVN_ERR(create_repos_and_wc(&wc_abspath, &db,
+                              "pristine_cleanup_progress", opts, pool));
+
+  for (i = 0; i < 10; i++)
+    SVN_ERR(install_text(&sha1[i], db, wc_abspath,
+                         apr_psprintf(pool, "Text %d", i), pool));
+
+  SVN_ERR(svn_wc__db_pristine_cleanup(db, wc_abspath, NULL, NULL,
+                                      record_cleanup_progress, &last,
+                                      pool));
+  SVN_TEST_INT_ASSERT(last.progress_total, 10);
+  SVN_TEST_INT_ASSERT(last.progress, 10);
+
+  for (i = 0; i < 10; i++)
+    {
+      SVN_ERR(svn_wc__db_pristine_check(&present, db, wc_abspath, sha1[i],
+                                        pool));
+      SVN_TEST_ASSERT(!present);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = -1;
 
@@ -318,6 +687,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pristine_delete_while_open"),
     SVN_TEST_OPTS_PASS(reject_mismatching_text,
                        "reject_mismatching_text"),
+    SVN_TEST_OPTS_PASS(pristine_chunked,
+                       "pristine_chunked"),
+    SVN_TEST_OPTS_PASS(pristine_shared,
+                       "pristine_shared"),
+    SVN_TEST_OPTS_PASS(pristine_cleanup_progress,
+                       "pristine_cleanup_progress"),
     SVN_TEST_NULL
   };
 
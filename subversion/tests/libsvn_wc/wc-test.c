@@ -35,6 +35,7 @@
 #include "svn_wc.h"
 #include "svn_client.h"
 #include "svn_hash.h"
+#include "svn_path.h"
 
 #include "utils.h"
 
@@ -493,6 +494,366 @@ test_internal_file_modified(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_file_modified_by_checksum(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_boolean_t modified;
+  const char *iota_path;
+  apr_time_t time;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "file_modified_by_checksum",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  b.wc_ctx->db->compare_by_checksum = TRUE;
+  iota_path = sbox_wc_path(&b, "iota");
+
+  /* Same contents, different timestamp. */
+  SVN_ERR(svn_io_file_affected_time(&time, iota_path, pool));
+  SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(1),
+                                        iota_path, pool));
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, FALSE, pool));
+  SVN_TEST_ASSERT(!modified);
+
+  /* Same size, different contents. */
+  SVN_ERR(sbox_file_write(&b, "iota", "This is the file 'IOTA'.\n"));
+  SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(2),
+                                        iota_path, pool));
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, FALSE, pool));
+  SVN_TEST_ASSERT(modified);
+
+  /* Exact comparisons still read the pristine text. */
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, TRUE, pool));
+  SVN_TEST_ASSERT(modified);
+
+  /* Restored contents. */
+  SVN_ERR(sbox_file_write(&b, "iota", "This is the file 'iota'.\n"));
+  SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(3),
+                                        iota_path, pool));
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, FALSE, pool));
+  SVN_TEST_ASSERT(!modified);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for walk_status_recorder(). */
+struct walk_status_record_t
+{
+  /* The path reported last. */
+  const char *last_abspath;
+
+  /* Root of the tree counted in BELOW_X. */
+  const char *x_abspath;
+
+  /* Counters. */
+  int below_x;
+  int modified;
+  int unversioned;
+
+  /* Set if the paths were not reported in depth-first order. */
+  svn_boolean_t out_of_order;
+
+  apr_pool_t *pool;
+};
+
+/* Implements svn_wc_status_func4_t. */
+static svn_error_t *
+walk_status_recorder(void *baton,
+                     const char *local_abspath,
+                     const svn_wc_status3_t *status,
+                     apr_pool_t *scratch_pool)
+{
+  struct walk_status_record_t *record = baton;
+
+  if (record->last_abspath
+      && svn_path_compare_paths(record->last_abspath, local_abspath) >= 0)
+    record->out_of_order = TRUE;
+
+  if (svn_dirent_is_ancestor(record->x_abspath, local_abspath))
+    record->below_x++;
+  if (status->node_status == svn_wc_status_modified)
+    record->modified++;
+  if (status->node_status == svn_wc_status_unversioned)
+    record->unversioned++;
+
+  record->last_abspath = apr_pstrdup(record->pool, local_abspath);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_walk_status_order(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  struct walk_status_record_t record = { 0 };
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "walk_status_order", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* Enough directories to keep the read-ahead workers busy. */
+  SVN_ERR(sbox_wc_mkdir(&b, "X"));
+  for (i = 0; i < 30; ++i)
+    {
+      const char *dir = apr_psprintf(pool, "X/d%02d", i);
+
+      SVN_ERR(sbox_wc_mkdir(&b, dir));
+      SVN_ERR(sbox_wc_mkdir(&b, svn_relpath_join(dir, "sub", pool)));
+    }
+
+  SVN_ERR(sbox_file_write(&b, "A/mu", "modified mu"));
+  SVN_ERR(sbox_file_write(&b, "A/D/G/new", "unversioned"));
+
+  record.x_abspath = sbox_wc_path(&b, "X");
+  record.pool = pool;
+  SVN_ERR(svn_wc_walk_status(b.wc_ctx, b.wc_abspath, svn_depth_infinity,
+                             TRUE /* get_all */, FALSE /* no_ignore */,
+                             FALSE /* ignore_text_mods */, NULL,
+                             walk_status_recorder, &record,
+                             NULL, NULL, pool));
+
+  SVN_TEST_ASSERT(!record.out_of_order);
+  SVN_TEST_INT_ASSERT(record.below_x, 1 + 2 * 30);
+  SVN_TEST_INT_ASSERT(record.modified, 1);
+  SVN_TEST_INT_ASSERT(record.unversioned, 1);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_status_stale_watch_journal(const svn_test_opts_t *opts,
+                                apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  struct walk_status_record_t record = { 0 };
+  const char *adm_abspath;
+  apr_finfo_t finfo;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "status_stale_watch_journal", opts,
+                                   pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* A journal claiming that nothing changed since a previous walk, left
+     behind by a watcher that is not running any more. */
+  adm_abspath = svn_dirent_join(b.wc_abspath, svn_wc_get_adm_dir(pool),
+                                pool);
+  SVN_ERR(svn_io_stat(&finfo, svn_dirent_join(adm_abspath, "wc.db", pool),
+                      APR_FINFO_SIZE | APR_FINFO_MTIME, pool));
+  SVN_ERR(svn_io_file_create(svn_dirent_join(adm_abspath,
+                                             SVN_WC__WATCH_JOURNAL, pool),
+                             SVN_WC__WATCH_JOURNAL_HEADER " 1-1\n", pool));
+  SVN_ERR(svn_io_file_create(
+            svn_dirent_join(adm_abspath, "status-cache", pool),
+            apr_psprintf(pool, "SVN-status-cache 1 1-1 %" APR_OFF_T_FMT
+                         " %" APR_OFF_T_FMT " %" APR_TIME_T_FMT "\n",
+                         (apr_off_t)strlen(SVN_WC__WATCH_JOURNAL_HEADER
+                                           " 1-1\n"),
+                         finfo.size, finfo.mtime),
+            pool));
+
+  SVN_ERR(sbox_file_write(&b, "A/mu", "modified mu"));
+  SVN_ERR(sbox_file_write(&b, "A/D/G/new", "unversioned"));
+
+  record.x_abspath = sbox_wc_path(&b, "X");
+  record.pool = pool;
+  SVN_ERR(svn_wc_walk_status(b.wc_ctx, b.wc_abspath, svn_depth_infinity,
+                             FALSE /* get_all */, FALSE /* no_ignore */,
+                             FALSE /* ignore_text_mods */, NULL,
+                             walk_status_recorder, &record,
+                             NULL, NULL, pool));
+
+  /* The journal is not locked, so the walk must not trust it. */
+  SVN_TEST_INT_ASSERT(record.modified, 1);
+  SVN_TEST_INT_ASSERT(record.unversioned, 1);
+
+  return SVN_NO_ERROR;
+}
+
+/* Assert that the file PATH in the working copy of B has CONTENTS and
+   its recorded size and timestamp match. */
+static svn_error_t *
+check_installed_file(svn_test__sandbox_t *b,
+                     const char *path,
+                     const char *contents,
+                     apr_pool_t *pool)
+{
+  const char *local_abspath = sbox_wc_path(b, path);
+  svn_stringbuf_t *actual;
+  svn_boolean_t modified;
+
+  SVN_ERR(svn_stringbuf_from_file2(&actual, local_abspath, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, contents);
+
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b->wc_ctx->db,
+                                           local_abspath, FALSE, pool));
+  SVN_TEST_ASSERT(!modified);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_parallel_file_install(const svn_test_opts_t *opts,
+                           apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  apr_uint64_t id;
+  svn_skel_t *work_item;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "parallel_file_install", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  SVN_ERR(sbox_file_write(&b, "iota", "new iota\n"));
+  SVN_ERR(sbox_file_write(&b, "A/mu", "new mu\n"));
+  SVN_ERR(sbox_file_write(&b, "A/B/E/alpha", "new alpha\n"));
+  SVN_ERR(sbox_wc_delete(&b, "A/D/G"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* As if configured by SVN_CONFIG_OPTION_INSTALL_THREADS. */
+  b.wc_ctx->db->install_threads = 4;
+
+  /* Installs all files and removes a few, in one work queue run. */
+  SVN_ERR(sbox_wc_update(&b, "", 1));
+  SVN_ERR(check_installed_file(&b, "iota", "This is the file 'iota'.\n",
+                               pool));
+  SVN_ERR(check_installed_file(&b, "A/mu", "This is the file 'mu'.\n",
+                               pool));
+  SVN_ERR(check_installed_file(&b, "A/D/G/pi", "This is the file 'pi'.\n",
+                               pool));
+
+  SVN_ERR(sbox_wc_update(&b, "", 2));
+  SVN_ERR(check_installed_file(&b, "iota", "new iota\n", pool));
+  SVN_ERR(check_installed_file(&b, "A/B/E/alpha", "new alpha\n", pool));
+  SVN_ERR(check_installed_file(&b, "A/B/E/beta",
+                               "This is the file 'beta'.\n", pool));
+
+  /* Nothing may be left behind in the work queue. */
+  SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, b.wc_ctx->db,
+                                   b.wc_abspath, 0, pool, pool));
+  SVN_TEST_ASSERT(work_item == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_batched_update(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "batched_update", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  SVN_ERR(sbox_file_write(&b, "A/B/lambda", "new lambda\n"));
+  SVN_ERR(sbox_wc_delete(&b, "A/C"));
+  SVN_ERR(sbox_wc_delete(&b, "A/D/H"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* Much smaller than the number of nodes in the Greek tree. */
+  b.wc_ctx->db->batch_size = 3;
+
+  SVN_ERR(sbox_wc_update(&b, "", 0));
+  SVN_ERR(sbox_wc_update(&b, "", 1));
+  SVN_ERR(check_installed_file(&b, "A/B/lambda",
+                               "This is the file 'lambda'.\n", pool));
+  SVN_ERR(check_installed_file(&b, "A/D/H/omega",
+                               "This is the file 'omega'.\n", pool));
+
+  SVN_ERR(sbox_wc_update(&b, "", 2));
+  SVN_ERR(check_installed_file(&b, "A/B/lambda", "new lambda\n", pool));
+  SVN_ERR(svn_io_check_path(sbox_wc_path(&b, "A/D/H"), &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* All batches are over. */
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath,
+                                                b.wc_ctx->db, b.wc_abspath,
+                                                pool, pool));
+  SVN_TEST_INT_ASSERT(wcroot->batch_depth, 0);
+  SVN_TEST_INT_ASSERT(wcroot->batch_nodes, -1);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for check_added_dir_committed(). */
+struct added_dir_baton_t
+{
+  /* A context with its own wc.db connection, which only sees committed
+     changes. */
+  svn_wc_context_t *wc_ctx;
+
+  /* Number of directories checked and the first failure. */
+  int checked;
+  svn_error_t *err;
+};
+
+/* Implements svn_wc_notify_func2_t.  Check that the directories that the
+   update added on disk are committed to wc.db already. */
+static void
+check_added_dir_committed(void *baton,
+                          const svn_wc_notify_t *notify,
+                          apr_pool_t *pool)
+{
+  struct added_dir_baton_t *b = baton;
+  svn_node_kind_t on_disk;
+  svn_node_kind_t kind;
+
+  if (b->err
+      || notify->action != svn_wc_notify_update_add
+      || notify->kind != svn_node_dir)
+    return;
+
+  b->err = svn_io_check_path(notify->path, &on_disk, pool);
+  if (!b->err && on_disk == svn_node_dir)
+    b->err = svn_wc_read_kind2(&kind, b->wc_ctx, notify->path, TRUE, FALSE,
+                               pool);
+  if (!b->err && on_disk == svn_node_dir && kind != svn_node_dir)
+    b->err = svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                               "'%s' exists before its node got committed",
+                               notify->path);
+  b->checked++;
+}
+
+static svn_error_t *
+test_batched_update_add_dir(const svn_test_opts_t *opts,
+                            apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_client_ctx_t *ctx;
+  struct added_dir_baton_t baton = { 0 };
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(const char *));
+  apr_array_header_t *result_revs;
+  svn_opt_revision_t head = { svn_opt_revision_head, { 0 } };
+
+  SVN_ERR(svn_test__sandbox_create(&b, "batched_update_add_dir", opts,
+                                   pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+  SVN_ERR(sbox_wc_update(&b, "", 0));
+
+  /* Large enough to have several directories in one batch. */
+  b.wc_ctx->db->batch_size = 100;
+
+  SVN_ERR(svn_wc_context_create(&baton.wc_ctx, NULL, pool, pool));
+  SVN_ERR(svn_test__create_client_ctx(&ctx, &b, pool));
+  ctx->notify_func2 = check_added_dir_committed;
+  ctx->notify_baton2 = &baton;
+
+  APR_ARRAY_PUSH(paths, const char *) = b.wc_abspath;
+  SVN_ERR(svn_client_update4(&result_revs, paths, &head, svn_depth_infinity,
+                             FALSE, FALSE, FALSE, FALSE, FALSE, ctx, pool));
+
+  SVN_ERR(baton.err);
+  SVN_TEST_INT_ASSERT(baton.checked, 8);
+
+  return SVN_NO_ERROR;
+}
+
 /* ---------------------------------------------------------------------- */
 /* The list of test functions */
 
@@ -515,6 +876,18 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test legacy commit2"),
     SVN_TEST_OPTS_PASS(test_internal_file_modified,
                        "test internal_file_modified"),
+    SVN_TEST_OPTS_PASS(test_file_modified_by_checksum,
+                       "test internal_file_modified by checksum"),
+    SVN_TEST_OPTS_PASS(test_walk_status_order,
+                       "test status walk order"),
+    SVN_TEST_OPTS_PASS(test_status_stale_watch_journal,
+                       "test status with a stale watch journal"),
+    SVN_TEST_OPTS_PASS(test_parallel_file_install,
+                       "test installing files in parallel"),
+    SVN_TEST_OPTS_PASS(test_batched_update,
+                       "test update with batched db changes"),
+    SVN_TEST_OPTS_PASS(test_batched_update_add_dir,
+                       "test batched update commits before mkdir"),
     SVN_TEST_NULL
   };
 
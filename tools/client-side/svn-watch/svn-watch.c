@@ -0,0 +1,546 @@
+/*
+ * svn-watch.c:  Journal changes to a working copy for 'svn status'.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* This tool watches all directories of a working copy with inotify and
+ * appends the directories whose entries change to the journal described
+ * at SVN_WC__WATCH_JOURNAL.  The status walk uses it to skip reading
+ * directories that did not change since its previous run.  Cookie files
+ * created in the administrative area of the root get journaled as well,
+ * which tells the status walk that it has seen all earlier changes. */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_strings.h>
+#include <apr_hash.h>
+#include <apr_time.h>
+
+#include "svn_cmdline.h"
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_path.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_utf.h"
+#include "svn_wc.h"
+
+#include "private/svn_cmdline_private.h"
+#include "private/svn_wc_private.h"
+
+#include "svn_private_config.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+/* Events that change what the status walk sees in a directory. */
+#define WATCH_MASK (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE \
+                    | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO \
+                    | IN_DELETE_SELF | IN_MOVE_SELF \
+                    | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK)
+
+/* Size of the inotify read buffer. */
+#define EVENT_BUFFER_SIZE 0x10000
+
+/* Milliseconds to wait for events before checking for cancellation. */
+#define POLL_TIMEOUT 500
+
+typedef struct watcher_t
+{
+  /* The inotify instance. */
+  int fd;
+
+  /* The working copy root being watched. */
+  const char *wcroot_abspath;
+
+  /* Watched directories: const char * relpaths by int watch descriptor,
+     and the other way around. */
+  apr_hash_t *relpaths;
+  apr_hash_t *descriptors;
+
+  /* Watch descriptor of the root's administrative area, in which only
+     the creation of cookie files matters. */
+  int adm_wd;
+
+  /* The journal, locked and opened for appending. */
+  apr_file_t *journal;
+
+  /* Entries to append to the journal with the next flush. */
+  svn_stringbuf_t *pending;
+
+  /* Relpaths (const char *) in PENDING. */
+  apr_hash_t *pending_set;
+
+  /* Owns the watch tables. */
+  apr_pool_t *pool;
+} watcher_t;
+
+/* Queue RELPATH as changed in WATCHER. */
+static void
+journal_dir(watcher_t *watcher,
+            const char *relpath)
+{
+  if (svn_hash_gets(watcher->pending_set, relpath))
+    return;
+
+  /* An entry must fit on one line. */
+  if (strchr(relpath, '\n'))
+    relpath = SVN_WC__WATCH_JOURNAL_OVERFLOW;
+
+  svn_stringbuf_appendcstr(watcher->pending, relpath);
+  svn_stringbuf_appendbyte(watcher->pending, '\n');
+  svn_hash_sets(watcher->pending_set,
+                apr_pstrdup(apr_hash_pool_get(watcher->pending_set),
+                            relpath),
+                "");
+}
+
+/* Queue the cookie file NAME as created in WATCHER.  Entries queued
+   before must be journaled before this one. */
+static void
+journal_cookie(watcher_t *watcher,
+               const char *name)
+{
+  if (strchr(name, '\n'))
+    return;
+
+  svn_stringbuf_appendcstr(watcher->pending, SVN_WC__WATCH_JOURNAL_COOKIE);
+  svn_stringbuf_appendcstr(watcher->pending, name);
+  svn_stringbuf_appendbyte(watcher->pending, '\n');
+}
+
+/* Append all queued entries of WATCHER to its journal. */
+static svn_error_t *
+flush_journal(watcher_t *watcher,
+              apr_pool_t *scratch_pool)
+{
+  if (!watcher->pending->len)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_file_write_full(watcher->journal, watcher->pending->data,
+                                 watcher->pending->len, NULL, scratch_pool));
+
+  svn_stringbuf_setempty(watcher->pending);
+  watcher->pending_set = apr_hash_make(apr_hash_pool_get(
+                                         watcher->pending_set));
+
+  return SVN_NO_ERROR;
+}
+
+/* Watch the directory RELPATH of WATCHER and all its subdirectories,
+   except administrative areas.  If JOURNAL is set, also record them as
+   changed because we may have missed changes made before the watch was
+   set up. */
+static svn_error_t *
+add_watches(watcher_t *watcher,
+            const char *relpath,
+            svn_boolean_t journal,
+            apr_pool_t *scratch_pool)
+{
+  const char *local_abspath = svn_dirent_join(watcher->wcroot_abspath,
+                                              relpath, scratch_pool);
+  const char *native_path;
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+  svn_error_t *err;
+  apr_status_t status;
+  int wd;
+
+  SVN_ERR(svn_utf_cstring_from_utf8(&native_path,
+                                    svn_dirent_local_style(local_abspath,
+                                                           scratch_pool),
+                                    scratch_pool));
+
+  wd = inotify_add_watch(watcher->fd, native_path, WATCH_MASK);
+  if (wd < 0)
+    {
+      /* Gone already, or not a directory any more.  The parent's events
+         have covered that. */
+      if (errno == ENOENT || errno == ENOTDIR)
+        return SVN_NO_ERROR;
+
+      /* Most likely out of watches.  We can't vouch for this directory. */
+      status = apr_get_os_error();
+      svn_handle_warning2(stderr,
+                          svn_error_wrap_apr(status,
+                                             _("Can't watch '%s'"),
+                                             svn_dirent_local_style(
+                                               local_abspath,
+                                               scratch_pool)),
+                          "svn-watch: ");
+      journal_dir(watcher, SVN_WC__WATCH_JOURNAL_OVERFLOW);
+      return SVN_NO_ERROR;
+    }
+
+  relpath = apr_pstrdup(watcher->pool, relpath);
+  apr_hash_set(watcher->relpaths,
+               apr_pmemdup(watcher->pool, &wd, sizeof(wd)), sizeof(wd),
+               relpath);
+  svn_hash_sets(watcher->descriptors, relpath,
+                apr_pmemdup(watcher->pool, &wd, sizeof(wd)));
+
+  if (journal)
+    journal_dir(watcher, relpath);
+
+  err = svn_io_get_dirents3(&dirents, local_abspath, TRUE,
+                            scratch_pool, scratch_pool);
+  if (err && (APR_STATUS_IS_ENOENT(err->apr_err)
+              || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+
+      svn_pool_clear(iterpool);
+
+      if (dirent->kind != svn_node_dir
+          || dirent->special
+          || svn_wc_is_adm_dir(name, iterpool))
+        continue;
+
+      SVN_ERR(add_watches(watcher, svn_relpath_join(relpath, name, iterpool),
+                          journal, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop watching the directory RELPATH of WATCHER and its subdirectories,
+   e.g. because they have been moved away. */
+static void
+remove_watches(watcher_t *watcher,
+               const char *relpath,
+               apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(scratch_pool, watcher->descriptors);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *watched = apr_hash_this_key(hi);
+      const int *wd = apr_hash_this_val(hi);
+
+      if (svn_relpath_skip_ancestor(relpath, watched))
+        {
+          /* The kernel confirms with IN_IGNORED, which drops the rest. */
+          inotify_rm_watch(watcher->fd, *wd);
+          svn_hash_sets(watcher->descriptors, watched, NULL);
+        }
+    }
+}
+
+/* Process the inotify event EVENT of WATCHER.  Set *DONE if the working
+   copy root went away. */
+static svn_error_t *
+process_event(svn_boolean_t *done,
+              watcher_t *watcher,
+              const struct inotify_event *event,
+              apr_pool_t *scratch_pool)
+{
+  const char *relpath;
+  const char *name;
+
+  if (event->mask & IN_Q_OVERFLOW)
+    {
+      journal_dir(watcher, SVN_WC__WATCH_JOURNAL_OVERFLOW);
+      return SVN_NO_ERROR;
+    }
+
+  if (event->wd == watcher->adm_wd)
+    {
+      if ((event->mask & IN_CREATE) && event->len)
+        {
+          SVN_ERR(svn_path_cstring_to_utf8(&name, event->name,
+                                           scratch_pool));
+          if (!strncmp(name, SVN_WC__WATCH_COOKIE_PREFIX,
+                       sizeof(SVN_WC__WATCH_COOKIE_PREFIX) - 1))
+            journal_cookie(watcher, name);
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+  relpath = apr_hash_get(watcher->relpaths, &event->wd, sizeof(event->wd));
+  if (!relpath)
+    return SVN_NO_ERROR;
+
+  if (event->mask & IN_IGNORED)
+    {
+      const int *wd = svn_hash_gets(watcher->descriptors, relpath);
+
+      /* The directory may be watched again under a new descriptor. */
+      if (wd && *wd == event->wd)
+        svn_hash_sets(watcher->descriptors, relpath, NULL);
+      apr_hash_set(watcher->relpaths, &event->wd, sizeof(event->wd), NULL);
+      return SVN_NO_ERROR;
+    }
+
+  if (event->mask & IN_UNMOUNT)
+    {
+      journal_dir(watcher, SVN_WC__WATCH_JOURNAL_OVERFLOW);
+      return SVN_NO_ERROR;
+    }
+
+  if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+    {
+      /* The parent reports this as a change of its own. */
+      if (!*relpath)
+        *done = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  if (!event->len)
+    {
+      /* Attributes of the directory itself. */
+      journal_dir(watcher, relpath);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_path_cstring_to_utf8(&name, event->name, scratch_pool));
+  if (svn_wc_is_adm_dir(name, scratch_pool))
+    return SVN_NO_ERROR;
+
+  journal_dir(watcher, relpath);
+
+  if (event->mask & IN_ISDIR)
+    {
+      const char *child_relpath = svn_relpath_join(relpath, name,
+                                                   scratch_pool);
+
+      if (event->mask & IN_MOVED_FROM)
+        remove_watches(watcher, child_relpath, scratch_pool);
+      else if (event->mask & (IN_CREATE | IN_MOVED_TO))
+        SVN_ERR(add_watches(watcher, child_relpath, TRUE, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Watch the working copy root WCROOT_ABSPATH until CANCEL_FUNC returns
+   an error or the root goes away. */
+static svn_error_t *
+watch(const char *wcroot_abspath,
+      svn_cancel_func_t cancel_func,
+      apr_pool_t *pool)
+{
+  watcher_t watcher = { 0 };
+  const char *journal_abspath;
+  const char *native_path;
+  const char *header;
+  char *buffer;
+  apr_pool_t *iterpool;
+  svn_boolean_t done = FALSE;
+  svn_error_t *err;
+
+  watcher.wcroot_abspath = wcroot_abspath;
+  watcher.relpaths = apr_hash_make(pool);
+  watcher.descriptors = apr_hash_make(pool);
+  watcher.pending = svn_stringbuf_create_empty(pool);
+  watcher.pending_set = apr_hash_make(svn_pool_create(pool));
+  watcher.pool = pool;
+
+  journal_abspath = svn_dirent_join_many(pool, wcroot_abspath,
+                                         svn_wc_get_adm_dir(pool),
+                                         SVN_WC__WATCH_JOURNAL,
+                                         SVN_VA_NULL);
+
+  /* Claim the journal before touching it. */
+  SVN_ERR(svn_io_file_open(&watcher.journal, journal_abspath,
+                           APR_WRITE | APR_CREATE | APR_APPEND,
+                           APR_OS_DEFAULT, pool));
+  err = svn_io_lock_open_file(watcher.journal, TRUE, TRUE, pool);
+  if (err && APR_STATUS_IS_EAGAIN(err->apr_err))
+    return svn_error_createf(SVN_ERR_WC_LOCKED, err,
+                             _("Working copy '%s' is watched already"),
+                             svn_dirent_local_style(wcroot_abspath, pool));
+  SVN_ERR(err);
+
+  watcher.fd = inotify_init1(IN_CLOEXEC);
+  if (watcher.fd < 0)
+    return svn_error_wrap_apr(apr_get_os_error(),
+                              _("Can't initialize inotify"));
+
+  /* Set up the watches first, so that nothing changes unnoticed after
+     the new session starts. */
+  SVN_ERR(add_watches(&watcher, "", FALSE, pool));
+
+  SVN_ERR(svn_utf_cstring_from_utf8(&native_path,
+                                    svn_dirent_local_style(
+                                      svn_dirent_dirname(journal_abspath,
+                                                         pool),
+                                      pool),
+                                    pool));
+  watcher.adm_wd = inotify_add_watch(watcher.fd, native_path,
+                                     IN_CREATE | IN_ONLYDIR);
+  if (watcher.adm_wd < 0)
+    return svn_error_wrap_apr(apr_get_os_error(), _("Can't watch '%s'"),
+                              svn_dirent_local_style(
+                                svn_dirent_dirname(journal_abspath, pool),
+                                pool));
+
+  SVN_ERR(svn_io_file_trunc(watcher.journal, 0, pool));
+  header = apr_psprintf(pool, SVN_WC__WATCH_JOURNAL_HEADER " %ld-%"
+                        APR_TIME_T_FMT "\n",
+                        (long)getpid(), apr_time_now());
+  SVN_ERR(svn_io_file_write_full(watcher.journal, header, strlen(header),
+                                 NULL, pool));
+  SVN_ERR(flush_journal(&watcher, pool));
+
+  buffer = apr_palloc(pool, EVENT_BUFFER_SIZE);
+  iterpool = svn_pool_create(pool);
+
+  while (!done)
+    {
+      struct pollfd pfd;
+      ssize_t len;
+      char *p;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(cancel_func(NULL));
+
+      pfd.fd = watcher.fd;
+      pfd.events = POLLIN;
+      if (poll(&pfd, 1, POLL_TIMEOUT) <= 0)
+        continue;
+
+      len = read(watcher.fd, buffer, EVENT_BUFFER_SIZE);
+      if (len < 0)
+        {
+          if (errno == EINTR || errno == EAGAIN)
+            continue;
+
+          return svn_error_wrap_apr(apr_get_os_error(),
+                                    _("Can't read inotify events"));
+        }
+
+      for (p = buffer; p < buffer + len; )
+        {
+          const struct inotify_event *event = (void *)p;
+
+          SVN_ERR(process_event(&done, &watcher, event, iterpool));
+          p += sizeof(*event) + event->len;
+        }
+
+      SVN_ERR(flush_journal(&watcher, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  close(watcher.fd);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the journal of WCROOT_ABSPATH, unless another watcher runs. */
+static svn_error_t *
+remove_journal(const char *wcroot_abspath,
+               apr_pool_t *pool)
+{
+  return svn_error_trace(svn_io_remove_file2(
+                           svn_dirent_join_many(pool, wcroot_abspath,
+                                                svn_wc_get_adm_dir(pool),
+                                                SVN_WC__WATCH_JOURNAL,
+                                                SVN_VA_NULL),
+                           TRUE, pool));
+}
+
+/* Watch the working copy root given on the command line. */
+static svn_error_t *
+sub_main(int argc,
+         const char *argv[],
+         apr_pool_t *pool)
+{
+  const char *wcroot_abspath;
+  svn_node_kind_t kind;
+  svn_cancel_func_t cancel_func;
+  svn_error_t *err;
+
+  if (argc != 2)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Usage: svn-watch WCROOT"));
+
+  SVN_ERR(svn_utf_cstring_to_utf8(&wcroot_abspath, argv[1], pool));
+  SVN_ERR(svn_dirent_get_absolute(&wcroot_abspath,
+                                  svn_dirent_internal_style(wcroot_abspath,
+                                                            pool),
+                                  pool));
+
+  SVN_ERR(svn_io_check_path(svn_dirent_join(wcroot_abspath,
+                                            svn_wc_get_adm_dir(pool), pool),
+                            &kind, pool));
+  if (kind != svn_node_dir)
+    return svn_error_createf(SVN_ERR_WC_NOT_WORKING_COPY, NULL,
+                             _("'%s' is not a working copy root"),
+                             svn_dirent_local_style(wcroot_abspath, pool));
+
+  cancel_func = svn_cmdline__setup_cancellation_handler();
+
+  err = watch(wcroot_abspath, cancel_func, pool);
+  if (!err || err->apr_err == SVN_ERR_CANCELLED)
+    {
+      svn_error_clear(err);
+      err = remove_journal(wcroot_abspath, pool);
+    }
+
+  return svn_error_trace(err);
+}
+#endif /* __linux__ */
+
+int
+main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  svn_error_t *err;
+
+  if (svn_cmdline_init("svn-watch", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+#ifdef __linux__
+  err = sub_main(argc, argv, pool);
+#else
+  err = svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                         _("svn-watch requires inotify"));
+#endif
+
+  if (err)
+    return svn_cmdline_handle_exit_error(err, pool, "svn-watch: ");
+
+  svn_pool_destroy(pool);
+
+  svn_cmdline__cancellation_exit();
+
+  return EXIT_SUCCESS;
+}
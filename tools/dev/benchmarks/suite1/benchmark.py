@@ -141,6 +141,12 @@ which svn
 ./benchmark.py run trunk@1352598,5x5 3
 ./benchmark.py chart compare 1.7.0 trunk@1352598 trunk@1352725 -o chart.svg
 
+# Measure checkouts without batched working copy database changes, using a
+# separate label for the unbatched runs.
+./benchmark.py run trunk-nobatch@1352725,5x5 3 \
+    -C config:working-copy:update-batch-size=0
+./benchmark.py compare trunk-nobatch trunk@1352725 -c checkout
+
 
 GLOBAL OPTIONS"""
 
@@ -601,7 +607,7 @@ class TimingQuery:
 
 
 def perform_run(batch, run_kind,
-                svn_bin, svnadmin_bin, verbose):
+                svn_bin, svnadmin_bin, verbose, config_options=()):
 
   run = Run(batch, run_kind)
 
@@ -628,6 +634,7 @@ def perform_run(batch, run_kind,
 
     cmd = [ svn_bin ]
     cmd.extend( list(args) )
+    cmd.extend( ['--config-option=%s' % o for o in config_options] )
     if verbose:
       print('svn cmd:', ' '.join(cmd))
 
@@ -915,7 +922,8 @@ def cmdline_run(db, options, run_kind_str, N=1):
   for i in range(N):
     print('Run %d of %d' % (i + 1, N))
     perform_run(batch, run_kind,
-                svn_bin, svnadmin_bin, options.verbose)
+                svn_bin, svnadmin_bin, options.verbose,
+                options.config_options or ())
 
   batch.done()
 
@@ -1260,6 +1268,10 @@ if __name__ == '__main__':
   parser.add_option('-t', '--title', action='store',
                     dest='title',
                     help='For charts, a title to print in the chart graphics.')
+  parser.add_option('-C', '--config-option', action='append',
+                    dest='config_options',
+                    help='For runs, pass --config-option=ARG to each svn'
+                         ' command. May be given several times.')
 
   parser.set_description(__doc__)
   parser.set_usage('')
@@ -0,0 +1,190 @@
+/* pool-churn.c -- measure the cost of short-lived pools
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+
+#include <apr_time.h>
+
+#include "svn_pools.h"
+#include "svn_cmdline.h"
+
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+/* Number of small allocations per pool. */
+#define ALLOCATIONS 16
+
+/* Depth of the simulated tree walk. */
+#define TREE_DEPTH 8
+
+/* Number of entries per directory in the simulated tree walk. */
+#define TREE_FANOUT 4
+
+/* Create a short-lived pool in PARENT, either an arena or a sub-pool. */
+static apr_pool_t *
+create_pool(apr_pool_t *parent,
+            svn_boolean_t use_arena)
+{
+  return use_arena ? svn_pool__create_arena(parent) : svn_pool_create(parent);
+}
+
+/* Destroy POOL, created by create_pool() with the same USE_ARENA. */
+static void
+destroy_pool(apr_pool_t *pool,
+             svn_boolean_t use_arena)
+{
+  if (use_arena)
+    svn_pool__destroy_arena(pool);
+  else
+    svn_pool_destroy(pool);
+}
+
+/* Allocate a few small objects in POOL, similar to what a loop body
+ * usually does. */
+static void
+use_pool(apr_pool_t *pool)
+{
+  int i;
+  for (i = 0; i < ALLOCATIONS; ++i)
+    apr_palloc(pool, 40 + 8 * i);
+}
+
+/* Create, use and destroy ITERATIONS pools in POOL. */
+static void
+flat_churn(int iterations,
+           svn_boolean_t use_arena,
+           apr_pool_t *pool)
+{
+  int i;
+  for (i = 0; i < iterations; ++i)
+    {
+      apr_pool_t *subpool = create_pool(pool, use_arena);
+      use_pool(subpool);
+      destroy_pool(subpool, use_arena);
+    }
+}
+
+/* Simulate a recursive tree walk of the given DEPTH below POOL with one
+ * pool per directory and one iteration pool per entry.  Return the number
+ * of pools created. */
+static int
+tree_churn(int depth,
+           svn_boolean_t use_arena,
+           apr_pool_t *pool)
+{
+  apr_pool_t *dir_pool = create_pool(pool, use_arena);
+  apr_pool_t *iterpool = svn_pool_create(dir_pool);
+  int count = 2;
+  int i;
+
+  use_pool(dir_pool);
+  for (i = 0; i < TREE_FANOUT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      use_pool(iterpool);
+
+      if (depth > 0)
+        count += tree_churn(depth - 1, use_arena, iterpool);
+    }
+
+  destroy_pool(dir_pool, use_arena);
+
+  return count;
+}
+
+/* Print the time elapsed since START for COUNT operations of kind NAME. */
+static svn_error_t *
+report(const char *name,
+       apr_time_t start,
+       int count,
+       apr_pool_t *pool)
+{
+  apr_time_t elapsed = apr_time_now() - start;
+
+  return svn_error_trace(svn_cmdline_printf(pool,
+                                            "%-24s %8.1f ns per pool\n",
+                                            name,
+                                            elapsed * 1000.0 / count));
+}
+
+/* Run all benchmarks with ITERATIONS pools for the flat case. */
+static svn_error_t *
+run_benchmarks(int iterations,
+               apr_pool_t *pool)
+{
+  apr_time_t start;
+  int count;
+
+  start = apr_time_now();
+  flat_churn(iterations, FALSE, pool);
+  SVN_ERR(report("flat, sub-pools", start, iterations, pool));
+
+  start = apr_time_now();
+  flat_churn(iterations, TRUE, pool);
+  SVN_ERR(report("flat, arenas", start, iterations, pool));
+
+  start = apr_time_now();
+  count = tree_churn(TREE_DEPTH, FALSE, pool);
+  SVN_ERR(report("tree walk, sub-pools", start, count, pool));
+
+  start = apr_time_now();
+  count = tree_churn(TREE_DEPTH, TRUE, pool);
+  SVN_ERR(report("tree walk, arenas", start, count, pool));
+
+  return SVN_NO_ERROR;
+}
+
+int main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  svn_error_t *err;
+  int iterations = 1000000;
+
+  if (svn_cmdline_init("pool-churn", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  if (argc > 2)
+    {
+      fprintf(stderr, "Usage: pool-churn [ITERATIONS]\n");
+      return EXIT_FAILURE;
+    }
+
+  if (argc == 2)
+    iterations = atoi(argv[1]);
+
+  if (iterations <= 0)
+    {
+      fprintf(stderr, "pool-churn: ITERATIONS must be positive\n");
+      return EXIT_FAILURE;
+    }
+
+  err = run_benchmarks(iterations, pool);
+  if (err)
+    return svn_cmdline_handle_exit_error(err, pool, "pool-churn: ");
+
+  svn_pool_destroy(pool);
+
+  return EXIT_SUCCESS;
+}